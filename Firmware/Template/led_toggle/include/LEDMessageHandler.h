@@ -4,7 +4,7 @@
 #include <string>
 #include <functional>
 #include "BeamUtils.h"
-#include "LEDUtils.h"
+#include "BeamLed.h"
 
 /**
  * @brief LED message handler for BeamLink LED examples
@@ -30,17 +30,22 @@ private:
   // Simple LED state tracking
   bool ledState;
   bool blinkingMode;
-  unsigned long lastBlinkTime;
+
+  // PWM output; blinking and fades run in hardware, nothing to poll
+  BeamLedcDriver ledDriver;
+  BeamLed led;
 
 public:
   LEDCommandHandler(int pin, bool activeHigh, const char* name, const char* id, 
                    const char* type, const char* fw);
   
+  // Set up the LEDC channel on the pin (call from setup()); afterwards
+  // drive the LED from one task only (handleMessage() or refreshFromSerial())
+  bool begin();
+
+  // Handles led:on|off|status|toggle|blink, led:brightness:<0-100>, led:fade:<ms>
   void handleMessage(const std::string& message, std::function<void(const std::string&)> reply);
   
-  // Update LED state (call from main loop)
-  void update();
-  
   // Refresh state from serial input
   bool refreshFromSerial(const std::string& serialInput);
   
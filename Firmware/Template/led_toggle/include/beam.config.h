@@ -12,8 +12,13 @@
 #define BLE_NAME "BeamLink-LED"
 #define BLE_POWER_DBM 9
 #define BLE_ADV_INTERVAL_MS 100
+#define BLE_ADV_FAST_INTERVAL_MS 20
+#define BLE_ADV_FAST_MS 30000
+#define BLE_ADV_NORMAL_MS 60000
+#define BLE_ADV_SLOW_INTERVAL_MS 1285
 #define BLE_SERVICE_UUID "12345678-1234-1234-1234-1234567890ab"
 #define BLE_CHARACTERISTIC_UUID "12345678-1234-1234-1234-1234567890ac"
+#define BLE_STATE_STREAM_UUID "12345678-1234-1234-1234-1234567890ad"
 
 // WiFi Configuration
 #define WIFI_ENABLED false
@@ -32,16 +37,31 @@
 // Hardware Configuration
 #define LED_PIN 2
 #define LED_ACTIVE_HIGH true
+#define LED_BRIGHTNESS 100      // % while on ("led:brightness:<n>")
+#define LED_FADE_MS 0           // Ramp per change; >0 makes blinking breathe ("led:fade:<ms>")
+#define LED_BLINK_MS 1000       // Blink period (on, then off, half each)
 #define SENSOR_PINS "34,35"
-#define ACTUATOR_PINS "12,13,14"
+#define ACTUATOR_PINS "25,26,27"   // Not 12: it is a strapping pin (flash voltage)
 
 // Behavior Configuration
 #define REPORT_INTERVAL_MS 5000
+#define HEARTBEAT_MS 60000
 #define AUTO_RECONNECT true
 #define LOG_LEVEL "INFO"
 #define SERIAL_BAUD 115200
 #define DEBUG_MODE true
 
+// Power Management (needs CONFIG_PM_ENABLE in the SDK build)
+#define POWER_MANAGEMENT_ENABLED true
+#define POWER_MAX_FREQ_MHZ 240
+#define POWER_MIN_FREQ_MHZ 80
+#define POWER_LIGHT_SLEEP true
+#define POWER_LINGER_MS 50
+
+// State Broadcast (LED state in the scan response, readable without connecting)
+#define STATE_BROADCAST_ENABLED true
+#define STATE_BROADCAST_INTERVAL_MS 1000
+
 // Security Configuration
 #define AUTH_TOKEN ""
 #define ENCRYPTION_ENABLED false
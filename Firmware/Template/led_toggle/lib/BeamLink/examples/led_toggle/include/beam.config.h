@@ -33,7 +33,7 @@
 #define LED_PIN 2
 #define LED_ACTIVE_HIGH true
 #define SENSOR_PINS "34,35"
-#define ACTUATOR_PINS "12,13,14"
+#define ACTUATOR_PINS "25,26,27"   // Not 12: it is a strapping pin (flash voltage)
 
 // Behavior Configuration
 #define REPORT_INTERVAL_MS 5000
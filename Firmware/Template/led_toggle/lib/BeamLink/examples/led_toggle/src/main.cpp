@@ -1,35 +1,39 @@
 #include <Arduino.h>
 #include "BeamLink.h"
 #include "BeamLog.hpp"
+#include "BootSequence.h"
+#include "BeamScheduler.h"
+#include <algorithm>
 #include "beam.config.h"
 
 BeamLink beam;
 
-static unsigned long lastStatus = 0;
+// Heartbeat and other timers; loop() sleeps until the next one is due
+static BeamScheduler scheduler;
+
+static BootTimeline bootTimeline;
+static BootSequencer bootBlink;
 
 static void waitForSerial(unsigned long ms = 300) {
-  delay(ms); // gives USB CDC a moment so early prints aren't dropped
+#if ARDUINO_USB_CDC_ON_BOOT
+  // Native USB only: don't drop early prints, but don't wait for a host forever
+  while (!Serial && millis() < ms) {
+    delay(1);
+  }
+#else
+  (void)ms; // UART is ready as soon as begin() returns
+#endif
 }
 
 static void bootBlinkSequence() {
   LOG_INFO("Starting boot blink sequence...");
-  // Start ON
-  digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? HIGH : LOW);
-  delay(150);
-
-  // Blink a couple of times
+  // Blink a couple of times from the default ON, 150 ms per step, driven by loop()
   for (int i = 0; i < 2; i++) {
-    // OFF
-    digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? LOW : HIGH);
-    delay(150);
-    // ON
-    digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? HIGH : LOW);
-    delay(150);
+    bootBlink.then(150, [] { digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? LOW : HIGH); });
+    bootBlink.then(150, [] { digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? HIGH : LOW); });
   }
-
-  // Ensure final state is ON
-  digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? HIGH : LOW);
-  LOG_OK("Boot blink sequence completed (LED ON)");
+  bootBlink.then(0, [] { LOG_OK("Boot blink sequence completed (LED ON)"); });
+  bootBlink.start();
 }
 
 static bool ledIsOn() {
@@ -62,8 +66,10 @@ static void printStatus() {
 }
 
 void setup() {
+  bootTimeline.mark("setup");
   Serial.begin(SERIAL_BAUD);
   waitForSerial();
+  bootTimeline.mark("serial");
 
   LOG_INFO("BeamLink LED Toggle Example booting…");
 
@@ -76,9 +82,6 @@ void setup() {
   pinMode(LED_PIN, OUTPUT);
   digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? HIGH : LOW);  // default ON
   LOG_PIN("GPIO%d set as OUTPUT (default ON)", LED_PIN);
-  
-  // Boot blink sequence
-  bootBlinkSequence();
 
   // Start BLE
   const bool ok = beam.begin(
@@ -89,6 +92,8 @@ void setup() {
     BLE_CHARACTERISTIC_UUID
   );
 
+  bootTimeline.mark("ble");
+
   if (!ok) {
     LOG_ERR("BeamLink begin() failed — BLE not started");
     return;
@@ -104,6 +109,10 @@ void setup() {
   LOG_BLE("Advertising as %s", BLE_NAME);
   LOG_BLE("Service UUID (active): %s", BLE_SERVICE_UUID);
   LOG_BLE("Char    UUID (active): %s", BLE_CHARACTERISTIC_UUID);
+  bootTimeline.mark("advertising");
+
+  // Boot blink plays while the device is already discoverable
+  bootBlinkSequence();
 
   // Message handler (unchanged)
   beam.onMessage([&](const std::string& in, ReplyFn reply) {
@@ -144,17 +153,20 @@ void setup() {
   });
 
   LOG_OK("Ready. Commands: led:on, led:off, led:status, led:toggle, info");
+
+  // Heartbeat every 1 second
+  scheduler.every(1000, printStatus);
+  bootTimeline.mark("ready");
+  bootTimeline.report();
 }
 
 void loop() {
   beam.loop();
+  bootBlink.update();
+  scheduler.run();
 
-  // Heartbeat every 1 second
-  if (millis() - lastStatus >= 1000) {
-    printStatus();
-    lastStatus = millis();
-  }
-
-  delay(10);
+  // BLE commands are handled on the NimBLE task, so nothing else needs loop() in between
+  const uint32_t idleMs = std::min(scheduler.msUntilNext(), bootBlink.msUntilNext());
+  delay(idleMs == BeamScheduler::kNever ? 1000 : idleMs);
 }
 
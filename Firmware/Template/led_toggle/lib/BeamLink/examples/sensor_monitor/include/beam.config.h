@@ -14,6 +14,7 @@
 #define BLE_ADV_INTERVAL_MS 100
 #define BLE_SERVICE_UUID "12345678-1234-1234-1234-1234567890ab"
 #define BLE_CHARACTERISTIC_UUID "12345678-1234-1234-1234-1234567890ac"
+#define BLE_SAMPLES_STREAM_UUID "12345678-1234-1234-1234-1234567890ae"
 
 // WiFi Configuration
 #define WIFI_ENABLED false
@@ -33,10 +34,17 @@
 #define LED_PIN 2
 #define LED_ACTIVE_HIGH true
 #define SENSOR_PINS "34,35"
-#define ACTUATOR_PINS "12,13,14"
+#define ACTUATOR_PINS "25,26,27"   // Not 12: it is a strapping pin (flash voltage)
 
 // Behavior Configuration
 #define REPORT_INTERVAL_MS 5000
+#define SAMPLE_RATE_HZ 200
+#define SAMPLE_BATCH 32
+#define AGG_SLIDING_MS 60000   // Sliding statistics window ("agg:sliding")
+#define CAPTURE_RATE_HZ 0   // >0: continuous DMA capture per pin (e.g. 20000) instead of sampling
+#define SPECTRUM_BANDS 4    // Equal-width FFT bands from 0 to CAPTURE_RATE_HZ / 2 ("spectrum")
+#define REPORT_DEADBAND 8   // Auto-report a pin only when its mean moved more than this (counts)
+#define HEARTBEAT_MS 60000  // ...or when it has not been reported for this long
 #define AUTO_RECONNECT true
 #define LOG_LEVEL "INFO"
 #define SERIAL_BAUD 115200
@@ -49,5 +57,8 @@
 // Calibration Configuration
 #define SENSOR_GAIN 1.0f
 #define ZERO_OFFSET 0.02f
+#define FILTER_MEDIAN 3        // Median window: 1 (off), 3, 5, 7 or 9
+#define FILTER_AVERAGE 4       // Moving-average window: 1 (off) or a power of two up to 64
+#define FILTER_CUTOFF_HZ 0     // >0: low-pass biquad at this frequency
 
 #endif // BEAM_CONFIG_H
@@ -1,9 +1,119 @@
 #include <Arduino.h>
 #include "BeamLink.h"
 #include "BeamUtils.h"
+#include "BeamScheduler.h"
+#include "BeamSampler.h"
+#include "BeamAdcStream.h"
+#include "BeamAggregate.h"
+#include "BeamBatchCodec.h"
+#include "BeamDsp.h"
+#include "BeamSpectrum.h"
+#include "BeamReport.h"
+#include <atomic>
+#include <cstdio>
 #include "../include/beam.config.h"
 
 BeamLink beam;
+BeamScheduler scheduler;
+
+// SENSOR_PINS sampled at SAMPLE_RATE_HZ, sent in batches on the "samples" stream
+BeamAnalogAdc adc;
+BeamSampler sampler;
+static BeamStreamId samplesStream = kBeamNoStream;
+
+// Samples already aggregated but not yet sent (they did not fit a batch)
+static BeamSample unsent[BEAM_SAMPLER_MAX_CHANNELS][128];  // more than a 244-byte batch usually holds
+static size_t unsentCount[BEAM_SAMPLER_MAX_CHANNELS] = {};
+
+// With CAPTURE_RATE_HZ > 0 the pins are captured continuously by DMA instead
+BeamDmaAdc dma;
+BeamAdcStream capture;
+static uint16_t captureLatest[BEAM_SAMPLER_MAX_CHANNELS] = {};
+
+// Statistics per pin: one window per report interval, plus a sliding window
+BeamAggregator agg;
+
+// Spectral features of each captured block (continuous capture only); one
+// analyser serves every pin in turn
+BeamSpectrum spectrum;
+static BeamSpectrumFeatures spectrumLatest[BEAM_SAMPLER_MAX_CHANNELS];
+
+// Report by exception: a pin's window (or a simulated reading) is auto-reported
+// only when it moved more than its deadband, or HEARTBEAT_MS after the last time
+BeamReportFilter pinReports[BEAM_SAMPLER_MAX_CHANNELS];
+BeamReportFilter simReports[3];  // temperature, humidity, light
+static bool reportsFresh = false;
+
+// Commands that read or reset what loop() writes are answered by loop()
+static std::atomic<bool> aggRequested{false};
+static std::atomic<bool> slidingRequested{false};
+static std::atomic<bool> resetRequested{false};
+static std::atomic<bool> rawRequested{false};
+static std::atomic<bool> filteredRequested{false};
+static std::atomic<bool> spectrumRequested{false};
+static std::atomic<bool> reportRequested{false};
+
+void beginReports() {
+  BeamReportPolicy policy;
+  policy.deadband = REPORT_DEADBAND;
+  policy.heartbeatMs = HEARTBEAT_MS;
+  for (BeamReportFilter& f : pinReports) f.begin(policy);
+  const float simDeadband[3] = {0.5f, 2.0f, 32};  // °C, %, counts
+  for (int i = 0; i < 3; i++) {
+    policy.deadband = simDeadband[i];
+    simReports[i].begin(policy);
+  }
+}
+
+// Offer a new value; true if it is to be sent (changed enough, or heartbeat due)
+bool reportDue(BeamReportFilter& filter, float value) {
+  return filter.offer(value) || filter.update() == 0;
+}
+
+// Sent/offered over every filter
+BeamReportStats reportStats() {
+  BeamReportStats total;
+  for (const BeamReportFilter& f : pinReports) {
+    total.offered += f.stats().offered;
+    total.sent += f.stats().sent;
+    total.suppressed += f.stats().suppressed;
+    total.heartbeats += f.stats().heartbeats;
+  }
+  for (const BeamReportFilter& f : simReports) {
+    total.offered += f.stats().offered;
+    total.sent += f.stats().sent;
+    total.suppressed += f.stats().suppressed;
+    total.heartbeats += f.stats().heartbeats;
+  }
+  return total;
+}
+
+// Calibrated, filtered signal per pin (SENSOR_GAIN, ZERO_OFFSET, FILTER_*)
+BeamDspPipeline dsp[BEAM_SAMPLER_MAX_CHANNELS];
+static int16_t filteredLatest[BEAM_SAMPLER_MAX_CHANNELS] = {};
+
+void beginFilters(size_t channels, uint32_t rateHz) {
+  BeamDspPipeline::Config cfg;
+  cfg.calibration = BeamCalibration::from(SENSOR_GAIN, ZERO_OFFSET);
+  cfg.medianWindow = FILTER_MEDIAN;
+  cfg.averageWindow = FILTER_AVERAGE;
+  cfg.filterEnabled = FILTER_CUTOFF_HZ > 0;
+  if (cfg.filterEnabled) cfg.filter = BeamBiquad::lowPass(rateHz, FILTER_CUTOFF_HZ);
+  for (size_t ch = 0; ch < channels; ch++) {
+    if (!dsp[ch].begin(cfg)) log_err("Invalid FILTER_MEDIAN or FILTER_AVERAGE");
+  }
+}
+
+// Run raw values through the channel's filters, keeping the last output
+void filterValues(uint8_t ch, const uint16_t* values, size_t n) {
+  if (n == 0) return;
+  int16_t out[BEAM_ADC_BLOCK];
+  for (size_t offset = 0; offset < n; offset += BEAM_ADC_BLOCK) {
+    const size_t count = std::min<size_t>(n - offset, BEAM_ADC_BLOCK);
+    dsp[ch].process(values + offset, out, count);
+    filteredLatest[ch] = out[count - 1];
+  }
+}
 
 // Simulate sensor readings (replace with real sensors in production)
 float readTemperature() {
@@ -18,6 +128,188 @@ int readLightLevel() {
   return random(0, 1024); // 0-1023
 }
 
+// Pin the aggregator's channel ch belongs to
+uint8_t aggPin(uint8_t ch) {
+  return capture.isRunning() ? capture.pin(ch) : sampler.pin(ch);
+}
+
+// "34: n=1000 mean=1523.4 sd=12.1 min=1490 max=1560 ewma=1525.0"
+std::string formatWindow(uint8_t ch, const BeamWindow& w) {
+  char line[96];
+  snprintf(line, sizeof(line), "%u: n=%lu mean=%.1f sd=%.1f min=%.0f max=%.0f ewma=%.1f", aggPin(ch),
+           static_cast<unsigned long>(w.count), w.mean, w.stddev(), w.min, w.max, w.ewma);
+  return line;
+}
+
+// formatWindow() for every pin, separated by "; "
+std::string formatWindows(bool slidingWindow) {
+  std::string text;
+  for (uint8_t ch = 0; ch < agg.channelCount(); ch++) {
+    if (ch) text += "; ";
+    text += formatWindow(ch, slidingWindow ? agg.sliding(ch) : agg.last(ch));
+  }
+  return text;
+}
+
+// "34: rms=12.3 peak=120.5Hz/45.2 bands=1.2,3.4,5.6,7.8" per pin
+std::string formatSpectrum() {
+  std::string text;
+  char line[64];
+  for (uint8_t ch = 0; ch < capture.channelCount(); ch++) {
+    const BeamSpectrumFeatures& f = spectrumLatest[ch];
+    snprintf(line, sizeof(line), "%s%u: rms=%.1f peak=%.1fHz/%.1f bands=", ch ? "; " : "", capture.pin(ch), f.rms,
+             f.peakHz, f.peakAmplitude);
+    text += line;
+    for (uint8_t b = 0; b < f.bands; b++) {
+      snprintf(line, sizeof(line), "%s%.1f", b ? "," : "", f.bandEnergy[b]);
+      text += line;
+    }
+  }
+  return text;
+}
+
+// Auto-report every configured interval: the windows that just closed, not
+// raw values, and only those that changed meaningfully
+void sendAutoReading() {
+  if (!beam.isConnected()) {
+    reportsFresh = false;
+    return;
+  }
+  if (!reportsFresh) {
+    beginReports();  // a new central has seen nothing yet
+    reportsFresh = true;
+  }
+  agg.advanceTo(micros());
+  std::string data;
+  if (agg.channelCount()) {
+    for (uint8_t ch = 0; ch < agg.channelCount(); ch++) {
+      const BeamWindow w = agg.last(ch);
+      if (!reportDue(pinReports[ch], w.mean)) continue;
+      if (!data.empty()) data += "; ";
+      data += formatWindow(ch, w);
+    }
+    if (!data.empty() && spectrum.size()) data += " | " + formatSpectrum();
+  } else {
+    auto append = [&data](const std::string& item) { data += (data.empty() ? "" : ", ") + item; };
+    const float temp = readTemperature(), hum = readHumidity();
+    const int light = readLightLevel();
+    if (reportDue(simReports[0], temp)) append("Temp=" + std::to_string(temp) + "°C");
+    if (reportDue(simReports[1], hum)) append("Hum=" + std::to_string(hum) + "%");
+    if (reportDue(simReports[2], light)) append("Light=" + std::to_string(light));
+  }
+  if (data.empty()) return;  // nothing the central does not know
+  beam.notify("📊 Auto: " + data);
+  log_heartbeat("Auto-sensor data sent");
+}
+
+// Aggregate the queued samples of every pin that has SAMPLE_BATCH of them
+// (every pin with flush); send them too, delta-encoded in MTU-sized batches,
+// while someone is subscribed
+void drainSamples(bool flush) {
+  const bool subscribed = beam.isSubscribed(samplesStream);
+  // Negotiated MTU: a larger batch would be cut by NimBLE and not decode
+  const size_t capacity = std::min<size_t>(beam.getMTU() - 3, 244);
+  uint8_t batch[244];
+  uint16_t values[128];
+
+  for (uint8_t ch = 0; ch < sampler.channelCount(); ch++) {
+    BeamSample* samples = unsent[ch];
+    size_t& pending = unsentCount[ch];
+    if (!subscribed) pending = 0;
+    if (!flush && pending + sampler.available(ch) < SAMPLE_BATCH) continue;
+    for (;;) {
+      const size_t n = sampler.read(ch, samples + pending, 128 - pending);
+      agg.add(ch, samples + pending, n);
+      for (size_t i = 0; i < n; i++) values[i] = samples[pending + i].value;
+      filterValues(ch, values, n);
+      if (!subscribed) {
+        if (n == 0) break;
+        continue;
+      }
+      pending += n;
+      if (pending == 0) break;
+
+      // Samples that did not fit go first into the next batch
+      size_t sent = 0;
+      const size_t size = beamEncodeBatch(ch, samples, pending, batch, capacity, kBeamBatchDelta, sent);
+      if (size == 0) break;  // kept for the next pass
+      beam.notify(samplesStream, batch, size);
+      std::copy(samples + sent, samples + pending, samples);
+      pending -= sent;
+    }
+  }
+}
+
+// Take every finished capture block; analysis hooks in here
+void processBlocks() {
+  while (const BeamAdcBlock* block = capture.next()) {
+    for (uint8_t ch = 0; ch < block->channels; ch++) {
+      if (!block->count[ch]) continue;
+      captureLatest[ch] = block->values[ch][block->count[ch] - 1];
+      agg.add(ch, block->values[ch], block->count[ch], block->firstUs, capture.rateHz());
+      filterValues(ch, block->values[ch], block->count[ch]);
+      if (spectrum.size() && spectrum.analyze(block->values[ch], block->count[ch])) {
+        spectrumLatest[ch] = spectrum.features();
+      }
+    }
+  }
+  capture.release();
+}
+
+// Latest raw (or filtered) value per pin, from whichever engine runs
+std::string latestValues(bool filtered) {
+  std::string raw;
+  const bool continuous = capture.isRunning();
+  const uint8_t channels = continuous ? capture.channelCount() : sampler.channelCount();
+  for (uint8_t ch = 0; ch < channels; ch++) {
+    if (ch) raw += ",";
+    raw += std::to_string(continuous ? capture.pin(ch) : sampler.pin(ch)) + "=";
+    if (filtered) {
+      raw += std::to_string(filteredLatest[ch]);
+    } else {
+      raw += std::to_string(continuous ? captureLatest[ch] : sampler.latest(ch));
+    }
+  }
+  return raw;
+}
+
+// Answer the commands onMessage() left to loop()
+void serveRequests() {
+  if (aggRequested.exchange(false)) {
+    beam.notify(agg.channelCount() ? formatWindows(false) : "Sampler not running");
+  }
+  if (slidingRequested.exchange(false)) {
+    beam.notify(agg.channelCount() ? formatWindows(true) : "Sampler not running");
+  }
+  if (resetRequested.exchange(false)) {
+    beam.resetStats();
+    sampler.resetStats();
+    capture.resetStats();
+    for (BeamReportFilter& f : pinReports) f.resetStats();
+    for (BeamReportFilter& f : simReports) f.resetStats();
+    beam.notify("Statistics reset");
+  }
+  if (rawRequested.exchange(false)) {
+    const std::string values = latestValues(false);
+    beam.notify(values.empty() ? "Sampler not running" : values);
+  }
+  if (filteredRequested.exchange(false)) {
+    const std::string values = latestValues(true);
+    beam.notify(values.empty() ? "Sampler not running" : values);
+  }
+  if (spectrumRequested.exchange(false)) {
+    beam.notify(spectrum.size() ? formatSpectrum() : "Spectrum needs continuous capture (CAPTURE_RATE_HZ)");
+  }
+  if (reportRequested.exchange(false)) {
+    const BeamReportStats s = reportStats();
+    char text[96];
+    snprintf(text, sizeof(text), "Report: %lu sent of %lu (%.1fx less), %lu suppressed, %lu heartbeats",
+             static_cast<unsigned long>(s.sent), static_cast<unsigned long>(s.offered), s.reduction(),
+             static_cast<unsigned long>(s.suppressed), static_cast<unsigned long>(s.heartbeats));
+    beam.notify(text);
+  }
+}
+
 void setup() {
   // Initialize serial
   Serial.begin(SERIAL_BAUD);
@@ -25,6 +317,9 @@ void setup() {
   log_info("BeamLink Sensor Monitor Starting...");
   log_config("Device: " + String(DEVICE_NAME) + " (" + String(DEVICE_ID) + ")");
   
+  // Streams are part of the GATT table: declare them before begin()
+  samplesStream = beam.addStream("samples", BLE_SAMPLES_STREAM_UUID);
+
   // Initialize BeamLink BLE with constants
   if (!beam.begin(BLE_NAME, BLE_POWER_DBM, BLE_ADV_INTERVAL_MS,
                   BLE_SERVICE_UUID, BLE_CHARACTERISTIC_UUID)) {
@@ -33,6 +328,40 @@ void setup() {
   }
   
   log_ble("BLE initialized successfully");
+
+  uint8_t pins[BEAM_SAMPLER_MAX_CHANNELS];
+  const size_t pinCount = beamParsePins(SENSOR_PINS, pins, BEAM_SAMPLER_MAX_CHANNELS);
+  if (CAPTURE_RATE_HZ > 0) {
+    capture.onBlock([] { beam.signalEvent(BEAM_EVENT_USER); });
+    if (capture.begin(dma, pins, pinCount, CAPTURE_RATE_HZ) && capture.start()) {
+      log_sensor("Capturing " + String(pinCount) + " pins at " + String(CAPTURE_RATE_HZ) + " Hz (DMA)");
+      BeamSpectrum::Config spectrumConfig;
+      spectrumConfig.size = BEAM_ADC_BLOCK;  // one FFT per block
+      spectrumConfig.rateHz = CAPTURE_RATE_HZ;
+      spectrumConfig.bands = SPECTRUM_BANDS;
+      spectrum.begin(spectrumConfig);
+    } else {
+      log_err("Continuous capture failed; check SENSOR_PINS (ADC1 only) and CAPTURE_RATE_HZ");
+    }
+  } else if (sampler.begin(adc, pins, pinCount, SAMPLE_RATE_HZ)) {
+    // Wake loop() once a batch is worth sending
+    sampler.onBatchReady(SAMPLE_BATCH, [] { beam.signalEvent(BEAM_EVENT_USER); });
+    // ...but not each time a notification leaves, which would drain again
+    beam.setWakeEvents(BEAM_EVENT_ALL & ~BEAM_EVENT_TX_DONE);
+    sampler.start();
+    log_sensor("Sampling " + String(pinCount) + " pins at " + String(SAMPLE_RATE_HZ) + " Hz");
+  } else {
+    log_err("Invalid SENSOR_PINS: " + String(SENSOR_PINS));
+  }
+
+  if (pinCount > 0) {
+    beginFilters(pinCount, CAPTURE_RATE_HZ > 0 ? CAPTURE_RATE_HZ : SAMPLE_RATE_HZ);
+
+    BeamAggregator::Config aggConfig;
+    aggConfig.windowUs = REPORT_INTERVAL_MS * 1000UL;
+    aggConfig.slidingUs = AGG_SLIDING_MS * 1000UL;
+    agg.begin(pinCount, aggConfig);
+  }
   
   // Set up comprehensive message handler
   beam.onMessage([](const std::string& msg, ReplyFn reply) {
@@ -42,7 +371,7 @@ void setup() {
     
     // Handle simple commands
     if (msg == "help") {
-      reply("Commands: temp, humidity, light, stats, all, uptime, reset, help");
+      reply("Commands: temp, humidity, light, samples, capture, spectrum, agg, report, stats, all, uptime, reset, help");
       log_info("Help requested");
     }
     else if (msg == "temp") {
@@ -78,13 +407,39 @@ void setup() {
       reply(stats);
       log_info("Statistics requested");
     }
+    else if (msg == "samples") {
+      const BeamSamplerStats s = sampler.stats();
+      const BeamStreamStats tx = beam.getStreamStats(samplesStream);
+      reply("Samples: " + std::to_string(s.samples) + " @" + std::to_string(sampler.rateHz()) +
+            "Hz, overruns=" + std::to_string(s.overruns) + ", late=" + std::to_string(s.lateTicks) +
+            " (max " + std::to_string(s.maxLatenessUs) + "us), batches=" + std::to_string(tx.sent));
+      log_sensor("Sampler statistics requested");
+    }
+    else if (msg == "capture") {
+      const BeamAdcStreamStats s = capture.stats();
+      reply("Capture: " + std::to_string(s.sustainedHz) + "/" + std::to_string(capture.rateHz()) +
+            " Hz sustained, blocks=" + std::to_string(s.blocks) + ", dropped=" + std::to_string(s.dropped) +
+            ", overflows=" + std::to_string(s.driverOverflows));
+      log_sensor("Capture statistics requested");
+    }
+    else if (msg == "spectrum") {
+      spectrumRequested = true;
+      log_sensor("Spectral features requested");
+    }
+    else if (msg == "agg") {
+      aggRequested = true;
+      log_sensor("Aggregated window requested");
+    }
+    else if (msg == "report") {
+      reportRequested = true;
+      log_info("Report statistics requested");
+    }
     else if (msg == "uptime") {
       reply("Uptime: " + formatUptime(beam.getUptime()));
       log_info("Uptime requested");
     }
     else if (msg == "reset") {
-      beam.resetStats();
-      reply("Statistics reset");
+      resetRequested = true;
       log_info("Statistics reset");
     }
     else if (msg == "mtu") {
@@ -110,6 +465,14 @@ void setup() {
           }
           log_config("Config query: " + String(cmd.c_str()) + ":" + String(action.c_str()));
         }
+        else if (cmd == "agg") {
+          if (action == "sliding") {
+            slidingRequested = true;
+          } else {
+            reply("Unknown window: " + action);
+          }
+          log_sensor("Aggregate query: " + String(action.c_str()));
+        }
         else if (cmd == "get") {
           if (action == "temp") {
             reply(std::to_string(readTemperature()));
@@ -117,6 +480,10 @@ void setup() {
             reply(std::to_string(readHumidity()));
           } else if (action == "light") {
             reply(std::to_string(readLightLevel()));
+          } else if (action == "raw") {
+            rawRequested = true;
+          } else if (action == "filtered") {
+            filteredRequested = true;
           } else {
             reply("Unknown sensor: " + action);
           }
@@ -144,25 +511,22 @@ void setup() {
   });
   
   log_success("Sensor Monitor Ready!");
-  log_info("Available commands: temp, humidity, light, all, stats, uptime, reset, help");
+  log_info("Available commands: temp, humidity, light, samples, capture, spectrum, agg, report, all, stats, uptime, reset, help");
+
+  scheduler.every(REPORT_INTERVAL_MS, sendAutoReading);
 }
 
 void loop() {
   beam.loop();
-  
-  // Optional: Auto-send sensor readings every configured interval
-  static unsigned long lastSend = 0;
-  unsigned long now = millis();
-  
-  if (beam.isConnected() && (now - lastSend > REPORT_INTERVAL_MS)) {
-    std::string data = "📊 Auto: Temp=" + std::to_string(readTemperature()) + "°C";
-    data += ", Hum=" + std::to_string(readHumidity()) + "%";
-    data += ", Light=" + std::to_string(readLightLevel());
-    beam.notify(data);
-    log_heartbeat("Auto-sensor data sent");
-    lastSend = now;
-  }
-  
-  delay(10);
+  // Aggregate what was sampled first, everything when a report is due, so
+  // it covers its whole window
+  drainSamples(scheduler.msUntilNext() == 0);
+  processBlocks();
+  scheduler.run();
+  serveRequests();
+
+  // Most commands are answered on the NimBLE task; loop() sleeps until a
+  // timer is due, a batch or block is ready (BEAM_EVENT_USER) or BLE activity
+  beam.waitForEvent(scheduler.msUntilNext());
 }
 
@@ -0,0 +1,301 @@
+#pragma once
+#include "BeamSampler.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#if defined(ARDUINO) && defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+struct BeamConfig;
+
+/**
+ * @file BeamAdcStream.h
+ * @brief Continuous ADC capture into double-buffered blocks
+ *
+ * BeamSampler calls analogRead() once per channel per tick, a few tens of
+ * microseconds of CPU each, which limits it to a few kHz. In continuous mode
+ * the ESP32's ADC digital controller converts the pins on its own and DMA
+ * writes the results to memory. The CPU only runs when a frame is complete:
+ * an acquisition task sorts the frame into per-channel arrays and hands out
+ * whole blocks.
+ *
+ * Two blocks alternate: the task fills one while the consumer (loop(), the
+ * calibration and analysis code) works on the other. If the consumer is
+ * still busy when the next block completes, a block is dropped and counted.
+ * The driver's own overflows are counted separately.
+ *
+ * The source behind the stream is a BeamAdcSource: BeamDmaAdc on ESP32,
+ * BeamSimDmaAdc (BeamSimAdc signals, virtual or real time) on the host.
+ *
+ * @example
+ * ```cpp
+ * BeamDmaAdc dma;
+ * BeamAdcStream capture;
+ *
+ * void setup() {
+ *   capture.begin(dma, beamConfig, 20000);   // SENSOR_PINS, 20 kHz each
+ *   capture.onBlock([] { beam.signalEvent(BEAM_EVENT_USER); });
+ *   capture.start();
+ * }
+ *
+ * void loop() {
+ *   while (const BeamAdcBlock* block = capture.next()) {
+ *     analyse(block->values[0], block->count[0]);
+ *   }
+ *   capture.release();
+ *   beam.waitForEvent();
+ * }
+ * ```
+ */
+
+/// Samples per channel in one block
+#ifndef BEAM_ADC_BLOCK
+#define BEAM_ADC_BLOCK 256
+#endif
+
+/// Conversions per DMA frame (all channels)
+#ifndef BEAM_ADC_FRAME
+#define BEAM_ADC_FRAME 256
+#endif
+
+/**
+ * @brief One conversion from a continuous source
+ */
+struct BeamAdcConversion {
+  uint8_t channel;  ///< Index into the pins given to begin()
+  uint16_t value;   ///< Raw counts
+};
+
+/**
+ * @brief Samples of all channels over one block period
+ */
+struct BeamAdcBlock {
+  uint32_t sequence = 0;  ///< Block number; a gap means blocks were dropped
+  uint32_t firstUs = 0;   ///< Estimated time of the first sample
+  uint8_t channels = 0;
+  uint16_t count[BEAM_SAMPLER_MAX_CHANNELS] = {};  ///< Samples per channel
+  uint16_t values[BEAM_SAMPLER_MAX_CHANNELS][BEAM_ADC_BLOCK];
+};
+
+/**
+ * @brief A converter that runs on its own and delivers frames
+ */
+class BeamAdcSource {
+public:
+  virtual ~BeamAdcSource() = default;
+
+  /**
+   * @param rateHz Conversions per second per channel
+   */
+  virtual bool begin(const uint8_t* pins, size_t count, uint32_t rateHz) = 0;
+  virtual bool start() = 0;
+  virtual void stop() = 0;
+
+  /**
+   * @brief Wait for the next frame (acquisition task only)
+   * @param endUs Set to the time the frame completed
+   * @return Conversions stored; 0 on timeout
+   */
+  virtual size_t read(BeamAdcConversion* out, size_t max, uint32_t timeoutMs, uint32_t& endUs) = 0;
+
+  /// Frames the driver lost because they were not read in time
+  virtual uint32_t overflows() const { return 0; }
+};
+
+/**
+ * @brief ADC1 channel of an ESP32 GPIO (32-39), or -1
+ *
+ * Continuous mode only drives ADC1.
+ */
+int beamAdc1Channel(uint8_t pin);
+
+#if defined(ARDUINO) && defined(ESP32)
+/**
+ * @brief ESP32 ADC1 digital controller with DMA (11 dB, 12 bit)
+ *
+ * Uses adc_continuous on ESP-IDF 5 and adc_digi on 4.4. The controller
+ * needs at least 20 kHz in total across all channels.
+ */
+class BeamDmaAdc : public BeamAdcSource {
+public:
+  ~BeamDmaAdc() override;
+
+  bool begin(const uint8_t* pins, size_t count, uint32_t rateHz) override;
+  bool start() override;
+  void stop() override;
+  size_t read(BeamAdcConversion* out, size_t max, uint32_t timeoutMs, uint32_t& endUs) override;
+  uint32_t overflows() const override { return overflowCount.load(std::memory_order_relaxed); }
+
+private:
+  int8_t channelIndex[8] = {-1, -1, -1, -1, -1, -1, -1, -1};  ///< ADC1 channel -> pin index
+  uint8_t raw[BEAM_ADC_FRAME * 2];
+  void* handle = nullptr;
+  bool initialized = false;
+  bool running = false;
+  std::atomic<uint32_t> overflowCount{0};
+
+  void release();
+  friend struct BeamDmaAdcCallbacks;
+};
+#endif
+
+/**
+ * @brief Simulated continuous source: BeamSimAdc signals, frame by frame
+ *
+ * In virtual time (default) read() returns the next frame at once and
+ * advances its own clock, so tests are exact and fast. In real time it
+ * sleeps until the frame would complete, like the DMA does.
+ */
+class BeamSimDmaAdc : public BeamAdcSource {
+public:
+  void setSignal(uint8_t channel, const BeamSimAdc::Signal& signal) { signals.setSignal(channel, signal); }
+  void setRealTime(bool enabled) { realTime = enabled; }
+
+  /// Conversions per frame, at most BEAM_ADC_FRAME
+  void setFrameSize(size_t conversions);
+
+  bool begin(const uint8_t* pins, size_t count, uint32_t rateHz) override;
+  bool start() override;
+  void stop() override { started = false; }
+  size_t read(BeamAdcConversion* out, size_t max, uint32_t timeoutMs, uint32_t& endUs) override;
+
+private:
+  BeamSimAdc signals;
+  uint8_t channels = 0;
+  uint32_t periodNs = 0;   ///< Between conversions of one channel
+  size_t frameSize = BEAM_ADC_FRAME;
+  uint64_t clockNs = 0;
+  uint8_t nextChannel = 0;
+  bool realTime = false;
+  bool started = false;
+};
+
+/**
+ * @brief Capture counters (see BeamAdcStream::stats())
+ */
+struct BeamAdcStreamStats {
+  uint32_t conversions = 0;      ///< Values read from the source
+  uint32_t blocks = 0;           ///< Blocks filled
+  uint32_t dropped = 0;          ///< Blocks lost because the consumer was still busy
+  uint32_t driverOverflows = 0;  ///< Frames lost inside the ADC driver
+  uint32_t sustainedHz = 0;      ///< Measured conversions per second per channel
+};
+
+class BeamAdcStream {
+public:
+  using BlockFn = std::function<void()>;
+
+  BeamAdcStream() = default;
+  ~BeamAdcStream();
+
+  BeamAdcStream(const BeamAdcStream&) = delete;
+  BeamAdcStream& operator=(const BeamAdcStream&) = delete;
+
+  /**
+   * @brief Configure the source; nothing is captured until start()
+   * @param rateHz Conversions per second per channel
+   * @param blockSamples Samples per channel per block, 1 to BEAM_ADC_BLOCK
+   * @return false on invalid input or if the source refuses the pins/rate
+   */
+  bool begin(BeamAdcSource& source, const uint8_t* pins, size_t count, uint32_t rateHz,
+             size_t blockSamples = BEAM_ADC_BLOCK);
+
+  /**
+   * @brief begin() with the pins in BeamConfig::sensorPins
+   */
+  bool begin(BeamAdcSource& source, const BeamConfig& cfg, uint32_t rateHz,
+             size_t blockSamples = BEAM_ADC_BLOCK);
+
+  /**
+   * @brief Call fn from the acquisition task when a block is ready
+   *
+   * Set before start(); fn must be short, e.g. BeamLink::signalEvent().
+   */
+  void onBlock(BlockFn fn) { blockReady = std::move(fn); }
+
+  /**
+   * @brief Start the source and the acquisition task
+   */
+  bool start();
+
+  void stop();
+
+  bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Read one frame from the source and sort it into blocks
+   *
+   * What the acquisition task runs. Call directly to drive the stream by
+   * hand (tests), never while start() is active.
+   * @return Conversions read
+   */
+  size_t pump(uint32_t timeoutMs = 0);
+
+  /**
+   * @brief Release the block returned last and take the next ready one
+   *        (consumer task only)
+   * @return nullptr if no block is ready
+   */
+  const BeamAdcBlock* next();
+
+  /// Give back the block returned by next() without taking another
+  void release();
+
+  uint8_t channelCount() const { return channels; }
+  uint8_t pin(uint8_t channel) const { return channel < channels ? pins[channel] : 0; }
+  uint32_t rateHz() const { return rate; }
+  size_t blockSamples() const { return blockSize; }
+
+  BeamAdcStreamStats stats() const;
+
+  /// Reset the counters (while stopped, or from the consumer with a small race)
+  void resetStats();
+
+private:
+  enum : uint8_t { kFree, kReady, kReading };
+
+  BeamAdcSource* source = nullptr;
+  uint8_t pins[BEAM_SAMPLER_MAX_CHANNELS] = {};
+  uint8_t channels = 0;
+  uint32_t rate = 0;
+  size_t blockSize = BEAM_ADC_BLOCK;
+  BlockFn blockReady;
+
+  BeamAdcBlock blocks[2];
+  std::atomic<uint8_t> state[2] = {{kFree}, {kFree}};
+  uint8_t writing = 0;   ///< Producer's block
+  int8_t reading = -1;   ///< Consumer's block
+  uint8_t lastTaken = 1;
+  bool blockStarted = false;
+  uint8_t fullChannels = 0;
+  uint32_t sequence = 0;
+  BeamAdcConversion frame[BEAM_ADC_FRAME];
+
+  // Written by the acquisition task, read by stats()
+  std::atomic<uint32_t> conversions{0};
+  std::atomic<uint32_t> filled{0};
+  std::atomic<uint32_t> dropped{0};
+  std::atomic<uint32_t> firstUs{0};
+  std::atomic<uint32_t> lastUs{0};
+  std::atomic<bool> timed{false};
+  uint32_t overflowBase = 0;
+
+  std::atomic<bool> running{false};
+
+  void publish();
+
+#if defined(ARDUINO) && defined(ESP32)
+  TaskHandle_t task = nullptr;
+  SemaphoreHandle_t finished = nullptr;
+  static void taskEntry(void* arg);
+#else
+  std::thread worker;
+#endif
+};
@@ -0,0 +1,121 @@
+#pragma once
+#include "BeamPlatform.h"
+#include <cstdint>
+
+struct BeamConfig;
+
+/**
+ * @file BeamAdvertising.h
+ * @brief Advertising schedule: a fast discovery burst that backs off
+ *
+ * After boot, a disconnect or restart() the device advertises every
+ * fastIntervalMs for fastMs, then at intervalMs (BLE_ADV_INTERVAL_MS) for
+ * normalMs, and finally at slowIntervalMs until something restarts the
+ * schedule. A zero duration skips that phase. While a client is connected
+ * the schedule is Off.
+ *
+ * The schedule only decides intervals and keeps time per phase; BeamLink
+ * applies them to the radio. Not thread-safe: BeamLink guards it.
+ */
+
+/**
+ * @brief Schedule phases, in the order they run
+ */
+enum class BeamAdvPhase : uint8_t {
+  Fast = 0,
+  Normal,
+  Slow,
+  Off,  ///< Connected or stopped
+};
+
+constexpr uint8_t kBeamAdvPhases = 4;
+
+/**
+ * @brief Intervals and phase lengths (see BLE_ADV_* in beam.config)
+ */
+struct BeamAdvSteps {
+  uint16_t fastIntervalMs = 20;    ///< BLE_ADV_FAST_INTERVAL_MS
+  uint32_t fastMs = 30000;         ///< BLE_ADV_FAST_MS; 0 skips the burst
+  uint16_t intervalMs = 100;       ///< BLE_ADV_INTERVAL_MS
+  uint32_t normalMs = 60000;       ///< BLE_ADV_NORMAL_MS; 0 goes straight to slow
+  uint16_t slowIntervalMs = 1285;  ///< BLE_ADV_SLOW_INTERVAL_MS
+
+  bool operator==(const BeamAdvSteps& o) const {
+    return fastIntervalMs == o.fastIntervalMs && fastMs == o.fastMs && intervalMs == o.intervalMs &&
+           normalMs == o.normalMs && slowIntervalMs == o.slowIntervalMs;
+  }
+  bool operator!=(const BeamAdvSteps& o) const { return !(*this == o); }
+};
+
+/**
+ * @brief Schedule settings from a runtime configuration
+ */
+BeamAdvSteps beamAdvSteps(const BeamConfig& cfg);
+
+/**
+ * @brief Time per phase and restart counters
+ */
+struct BeamAdvStats {
+  uint32_t timeMs[kBeamAdvPhases] = {};  ///< Indexed by BeamAdvPhase
+  uint32_t restarts = 0;                 ///< restart() calls (boot, disconnect, app)
+  uint32_t steps = 0;                    ///< Fast -> Normal -> Slow transitions
+
+  uint32_t totalMs() const { return timeMs[0] + timeMs[1] + timeMs[2] + timeMs[3]; }
+};
+
+const char* beamAdvPhaseName(BeamAdvPhase phase);
+
+class BeamAdvSchedule {
+public:
+  static constexpr uint32_t kNever = UINT32_MAX;
+
+  explicit BeamAdvSchedule(uint32_t nowMs = millis());
+
+  /**
+   * @brief Replace the settings; the current phase keeps its start time
+   */
+  void configure(const BeamAdvSteps& steps);
+
+  const BeamAdvSteps& steps() const { return settings; }
+
+  /**
+   * @brief Start over with the fast burst (or the first phase not skipped)
+   */
+  void restart(uint32_t nowMs = millis());
+
+  /**
+   * @brief Enter Off, e.g. when a client connects
+   */
+  void stop(uint32_t nowMs = millis());
+
+  /**
+   * @brief Step past phases whose time is up
+   * @return true if the phase changed; apply intervalMs() to the radio
+   */
+  bool update(uint32_t nowMs = millis());
+
+  BeamAdvPhase phase() const { return current; }
+
+  /// Interval for the current phase; 0 while Off
+  uint32_t intervalMs() const;
+
+  /// Milliseconds until update() changes phase, or kNever
+  uint32_t msUntilNext(uint32_t nowMs = millis()) const;
+
+  /**
+   * @brief Counters since construction or resetStats(), including the current phase
+   */
+  BeamAdvStats stats(uint32_t nowMs = millis()) const;
+
+  void resetStats(uint32_t nowMs = millis());
+
+private:
+  BeamAdvSteps settings;
+  BeamAdvPhase current = BeamAdvPhase::Off;
+  uint32_t phaseStartMs;
+  uint32_t sinceMs;
+  BeamAdvStats counters;
+
+  uint32_t durationMs(BeamAdvPhase phase) const;
+  void enter(BeamAdvPhase phase, uint32_t nowMs);
+};
@@ -0,0 +1,463 @@
+#pragma once
+#include "BeamSampler.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * @file BeamAggregate.h
+ * @brief Windowed statistics per sensor, in constant memory
+ *
+ * Instead of pulling raw samples to average them elsewhere, a central asks
+ * for (or is sent) summaries: count, min, max, mean, variance and an EWMA
+ * per window. Nothing here grows with the number of samples:
+ *
+ * - Accumulators keep sums, not values, and merge exactly. BeamAccumulator
+ *   is the fixed-point path for raw ADC counts (integer sums, floats only
+ *   when a window is read); BeamFloatAccumulator (Welford) takes any float.
+ * - BeamTumblingWindow closes back-to-back windows of a fixed length and
+ *   reports each one.
+ * - BeamSlidingWindow covers the last N microseconds as a ring of panes
+ *   (sub-windows); it moves one pane at a time.
+ * - BeamAggregator bundles both, plus an EWMA, for each sampled channel.
+ *
+ * Windows follow sample timestamps, so the same code handles BeamSampler
+ * output (one timestamp per sample) and BeamAdcStream blocks (first
+ * timestamp plus rate).
+ *
+ * @example
+ * ```cpp
+ * BeamAggregator agg;
+ * agg.begin(2, {1000000, 10000000, 4});   // 1 s tumbling, 10 s sliding
+ * agg.onWindow([](uint8_t ch, const BeamWindow& w) { report(ch, w); });
+ *
+ * // loop(): feed whatever was sampled
+ * n = sampler.read(ch, samples, 64);
+ * agg.add(ch, samples, n);
+ * ```
+ */
+
+/**
+ * @brief Statistics of one window
+ */
+struct BeamWindow {
+  uint32_t startUs = 0;  ///< First microsecond covered
+  uint32_t endUs = 0;    ///< End of the window (exclusive)
+  uint32_t count = 0;    ///< Samples
+  float min = 0;
+  float max = 0;
+  float mean = 0;
+  float variance = 0;    ///< Population variance
+  float ewma = 0;        ///< Set by BeamAggregator: EWMA at the end of the window
+
+  float stddev() const { return std::sqrt(variance); }
+};
+
+/**
+ * @brief Fixed-point accumulator for raw ADC counts
+ *
+ * Sums in integers, so a window of any length is exact and adding a sample
+ * is a few integer operations, with no float on the sampling path.
+ */
+class BeamAccumulator {
+public:
+  using Value = uint16_t;
+
+  void clear() { *this = BeamAccumulator{}; }
+
+  void add(uint16_t value) {
+    const uint32_t v = value;
+    n++;
+    sum += v;
+    sumSq += v * v;
+    if (value < lo) lo = value;
+    if (value > hi) hi = value;
+  }
+
+  /// Add a run of samples (block path: 32-bit partial sums)
+  void add(const uint16_t* values, size_t count);
+
+  /// Combine with another window's accumulator; exact
+  void merge(const BeamAccumulator& other);
+
+  uint32_t count() const { return n; }
+
+  /// Fill count, min, max, mean and variance of w
+  void result(BeamWindow& w) const;
+
+private:
+  uint32_t n = 0;
+  uint16_t lo = UINT16_MAX;
+  uint16_t hi = 0;
+  uint64_t sum = 0;
+  uint64_t sumSq = 0;
+};
+
+/**
+ * @brief Float accumulator (Welford), for calibrated or derived values
+ */
+class BeamFloatAccumulator {
+public:
+  using Value = float;
+
+  void clear() { *this = BeamFloatAccumulator{}; }
+
+  void add(float value) {
+    n++;
+    const float delta = value - runMean;
+    runMean += delta / n;
+    m2 += delta * (value - runMean);
+    if (value < lo) lo = value;
+    if (value > hi) hi = value;
+  }
+
+  void add(const float* values, size_t count) {
+    for (size_t i = 0; i < count; i++) add(values[i]);
+  }
+
+  /// Combine with another window's accumulator (Chan et al.)
+  void merge(const BeamFloatAccumulator& other);
+
+  uint32_t count() const { return n; }
+  void result(BeamWindow& w) const;
+
+private:
+  uint32_t n = 0;
+  float runMean = 0;
+  float m2 = 0;
+  float lo = INFINITY;
+  float hi = -INFINITY;
+};
+
+/**
+ * @brief Fixed-point EWMA of ADC counts, alpha = 1 / 2^shift
+ *
+ * Q16 state: one subtract, one shift and one add per sample.
+ */
+class BeamEwma {
+public:
+  explicit BeamEwma(uint8_t shift = 4) : k(shift > 15 ? 15 : shift) {}
+
+  void add(uint16_t value) {
+    const int32_t x = static_cast<int32_t>(value) << 16;
+    state = primed ? state + ((x - state) >> k) : x;
+    primed = true;
+  }
+
+  void setShift(uint8_t shift) { k = shift > 15 ? 15 : shift; }
+  void reset() { primed = false; state = 0; }
+  bool hasValue() const { return primed; }
+  float value() const { return state / 65536.0f; }
+
+private:
+  int32_t state = 0;
+  uint8_t k;
+  bool primed = false;
+};
+
+/**
+ * @brief Float EWMA, for values BeamEwma cannot hold
+ */
+class BeamFloatEwma {
+public:
+  explicit BeamFloatEwma(float alpha = 0.0625f) : a(alpha) {}
+
+  void add(float value) {
+    state = primed ? state + a * (value - state) : value;
+    primed = true;
+  }
+
+  void reset() { primed = false; state = 0; }
+  bool hasValue() const { return primed; }
+  float value() const { return state; }
+
+private:
+  float state = 0;
+  float a;
+  bool primed = false;
+};
+
+/// Microseconds from the first sample of a run to sample i, at rateHz
+inline uint32_t beamSampleOffsetUs(size_t i, uint32_t rateHz) {
+  return static_cast<uint32_t>(static_cast<uint64_t>(i) * 1000000u / rateHz);
+}
+
+/// Index of the first sample of a run at or after relUs from its start
+inline size_t beamSampleIndexAt(uint32_t relUs, uint32_t rateHz) {
+  return static_cast<size_t>((static_cast<uint64_t>(relUs) * rateHz + 999999u) / 1000000u);
+}
+
+/**
+ * @brief Back-to-back windows of a fixed length
+ *
+ * The first sample starts the first window. A sample at or past the end
+ * closes it: the result goes to onWindow() and last(). Windows without
+ * samples are skipped, not reported.
+ *
+ * @tparam Acc BeamAccumulator or BeamFloatAccumulator
+ */
+template<typename Acc>
+class BeamTumblingWindow {
+public:
+  using Value = typename Acc::Value;
+  using WindowFn = std::function<void(const BeamWindow&)>;
+
+  explicit BeamTumblingWindow(uint32_t windowUs = 1000000) : length(windowUs ? windowUs : 1) {}
+
+  void setLength(uint32_t windowUs) {
+    length = windowUs ? windowUs : 1;
+    reset();
+  }
+
+  uint32_t lengthUs() const { return length; }
+
+  void onWindow(WindowFn fn) { closedFn = std::move(fn); }
+
+  void reset() {
+    acc.clear();
+    started = false;
+    closed = 0;
+  }
+
+  /**
+   * @return true if the sample closed a window
+   */
+  bool add(Value value, uint32_t timeUs) {
+    const bool done = advance(timeUs);
+    acc.add(value);
+    return done;
+  }
+
+  /**
+   * @brief Add evenly spaced samples, e.g. one channel of a BeamAdcBlock
+   * @return Windows closed
+   */
+  size_t add(const Value* values, size_t n, uint32_t firstUs, uint32_t rateHz) {
+    size_t done = 0;
+    size_t i = 0;
+    while (i < n) {
+      if (advance(firstUs + beamSampleOffsetUs(i, rateHz))) done++;
+      size_t end = beamSampleIndexAt(startUs + length - firstUs, rateHz);
+      if (end <= i) end = i + 1;
+      if (end > n) end = n;
+      acc.add(values + i, end - i);
+      i = end;
+    }
+    return done;
+  }
+
+  /**
+   * @brief Close the window if nowUs is past its end, without a sample
+   * @return true if a window was closed
+   */
+  bool advanceTo(uint32_t nowUs) { return started && acc.count() && advance(nowUs); }
+
+  /// Most recently closed window
+  const BeamWindow& last() const { return latest; }
+
+  /// Windows closed since reset()
+  uint32_t windows() const { return closed; }
+
+  bool isStarted() const { return started; }
+
+  /// End of the window in progress (valid once started)
+  uint32_t endUs() const { return startUs + length; }
+
+  /// Statistics of the window in progress
+  BeamWindow current() const {
+    BeamWindow w;
+    w.startUs = startUs;
+    w.endUs = startUs + length;
+    acc.result(w);
+    return w;
+  }
+
+private:
+  Acc acc;
+  uint32_t length;
+  uint32_t startUs = 0;
+  bool started = false;
+  uint32_t closed = 0;
+  BeamWindow latest;
+  WindowFn closedFn;
+
+  bool advance(uint32_t timeUs) {
+    if (!started) {
+      startUs = timeUs;
+      started = true;
+      return false;
+    }
+    // Earlier than the window (a sample that arrived late) belongs to it;
+    // unsigned, it would look like a huge gap
+    if (static_cast<int32_t>(timeUs - startUs) < 0) return false;
+    const uint32_t elapsed = timeUs - startUs;
+    if (elapsed < length) return false;
+
+    latest = BeamWindow{};
+    latest.startUs = startUs;
+    latest.endUs = startUs + length;
+    acc.result(latest);
+    acc.clear();
+    closed++;
+    startUs += (elapsed / length) * length;  // skip empty windows
+    if (closedFn) closedFn(latest);
+    return true;
+  }
+};
+
+/**
+ * @brief The last windowUs as a ring of Panes sub-windows
+ *
+ * stats() merges the current pane and the Panes - 1 before it, so the
+ * window moves in steps of windowUs / Panes. Memory is Panes accumulators,
+ * whatever the rate.
+ *
+ * @tparam Acc BeamAccumulator or BeamFloatAccumulator
+ * @tparam Panes Number of panes
+ */
+template<typename Acc, size_t Panes = 8>
+class BeamSlidingWindow {
+  static_assert(Panes >= 2, "A sliding window needs at least two panes");
+
+public:
+  using Value = typename Acc::Value;
+
+  explicit BeamSlidingWindow(uint32_t windowUs = 10000000) { setLength(windowUs); }
+
+  void setLength(uint32_t windowUs) {
+    paneUs = windowUs / Panes ? windowUs / Panes : 1;
+    reset();
+  }
+
+  uint32_t lengthUs() const { return paneUs * Panes; }
+
+  void reset() {
+    for (Acc& pane : panes) pane.clear();
+    current = 0;
+    started = false;
+  }
+
+  void add(Value value, uint32_t timeUs) {
+    advanceTo(timeUs);
+    panes[current].add(value);
+  }
+
+  /// Add evenly spaced samples
+  void add(const Value* values, size_t n, uint32_t firstUs, uint32_t rateHz) {
+    size_t i = 0;
+    while (i < n) {
+      advanceTo(firstUs + beamSampleOffsetUs(i, rateHz));
+      size_t end = beamSampleIndexAt(paneStartUs + paneUs - firstUs, rateHz);
+      if (end <= i) end = i + 1;
+      if (end > n) end = n;
+      panes[current].add(values + i, end - i);
+      i = end;
+    }
+  }
+
+  /**
+   * @brief Move the window to nowUs, expiring panes without samples
+   */
+  void advanceTo(uint32_t nowUs) {
+    if (!started) {
+      paneStartUs = nowUs;
+      started = true;
+      return;
+    }
+    // A late sample counts towards the current pane, as in BeamTumblingWindow
+    if (static_cast<int32_t>(nowUs - paneStartUs) < 0) return;
+    const uint32_t elapsed = nowUs - paneStartUs;
+    if (elapsed < paneUs) return;
+    const uint32_t steps = elapsed / paneUs;
+    const uint32_t cleared = steps < Panes ? steps : Panes;
+    for (uint32_t s = 0; s < cleared; s++) {
+      current = (current + 1) % Panes;
+      panes[current].clear();
+    }
+    paneStartUs += steps * paneUs;
+  }
+
+  /// Statistics of the last Panes panes (the current one partly filled)
+  BeamWindow stats() const {
+    Acc all;
+    for (const Acc& pane : panes) all.merge(pane);
+    BeamWindow w;
+    w.startUs = paneStartUs - (Panes - 1) * paneUs;
+    w.endUs = paneStartUs + paneUs;
+    all.result(w);
+    return w;
+  }
+
+private:
+  Acc panes[Panes];
+  size_t current = 0;
+  uint32_t paneUs = 1;
+  uint32_t paneStartUs = 0;
+  bool started = false;
+};
+
+/**
+ * @brief Tumbling window, sliding window and EWMA for each sampled channel
+ *
+ * The fixed-point path: raw ADC counts in, summaries out. Feed it from the
+ * consumer task (loop()); it is not thread-safe.
+ */
+class BeamAggregator {
+public:
+  struct Config {
+    uint32_t windowUs = 1000000;    ///< Tumbling window (e.g. the report interval)
+    uint32_t slidingUs = 10000000;  ///< Sliding window
+    uint8_t ewmaShift = 4;          ///< EWMA alpha = 1 / 2^ewmaShift
+  };
+
+  using WindowFn = std::function<void(uint8_t channel, const BeamWindow& window)>;
+
+  BeamAggregator() = default;
+  BeamAggregator(const BeamAggregator&) = delete;
+  BeamAggregator& operator=(const BeamAggregator&) = delete;
+
+  /**
+   * @return false if channels is 0 or above BEAM_SAMPLER_MAX_CHANNELS
+   */
+  bool begin(uint8_t channels, const Config& config);
+
+  /// Called for every tumbling window closed, on the feeding task
+  void onWindow(WindowFn fn) { closedFn = std::move(fn); }
+
+  void add(uint8_t channel, uint16_t value, uint32_t timeUs);
+  void add(uint8_t channel, const BeamSample* samples, size_t n);
+
+  /// Evenly spaced samples, e.g. block->values[ch] of a BeamAdcBlock
+  void add(uint8_t channel, const uint16_t* values, size_t n, uint32_t firstUs, uint32_t rateHz);
+
+  /// Close windows that ended without new samples (call with the current time)
+  void advanceTo(uint32_t nowUs);
+
+  /// Last closed tumbling window, with the EWMA at its close
+  const BeamWindow& last(uint8_t channel) const;
+
+  /// Sliding window as of the last sample
+  BeamWindow sliding(uint8_t channel) const;
+
+  float ewma(uint8_t channel) const;
+
+  uint32_t windows(uint8_t channel) const;
+  uint8_t channelCount() const { return count; }
+  const Config& config() const { return cfg; }
+
+  void reset();
+
+private:
+  struct Channel {
+    BeamTumblingWindow<BeamAccumulator> tumbling;
+    BeamSlidingWindow<BeamAccumulator> window;
+    BeamEwma ewma;
+    BeamWindow closed;
+  };
+
+  Channel channels[BEAM_SAMPLER_MAX_CHANNELS];
+  uint8_t count = 0;
+  Config cfg;
+  WindowFn closedFn;
+};
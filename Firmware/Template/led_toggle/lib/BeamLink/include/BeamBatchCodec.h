@@ -0,0 +1,128 @@
+#pragma once
+#include "BeamSampler.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file BeamBatchCodec.h
+ * @brief Compact time-series encoding of sample batches
+ *
+ * A raw batch spends 6 bytes per sample, although consecutive samples of a
+ * fixed-rate channel barely differ: the interval is the same every time and
+ * the value moves by a few counts. The delta formats store what changes:
+ *
+ * - Time: delta-of-delta. The first interval is stored in full; after that,
+ *   only its change (0 at a steady rate, a few µs of jitter otherwise).
+ * - Value: the difference to the previous value (kBeamBatchDelta) or the
+ *   bits that changed (kBeamBatchXor).
+ * - Both as zigzag varints: 7 bits per byte, small magnitudes of either sign
+ *   in one byte.
+ *
+ * A steadily sampled 12-bit signal takes 2-3 bytes per sample, so one
+ * notification carries two to three times the samples, and the same data
+ * needs fewer connection events.
+ *
+ * @example
+ * ```cpp
+ * BeamBatchEncoder enc;
+ * enc.begin(batch, capacity, ch, kBeamBatchDelta);
+ * while (i < n && enc.add(samples[i])) i++;   // stops when the next one won't fit
+ * beam.notify(stream, batch, enc.finish());
+ *
+ * // central / tests
+ * int count = beamDecodeBatch(batch, size, &ch, out, maxOut);
+ * ```
+ */
+
+/// Map signed to unsigned so small magnitudes of either sign stay small
+constexpr uint32_t beamZigzag(int32_t v) {
+  return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+constexpr int32_t beamUnzigzag(uint32_t v) {
+  return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+}
+
+/// Bytes beamPutVarint() writes for v (1-5)
+constexpr size_t beamVarintSize(uint32_t v) {
+  return v < (1u << 7) ? 1 : v < (1u << 14) ? 2 : v < (1u << 21) ? 3 : v < (1u << 28) ? 4 : 5;
+}
+
+/// LEB128: 7 bits per byte, low bits first
+inline size_t beamPutVarint(uint8_t* out, uint32_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = static_cast<uint8_t>(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = static_cast<uint8_t>(v);
+  return n;
+}
+
+/**
+ * @return Bytes read, or 0 if the varint runs past end or is longer than 5 bytes
+ */
+inline size_t beamGetVarint(const uint8_t* in, const uint8_t* end, uint32_t& v) {
+  v = 0;
+  for (size_t n = 0; n < 5 && in + n < end; n++) {
+    v |= static_cast<uint32_t>(in[n] & 0x7F) << (7 * n);
+    if (!(in[n] & 0x80)) return n + 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Builds one batch sample by sample, in any batch format
+ *
+ * add() refuses a sample that would not fit, so a caller can take samples
+ * from a queue only once they are in the batch.
+ */
+class BeamBatchEncoder {
+public:
+  /**
+   * @param format kBeamBatchRaw, kBeamBatchDelta or kBeamBatchXor
+   * @return false for an unknown format or a capacity below the header
+   */
+  bool begin(uint8_t* out, size_t capacity, uint8_t channel, uint8_t format = kBeamBatchDelta);
+
+  /**
+   * @return false if the sample does not fit (bytes, or 255 samples)
+   */
+  bool add(const BeamSample& sample);
+
+  size_t count() const { return n; }
+  size_t size() const { return used; }
+
+  /**
+   * @brief Complete the header
+   * @return Batch size in bytes; 0 if no sample was added
+   */
+  size_t finish();
+
+private:
+  uint8_t* buffer = nullptr;
+  size_t limit = 0;
+  size_t used = 0;
+  size_t n = 0;
+  uint8_t format = kBeamBatchRaw;
+  uint32_t prevUs = 0;
+  uint32_t prevDeltaUs = 0;
+  uint16_t prevValue = 0;
+};
+
+/**
+ * @brief Encode up to n samples into one batch
+ * @param encoded Set to the samples that fit
+ * @return Bytes written; 0 if none fit
+ */
+size_t beamEncodeBatch(uint8_t channel, const BeamSample* samples, size_t n, uint8_t* out,
+                       size_t capacity, uint8_t format, size_t& encoded);
+
+/**
+ * @brief Decode a kBeamBatchDelta or kBeamBatchXor batch
+ *
+ * beamDecodeBatch() calls this for those formats.
+ * @return Samples in the batch, or -1 if malformed; at most maxSamples are stored
+ */
+int beamDecodeDeltaBatch(const uint8_t* data, size_t size, uint8_t* channel, BeamSample* out,
+                         size_t maxSamples);
@@ -1,6 +1,9 @@
 #pragma once
-#include <Arduino.h>
+#include "BeamPlatform.h"
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 /**
  * @file BeamConfig.h
@@ -27,9 +30,13 @@ struct BeamConfig {
 
   // BLE Configuration
   bool bleEnabled         = true;               ///< Enable BLE
-  std::string bleName     = "BeamLink-ESP32";   ///< BLE advertising name (max 32 chars)
-  int blePowerDbm         = 9;                  ///< Advertising power in dBm (-12 to +9)
+  std::string bleName     = "BeamLink-ESP32";   ///< BLE advertising name (max 29 chars)
+  int blePowerDbm         = 9;                  ///< Advertising power in dBm (-12 to +9, 3 dB steps)
   int bleAdvIntervalMs    = 100;                ///< Advertising interval in ms (20-10240)
+  int bleAdvFastIntervalMs = 20;                ///< Interval during the burst after boot/disconnect
+  int bleAdvFastMs        = 30000;              ///< Burst length in ms (0 skips it)
+  int bleAdvNormalMs      = 60000;              ///< Time at bleAdvIntervalMs before backing off (0 skips it)
+  int bleAdvSlowIntervalMs = 1285;              ///< Interval once backed off (20-10240)
   std::string bleServiceUuid       = "12345678-1234-1234-1234-1234567890ab"; ///< BLE Service UUID
   std::string bleCharacteristicUuid = "12345678-1234-1234-1234-1234567890ac"; ///< BLE Characteristic UUID
 
@@ -49,10 +56,11 @@ struct BeamConfig {
   int ledPin              = 2;                  ///< LED pin number (0-39)
   bool ledActiveHigh      = true;               ///< LED active high (true) or low (false)
   std::string sensorPins  = "34,35";            ///< Sensor pin mapping (comma-separated)
-  std::string actuatorPins = "12,13,14";        ///< Actuator pin mapping (comma-separated)
+  std::string actuatorPins = "25,26,27";        ///< Actuator pin mapping (comma-separated, avoid strapping pins 0, 2, 5, 12, 15)
 
   // Behavior
-  int reportIntervalMs    = 5000;               ///< Report interval in ms
+  int reportIntervalMs    = 5000;               ///< Report interval in ms (shortest gap per state key)
+  int heartbeatMs         = 60000;              ///< Resend unchanged state after this long (0: never)
   bool autoReconnect      = true;               ///< Auto-reconnect on disconnect
   std::string logLevel    = "INFO";             ///< Log level (DEBUG/INFO/WARN/ERROR)
   int serialBaud          = 115200;             ///< Serial baud rate (9600-2000000)
@@ -67,6 +75,38 @@ struct BeamConfig {
   float zeroOffset        = 0.02;               ///< Zero offset calibration
 };
 
+/**
+ * @brief Details of a configuration load, for diagnostics and boot timing
+ */
+struct BeamConfigLoadInfo {
+  enum class Source : uint8_t {
+    Defaults, ///< No usable file; cfg left unchanged
+    Text      ///< Parsed from the KEY=VALUE file
+  };
+
+  Source source = Source::Defaults;
+  uint32_t totalMicros = 0;   ///< Whole load, including file system access
+  uint32_t parseMicros = 0;   ///< Text parsing only
+  uint16_t keysApplied = 0;   ///< Keys that set a field
+  uint16_t keysRejected = 0;  ///< Unknown keys and invalid or out-of-range values
+};
+
+/**
+ * @brief Parse KEY=VALUE text into a configuration
+ * 
+ * Keys use the names from beam.config.h (DEVICE_NAME, BLE_POWER_DBM, ...).
+ * Whitespace around keys and values is ignored, values may be wrapped in
+ * double quotes, and lines starting with # are comments. Unknown keys and
+ * invalid values are reported and leave the field unchanged. The parser
+ * works on views of `text` and only allocates when assigning string fields.
+ * 
+ * @param text File contents
+ * @param cfg Configuration to update
+ * @param info Optional counters (keysApplied, keysRejected, parseMicros)
+ * @return true if no line was rejected
+ */
+bool parseBeamConfig(std::string_view text, BeamConfig& cfg, BeamConfigLoadInfo* info = nullptr);
+
 /**
  * @brief Load configuration from file
  * 
@@ -74,12 +114,16 @@ struct BeamConfig {
  * The file should contain KEY=VALUE pairs, one per line.
  * Comments start with # and empty lines are ignored.
  * 
+ * The file is parsed on every boot: a full file takes a few microseconds,
+ * less than opening and validating a pre-parsed copy would.
+ * 
  * @param cfg Reference to BeamConfig structure to populate
  * @param path Path to configuration file (default: "/beam.config")
+ * @param info Optional load details (source, timing, key counts)
  * @return true if configuration was loaded successfully, false otherwise
  * 
  * @note If the file doesn't exist or fails to load, the config structure
- *       retains its default values.
+ *       retains its default values. SPIFFS must already be mounted.
  * 
  * @example
  * ```cpp
@@ -91,4 +135,15 @@ struct BeamConfig {
  * }
  * ```
  */
-bool loadBeamConfig(BeamConfig& cfg, const char* path = "/beam.config");
+bool loadBeamConfig(BeamConfig& cfg, const char* path = "/beam.config", BeamConfigLoadInfo* info = nullptr);
+
+#if defined(ARDUINO)
+#include <FS.h>
+
+/**
+ * @brief Load configuration from a specific file system (e.g. LittleFS)
+ * @see loadBeamConfig(BeamConfig&, const char*, BeamConfigLoadInfo*)
+ */
+bool loadBeamConfig(fs::FS& fs, BeamConfig& cfg, const char* path = "/beam.config",
+                    BeamConfigLoadInfo* info = nullptr);
+#endif
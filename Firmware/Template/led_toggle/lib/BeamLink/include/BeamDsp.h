@@ -0,0 +1,206 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+struct BeamConfig;
+
+/**
+ * @file BeamDsp.h
+ * @brief Fixed-point calibration and filtering of sample blocks
+ *
+ * Each stage works on a whole block of int16 samples at a time, in place,
+ * and keeps its own history, so consecutive blocks (e.g. BeamAdcStream's)
+ * filter as one continuous signal:
+ *
+ * - BeamCalibration: (raw - offset) x gain, from BeamConfig::sensorGain and
+ *   zeroOffset, raw uint16 counts in, int16 out.
+ * - BeamMedianFilter: median of the last 3, 5, 7 or 9 samples (spikes).
+ * - BeamMovingAverage: mean of the last 2^k samples.
+ * - BeamBiquad: second-order IIR (low-pass, high-pass, band-pass), Q14.
+ * - BeamDspPipeline: all of the above, each optional, in that order.
+ *
+ * Every stage has two implementations. process() is the fast path: lane-
+ * parallel kernels (GCC vector extensions) and int32-only loops that the
+ * compiler turns into SIMD where the target has it, and running sums
+ * instead of window sums.
+ * processScalar() is the one-sample-at-a-time reference. Both give exactly
+ * the same output; the tests check it bit for bit.
+ *
+ * All arithmetic is integer: results do not depend on the FPU, and the
+ * float parameters are converted once, when a stage is configured.
+ *
+ * @example
+ * ```cpp
+ * BeamDspPipeline dsp;
+ * BeamDspPipeline::Config cfg;
+ * cfg.calibration = BeamCalibration::fromConfig(beamConfig);
+ * cfg.medianWindow = 5;
+ * cfg.filterEnabled = true;
+ * cfg.filter = BeamBiquad::lowPass(20000, 500);
+ * dsp.begin(cfg);
+ *
+ * int16_t out[BEAM_ADC_BLOCK];
+ * dsp.process(block->values[0], out, block->count[0]);
+ * ```
+ */
+
+/// Samples processed per inner loop of the fast path (4 x int32 = one 128-bit register)
+#ifndef BEAM_DSP_LANES
+#define BEAM_DSP_LANES 4
+#endif
+
+/// Longest moving-average window
+#ifndef BEAM_DSP_MAX_AVERAGE
+#define BEAM_DSP_MAX_AVERAGE 64
+#endif
+
+/// Longest median window
+#define BEAM_DSP_MAX_MEDIAN 9
+
+/**
+ * @brief Offset and gain, applied to raw counts
+ *
+ * out = saturate((clamp(raw - offset, +-65535) x gainQ12 + 2048) >> 12)
+ *
+ * The clamp only matters for offsets beyond the ADC range; it keeps the
+ * product in 32 bits for the fast path.
+ */
+struct BeamCalibration {
+  int32_t offset = 0;      ///< Counts subtracted first
+  int32_t gainQ12 = 4096;  ///< Gain x 4096 (1.0 = 4096), within +-32767
+
+  /**
+   * @param zeroOffset Fraction of full scale (0.02 = 2 % = 82 counts at 12 bit)
+   */
+  static BeamCalibration from(float gain, float zeroOffset, uint32_t fullScale = 4095);
+
+  /// from(cfg.sensorGain, cfg.zeroOffset)
+  static BeamCalibration fromConfig(const BeamConfig& cfg, uint32_t fullScale = 4095);
+
+  void process(const uint16_t* in, int16_t* out, size_t n) const;
+  void processScalar(const uint16_t* in, int16_t* out, size_t n) const;
+};
+
+/**
+ * @brief Mean of the last window samples; window a power of two
+ *
+ * Until window samples have been seen, the missing ones count as the first.
+ */
+class BeamMovingAverage {
+public:
+  /**
+   * @return false if window is not a power of two from 1 to BEAM_DSP_MAX_AVERAGE
+   */
+  bool begin(size_t window);
+  void reset() { primed = false; }
+  size_t window() const { return length; }
+
+  void process(int16_t* data, size_t n);
+  void processScalar(int16_t* data, size_t n);
+
+private:
+  int16_t history[BEAM_DSP_MAX_AVERAGE] = {};  ///< Last window inputs (ring)
+  size_t pos = 0;                              ///< Oldest input in history
+  size_t length = 1;
+  uint8_t shift = 0;
+  bool primed = false;
+
+  void prime(int16_t first);
+};
+
+/**
+ * @brief Median of the last window samples (3, 5, 7 or 9)
+ *
+ * Until window samples have been seen, the missing ones count as the first.
+ */
+class BeamMedianFilter {
+public:
+  /**
+   * @return false unless window is 1, 3, 5, 7 or 9
+   */
+  bool begin(size_t window);
+  void reset() { primed = false; }
+  size_t window() const { return length; }
+
+  void process(int16_t* data, size_t n);
+  void processScalar(int16_t* data, size_t n);
+
+private:
+  int16_t history[BEAM_DSP_MAX_MEDIAN] = {};  ///< Last window - 1 inputs, oldest first
+  size_t length = 1;
+  bool primed = false;
+
+  void prime(int16_t first);
+};
+
+/**
+ * @brief Second-order IIR section, direct form I, Q14 coefficients
+ *
+ * acc = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2 + e; y = acc >> 14, saturated.
+ * e is the previous sample's rounding remainder (error feedback): without
+ * it, low cut-offs would amplify rounding into a DC error of tens of counts.
+ * Coefficients must lie in (-2, 2): cut-off frequencies down to about
+ * fs / 500 stay accurate.
+ */
+class BeamBiquad {
+public:
+  struct Coefficients {
+    int16_t b0 = 16384, b1 = 0, b2 = 0, a1 = 0, a2 = 0;  ///< Default: pass-through
+  };
+
+  /// RBJ cookbook designs; q = 0.7071 is Butterworth
+  static Coefficients lowPass(float sampleHz, float cutoffHz, float q = 0.7071f);
+  static Coefficients highPass(float sampleHz, float cutoffHz, float q = 0.7071f);
+  static Coefficients bandPass(float sampleHz, float centerHz, float q = 0.7071f);
+
+  void begin(const Coefficients& coefficients);
+  void reset();
+  const Coefficients& coefficients() const { return c; }
+
+  void process(int16_t* data, size_t n);
+  void processScalar(int16_t* data, size_t n);
+
+private:
+  Coefficients c;
+  int16_t x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+  int32_t err = 0;  ///< Low 14 bits of the last acc
+
+  int16_t step(int16_t x);
+};
+
+/**
+ * @brief Calibration, median, moving average and biquad for one channel
+ */
+class BeamDspPipeline {
+public:
+  struct Config {
+    BeamCalibration calibration;
+    size_t medianWindow = 1;     ///< 1 = off
+    size_t averageWindow = 1;    ///< 1 = off
+    bool filterEnabled = false;
+    BeamBiquad::Coefficients filter;
+  };
+
+  /**
+   * @return false if a window is invalid (see the stages' begin())
+   */
+  bool begin(const Config& config);
+
+  /// Clear the filters' history (e.g. after a gap in the data)
+  void reset();
+
+  /**
+   * @brief Run all stages over one block
+   * @param out n samples; may not alias in
+   */
+  void process(const uint16_t* in, int16_t* out, size_t n);
+  void processScalar(const uint16_t* in, int16_t* out, size_t n);
+
+  const Config& config() const { return cfg; }
+
+private:
+  Config cfg;
+  BeamMedianFilter median;
+  BeamMovingAverage average;
+  BeamBiquad biquad;
+};
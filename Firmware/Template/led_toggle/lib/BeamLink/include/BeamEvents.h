@@ -0,0 +1,127 @@
+#pragma once
+#include "BeamPlatform.h"
+#include <atomic>
+#include <cstdint>
+
+#if defined(ARDUINO) && defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+/**
+ * @file BeamEvents.h
+ * @brief Wake-on-event primitive for an idle loop()
+ *
+ * Producers (BLE callbacks, other tasks, ISRs) OR event bits into a pending
+ * set; one consumer task blocks in wait() until a bit it cares about arrives
+ * or a timeout expires. On ESP32 the consumer sleeps on a FreeRTOS task
+ * notification, so an idle loop costs no CPU wakeups at all; on the host a
+ * condition variable stands in.
+ *
+ * Counters record how often the consumer woke and how long after the first
+ * signal it did, so wakeups per second and dispatch latency can be compared
+ * against a polling loop.
+ */
+
+/**
+ * @brief Event bits; the application may use BEAM_EVENT_USER and above
+ */
+enum BeamEventBits : uint32_t {
+  BEAM_EVENT_RX = 1u << 0,          ///< A client write was handled
+  BEAM_EVENT_TX_DONE = 1u << 1,     ///< A notification left the stack
+  BEAM_EVENT_CONNECT = 1u << 2,     ///< A client connected
+  BEAM_EVENT_DISCONNECT = 1u << 3,  ///< A client disconnected
+  BEAM_EVENT_TIMER = 1u << 4,       ///< Signalled by a hardware/esp_timer callback
+  BEAM_EVENT_SUBSCRIBE = 1u << 5,   ///< A central enabled or disabled stream notifications
+  BEAM_EVENT_USER = 1u << 8,        ///< First application-defined bit
+  BEAM_EVENT_ALL = 0xFFFFFFFFu
+};
+
+/**
+ * @brief Consumer-side counters (see BeamEventFlags::stats())
+ */
+struct BeamEventStats {
+  uint32_t signals = 0;          ///< signal() calls, woken or not
+  uint32_t wakeups = 0;          ///< wait() calls that returned events
+  uint32_t timeouts = 0;         ///< wait() calls that returned 0
+  uint32_t lastLatencyUs = 0;    ///< First pending signal -> wait() return
+  uint32_t maxLatencyUs = 0;
+  uint64_t totalLatencyUs = 0;
+  uint32_t elapsedMs = 0;        ///< Time covered by these counters
+
+  uint32_t meanLatencyUs() const {
+    return wakeups ? static_cast<uint32_t>(totalLatencyUs / wakeups) : 0;
+  }
+
+  /// Wakeups plus timeouts, i.e. how often the consumer ran
+  float wakeupsPerSecond() const {
+    return elapsedMs ? (wakeups + timeouts) * 1000.0f / elapsedMs : 0.0f;
+  }
+};
+
+/**
+ * @brief Pending event bits with a blocking wait for one consumer task
+ */
+class BeamEventFlags {
+public:
+  BeamEventFlags();
+
+  /**
+   * @brief Add events and wake the consumer if any is in the wake mask
+   *
+   * Safe from any task. Not for ISRs on ESP32 (use signalFromISR()).
+   */
+  void signal(uint32_t events);
+
+#if defined(ARDUINO) && defined(ESP32)
+  /**
+   * @brief signal() for interrupt handlers and esp_timer ISR callbacks
+   *
+   * Not placed in IRAM: do not call while the flash cache is disabled.
+   */
+  void signalFromISR(uint32_t events);
+#endif
+
+  /**
+   * @brief Block until events arrive or timeoutMs passes
+   *
+   * Call from one task only (normally loop()). Events outside the wake mask
+   * do not wake it but are returned with the next wakeup.
+   * @param timeoutMs Maximum wait; UINT32_MAX waits forever, 0 only polls
+   * @return The pending events (cleared), or 0 on timeout
+   */
+  uint32_t wait(uint32_t timeoutMs = UINT32_MAX);
+
+  /**
+   * @brief Choose which events wake wait(); default BEAM_EVENT_ALL
+   */
+  void setWakeMask(uint32_t mask) { wakeMask.store(mask, std::memory_order_relaxed); }
+
+  /**
+   * @brief Counters since construction or resetStats()
+   */
+  BeamEventStats stats() const;
+
+  void resetStats();
+
+private:
+  std::atomic<uint32_t> pending{0};
+  std::atomic<uint32_t> wakeMask{BEAM_EVENT_ALL};
+  std::atomic<uint32_t> firstSignalUs{0};
+  std::atomic<uint32_t> signalCount{0};
+  BeamEventStats counters;
+  uint32_t statsSinceMs = 0;
+
+  uint32_t take();
+  bool record(uint32_t events);
+
+#if defined(ARDUINO) && defined(ESP32)
+  std::atomic<TaskHandle_t> waiter{nullptr};
+#else
+  std::mutex mutex;
+  std::condition_variable wakeup;
+#endif
+};
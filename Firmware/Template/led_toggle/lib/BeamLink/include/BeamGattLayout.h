@@ -0,0 +1,101 @@
+#pragma once
+#include "BeamPlatform.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file BeamGattLayout.h
+ * @brief Layout version of the BeamLink attribute table, and connect timing
+ *
+ * NimBLE hands out attribute handles in registration order, and BeamLink
+ * always registers the same way: the service, the main characteristic,
+ * streams in addStream() order, then the layout characteristic. The same
+ * UUIDs and properties therefore give the same handles on every boot and
+ * in every firmware build that declares them.
+ *
+ * BeamGattLayout hashes that sequence. BeamLink serves the hash from a
+ * read-only characteristic (BMLK_LAYOUT_UUID) registered last, so the
+ * handles of firmware without it stay where they were. A central that cached
+ * the handles of an earlier connection reads the hash by UUID (ATT Read By
+ * Type, no discovery needed) and skips service discovery if it matches.
+ *
+ * BeamConnectTimer measures connect to first command, the delay a cached
+ * layout is meant to cut.
+ */
+
+/**
+ * @brief Running hash of a GATT layout, in registration order
+ */
+class BeamGattLayout {
+public:
+  /// Bumped if the hash input changes, so old caches never match by accident
+  static constexpr uint8_t kFormat = 1;
+
+  BeamGattLayout() { clear(); }
+
+  void clear();
+
+  /**
+   * @brief Add a primary service
+   * @return false if uuid is not a 128-bit UUID (the hash is still updated)
+   */
+  bool addService(const char* uuid);
+
+  /**
+   * @brief Add a characteristic of the last service
+   * @param properties BeamStreamProperty bits (READ/WRITE/NOTIFY)
+   * @return false if uuid is not a 128-bit UUID (the hash is still updated)
+   */
+  bool addCharacteristic(const char* uuid, uint8_t properties);
+
+  /// Layout version served to centrals
+  uint32_t hash() const { return value; }
+
+  /// Attributes registered: 1 per service, 2 per characteristic, +1 CCCD if it notifies
+  uint16_t attributeCount() const { return attributes; }
+
+private:
+  uint32_t value = 0;
+  uint16_t attributes = 0;
+
+  void mix(uint8_t byte);
+  bool mixUuid(const char* uuid);
+};
+
+/**
+ * @brief Connect-to-first-command times
+ */
+struct BeamConnectStats {
+  uint32_t connections = 0;  ///< Connects seen
+  uint32_t measured = 0;     ///< Connects followed by a command
+  uint32_t lastUs = 0;       ///< Most recent connect to first command
+  uint32_t maxUs = 0;
+  uint64_t totalUs = 0;
+
+  uint32_t meanUs() const { return measured ? static_cast<uint32_t>(totalUs / measured) : 0; }
+};
+
+/**
+ * @brief Times each connection until its first command
+ *
+ * Both calls come from the NimBLE host task. stats() may be read from
+ * another task; a torn read only skews one report.
+ */
+class BeamConnectTimer {
+public:
+  void connected(uint32_t nowUs = micros());
+
+  /**
+   * @brief Record a command
+   * @return true if it was the first one since connected()
+   */
+  bool command(uint32_t nowUs = micros());
+
+  const BeamConnectStats& stats() const { return counters; }
+  void resetStats() { counters = BeamConnectStats{}; }
+
+private:
+  BeamConnectStats counters;
+  uint32_t connectedAtUs = 0;
+  bool waiting = false;
+};
@@ -0,0 +1,243 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * @file BeamLed.h
+ * @brief LED on, off, brightness, fades and blinking, timed by hardware
+ *
+ * Blinking used to be a 500 ms timer in loop() that toggled the pin, so the
+ * loop had to wake for every blink and the timing moved with loop load. Here
+ * the LED is a PWM channel that fades on its own (LEDC on the ESP32), and a
+ * blink pattern is a hardware timer that starts the next step: the loop is
+ * not involved once the pattern is set, and can sleep.
+ *
+ * - Brightness is a percentage, mapped to duty on a squared curve so equal
+ *   steps look roughly equal.
+ * - With a fade time, every change ramps over that time. A blink with a
+ *   fade time breathes: each half period is one ramp.
+ * - Steady states need no timer at all.
+ *
+ * The hardware behind it is a BeamLedDriver: BeamLedcDriver on ESP32,
+ * BeamSimLedDriver (virtual time) in tests and on the host.
+ *
+ * @example
+ * ```cpp
+ * BeamLedcDriver ledc;
+ * BeamLed led;
+ *
+ * void setup() {
+ *   led.begin(ledc, LED_PIN, LED_ACTIVE_HIGH);
+ *   led.setFade(300);       // ms per change
+ *   led.setBrightness(40);  // %
+ *   led.blink(1000);        // period; runs without loop()
+ * }
+ * ```
+ */
+
+/// PWM resolution in bits (duty 0 to 2^bits - 1)
+#ifndef BEAM_LED_PWM_BITS
+#define BEAM_LED_PWM_BITS 12
+#endif
+
+/// PWM frequency; well above flicker
+#ifndef BEAM_LED_PWM_HZ
+#define BEAM_LED_PWM_HZ 1000
+#endif
+
+/// Shortest blink period
+#define BEAM_LED_MIN_PERIOD_MS 20
+
+/**
+ * @brief A PWM output that ramps on its own, plus a periodic timer
+ *
+ * setDuty() and fadeTo() return at once, and may be called from the timer
+ * callback as well as from the task that owns the BeamLed. stopTimer() does
+ * not wait for a callback that is already running.
+ */
+class BeamLedDriver {
+public:
+  using TickFn = void (*)(void* arg);
+
+  static constexpr uint32_t kMaxDuty = (1u << BEAM_LED_PWM_BITS) - 1;
+
+  virtual ~BeamLedDriver() = default;
+
+  /// Attach the PWM channel to pin, dark
+  virtual bool begin(uint8_t pin, bool activeHigh) = 0;
+
+  /// Jump to duty (0 to kMaxDuty), cancelling a running fade
+  virtual void setDuty(uint32_t duty) = 0;
+
+  /// Ramp linearly from the current duty to duty over ms
+  virtual void fadeTo(uint32_t duty, uint32_t ms) = 0;
+
+  /// Call fn(arg) every periodMs until stopTimer(), replacing any running timer
+  virtual bool startTimer(uint32_t periodMs, TickFn fn, void* arg) = 0;
+  virtual void stopTimer() = 0;
+
+  /// Milliseconds on the clock the timer runs by
+  virtual uint32_t nowMs() const = 0;
+};
+
+#if defined(ARDUINO) && defined(ESP32)
+/**
+ * @brief LEDC low-speed channel with hardware fade, stepped by an esp_timer
+ *
+ * The channel runs from the RTC 8 MHz clock where the chip allows it, so the
+ * PWM keeps running in automatic light sleep; the esp_timer wakes the chip
+ * for each blink step. Otherwise it falls back to the default clock.
+ *
+ * Before ESP-IDF 5 (Arduino-ESP32 2.x) a running fade cannot be stopped, and
+ * every LEDC call waits until it ends. A change during a fade is held back
+ * instead, and a one-shot timer applies the latest one when the fade ends.
+ */
+class BeamLedcDriver : public BeamLedDriver {
+public:
+  /// LEDC channel and timer, when several LEDs (or other LEDC users) share the chip
+  explicit BeamLedcDriver(uint8_t channel = 0, uint8_t timer = 0) : channel(channel), timerNum(timer) {}
+  ~BeamLedcDriver() override;
+
+  bool begin(uint8_t pin, bool activeHigh) override;
+  void setDuty(uint32_t duty) override;
+  void fadeTo(uint32_t duty, uint32_t ms) override;
+  bool startTimer(uint32_t periodMs, TickFn fn, void* arg) override;
+  void stopTimer() override;
+  uint32_t nowMs() const override;
+
+private:
+  uint8_t channel;
+  uint8_t timerNum;
+  bool ready = false;
+  void* timer = nullptr;  ///< esp_timer_handle_t
+  std::mutex lock;        ///< Everything below; the esp_timer task reads it too
+  TickFn tickFn = nullptr;
+  void* tickArg = nullptr;
+
+  // IDF < 5: the change held back by a running fade
+  void* fadeTimer = nullptr;  ///< esp_timer_handle_t, fires when the fade ends
+  int64_t fadeEndUs = 0;
+  bool held = false;
+  uint32_t heldDuty = 0;
+  uint32_t heldMs = 0;
+
+  void request(uint32_t duty, uint32_t ms);
+  void write(uint32_t duty, uint32_t ms);
+  static void timerEntry(void* arg);
+  static void fadeDoneEntry(void* arg);
+};
+#endif
+
+/**
+ * @brief Simulated driver in virtual time: fades are linear, the timer
+ *        fires from advance()
+ */
+class BeamSimLedDriver : public BeamLedDriver {
+public:
+  bool begin(uint8_t pin, bool activeHigh) override;
+  void setDuty(uint32_t duty) override;
+  void fadeTo(uint32_t duty, uint32_t ms) override;
+  bool startTimer(uint32_t periodMs, TickFn fn, void* arg) override;
+  void stopTimer() override { period = 0; }
+
+  /// Run the timer callback once now, as a tick already under way when the timer stopped would
+  void fireTick() { if (tickFn) tickFn(tickArg); }
+
+  /// Move virtual time forward, firing the timer on each of its ticks
+  void advance(uint32_t ms);
+
+  /// Duty at the current virtual time
+  uint32_t duty() const;
+  /// Duty the running fade ends at (or the current duty)
+  uint32_t targetDuty() const { return to; }
+  bool isFading() const { return now < fadeEnd; }
+  bool timerRunning() const { return period != 0; }
+  uint32_t nowMs() const override { return now; }
+  /// setDuty() and fadeTo() calls so far
+  uint32_t writes() const { return writeCount; }
+  uint8_t pin() const { return ledPin; }
+
+private:
+  uint8_t ledPin = 0;
+  uint32_t now = 0;
+  uint32_t from = 0, to = 0;
+  uint32_t fadeStart = 0, fadeEnd = 0;
+  uint32_t period = 0, nextTick = 0;
+  TickFn tickFn = nullptr;
+  void* tickArg = nullptr;
+  uint32_t writeCount = 0;
+};
+
+/**
+ * @brief LED state on top of a BeamLedDriver
+ *
+ * Call the setters from one task (loop()). The timer callback runs on
+ * another task; it and apply() take turns on the driver under a mutex, and a
+ * tick that was already running when the pattern changed does nothing.
+ */
+class BeamLed {
+public:
+  BeamLed() = default;
+  ~BeamLed();
+
+  BeamLed(const BeamLed&) = delete;
+  BeamLed& operator=(const BeamLed&) = delete;
+
+  /**
+   * @brief Attach the driver to pin and show the current state (off at first)
+   * @return false if the driver could not set up the pin
+   */
+  bool begin(BeamLedDriver& driver, uint8_t pin, bool activeHigh);
+
+  /// Steady on (at brightness()) or off; ends blinking
+  void set(bool on);
+
+  /**
+   * @brief Blink with this period (on, then off, half each)
+   * @return false if periodMs < BEAM_LED_MIN_PERIOD_MS
+   */
+  bool blink(uint32_t periodMs);
+
+  /// Brightness while on, 0-100 %; applies at once (with the fade time)
+  void setBrightness(uint8_t percent);
+
+  /// Ramp time for every change, 0 for instant; blinking breathes when > 0
+  void setFade(uint32_t ms);
+
+  bool isOn() const { return lit; }
+  bool isBlinking() const { return blinking; }
+  uint8_t brightness() const { return level; }
+  uint32_t fadeMs() const { return fade; }
+  uint32_t blinkPeriodMs() const { return period; }
+
+  /// Blink steps started by the hardware timer (the loop ran none of them)
+  uint32_t steps() const { return stepCount.load(std::memory_order_relaxed); }
+
+  /// Duty for a brightness: squared, at least 1 when percent > 0
+  static uint32_t dutyFor(uint8_t percent);
+
+private:
+  BeamLedDriver* driver = nullptr;
+  bool lit = false;
+  bool blinking = false;
+  uint8_t level = 100;
+  uint32_t fade = 0;
+  uint32_t period = 1000;
+
+  // Shared with the timer callback
+  std::mutex lock;                       ///< Guards the driver and the blink fields below
+  bool blinkActive = false;
+  uint32_t blinkDuty = 0;
+  uint32_t blinkRampMs = 0;
+  uint32_t blinkHalfMs = 0;
+  uint32_t nextStepMs = 0;               ///< Due time of the timer's next tick; earlier ones are stale
+  bool phaseOn = false;
+  std::atomic<uint32_t> stepCount{0};
+
+  void apply();
+  void stop();
+  static void show(BeamLedDriver* driver, uint32_t duty, uint32_t ms);
+  static void tick(void* arg);
+};
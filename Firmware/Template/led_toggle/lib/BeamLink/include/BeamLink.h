@@ -1,8 +1,18 @@
 #pragma once
 #include <NimBLEDevice.h>
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <Arduino.h>
 #include <memory>
+#include <mutex>
+#include "BeamAdvertising.h"
+#include "BeamConfig.h"
+#include "BeamEvents.h"
+#include "BeamGattLayout.h"
+#include "BeamPower.h"
+#include "BeamStaticConfig.h"
+#include "BeamStreams.h"
 
 /**
  * @file BeamLink.h
@@ -30,6 +40,23 @@ using ReplyFn = std::function<void(const std::string&)>;
  */
 using MessageHandler = std::function<void(const std::string& in, ReplyFn reply)>;
 
+/**
+ * @brief Function type for connection state changes
+ * 
+ * Called with true when a client connects and false when it disconnects.
+ */
+using ConnectionHandler = std::function<void(bool connected)>;
+
+/**
+ * @brief Outcome of one live configuration change
+ */
+struct BeamChangeReport {
+  const char* setting = "";  ///< Setting name as in beam.config, e.g. "BLE_POWER_DBM"
+  bool ok = false;           ///< New value in effect (false: the old value was kept)
+  bool restarted = false;    ///< Needed a full BLE stack restart (connections dropped)
+  uint32_t downtimeUs = 0;   ///< Time the device was not advertising or connectable
+};
+
 /**
  * @class BeamLink
  * @brief Main BLE communication class
@@ -78,7 +105,7 @@ public:
    * Initializes the BLE device, creates the server, service, and characteristic,
    * and starts advertising for client connections.
    * 
-   * @param deviceName The name to advertise as (max 32 characters)
+   * @param deviceName The name to advertise as (max 29 characters)
    * @param advPowerDbm Advertising power in dBm (-12 to +9, default: 9)
    * @param advIntervalMs Advertising interval in ms (20 to 10240, default: 100)
    * @param serviceUuid BLE Service UUID (default: from Uuids.h)
@@ -91,6 +118,133 @@ public:
   bool begin(const char* deviceName, int8_t advPowerDbm = 9, uint16_t advIntervalMs = 100,
              const char* serviceUuid = nullptr, const char* characteristicUuid = nullptr);
 
+  /**
+   * @brief Initialize BLE from a compile-time configuration
+   * 
+   * The values were range-checked by BEAM_STATIC_ASSERT_CONFIG() and the UUIDs
+   * parsed by the compiler, so nothing is validated, clamped or parsed here.
+   * 
+   * @param config constexpr configuration (must stay valid, e.g. a global)
+   * @return true if initialization was successful, false otherwise
+   */
+  bool begin(const BeamStaticConfig& config);
+
+  /**
+   * @brief Change the TX power without interrupting advertising or connections
+   * 
+   * @param dbm New power in dBm: -12, -9, -6, -3, 0, 3, 6 or 9
+   * @param report Receives the outcome (optional)
+   * @return false if not initialized, not one of those levels, or the controller
+   *         rejected it (the old power is restored)
+   */
+  bool setAdvPower(int8_t dbm, BeamChangeReport* report = nullptr);
+
+  /**
+   * @brief Change the advertising interval of the normal phase
+   * 
+   * In the normal phase advertising is stopped and restarted with the new
+   * interval; existing connections are not affected. In other phases, or
+   * while connected, it applies the next time the schedule reaches it.
+   * 
+   * @param intervalMs New interval in ms (20 to 10240)
+   * @param report Receives the outcome and advertising gap (optional)
+   * @return false on invalid input or failure (the old interval is restored)
+   */
+  bool setAdvInterval(uint16_t intervalMs, BeamChangeReport* report = nullptr);
+
+  /**
+   * @brief Change the advertising schedule (fast burst, normal, slow)
+   * 
+   * The current phase keeps its start time; if its interval changed,
+   * advertising is restarted with the new one.
+   * 
+   * @param steps Intervals 20 to 10240 ms; durations in ms, 0 skips a phase
+   * @param report Receives the outcome and advertising gap (optional)
+   * @return false on invalid input or failure (the old schedule is restored)
+   */
+  bool setAdvSchedule(const BeamAdvSteps& steps, BeamChangeReport* report = nullptr);
+
+  /**
+   * @brief Go back to the fast burst, e.g. after a button press
+   * 
+   * Safe from any task. Ignored while a client is connected.
+   */
+  void restartAdvertising();
+
+  /**
+   * @brief Current advertising phase (Off while connected)
+   */
+  BeamAdvPhase getAdvPhase() const;
+
+  /**
+   * @brief Time spent in each advertising phase, restarts and steps
+   */
+  BeamAdvStats getAdvStats() const;
+
+  /**
+   * @brief Bytes of manufacturer data that fit next to the name in the scan response
+   * 
+   * The 128-bit service UUID fills most of the advertising packet, so
+   * broadcast data goes in the scan response (31 bytes): name AD, then the
+   * manufacturer AD header. Shrinks as the device name grows.
+   */
+  size_t getBroadcastCapacity() const;
+
+  /**
+   * @brief Put manufacturer-specific data (company id first) in the scan response
+   * 
+   * Scanners doing an active scan read it without connecting; see
+   * StateBroadcast. Updated in place, advertising is not restarted. Kept
+   * across setDeviceName() and restarts; an empty payload removes it.
+   * 
+   * @return false if not initialized or size exceeds getBroadcastCapacity()
+   */
+  bool setBroadcastData(const uint8_t* data, size_t size);
+
+  /**
+   * @brief Change the GAP device name and the advertised name
+   * 
+   * @param name New name (1 to 29 characters)
+   * @param report Receives the outcome and advertising gap (optional)
+   * @return false on invalid input or failure (the old name is restored)
+   */
+  bool setDeviceName(const char* name, BeamChangeReport* report = nullptr);
+
+  /**
+   * @brief Change the service and characteristic UUIDs
+   * 
+   * The GATT table cannot be changed live, so this is the one change that
+   * restarts the BLE stack (end() + begin()) and drops connections. Handlers
+   * registered with onMessage()/onConnectionChange() are kept.
+   * 
+   * @param report Receives the outcome and total downtime (optional)
+   * @return false on failure (the stack is restarted with the old UUIDs)
+   */
+  bool setUuids(const char* serviceUuid, const char* characteristicUuid, BeamChangeReport* report = nullptr);
+
+  /**
+   * @brief Apply every BLE setting in cfg that differs from the running one
+   * 
+   * Live changes (power, interval, schedule, name) are applied first, each on its own
+   * with rollback on failure; a UUID change restarts the stack last.
+   * 
+   * @param cfg Desired configuration
+   * @param reports Receives one report per attempted change (may be nullptr)
+   * @param maxReports Capacity of reports
+   * @return Number of changes attempted
+   */
+  size_t reconfigure(const BeamConfig& cfg, BeamChangeReport* reports = nullptr, size_t maxReports = 0);
+
+  /**
+   * @brief Current TX power in dBm
+   */
+  int8_t getAdvPower() const { return advPowerDbm; }
+
+  /**
+   * @brief Normal-phase advertising interval in ms (BLE_ADV_INTERVAL_MS)
+   */
+  uint16_t getAdvInterval() const { return advIntervalMs; }
+
   /**
    * @brief Register message handler for incoming messages
    * 
@@ -110,6 +264,26 @@ public:
    */
   void onMessage(MessageHandler handler);
 
+  /**
+   * @brief Register handler for client connect/disconnect events
+   * 
+   * Lets the application react to connection changes instead of polling
+   * isConnected() every loop iteration.
+   * 
+   * @param handler Function to call with the new connection state
+   * 
+   * @note The handler runs on the NimBLE host task. Use NexState::post() or
+   *       another thread-safe mechanism to hand the event to loop().
+   * 
+   * @example
+   * ```cpp
+   * beam.onConnectionChange([](bool connected) {
+   *   State().post("bleConnected", connected);
+   * });
+   * ```
+   */
+  void onConnectionChange(ConnectionHandler handler);
+
   /**
    * @brief Send a message to the connected client
    * 
@@ -123,6 +297,80 @@ public:
    */
   bool notify(const std::string& msg);
 
+  /**
+   * @brief Declare an extra characteristic for a dedicated stream
+   * 
+   * Call before begin(): the GATT table is built once. Streams are kept across
+   * end()/begin() and setUuids(). Each has its own CCCD, so a central
+   * subscribes only to the streams it shows, and replies on the main
+   * characteristic never queue behind telemetry.
+   * 
+   * @param name Unique name, e.g. "telemetry" (a string literal)
+   * @param uuid 128-bit UUID, different from the main characteristic
+   * @param properties BeamStreamProperty bits
+   * @param handler Receives writes (NimBLE host task); required with BEAM_STREAM_WRITE
+   * @return Stream id, or kBeamNoStream on invalid input or after begin()
+   * 
+   * @example
+   * ```cpp
+   * static BeamStreamId telemetry = beam.addStream("telemetry", TELEMETRY_UUID);
+   * 
+   * if (beam.isSubscribed(telemetry)) {   // nothing is encoded otherwise
+   *   beam.notify(telemetry, encodeSample());
+   * }
+   * ```
+   */
+  BeamStreamId addStream(const char* name, const char* uuid, uint8_t properties = BEAM_STREAM_NOTIFY,
+                         BeamStreamHandler handler = nullptr);
+
+  /**
+   * @brief Whether the connected central enabled notifications on a stream
+   * 
+   * Lock-free, safe from any task. Check it before building a payload.
+   */
+  bool isSubscribed(BeamStreamId id) const { return deviceConnected && streams.isSubscribed(id); }
+
+  /**
+   * @brief Notify on a stream characteristic
+   * 
+   * Not logged per message, unlike notify(msg): streams may run at a high rate.
+   * 
+   * @return false if nobody is subscribed (counted as skipped), the stream has
+   *         no BEAM_STREAM_NOTIFY, or data is empty; cut to MTU - 3 bytes
+   */
+  bool notify(BeamStreamId id, const uint8_t* data, size_t size);
+  bool notify(BeamStreamId id, const std::string& msg) {
+    return notify(id, reinterpret_cast<const uint8_t*>(msg.data()), msg.size());
+  }
+
+  /**
+   * @brief Sent, skipped, truncated and received counts of one stream
+   */
+  BeamStreamStats getStreamStats(BeamStreamId id) const { return streams.stats(id); }
+
+  /**
+   * @brief Declared streams, e.g. to list them in an info reply
+   */
+  const BeamStreams& getStreams() const { return streams; }
+
+  /**
+   * @brief Version of the attribute table, as served by BMLK_LAYOUT_UUID
+   * 
+   * Same UUIDs, properties and stream order give the same value and the same
+   * handles, across boots and firmware builds. A central that cached the
+   * handles for this value can skip service discovery. 0 before begin().
+   */
+  uint32_t getLayoutHash() const { return initialized ? layout.hash() : 0; }
+
+  /**
+   * @brief Time from connect to the first command (main or stream write)
+   * 
+   * Compare a central that rediscovers on every connect with one that reads
+   * the layout version and uses cached handles.
+   */
+  const BeamConnectStats& getConnectStats() const { return connectTimer.stats(); }
+  void resetConnectStats() { connectTimer.resetStats(); }
+
   /**
    * @brief Check if a client is connected
    * 
@@ -130,6 +378,14 @@ public:
    */
   bool isConnected() const { return deviceConnected; }
 
+  /**
+   * @brief Callbacks registered with the NimBLE server
+   * 
+   * Owned by BeamLink and registered again by every begin(). Lets tests fire
+   * connect and disconnect without a central.
+   */
+  NimBLEServerCallbacks* getServerCallbacks() const;
+
   /**
    * @brief Get the device name
    * 
@@ -138,12 +394,21 @@ public:
   const std::string& getDeviceName() const { return deviceName; }
 
   /**
-   * @brief Get the MTU (Maximum Transmission Unit) size
+   * @brief Get the ATT MTU negotiated with the connected client
    * 
-   * @return Current MTU size in bytes (default: 23, max: 512)
+   * Size notifications and batches (readBatch(), beamEncodeBatch()) to
+   * getMTU() - 3: the client may have accepted less than we asked for.
+   * 
+   * @return MTU in bytes; 23 (the BLE default) until the client's MTU
+   *         exchange, and while nobody is connected
    */
   uint16_t getMTU() const;
 
+  /**
+   * @brief Get the MTU this device asks for in the MTU exchange (512)
+   */
+  uint16_t getPreferredMTU() const;
+
   /**
    * @brief Get number of messages received
    * 
@@ -177,14 +442,69 @@ public:
    */
   void resetStats();
 
+  /**
+   * @brief Sleep until BLE activity or another signalled event
+   *
+   * RX (after the message handler returns), TX completion, connect and
+   * disconnect signal the matching BEAM_EVENT_* bit; the application can add
+   * its own with signalEvent(). Blocks on a FreeRTOS task notification, so an
+   * idle loop() does not wake at all. Call from one task only.
+   * 
+   * The wait also ends when the advertising schedule is due to step down,
+   * so call loop() after it returns.
+   *
+   * @param timeoutMs Maximum wait, e.g. BeamScheduler::msUntilNext()
+   * @return Events since the last call, or 0 on timeout
+   *
+   * @example
+   * ```cpp
+   * void loop() {
+   *   scheduler.run();
+   *   State().update();
+   *   beam.waitForEvent(scheduler.msUntilNext());
+   * }
+   * ```
+   */
+  uint32_t waitForEvent(uint32_t timeoutMs = UINT32_MAX) {
+    return events.wait(std::min(timeoutMs, msUntilAdvStep()));
+  }
+
+  /**
+   * @brief Wake waitForEvent() from another task (BEAM_EVENT_USER and up)
+   */
+  void signalEvent(uint32_t bits) { events.signal(bits); }
+
+  /**
+   * @brief Events that wake waitForEvent(); others are only accumulated
+   */
+  void setWakeEvents(uint32_t mask) { events.setWakeMask(mask); }
+
+  /**
+   * @brief Wakeups, timeouts and signal-to-wake latency of waitForEvent()
+   */
+  BeamEventStats getEventStats() const { return events.stats(); }
+
+  /**
+   * @brief Reset waitForEvent() counters (call from the waiting task)
+   */
+  void resetEventStats() { events.resetStats(); }
+
+  /**
+   * @brief Keep the CPU at full speed while BLE work is pending
+   *
+   * Message handlers and notify() hold a BeamPower lock while they run, and
+   * connects, disconnects and writes start its linger period. Call from
+   * setup() before clients connect; nullptr detaches.
+   */
+  void setPowerManager(BeamPower* manager) { power = manager; }
+
   /**
    * @brief Main loop function
    * 
    * This function should be called regularly in the main loop() function.
-   * It handles BLE operations and can be extended for future features like
-   * timers, heartbeats, etc.
-   * 
-   * @note This function includes a small delay for proper BLE operation.
+   * It steps the advertising schedule and returns immediately; NimBLE runs
+   * on its own task. Use BeamScheduler for timers and heartbeats and let loop() sleep
+   * until the next deadline.
    */
   void loop();
 
@@ -200,30 +520,54 @@ private:
   // Forward declarations for callback classes
   class ServerCallbacks;
   class RxCallbacks;
+  class StreamCallbacks;
   
+  static constexpr uint16_t kDefaultMtu = 23; ///< BLE minimum, until the MTU exchange
+
   // BLE objects
   NimBLEServer* pServer = nullptr;         ///< BLE server instance
   NimBLECharacteristic* pChar = nullptr;  ///< Main characteristic (read/write/notify)
+  NimBLECharacteristic* pLayoutChar = nullptr; ///< Layout version (read)
+  NimBLECharacteristic* streamChars[BEAM_MAX_STREAMS] = {}; ///< One per addStream(), same order
   
   // State
   MessageHandler messageHandler = nullptr; ///< Message handler function
-  bool deviceConnected = false;            ///< Client connection status
+  ConnectionHandler connectionHandler = nullptr; ///< Connection change handler
+  std::atomic<bool> deviceConnected{false};      ///< Client connection status (set by the NimBLE host task)
+  std::atomic<uint16_t> peerMtu{kDefaultMtu};    ///< Negotiated with the client (set by onMTUChange)
   bool initialized = false;                ///< Initialization status
   std::string deviceName;                  ///< Device name
-  std::string serviceUuid;                 ///< BLE Service UUID
-  std::string characteristicUuid;          ///< BLE Characteristic UUID
+  int8_t advPowerDbm = 9;                  ///< TX power in effect
+  uint16_t advIntervalMs = 100;            ///< Normal-phase advertising interval
+  BeamAdvSchedule advSchedule;             ///< Fast/normal/slow phases (guarded by advMutex)
+  mutable std::mutex advMutex;             ///< Loop task and NimBLE callbacks both step it
+  std::mutex txMutex;                      ///< notify(msg): setValue() and notify() go out as a pair
+  std::string broadcastData;               ///< Scan response manufacturer data (guarded by advMutex)
+  NimBLEUUID serviceUuid;                  ///< BLE Service UUID (binary, no heap)
+  NimBLEUUID characteristicUuid;           ///< BLE Characteristic UUID (binary, no heap)
   
-  // Statistics
-  uint32_t messagesReceived = 0;           ///< Count of messages received
-  uint32_t messagesSent = 0;               ///< Count of messages sent
-  uint32_t errorCount = 0;                 ///< Count of errors
+  // Statistics, counted from the loop task and the NimBLE host task
+  std::atomic<uint32_t> messagesReceived{0}; ///< Count of messages received
+  std::atomic<uint32_t> messagesSent{0};     ///< Count of messages sent
+  std::atomic<uint32_t> errorCount{0};       ///< Count of errors
+  BeamEventFlags events;                   ///< Wakes waitForEvent() from BLE callbacks
+  BeamStreams streams;                     ///< Extra characteristics and their subscriptions
+  BeamGattLayout layout;                   ///< Hash of the attribute table, built in setupService()
+  BeamConnectTimer connectTimer;           ///< Connect to first command
+  BeamPower* power = nullptr;              ///< Optional power policy (setPowerManager())
   unsigned long startTime = 0;             ///< Start time for uptime calculation
   
   // Callback objects
   std::unique_ptr<ServerCallbacks> serverCallbacks; ///< Server callbacks
   std::unique_ptr<RxCallbacks> rxCallbacks;         ///< RX callbacks
+  std::unique_ptr<StreamCallbacks> streamCallbacks[BEAM_MAX_STREAMS]; ///< Writes and CCCD per stream
   
   // Helper methods
+  bool start(int8_t advPowerDbm, uint16_t advIntervalMs); ///< Bring up BLE with validated settings
   bool setupService();                      ///< Setup BLE service and characteristics
   bool startAdvertising(uint16_t intervalMs); ///< Start BLE advertising with interval
+  bool applyAdvInterval(uint16_t intervalMs); ///< Restart advertising if running (advMutex held)
+  uint32_t msUntilAdvStep() const;          ///< Time until the schedule steps down
+  void applyScanResponse();                 ///< Name + broadcast data (advMutex held)
+  static bool applyPower(int8_t dbm);       ///< Set adv + default TX power, verified by reading back
 };
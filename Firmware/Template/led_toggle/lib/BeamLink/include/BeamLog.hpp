@@ -56,6 +56,29 @@ inline void bl_print(const char* fmt, ...) {
   Serial.print(buffer);
 }
 
+// ---- Runtime level (can be changed live, e.g. by config:set:LOG_LEVEL=WARN) ----
+enum class BeamLogLevel : uint8_t { Debug, Info, Warn, Error };
+
+inline BeamLogLevel& bl_level_ref() {
+  static BeamLogLevel level = BeamLogLevel::Debug;
+  return level;
+}
+
+inline BeamLogLevel bl_level() { return bl_level_ref(); }
+inline void bl_set_level(BeamLogLevel level) { bl_level_ref() = level; }
+
+// Parse DEBUG/INFO/WARN/ERROR (case-insensitive); false leaves `out` unchanged
+inline bool bl_parse_level(const char* text, BeamLogLevel& out) {
+  static const char* const kNames[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+  for (uint8_t i = 0; i < 4; i++) {
+    if (text && strcasecmp(text, kNames[i]) == 0) {
+      out = static_cast<BeamLogLevel>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
 // Timestamp (ms since boot)
 inline void bl_stamp() {
   bl_print(BLK_CLR_DIM "[%8lu ms]" BLK_CLR_RESET " ", millis());
@@ -73,14 +96,18 @@ inline void bl_stamp() {
 #define BL_LOG_RAW(color, emoji, fmt, ...) \
   do { bl_stamp(); bl_print(color "%s" fmt BLK_CLR_RESET "\n", emoji, ##__VA_ARGS__); } while(0)
 
+// Core macro with runtime level filter
+#define BL_LOG_AT(level, color, emoji, fmt, ...) \
+  do { if (BeamLogLevel::level >= bl_level()) BL_LOG_RAW(color, emoji, fmt, ##__VA_ARGS__); } while(0)
+
 // Public APIs
-#define LOG_OK(fmt, ...)    BL_LOG_RAW(BLK_FG_GRN, BLK_EMJ_OK,   fmt, ##__VA_ARGS__)
-#define LOG_INFO(fmt, ...)  BL_LOG_RAW(BLK_FG_CYN, BLK_EMJ_INFO, fmt, ##__VA_ARGS__)
-#define LOG_WARN(fmt, ...)  BL_LOG_RAW(BLK_FG_YEL, BLK_EMJ_WARN, fmt, ##__VA_ARGS__)
-#define LOG_ERR(fmt, ...)   BL_LOG_RAW(BLK_FG_RED, BLK_EMJ_ERR,  fmt, ##__VA_ARGS__)
+#define LOG_OK(fmt, ...)    BL_LOG_AT(Info,  BLK_FG_GRN, BLK_EMJ_OK,   fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...)  BL_LOG_AT(Info,  BLK_FG_CYN, BLK_EMJ_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...)  BL_LOG_AT(Warn,  BLK_FG_YEL, BLK_EMJ_WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERR(fmt, ...)   BL_LOG_AT(Error, BLK_FG_RED, BLK_EMJ_ERR,  fmt, ##__VA_ARGS__)
 
 #if !defined(BEAMLOG_DISABLE_DEBUG)
-  #define LOG_DBG(fmt, ...) BL_LOG_RAW(BLK_CLR_DIM, "", fmt, ##__VA_ARGS__)
+  #define LOG_DBG(fmt, ...) BL_LOG_AT(Debug, BLK_CLR_DIM, "", fmt, ##__VA_ARGS__)
 #else
   #define LOG_DBG(fmt, ...) do{}while(0)
 #endif
@@ -90,6 +117,6 @@ inline void bl_stamp() {
   do { bl_stamp(); bl_print(BLK_CLR_DIM "%s=" BLK_CLR_RESET valueFmt "\n", key, ##__VA_ARGS__); } while(0)
 
 // Optional domain helpers
-#define LOG_BLE(fmt, ...)  BL_LOG_RAW(BLK_FG_MAG, BLK_EMJ_BLE, fmt, ##__VA_ARGS__)
-#define LOG_CFG(fmt, ...)  BL_LOG_RAW(BLK_FG_BLU, BLK_EMJ_CFG, fmt, ##__VA_ARGS__)
-#define LOG_PIN(fmt, ...)  BL_LOG_RAW(BLK_FG_GRN, BLK_EMJ_PIN, fmt, ##__VA_ARGS__)
+#define LOG_BLE(fmt, ...)  BL_LOG_AT(Info, BLK_FG_MAG, BLK_EMJ_BLE, fmt, ##__VA_ARGS__)
+#define LOG_CFG(fmt, ...)  BL_LOG_AT(Info, BLK_FG_BLU, BLK_EMJ_CFG, fmt, ##__VA_ARGS__)
+#define LOG_PIN(fmt, ...)  BL_LOG_AT(Info, BLK_FG_GRN, BLK_EMJ_PIN, fmt, ##__VA_ARGS__)
@@ -0,0 +1,73 @@
+#pragma once
+
+/**
+ * @file BeamPlatform.h
+ * @brief Arduino stand-ins for building portable BeamLink modules on the host
+ *
+ * On the device this simply pulls in Arduino.h. Under PlatformIO's `native`
+ * platform it provides the few Arduino symbols the portable modules rely on
+ * (millis, micros, delay, yield, Serial) so their logic can be unit-tested and
+ * benchmarked without a board. Modules that talk to NimBLE or ESP-IDF drivers
+ * keep including Arduino.h directly.
+ */
+
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+
+#else
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <thread>
+
+namespace beamplatform {
+
+/**
+ * @brief Monotonic reference point shared by millis() and micros()
+ */
+inline std::chrono::steady_clock::time_point bootTime() {
+  static const auto start = std::chrono::steady_clock::now();
+  return start;
+}
+
+} // namespace beamplatform
+
+inline unsigned long millis() {
+  return static_cast<unsigned long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - beamplatform::bootTime()).count());
+}
+
+inline unsigned long micros() {
+  return static_cast<unsigned long>(std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - beamplatform::bootTime()).count());
+}
+
+inline void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void yield() {
+  std::this_thread::yield();
+}
+
+/**
+ * @brief Minimal Serial replacement that writes to stdout
+ */
+struct HostSerial {
+  void print(const char* s) { std::fputs(s, stdout); }
+  void println(const char* s = "") { std::puts(s); }
+
+  int printf(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = std::vprintf(fmt, args);
+    va_end(args);
+    return n;
+  }
+};
+
+inline HostSerial Serial;
+
+#endif
@@ -0,0 +1,187 @@
+#pragma once
+#include "BeamPlatform.h"
+#include <cstdint>
+#include <mutex>
+
+#if defined(ARDUINO) && defined(ESP32)
+#include <sdkconfig.h>
+#include <esp_pm.h>
+#endif
+
+/**
+ * @file BeamPower.h
+ * @brief Power policy: automatic light sleep and CPU frequency scaling
+ *
+ * On ESP32 begin() configures esp_pm for dynamic frequency scaling between
+ * minFreqMhz and maxFreqMhz and, optionally, automatic light sleep. Both only
+ * happen while no power-management lock is held, so BeamPower holds a single
+ * ESP_PM_CPU_FREQ_MAX lock while there is work to do:
+ *
+ * - Busy:   a handler, a notification or loop() work is in progress
+ * - Linger: briefly after BLE activity, so a follow-up command is handled at
+ *           full speed instead of waking from light sleep
+ * - Idle:   nothing pending; the CPU may drop to minFreqMhz and light sleep
+ *           between BLE connection events
+ *
+ * The policy and the per-state time accounting are the same on the host,
+ * where no lock exists and holdsLock() shows what would have been held.
+ * Requires CONFIG_PM_ENABLE (and CONFIG_FREERTOS_USE_TICKLESS_IDLE for light
+ * sleep); without them begin() returns false and only the accounting runs.
+ */
+
+/**
+ * @brief Policy states, in order of precedence
+ */
+enum class BeamPowerState : uint8_t {
+  Busy = 0,
+  Linger,
+  Idle,
+};
+
+/**
+ * @brief Why work is pending; each reason nests independently
+ */
+enum class BeamPowerReason : uint8_t {
+  Handler = 0,  ///< BeamLink message handler running
+  Tx,           ///< Notification being encoded and queued
+  App,          ///< Application work, e.g. the body of loop()
+};
+
+constexpr uint8_t kBeamPowerStates = 3;
+constexpr uint8_t kBeamPowerReasons = 3;
+
+/**
+ * @brief esp_pm settings and linger time
+ */
+struct BeamPowerConfig {
+  uint16_t maxFreqMhz = 240;  ///< While the lock is held
+  uint16_t minFreqMhz = 80;   ///< While idle (80 keeps the APB clock at 80 MHz)
+  bool lightSleep = true;     ///< Automatic light sleep while idle
+  uint32_t lingerMs = 50;     ///< Stay at full speed after BLE activity; 0 disables
+};
+
+/**
+ * @brief Time per state and lock counters (see BeamPower::stats())
+ */
+struct BeamPowerStats {
+  uint64_t timeUs[kBeamPowerStates] = {};   ///< Indexed by BeamPowerState
+  uint32_t acquires[kBeamPowerReasons] = {}; ///< acquire() calls per BeamPowerReason
+  uint32_t lockTaken = 0;                   ///< Idle -> Busy/Linger transitions
+
+  uint64_t totalUs() const { return timeUs[0] + timeUs[1] + timeUs[2]; }
+
+  float percent(BeamPowerState state) const {
+    const uint64_t total = totalUs();
+    return total ? timeUs[static_cast<uint8_t>(state)] * 100.0f / total : 0.0f;
+  }
+};
+
+/**
+ * @brief Holds a power-management lock only while work is pending
+ *
+ * acquire()/release() and activity() are safe from any task (not ISRs);
+ * update() belongs to the task that sleeps, normally loop().
+ */
+class BeamPower {
+public:
+  static constexpr uint32_t kNever = UINT32_MAX;
+
+  /**
+   * @param clockUs Monotonic microsecond clock; nullptr uses esp_timer on
+   *                ESP32 and micros() on the host. Tests pass a fake clock.
+   */
+  explicit BeamPower(uint64_t (*clockUs)() = nullptr);
+  ~BeamPower();
+
+  BeamPower(const BeamPower&) = delete;
+  BeamPower& operator=(const BeamPower&) = delete;
+
+  /**
+   * @brief Apply the policy and, on ESP32, configure esp_pm
+   * @return true if esp_pm is managing the CPU; false means accounting only
+   */
+  bool begin(const BeamPowerConfig& config = BeamPowerConfig());
+
+  /**
+   * @brief Release the lock and pin the CPU at maxFreqMhz again
+   */
+  void end();
+
+  /**
+   * @brief Mark work as pending; the CPU runs at maxFreqMhz until release()
+   */
+  void acquire(BeamPowerReason reason);
+
+  /**
+   * @brief End work started by acquire() with the same reason
+   */
+  void release(BeamPowerReason reason);
+
+  /**
+   * @brief BLE traffic seen: stay at full speed for lingerMs from now
+   */
+  void activity();
+
+  /**
+   * @brief End an expired linger period
+   * @return Milliseconds until the linger period ends, or kNever; pass it to
+   *         waitForEvent() so the lock is dropped on time
+   */
+  uint32_t update();
+
+  BeamPowerState state() const;
+
+  /// True while the ESP_PM_CPU_FREQ_MAX lock is (or, on the host, would be) held
+  bool holdsLock() const;
+
+  /// True if begin() configured esp_pm
+  bool isManaged() const { return managed; }
+
+  /**
+   * @brief Time per state since begin() or resetStats(), including the current one
+   */
+  BeamPowerStats stats() const;
+
+  void resetStats();
+
+  /**
+   * @brief acquire() for the lifetime of a scope; a null BeamPower is ignored
+   */
+  class Hold {
+  public:
+    Hold(BeamPower* power, BeamPowerReason reason) : power(power), reason(reason) {
+      if (power) power->acquire(reason);
+    }
+    ~Hold() {
+      if (power) power->release(reason);
+    }
+    Hold(const Hold&) = delete;
+    Hold& operator=(const Hold&) = delete;
+
+  private:
+    BeamPower* power;
+    BeamPowerReason reason;
+  };
+
+private:
+  uint64_t (*clock)();
+  BeamPowerConfig config;
+  mutable std::mutex mutex;
+
+  uint8_t pending[kBeamPowerReasons] = {};
+  uint8_t pendingTotal = 0;
+  uint64_t lingerUntilUs = 0;
+  BeamPowerState current = BeamPowerState::Idle;
+  uint64_t sinceUs = 0;
+  BeamPowerStats counters;
+  bool lockHeld = false;
+  bool managed = false;
+
+#if defined(ARDUINO) && defined(ESP32) && CONFIG_PM_ENABLE
+  esp_pm_lock_handle_t lock = nullptr;
+#endif
+
+  BeamPowerState evaluate(uint64_t nowUs) const;
+  void transition(uint64_t nowUs);
+  void setLock(bool hold);
+};
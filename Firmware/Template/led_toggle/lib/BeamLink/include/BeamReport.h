@@ -0,0 +1,214 @@
+#pragma once
+#include "BeamPlatform.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+/**
+ * @file BeamReport.h
+ * @brief Report by exception: send a value only when it changed meaningfully
+ *
+ * Most telemetry repeats what the central already knows. A BeamReportFilter
+ * decides, per signal, whether a new value is worth a notification:
+ *
+ * - Deadband: the value moved more than this from the last one sent.
+ * - Threshold with hysteresis: the value crossed a level (upwards at
+ *   threshold, back down only below threshold - hysteresis), even by less
+ *   than the deadband.
+ * - Minimum interval: never two reports closer than this. The first change
+ *   after a quiet period goes out at once; later ones are held, and the
+ *   latest value is sent when the interval ends (if it still differs).
+ * - Heartbeat: after this long without a report, the current value is sent
+ *   anyway, so the central can tell a steady signal from a dead device.
+ *
+ * BeamReporter applies filters to keyed text values, such as NexState
+ * changes, and sends what passes through one callback.
+ *
+ * @example
+ * ```cpp
+ * BeamReportPolicy policy;
+ * policy.deadband = 0.5f;            // °C
+ * policy.minIntervalMs = cfg.reportIntervalMs;
+ * policy.heartbeatMs = cfg.heartbeatMs;
+ * BeamReportFilter temperature;
+ * temperature.begin(policy);
+ *
+ * if (temperature.offer(readTemperature())) send(temperature.value());
+ * // loop(): held-back changes and heartbeats
+ * if (temperature.update() == 0) send(temperature.value());
+ * ```
+ */
+
+/// Signals a BeamReporter tracks
+#ifndef BEAM_REPORT_MAX_SIGNALS
+#define BEAM_REPORT_MAX_SIGNALS 16
+#endif
+
+/**
+ * @brief When one signal is reported
+ */
+struct BeamReportPolicy {
+  float deadband = 0;          ///< Report changes larger than this (0: any change)
+  float threshold = NAN;       ///< Level whose crossing is always reported (NAN: none)
+  float hysteresis = 0;        ///< Dropping back below threshold needs threshold - hysteresis
+  uint32_t minIntervalMs = 0;  ///< Shortest time between two reports
+  uint32_t heartbeatMs = 0;    ///< Longest time without a report (0: no heartbeat)
+};
+
+/**
+ * @brief Report counters
+ */
+struct BeamReportStats {
+  uint32_t offered = 0;     ///< Values offered
+  uint32_t sent = 0;        ///< Reports, heartbeats included
+  uint32_t suppressed = 0;  ///< Offered values not sent right away
+  uint32_t heartbeats = 0;  ///< Reports sent only because the heartbeat expired
+
+  /// Offered values per report (10 means a tenth of the traffic)
+  float reduction() const { return sent ? static_cast<float>(offered) / sent : 0.0f; }
+};
+
+/**
+ * @brief Report-by-exception decision for one signal
+ *
+ * Times are millis() values; wrapping is handled.
+ */
+class BeamReportFilter {
+public:
+  static constexpr uint32_t kNever = UINT32_MAX;
+
+  /// Set the policy and forget everything reported so far (counters stay)
+  void begin(const BeamReportPolicy& policy);
+
+  /// Change the policy, keeping the last report
+  void setPolicy(const BeamReportPolicy& policy) { p = policy; }
+  const BeamReportPolicy& policy() const { return p; }
+
+  /**
+   * @brief Offer a new value
+   * @return true if it should be sent now (it then counts as reported)
+   */
+  bool offer(float value, uint32_t nowMs = millis());
+
+  /**
+   * @brief Offer a value that is only equal or different (text, enums)
+   * @param changed Differs from the last value reported
+   * @return true if it should be sent now
+   */
+  bool offerChange(bool changed, uint32_t nowMs = millis());
+
+  /**
+   * @brief Release a held-back change or a heartbeat when due
+   *
+   * When it returns 0, value() is to be sent now and counts as reported.
+   * @return 0 if a report is due, else milliseconds until one may be, or kNever
+   */
+  uint32_t update(uint32_t nowMs = millis());
+
+  /// Latest value offered
+  float value() const { return current; }
+  /// Value of the last report
+  float reported() const { return lastSent; }
+  bool hasReported() const { return reportedOnce; }
+  /// A change is waiting for the minimum interval to end
+  bool isPending() const { return pending; }
+
+  const BeamReportStats& stats() const { return counters; }
+  void resetStats() { counters = BeamReportStats{}; }
+
+private:
+  BeamReportPolicy p;
+  float current = 0;
+  float lastSent = 0;
+  uint32_t lastSentMs = 0;
+  bool hasValue = false;
+  bool reportedOnce = false;
+  bool reportedAbove = false;  ///< Threshold side at the last report
+  bool pending = false;
+  BeamReportStats counters;
+
+  bool decide(bool meaningful, uint32_t nowMs);
+  void markSent(uint32_t nowMs);
+};
+
+/**
+ * @brief Report-by-exception for keyed text values (e.g. NexState keys)
+ *
+ * Values that parse as numbers go through the deadband and threshold; any
+ * other text (true/false, "BLINKING") is reported when it changes.
+ * Each key gets the default policy unless setPolicy() gave it its own. Keys
+ * beyond BEAM_REPORT_MAX_SIGNALS are sent unfiltered.
+ */
+class BeamReporter {
+public:
+  using ReportFn = std::function<void(const std::string& key, const std::string& value)>;
+  static constexpr uint32_t kNever = BeamReportFilter::kNever;
+
+  void onReport(ReportFn fn) { reportFn = std::move(fn); }
+
+  /// Policy for keys without their own; applies to keys already seen, too
+  void setDefaultPolicy(const BeamReportPolicy& policy);
+  const BeamReportPolicy& defaultPolicy() const { return fallback; }
+
+  /**
+   * @brief Give one key its own policy
+   * @return false if BEAM_REPORT_MAX_SIGNALS keys are tracked already
+   */
+  bool setPolicy(std::string_view key, const BeamReportPolicy& policy);
+
+  /**
+   * @brief Offer a new value for key; reports it now if it passes
+   * @return true if it was reported
+   */
+  bool offer(std::string_view key, std::string_view value, uint32_t nowMs = millis());
+
+  /**
+   * @brief Report held-back changes and heartbeats that are due
+   * @return Milliseconds until the next one may be due, or kNever
+   */
+  uint32_t update(uint32_t nowMs = millis());
+
+  /**
+   * @brief Follow whether anyone receives the reports (e.g. a subscription)
+   *
+   * While inactive, offer() only records the latest value: nothing is
+   * reported or counted. Becoming active starts every key over and reports
+   * its latest value now, so a new listener gets the full state. Keys beyond
+   * BEAM_REPORT_MAX_SIGNALS are not replayed. Active by default.
+   */
+  void setActive(bool active, uint32_t nowMs = millis());
+  bool isActive() const { return active; }
+
+  /// Totals over all keys, unfiltered ones included
+  BeamReportStats stats() const;
+  void resetStats();
+
+  size_t signalCount() const { return count; }
+
+private:
+  struct Signal {
+    std::string key;
+    std::string value;     ///< Latest offered
+    std::string sentText;  ///< Last reported (text values)
+    BeamReportFilter filter;
+    bool numeric = false;  ///< Last report was a number
+    bool ownPolicy = false;
+    bool offered = false;  ///< value holds an offered value
+  };
+
+  Signal signals[BEAM_REPORT_MAX_SIGNALS];
+  size_t count = 0;
+  BeamReportPolicy fallback;
+  BeamReportStats unfiltered;
+  bool warned = false;
+  bool active = true;
+  ReportFn reportFn;
+
+  Signal* find(std::string_view key);
+  Signal* add(std::string_view key);
+  bool decide(Signal& s, uint32_t nowMs);
+  void send(Signal& s);
+};
@@ -0,0 +1,369 @@
+#pragma once
+#include "BeamPlatform.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+
+#if defined(ARDUINO) && defined(ESP32)
+#include <esp_timer.h>
+#else
+#include <thread>
+#endif
+
+struct BeamConfig;
+
+/**
+ * @file BeamSampler.h
+ * @brief Fixed-rate sampling of the sensor pins into lock-free rings
+ *
+ * A periodic timer reads every channel at rateHz and pushes the values into
+ * one ring per channel; loop() drains the rings and sends MTU-sized batches.
+ * Sample times no longer depend on when a BLE command arrives, and the
+ * sampling path neither allocates nor takes a lock.
+ *
+ * On ESP32 the timer is an esp_timer (hardware timer, callback on the
+ * esp_timer task, where analogRead() is allowed). On the host a thread
+ * stands in, and BeamSimAdc provides deterministic signals, so the whole
+ * path runs in unit tests; tick() can also be called directly.
+ *
+ * @example
+ * ```cpp
+ * BeamAnalogAdc adc;
+ * BeamSampler sampler;
+ *
+ * void setup() {
+ *   sampler.begin(adc, beamConfig, 200);   // SENSOR_PINS at 200 Hz
+ *   sampler.onBatchReady(32, [] { beam.signalEvent(BEAM_EVENT_USER); });
+ *   sampler.start();
+ * }
+ *
+ * void loop() {
+ *   uint8_t batch[244];
+ *   size_t n = sampler.readBatch(0, batch, sizeof(batch));
+ *   if (n) beam.notify(samples, batch, n);
+ * }
+ * ```
+ */
+
+#ifndef BEAM_SAMPLER_MAX_CHANNELS
+#define BEAM_SAMPLER_MAX_CHANNELS 4
+#endif
+
+#ifndef BEAM_SAMPLER_RING
+#define BEAM_SAMPLER_RING 256
+#endif
+
+/// analogRead() per channel per tick; faster capture needs a DMA source
+#ifndef BEAM_SAMPLER_MAX_RATE_HZ
+#define BEAM_SAMPLER_MAX_RATE_HZ 4000
+#endif
+
+/**
+ * @brief Bounded lock-free ring for one producer and one consumer
+ *
+ * The producer only writes head, the consumer only writes tail, so each
+ * side needs one acquire load and one release store per element.
+ *
+ * @tparam T Trivially copyable element type
+ * @tparam Capacity Number of elements (power of two)
+ */
+template<typename T, size_t Capacity>
+class BeamRing {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+  static_assert(std::is_trivially_copyable<T>::value, "BeamRing needs a trivially copyable type");
+
+public:
+  /**
+   * @brief Append an element (producer only)
+   * @return false if the ring is full; the element is dropped
+   */
+  bool push(const T& item) {
+    const size_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == Capacity) return false;
+    items[h & (Capacity - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Copy the oldest element without taking it (consumer only)
+   * @return false if the ring is empty
+   */
+  bool peek(T& item) const {
+    const size_t t = tail.load(std::memory_order_relaxed);
+    if (head.load(std::memory_order_acquire) == t) return false;
+    item = items[t & (Capacity - 1)];
+    return true;
+  }
+
+  /**
+   * @brief Take the oldest element (consumer only)
+   * @return false if the ring is empty
+   */
+  bool pop(T& item) {
+    const size_t t = tail.load(std::memory_order_relaxed);
+    if (head.load(std::memory_order_acquire) == t) return false;
+    item = items[t & (Capacity - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Elements waiting; exact for the consumer, a lower bound for others
+  size_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  /// Drop everything queued (consumer only)
+  void clear() { tail.store(head.load(std::memory_order_acquire), std::memory_order_release); }
+
+  static constexpr size_t capacity() { return Capacity; }
+
+private:
+  T items[Capacity] = {};
+  std::atomic<size_t> head{0};
+  std::atomic<size_t> tail{0};
+};
+
+/**
+ * @brief One reading of one channel
+ */
+struct BeamSample {
+  uint32_t timeUs;  ///< micros() when it was read
+  uint16_t value;   ///< Raw ADC counts (12 bit on ESP32)
+};
+
+/**
+ * @brief Where samples come from
+ */
+class BeamAdc {
+public:
+  virtual ~BeamAdc() = default;
+
+  /**
+   * @brief Prepare the pins (called by BeamSampler::begin())
+   */
+  virtual bool begin(const uint8_t* pins, size_t count) {
+    (void)pins;
+    (void)count;
+    return true;
+  }
+
+  /**
+   * @brief Read one channel; called from the sampling timer
+   * @param channel Index into the pins given to begin()
+   * @param timeUs Sampling instant (used by simulated sources)
+   */
+  virtual uint16_t read(uint8_t channel, uint32_t timeUs) = 0;
+};
+
+/**
+ * @brief Simulated ADC: offset + sine + noise per channel, 12-bit, repeatable
+ */
+class BeamSimAdc : public BeamAdc {
+public:
+  struct Signal {
+    float offset = 2048;    ///< Counts
+    float amplitude = 0;    ///< Counts, peak
+    float frequencyHz = 0;
+    float noise = 0;        ///< Counts, peak of uniform noise
+  };
+
+  void setSignal(uint8_t channel, const Signal& signal);
+
+  uint16_t read(uint8_t channel, uint32_t timeUs) override;
+
+  /// Reads so far, across all channels
+  uint32_t reads() const { return readCount; }
+
+private:
+  Signal signals[BEAM_SAMPLER_MAX_CHANNELS];
+  uint32_t noiseState = 0x12345678u;
+  uint32_t readCount = 0;
+};
+
+#if defined(ARDUINO)
+/**
+ * @brief analogRead() on the configured pins (11 dB attenuation, 12 bit)
+ */
+class BeamAnalogAdc : public BeamAdc {
+public:
+  bool begin(const uint8_t* pins, size_t count) override;
+  uint16_t read(uint8_t channel, uint32_t timeUs) override;
+
+private:
+  uint8_t pins[BEAM_SAMPLER_MAX_CHANNELS] = {};
+};
+#endif
+
+/**
+ * @brief Sampling counters (see BeamSampler::stats())
+ */
+struct BeamSamplerStats {
+  uint32_t ticks = 0;          ///< Sampling instants
+  uint32_t samples = 0;        ///< Values stored
+  uint32_t overruns = 0;       ///< Values dropped because a ring was full
+  uint32_t lateTicks = 0;      ///< Ticks more than half a period late
+  uint32_t maxLatenessUs = 0;  ///< Worst tick delay behind its schedule
+  uint32_t batches = 0;        ///< readBatch() results handed out
+};
+
+/**
+ * @brief Parse a pin list such as "34,35" (SENSOR_PINS)
+ * @return Pins stored, or 0 if the list is empty, malformed or too long
+ */
+size_t beamParsePins(std::string_view text, uint8_t* pins, size_t maxPins);
+
+/**
+ * @brief Batch layouts written by BeamSampler::readBatch()
+ *
+ * Raw (1):
+ *
+ *     format (1) | channel (1) | count (1) | count x (timeUs u32 LE, value u16 LE)
+ *
+ * Delta (2) and XOR (3), see BeamBatchCodec.h:
+ *
+ *     format (1) | channel (1) | count (1) | timeUs u32 LE | value u16 LE |
+ *     (count - 1) x (zigzag varint time delta-of-delta, varint value code)
+ *
+ * The value code is the zigzag difference to the previous value (2) or the
+ * previous value XOR this one (3).
+ */
+constexpr uint8_t kBeamBatchRaw = 1;
+constexpr uint8_t kBeamBatchDelta = 2;
+constexpr uint8_t kBeamBatchXor = 3;
+constexpr size_t kBeamBatchHeader = 3;
+constexpr size_t kBeamBatchRawSample = 6;
+
+/// Samples that fit a raw batch of capacity bytes (at most 255)
+size_t beamBatchSamples(size_t capacity);
+
+/**
+ * @brief Encode samples already read as a raw batch
+ *
+ * For callers that use the samples too (e.g. aggregate them) before sending.
+ * @return Bytes written; 0 if n is 0 or capacity is too small. Samples past
+ *         beamBatchSamples(capacity) are left out.
+ */
+size_t beamEncodeBatch(uint8_t channel, const BeamSample* samples, size_t n, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Decode a batch of any format (for centrals and tests)
+ * @return Samples in the batch, or -1 if malformed; at most maxSamples are stored
+ */
+int beamDecodeBatch(const uint8_t* data, size_t size, uint8_t* channel, BeamSample* out, size_t maxSamples);
+
+class BeamSampler {
+public:
+  using Ring = BeamRing<BeamSample, BEAM_SAMPLER_RING>;
+  using ReadyFn = std::function<void()>;
+
+  BeamSampler() = default;
+  ~BeamSampler();
+
+  BeamSampler(const BeamSampler&) = delete;
+  BeamSampler& operator=(const BeamSampler&) = delete;
+
+  /**
+   * @brief Set up the channels; nothing is sampled until start()
+   * @param rateHz Samples per second per channel, 1 to BEAM_SAMPLER_MAX_RATE_HZ
+   * @return false on invalid input, too many pins, or if the ADC refuses them
+   */
+  bool begin(BeamAdc& adc, const uint8_t* pins, size_t count, uint32_t rateHz);
+
+  /**
+   * @brief begin() with the pins in BeamConfig::sensorPins
+   */
+  bool begin(BeamAdc& adc, const BeamConfig& cfg, uint32_t rateHz);
+
+  /**
+   * @brief Call fn from the sampling context whenever a channel reaches
+   *        threshold samples (once per threshold, not on every tick)
+   *
+   * Set before start(). fn must be short and non-blocking, e.g.
+   * BeamLink::signalEvent().
+   */
+  void onBatchReady(size_t threshold, ReadyFn fn);
+
+  /**
+   * @brief Start the periodic timer
+   */
+  bool start();
+
+  void stop();
+
+  bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief One sampling instant: read every channel and store the values
+   *
+   * What the timer runs. Call directly when driving the sampler by hand
+   * (tests, or an external timer), never while start() is active.
+   */
+  void tick(uint32_t nowUs = micros());
+
+  /// Samples waiting in a channel's ring
+  size_t available(uint8_t channel) const;
+
+  /**
+   * @brief Take up to max samples, oldest first (consumer task only)
+   */
+  size_t read(uint8_t channel, BeamSample* out, size_t max);
+
+  /**
+   * @brief Take as many samples as fit in capacity bytes and encode them
+   *        (consumer task only)
+   * @param capacity Usually BeamLink::getMTU() - 3
+   * @param format kBeamBatchRaw, kBeamBatchDelta or kBeamBatchXor
+   * @return Bytes written; 0 if the channel is empty or capacity is too small
+   */
+  size_t readBatch(uint8_t channel, uint8_t* out, size_t capacity, uint8_t format = kBeamBatchRaw);
+
+  /// Drop a channel's samples without encoding them, e.g. nobody is subscribed
+  void discard(uint8_t channel);
+
+  /// Most recent value of a channel (any task)
+  uint16_t latest(uint8_t channel) const;
+
+  uint8_t channelCount() const { return channels; }
+  uint8_t pin(uint8_t channel) const { return channel < channels ? pins[channel] : 0; }
+  uint32_t rateHz() const { return rate; }
+  uint32_t periodUs() const { return period; }
+
+  BeamSamplerStats stats() const;
+  void resetStats();
+
+private:
+  BeamAdc* adc = nullptr;
+  uint8_t pins[BEAM_SAMPLER_MAX_CHANNELS] = {};
+  uint8_t channels = 0;
+  uint32_t rate = 0;
+  uint32_t period = 0;
+  Ring rings[BEAM_SAMPLER_MAX_CHANNELS];
+  std::atomic<uint16_t> latestValue[BEAM_SAMPLER_MAX_CHANNELS] = {};
+
+  ReadyFn ready;
+  size_t readyThreshold = 0;
+  bool readyArmed[BEAM_SAMPLER_MAX_CHANNELS] = {};
+
+  uint32_t nextDueUs = 0;
+  bool scheduled = false;
+  std::atomic<bool> running{false};
+
+  // Written by the sampling context, read by stats()
+  std::atomic<uint32_t> ticks{0};
+  std::atomic<uint32_t> samples{0};
+  std::atomic<uint32_t> overruns{0};
+  std::atomic<uint32_t> lateTicks{0};
+  std::atomic<uint32_t> maxLatenessUs{0};
+  uint32_t batches = 0;
+
+#if defined(ARDUINO) && defined(ESP32)
+  esp_timer_handle_t timer = nullptr;
+  static void timerCallback(void* arg);
+#else
+  std::thread worker;
+#endif
+};
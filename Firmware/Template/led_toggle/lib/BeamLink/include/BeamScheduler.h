@@ -0,0 +1,144 @@
+#pragma once
+#include "BeamPlatform.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * @file BeamScheduler.h
+ * @brief Cooperative one-shot and periodic timers for loop()
+ *
+ * Replaces `millis() - last >= interval` polling: callbacks are registered
+ * once and run from run() when due, and msUntilNext() tells loop() how long
+ * it may sleep. Timers live in a three-level hierarchical timing wheel
+ * (64 slots each, 1 ms / 64 ms / 4096 ms per slot) with an occupancy bitmap
+ * per level, so scheduling, cancelling and finding the next event are O(1)
+ * regardless of how many timers are armed.
+ *
+ * Not thread-safe: schedule, cancel and run from one task (normally loop()).
+ * Other tasks should post work to that task instead.
+ *
+ * @example
+ * ```cpp
+ * BeamScheduler scheduler;
+ *
+ * void setup() {
+ *   scheduler.every(1000, [] { printStatus(); });
+ *   scheduler.after(5000, [] { Serial.println("5 s after boot"); });
+ * }
+ *
+ * void loop() {
+ *   scheduler.run();
+ *   delay(std::min<uint32_t>(scheduler.msUntilNext(), 10));
+ * }
+ * ```
+ */
+
+#ifndef BEAM_SCHEDULER_MAX_TIMERS
+#define BEAM_SCHEDULER_MAX_TIMERS 16
+#endif
+
+/**
+ * @brief Handle for a scheduled callback; 0 is never a valid timer
+ */
+using BeamTimerId = uint32_t;
+
+class BeamScheduler {
+public:
+  using Callback = std::function<void()>;
+
+  /// Returned by msUntilNext() when no timer is armed
+  static constexpr uint32_t kNever = UINT32_MAX;
+
+  /**
+   * @param nowMs Current time; timers are scheduled relative to it
+   */
+  explicit BeamScheduler(uint32_t nowMs = millis());
+
+  /**
+   * @brief Run fn once, delayMs from now
+   * @return Timer handle, or 0 if all BEAM_SCHEDULER_MAX_TIMERS are in use
+   */
+  BeamTimerId after(uint32_t delayMs, Callback fn, uint32_t nowMs = millis());
+
+  /**
+   * @brief Run fn every periodMs, first after firstDelayMs (default: one period)
+   *
+   * Late runs keep the original phase; periods missed entirely are skipped
+   * rather than replayed in a burst.
+   * @return Timer handle, or 0 if the pool is full or periodMs is 0
+   */
+  BeamTimerId every(uint32_t periodMs, Callback fn, uint32_t nowMs = millis(),
+                    uint32_t firstDelayMs = kNever);
+
+  /**
+   * @brief Stop a timer; safe from inside its own callback
+   * @param id Handle, reset to 0
+   * @return true if the timer was armed
+   */
+  bool cancel(BeamTimerId& id);
+
+  /**
+   * @brief True while id refers to an armed timer
+   */
+  bool isScheduled(BeamTimerId id) const;
+
+  /**
+   * @brief Run every callback due at or before nowMs (call from loop())
+   *
+   * Timers scheduled from a callback with a zero delay run on the next call.
+   * @return Number of callbacks run
+   */
+  size_t run(uint32_t nowMs = millis());
+
+  /**
+   * @brief Milliseconds until the next callback is due
+   * @return 0 if one is already due, kNever if no timer is armed
+   */
+  uint32_t msUntilNext(uint32_t nowMs = millis()) const;
+
+  /**
+   * @brief Number of armed timers
+   */
+  size_t size() const { return active; }
+
+private:
+  static constexpr uint8_t kNone = 0xFF;
+  static constexpr uint8_t kLevels = 3;
+  static constexpr uint8_t kSlotBits = 6;
+  static constexpr uint8_t kSlots = 1 << kSlotBits;
+
+  static_assert(BEAM_SCHEDULER_MAX_TIMERS < kNone, "BEAM_SCHEDULER_MAX_TIMERS must be below 255");
+
+  struct Timer {
+    Callback fn;
+    uint32_t deadline = 0;
+    uint32_t period = 0;
+    uint16_t generation = 0;
+    uint8_t next = kNone;
+    uint8_t prev = kNone;
+    uint8_t level = 0;
+    uint8_t slot = 0;
+    bool armed = false;
+    bool linked = false;
+  };
+
+  Timer timers[BEAM_SCHEDULER_MAX_TIMERS];
+  uint8_t heads[kLevels][kSlots];
+  uint64_t occupied[kLevels] = {};
+  uint32_t now;          ///< Last tick processed by run()
+  uint8_t freeList = kNone;
+  uint8_t firing = kNone;
+  size_t active = 0;
+
+  BeamTimerId schedule(uint32_t delayMs, uint32_t periodMs, Callback fn, uint32_t nowMs);
+  Timer* lookup(BeamTimerId id);
+  const Timer* lookup(BeamTimerId id) const;
+  void place(uint8_t index);
+  void unlink(uint8_t index);
+  void release(uint8_t index);
+  void cascade(uint8_t level);
+  size_t expire(uint32_t nowMs);
+  bool nextEvent(uint32_t& tick) const;
+  uint32_t earliestIn(uint8_t level, uint8_t slot) const;
+};
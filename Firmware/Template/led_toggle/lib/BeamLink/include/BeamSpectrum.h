@@ -0,0 +1,140 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file BeamSpectrum.h
+ * @brief Spectral features of a sample block: FFT magnitudes, band energies, RMS, peak
+ *
+ * For machine-health monitoring the interesting part of a vibration or
+ * current signal is its spectrum, and a few numbers describe it well
+ * enough: RMS, the dominant frequency and the energy per frequency band.
+ * BeamSpectrum computes them on the device from each block, so a central
+ * receives a handful of values instead of every sample.
+ *
+ * - Mean removed, then a Hann (or no) window.
+ * - Real FFT: an N/2-point complex FFT in radix-4 passes (radix-2^2
+ *   butterflies, one radix-2 pass when log2(N/2) is odd), then a split step.
+ * - Twiddles and the window come from a quarter-wave sine table computed at
+ *   compile time (constexpr), so it lives in flash and costs no RAM or boot
+ *   time.
+ *
+ * Everything is in float: the ESP32 has a single-precision FPU.
+ *
+ * @example
+ * ```cpp
+ * BeamSpectrum spectrum;
+ * BeamSpectrum::Config cfg;
+ * cfg.size = 256;
+ * cfg.rateHz = capture.rateHz();
+ * spectrum.begin(cfg);
+ *
+ * if (spectrum.analyze(block->values[0], block->count[0])) {
+ *   const BeamSpectrumFeatures& f = spectrum.features();
+ *   report(f.rms, f.peakHz, f.bandEnergy, f.bands);
+ * }
+ * ```
+ */
+
+/// Largest FFT size (power of two); sets the twiddle table (size / 4 + 1 floats in flash)
+#ifndef BEAM_FFT_MAX_SIZE
+#define BEAM_FFT_MAX_SIZE 1024
+#endif
+
+/// Smallest FFT size
+#define BEAM_FFT_MIN_SIZE 16
+
+/// Most frequency bands per spectrum
+#ifndef BEAM_SPECTRUM_MAX_BANDS
+#define BEAM_SPECTRUM_MAX_BANDS 8
+#endif
+
+enum BeamFftWindow : uint8_t {
+  kBeamWindowRectangular = 0,  ///< No window: exact for bin-centred tones, leaks otherwise
+  kBeamWindowHann = 1,         ///< Low leakage; the default
+};
+
+/**
+ * @brief What one block reduces to
+ *
+ * Energies are mean squares in counts^2: with a rectangular window the
+ * bands add up to rms^2 (Parseval), with Hann approximately.
+ */
+struct BeamSpectrumFeatures {
+  uint32_t samples = 0;   ///< Samples analysed (the FFT size)
+  float mean = 0;         ///< DC level, removed before the FFT
+  float rms = 0;          ///< RMS around the mean (time domain)
+  float peakHz = 0;       ///< Strongest non-DC frequency, interpolated between bins
+  float peakAmplitude = 0;  ///< Amplitude of that component (a sine of amplitude A gives ~A)
+  uint8_t bands = 0;
+  float bandEnergy[BEAM_SPECTRUM_MAX_BANDS] = {};
+};
+
+/**
+ * @brief Real FFT and spectral features for blocks of a fixed size
+ *
+ * Not thread-safe; one instance per channel if they are analysed in
+ * parallel, or one shared instance called in turn.
+ */
+class BeamSpectrum {
+public:
+  struct Config {
+    size_t size = 256;           ///< FFT size: power of two, BEAM_FFT_MIN_SIZE to BEAM_FFT_MAX_SIZE
+    float rateHz = 1000;         ///< Sample rate, for bin frequencies
+    BeamFftWindow window = kBeamWindowHann;
+    uint8_t bands = 4;           ///< 1 to BEAM_SPECTRUM_MAX_BANDS
+    /**
+     * bands + 1 ascending edges in Hz, or nullptr for equal widths from 0 to
+     * rateHz / 2. Copied by begin().
+     */
+    const float* bandEdgesHz = nullptr;
+  };
+
+  /**
+   * @return false for an unsupported size, band count, rate or band edges
+   */
+  bool begin(const Config& config);
+
+  /**
+   * @brief Analyse the first size() samples
+   * @return false if n < size() (nothing analysed) or begin() failed
+   */
+  bool analyze(const uint16_t* samples, size_t n);
+  bool analyze(const int16_t* samples, size_t n);
+  bool analyze(const float* samples, size_t n);
+
+  /// Features of the last analysed block
+  const BeamSpectrumFeatures& features() const { return result; }
+
+  /**
+   * @brief Amplitude spectrum of the last block, bins() values
+   *
+   * Bin k is k x binHz(); scaled like peakAmplitude. Bin 0 is ~0 (mean removed).
+   */
+  const float* magnitudes() const { return mag; }
+  size_t bins() const { return n / 2 + 1; }
+  float binHz() const { return cfg.rateHz / n; }
+
+  size_t size() const { return n; }
+  const Config& config() const { return cfg; }
+
+private:
+  Config cfg;
+  size_t n = 0;
+  float edges[BEAM_SPECTRUM_MAX_BANDS + 1] = {};
+  float work[BEAM_FFT_MAX_SIZE] = {};           ///< Windowed input, then N/2 complex values
+  float mag[BEAM_FFT_MAX_SIZE / 2 + 1] = {};
+  BeamSpectrumFeatures result;
+
+  template <typename T>
+  bool run(const T* samples, size_t count);
+};
+
+/**
+ * @brief In-place complex FFT (forward), interleaved re/im
+ *
+ * The kernel behind BeamSpectrum, exposed for tests and other transforms.
+ * @param points Power of two, 1 to BEAM_FFT_MAX_SIZE / 2
+ * @return false for an unsupported size
+ */
+bool beamFftComplex(float* data, size_t points);
@@ -0,0 +1,163 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file BeamStaticConfig.h
+ * @brief Compile-time BeamLink configuration kept in flash
+ *
+ * BeamConfig holds runtime copies (std::string) so values can come from a
+ * file. When a setting is fixed at build time (beam.config.h), a constexpr
+ * BeamStaticConfig keeps the literals in flash, stores UUIDs as pre-parsed
+ * 128-bit values and lets the compiler reject out-of-range values, so
+ * BeamLink::begin() has nothing left to copy, parse or clamp.
+ *
+ * @example
+ * ```cpp
+ * #include "beam.config.h"
+ *
+ * constexpr BeamStaticConfig kBeamConfig(DEVICE_ID, DEVICE_NAME, DEVICE_TYPE, FIRMWARE_VERSION,
+ *                                        BLE_NAME, BLE_POWER_DBM, BLE_ADV_INTERVAL_MS,
+ *                                        BLE_SERVICE_UUID, BLE_CHARACTERISTIC_UUID,
+ *                                        LED_PIN, LED_ACTIVE_HIGH);
+ * BEAM_STATIC_ASSERT_CONFIG(kBeamConfig);
+ *
+ * void setup() {
+ *   beam.begin(kBeamConfig);
+ * }
+ * ```
+ */
+
+namespace beamcfg {
+
+// Limits shared by the compile-time checks and the runtime validation
+constexpr int kMinPowerDbm = -12;       ///< Lowest ESP32 BLE TX power
+constexpr int kMaxPowerDbm = 9;         ///< Highest ESP32 BLE TX power
+constexpr int kPowerStepDb = 3;         ///< ESP32 BLE TX power levels are 3 dB apart
+constexpr int kMinAdvIntervalMs = 20;   ///< BLE spec minimum advertising interval
+constexpr int kMaxAdvIntervalMs = 10240;///< BLE spec maximum advertising interval
+constexpr int kMaxPin = 39;             ///< Highest ESP32 GPIO number
+constexpr size_t kMaxNameLength = 29;   ///< Complete local name in one 31-byte AD payload
+
+/// In range and on one of the power levels the radio has (-12, -9, ... +9 dBm)
+constexpr bool powerValid(int dbm) {
+  return dbm >= kMinPowerDbm && dbm <= kMaxPowerDbm && (dbm - kMinPowerDbm) % kPowerStepDb == 0;
+}
+
+/**
+ * @brief 128-bit UUID in over-the-air (least significant byte first) order
+ */
+struct Uuid128 {
+  uint8_t bytes[16] = {};
+};
+
+/**
+ * @brief Length of a string literal, usable in constant expressions
+ */
+constexpr size_t length(const char* s) {
+  size_t n = 0;
+  while (s && s[n]) n++;
+  return n;
+}
+
+/**
+ * @brief Value of a hex digit, or -1
+ */
+constexpr int hexValue(char c) {
+  return (c >= '0' && c <= '9') ? c - '0'
+       : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+       : (c >= 'A' && c <= 'F') ? c - 'A' + 10
+       : -1;
+}
+
+/**
+ * @brief Check the 8-4-4-4-12 hex form of a 128-bit UUID
+ */
+constexpr bool isUuid128(const char* s) {
+  if (length(s) != 36) return false;
+  for (size_t i = 0; i < 36; i++) {
+    const bool dash = (i == 8 || i == 13 || i == 18 || i == 23);
+    if (dash ? s[i] != '-' : hexValue(s[i]) < 0) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Parse a UUID string checked with isUuid128()
+ * @return The UUID, or all zeros if the text is malformed
+ */
+constexpr Uuid128 parseUuid128(const char* s) {
+  Uuid128 uuid;
+  if (!isUuid128(s)) return uuid;
+  size_t out = 16;
+  for (size_t i = 0; i < 36; i += 2) {
+    if (s[i] == '-') i++;
+    uuid.bytes[--out] = static_cast<uint8_t>(hexValue(s[i]) << 4 | hexValue(s[i + 1]));
+  }
+  return uuid;
+}
+
+} // namespace beamcfg
+
+/**
+ * @struct BeamStaticConfig
+ * @brief Build-time configuration; all strings point at literals in flash
+ *
+ * Numeric fields are kept as int so that out-of-range values from
+ * beam.config.h reach BEAM_STATIC_ASSERT_CONFIG() unchanged instead of being
+ * truncated first.
+ */
+struct BeamStaticConfig {
+  const char* deviceId;
+  const char* deviceName;
+  const char* deviceType;
+  const char* fwVersion;
+  const char* bleName;
+  int blePowerDbm;
+  int bleAdvIntervalMs;
+  const char* bleServiceUuid;           ///< Text form, for logging
+  const char* bleCharacteristicUuid;    ///< Text form, for logging
+  beamcfg::Uuid128 serviceUuid;         ///< Parsed at compile time
+  beamcfg::Uuid128 characteristicUuid;  ///< Parsed at compile time
+  int ledPin;
+  bool ledActiveHigh;
+
+  constexpr BeamStaticConfig(const char* deviceId, const char* deviceName, const char* deviceType,
+                             const char* fwVersion, const char* bleName, int blePowerDbm,
+                             int bleAdvIntervalMs, const char* bleServiceUuid,
+                             const char* bleCharacteristicUuid, int ledPin, bool ledActiveHigh)
+      : deviceId(deviceId), deviceName(deviceName), deviceType(deviceType), fwVersion(fwVersion),
+        bleName(bleName), blePowerDbm(blePowerDbm), bleAdvIntervalMs(bleAdvIntervalMs),
+        bleServiceUuid(bleServiceUuid), bleCharacteristicUuid(bleCharacteristicUuid),
+        serviceUuid(beamcfg::parseUuid128(bleServiceUuid)),
+        characteristicUuid(beamcfg::parseUuid128(bleCharacteristicUuid)),
+        ledPin(ledPin), ledActiveHigh(ledActiveHigh) {}
+
+  constexpr bool powerValid() const {
+    return beamcfg::powerValid(blePowerDbm);
+  }
+  constexpr bool intervalValid() const {
+    return bleAdvIntervalMs >= beamcfg::kMinAdvIntervalMs && bleAdvIntervalMs <= beamcfg::kMaxAdvIntervalMs;
+  }
+  constexpr bool pinValid() const { return ledPin >= 0 && ledPin <= beamcfg::kMaxPin; }
+  constexpr bool nameValid() const {
+    return beamcfg::length(bleName) > 0 && beamcfg::length(bleName) <= beamcfg::kMaxNameLength;
+  }
+  constexpr bool uuidsValid() const {
+    return beamcfg::isUuid128(bleServiceUuid) && beamcfg::isUuid128(bleCharacteristicUuid);
+  }
+  constexpr bool valid() const {
+    return powerValid() && intervalValid() && pinValid() && nameValid() && uuidsValid();
+  }
+};
+
+/**
+ * @brief Reject an invalid BeamStaticConfig at compile time, one message per field
+ * @param cfg A constexpr BeamStaticConfig
+ */
+#define BEAM_STATIC_ASSERT_CONFIG(cfg)                                                           \
+  static_assert((cfg).powerValid(), "BLE_POWER_DBM must be -12 to 9 in 3 dB steps");            \
+  static_assert((cfg).intervalValid(), "BLE_ADV_INTERVAL_MS must be between 20 and 10240");      \
+  static_assert((cfg).pinValid(), "LED_PIN must be a GPIO between 0 and 39");                    \
+  static_assert((cfg).nameValid(), "BLE_NAME must be 1 to 29 characters");                       \
+  static_assert((cfg).uuidsValid(), "BLE UUIDs must be 128-bit xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx")
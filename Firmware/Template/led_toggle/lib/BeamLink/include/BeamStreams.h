@@ -0,0 +1,112 @@
+#pragma once
+#include "BeamPlatform.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * @file BeamStreams.h
+ * @brief Extra GATT characteristics for dedicated data streams
+ *
+ * The main characteristic carries commands and their replies. Telemetry,
+ * state changes or logs can each get a characteristic of their own, so a
+ * central subscribes only to what it shows and a busy stream does not
+ * delay replies. BeamLink::addStream() declares them before begin().
+ *
+ * This registry is the portable part: definitions, the subscription bit per
+ * stream (set from its CCCD by the NimBLE host task) and counters. Check
+ * isSubscribed() before encoding, so data nobody reads costs no CPU.
+ */
+
+#ifndef BEAM_MAX_STREAMS
+#define BEAM_MAX_STREAMS 4
+#endif
+
+/**
+ * @brief Stream characteristic properties (combine with |)
+ */
+enum BeamStreamProperty : uint8_t {
+  BEAM_STREAM_NOTIFY = 1u << 0,  ///< Device to central, as notifications
+  BEAM_STREAM_WRITE = 1u << 1,   ///< Central to device, with or without response
+  BEAM_STREAM_READ = 1u << 2,    ///< Last value notified can be read
+};
+
+/// Index of a stream, in the order added
+using BeamStreamId = uint8_t;
+constexpr BeamStreamId kBeamNoStream = 0xFF;
+
+/**
+ * @brief Called on the NimBLE host task with the bytes a central wrote
+ */
+using BeamStreamHandler = std::function<void(const uint8_t* data, size_t size)>;
+
+/**
+ * @brief Per-stream counters
+ */
+struct BeamStreamStats {
+  uint32_t sent = 0;       ///< Notifications queued
+  uint32_t skipped = 0;    ///< notify() calls with nobody subscribed
+  uint32_t truncated = 0;  ///< Notifications cut to the MTU
+  uint32_t received = 0;   ///< Writes handled
+};
+
+/**
+ * @brief One declared stream
+ */
+struct BeamStream {
+  const char* name = "";      ///< For logs and find(); must outlive the registry (a literal)
+  char uuid[37] = {};         ///< 128-bit UUID text
+  uint8_t properties = 0;     ///< BeamStreamProperty bits
+  BeamStreamHandler handler;  ///< For BEAM_STREAM_WRITE
+};
+
+class BeamStreams {
+public:
+  /**
+   * @brief Declare a stream
+   * @param name Unique, non-empty
+   * @param uuid 128-bit UUID, different from every other stream
+   * @param properties BeamStreamProperty bits, at least one
+   * @param handler Receives writes; required with BEAM_STREAM_WRITE
+   * @return Stream id, or kBeamNoStream on invalid input or BEAM_MAX_STREAMS reached
+   */
+  BeamStreamId add(const char* name, const char* uuid, uint8_t properties, BeamStreamHandler handler = nullptr);
+
+  size_t size() const { return count; }
+
+  /// Definition of a valid id (see size())
+  const BeamStream& operator[](BeamStreamId id) const { return streams[id]; }
+
+  /// Id of the stream with this name or UUID, or kBeamNoStream
+  BeamStreamId find(const char* nameOrUuid) const;
+
+  /**
+   * @brief Record a CCCD write (NimBLE host task)
+   */
+  void setSubscribed(BeamStreamId id, bool subscribed);
+
+  /// All streams unsubscribed, e.g. on disconnect
+  void clearSubscriptions() { subscribed.store(0, std::memory_order_relaxed); }
+
+  /// Lock-free; safe from any task
+  bool isSubscribed(BeamStreamId id) const {
+    return id < count && (subscribed.load(std::memory_order_relaxed) & (1u << id));
+  }
+
+  /// Bit n set if stream n is subscribed
+  uint32_t subscribedMask() const { return subscribed.load(std::memory_order_relaxed); }
+
+  void countSent(BeamStreamId id, bool truncated);
+  void countSkipped(BeamStreamId id);
+  void countReceived(BeamStreamId id);
+
+  BeamStreamStats stats(BeamStreamId id) const;
+  void resetStats();
+
+private:
+  BeamStream streams[BEAM_MAX_STREAMS];
+  BeamStreamStats counters[BEAM_MAX_STREAMS];
+  uint8_t count = 0;
+  std::atomic<uint32_t> subscribed{0};
+};
@@ -1,5 +1,8 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
 
@@ -133,5 +136,99 @@ namespace BeamUtils {
    */
   std::string formatUptime(unsigned long uptimeMs);
 
+  // ---- Non-allocating helpers (views into the caller's buffer) ----
+
+  /**
+   * @brief Trim whitespace from both ends without copying
+   * 
+   * @param str Text to trim
+   * @return View of the trimmed text (same storage as str)
+   */
+  std::string_view trimView(std::string_view str);
+
+  /**
+   * @brief Take the next line off the front of a text buffer
+   * 
+   * Handles both "\n" and "\r\n" line endings.
+   * 
+   * @param text Remaining text; advanced past the returned line
+   * @param line Output view of the line, without its line ending
+   * @return false when text is exhausted
+   * 
+   * @example
+   * ```cpp
+   * std::string_view text = fileContents, line;
+   * while (nextLine(text, line)) {
+   *   // ...
+   * }
+   * ```
+   */
+  bool nextLine(std::string_view& text, std::string_view& line);
+
+  /**
+   * @brief Split "key<sep>value" at the first separator, trimming both parts
+   * 
+   * @param str Text to split
+   * @param separator Separator character (e.g. '=')
+   * @param key Output view of the key
+   * @param value Output view of the value (may be empty)
+   * @return false if there is no separator or the key is empty
+   */
+  bool splitPair(std::string_view str, char separator, std::string_view& key, std::string_view& value);
+
+  /**
+   * @brief Parse a whole string as a signed decimal integer
+   * 
+   * @param str Text such as "-12"
+   * @param out Parsed value
+   * @return false on empty input, stray characters or overflow
+   */
+  bool parseInt(std::string_view str, int32_t& out);
+
+  /**
+   * @brief Parse a whole string as a floating-point number
+   * 
+   * @param str Text such as "0.02"
+   * @param out Parsed value
+   * @return false if the text is not entirely a number
+   */
+  bool parseFloat(std::string_view str, float& out);
+
+  /**
+   * @brief Parse true/false, 1/0, yes/no or on/off (case-insensitive)
+   * 
+   * @param str Text to parse
+   * @param out Parsed value
+   * @return false if the text is not a recognised boolean
+   */
+  bool parseBool(std::string_view str, bool& out);
+
+  /**
+   * @brief Write the low bytes of a value, least significant first
+   * 
+   * Inline because the batch codec, sampler and broadcast encoder call it per
+   * field.
+   * 
+   * @param out Destination, at least `bytes` long
+   * @param value Value to write
+   * @param bytes Number of bytes (1-4)
+   */
+  inline void putLe(uint8_t* out, uint32_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) out[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+
+  /**
+   * @brief Read a little-endian value written by putLe()
+   * 
+   * @param in Source, at least `bytes` long
+   * @param bytes Number of bytes (1-4)
+   * @return The value, zero-extended
+   */
+  inline uint32_t getLe(const uint8_t* in, size_t bytes) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < bytes; i++) value |= static_cast<uint32_t>(in[i]) << (8 * i);
+    return value;
+  }
+
 } // namespace BeamUtils
 
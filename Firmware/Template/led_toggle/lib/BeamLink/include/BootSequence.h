@@ -0,0 +1,196 @@
+#pragma once
+#include "BeamPlatform.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#if defined(ARDUINO) && defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+/**
+ * @file BootSequence.h
+ * @brief Boot-phase timing and non-blocking boot steps
+ *
+ * - BootTimeline records a microsecond timestamp per boot phase and prints
+ *   the breakdown once, so time-to-advertise regressions are visible.
+ * - BootSequencer runs cosmetic steps (e.g. the boot blink) from loop()
+ *   after advertising has started, instead of delay() calls in setup().
+ * - BootTask runs an init function on the other core while setup()
+ *   continues, for work that does not depend on the BLE stack.
+ */
+
+#ifndef BOOT_MAX_MARKERS
+#define BOOT_MAX_MARKERS 16
+#endif
+
+#ifndef BOOT_MAX_STEPS
+#define BOOT_MAX_STEPS 12
+#endif
+
+/**
+ * @brief Boot phase markers with microsecond timestamps
+ *
+ * mark() may be called from several tasks (e.g. setup() and a BootTask);
+ * read the results after those tasks have finished.
+ */
+class BootTimeline {
+public:
+  /**
+   * @brief Record the end of a boot phase
+   * @param phase Phase name; must stay valid (use a string literal)
+   * @return false if BOOT_MAX_MARKERS is exceeded
+   */
+  bool mark(const char* phase);
+
+  /**
+   * @brief Number of markers recorded
+   */
+  size_t size() const;
+
+  /**
+   * @brief Name of marker i (nullptr if out of range)
+   */
+  const char* name(size_t i) const;
+
+  /**
+   * @brief Timestamp of marker i in µs since reset (0 if out of range)
+   */
+  uint32_t at(size_t i) const;
+
+  /**
+   * @brief Timestamp of the first marker with this name (0 if absent)
+   */
+  uint32_t at(const char* phase) const;
+
+  /**
+   * @brief Print all phases, sorted by time, with the gap to the previous one
+   *
+   * Only the first call prints; later calls return false.
+   */
+  bool report();
+
+private:
+  struct Marker {
+    const char* name;
+    uint32_t micros;
+  };
+
+  Marker markers[BOOT_MAX_MARKERS] = {};
+  std::atomic<size_t> count{0};
+  bool reported = false;
+};
+
+/**
+ * @brief Timed steps driven from loop()
+ *
+ * @example
+ * ```cpp
+ * BootSequencer blink;
+ * blink.then(0,   [] { digitalWrite(LED_PIN, LOW); });
+ * blink.then(150, [] { digitalWrite(LED_PIN, HIGH); });
+ * blink.start();
+ * // loop(): blink.update();
+ * ```
+ */
+class BootSequencer {
+public:
+  using Step = std::function<void()>;
+
+  /**
+   * @brief Append a step that runs delayMs after the previous one
+   * @return false if BOOT_MAX_STEPS is exceeded or the sequence is running
+   */
+  bool then(uint32_t delayMs, Step step);
+
+  /**
+   * @brief Start the sequence; the first step is due delayMs after nowMs
+   */
+  void start(uint32_t nowMs = millis());
+
+  /**
+   * @brief Run the steps that are due (call in loop())
+   * @return true while steps remain
+   */
+  bool update(uint32_t nowMs = millis());
+
+  /**
+   * @brief Milliseconds until the next step is due, so loop() can sleep
+   * @return 0 if a step is due, UINT32_MAX if none is pending
+   */
+  uint32_t msUntilNext(uint32_t nowMs = millis()) const;
+
+  /**
+   * @brief True once every step has run
+   */
+  bool isFinished() const { return next >= count; }
+
+  /**
+   * @brief True between start() and the last step
+   */
+  bool isRunning() const { return running && !isFinished(); }
+
+private:
+  struct Entry {
+    uint32_t delayMs;
+    Step step;
+  };
+
+  Entry steps[BOOT_MAX_STEPS];
+  uint8_t count = 0;
+  uint8_t next = 0;
+  uint32_t lastMs = 0;
+  bool running = false;
+};
+
+/**
+ * @brief One-shot init function on the other CPU core
+ *
+ * On a dual-core ESP32 setup() runs on core 1, so the task is pinned to
+ * core 0 (where the NimBLE host also runs, at its own priority). On single
+ * core chips it runs unpinned; on the host it is a std::thread.
+ */
+class BootTask {
+public:
+  BootTask() = default;
+  ~BootTask();
+  BootTask(const BootTask&) = delete;
+  BootTask& operator=(const BootTask&) = delete;
+
+  /**
+   * @brief Start fn on the other core
+   * @param name Task name (for debugging)
+   * @param fn Work to run; must not touch objects setup() uses until wait()
+   * @param stackBytes Task stack size
+   * @return false if a task is already running or could not be created
+   *         (fn is then run inline before returning)
+   */
+  bool start(const char* name, std::function<void()> fn, uint32_t stackBytes = 4096);
+
+  /**
+   * @brief Block until fn has returned
+   * @param timeoutMs Maximum wait
+   * @return true if fn has finished
+   */
+  bool wait(uint32_t timeoutMs = UINT32_MAX);
+
+  /**
+   * @brief True once fn has returned
+   */
+  bool isDone() const;
+
+private:
+  std::function<void()> fn;
+  mutable std::atomic<bool> done{true};
+#if defined(ARDUINO) && defined(ESP32)
+  SemaphoreHandle_t finished = nullptr;
+  static void entry(void* arg);
+#else
+  std::thread thread;
+#endif
+};
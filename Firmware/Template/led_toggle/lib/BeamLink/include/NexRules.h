@@ -0,0 +1,189 @@
+#pragma once
+#include "NexState.h"
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file NexRules.h
+ * @brief On-device automation rules evaluated on NexState changes
+ *
+ * Rules are plain text, compiled once when added:
+ *
+ *   light < 200 => ledOn = true
+ *   temp >= 30 && fan == false => notify:Overheating
+ *
+ * Conditions compare a key against a number or true/false
+ * (<, <=, >, >=, ==, !=) and may be joined with &&. An action either sets a
+ * key (keeping its stored type) or sends a notification text. Actions are
+ * edge-triggered: they run when the conditions become true, not on every
+ * change while they stay true.
+ *
+ * Rules are indexed by the keys they read, so a change re-evaluates only the
+ * rules that mention the changed key, without parsing or allocating.
+ */
+
+namespace nexstate {
+
+#ifndef NEXRULES_MAX_RULES
+#define NEXRULES_MAX_RULES 16
+#endif
+
+#ifndef NEXRULES_MAX_CONDITIONS
+#define NEXRULES_MAX_CONDITIONS 2
+#endif
+
+#ifndef NEXRULES_MAX_TEXT_LENGTH
+#define NEXRULES_MAX_TEXT_LENGTH 95
+#endif
+
+/**
+ * @brief Comparison operator of a rule condition
+ */
+enum class RuleOp : uint8_t {
+  Less,
+  LessEqual,
+  Greater,
+  GreaterEqual,
+  Equal,
+  NotEqual
+};
+
+/**
+ * @brief Compiled condition: `key op operand`
+ */
+struct RuleCondition {
+  SmallString key;
+  double operand = 0;
+  RuleOp op = RuleOp::Equal;
+
+  bool matches(double value) const;
+};
+
+/**
+ * @brief Compiled rule
+ */
+struct Rule {
+  enum class Action : uint8_t { SetKey, Notify };
+
+  RuleCondition conditions[NEXRULES_MAX_CONDITIONS];
+  uint8_t conditionCount = 0;
+  Action action = Action::SetKey;
+  SmallString target;                        ///< Key to set, or notification text
+  double value = 0;                          ///< Value for SetKey
+  RecordType valueType = RecordType::Double; ///< Type for SetKey if the key does not exist yet
+  bool active = false;                       ///< Conditions held at the last evaluation
+  bool used = false;                         ///< Slot holds a rule
+};
+
+/**
+ * @brief Rule table attached to a NexState store
+ *
+ * All methods except post() must be called from the store's owner task.
+ */
+class RuleEngine {
+public:
+  using NotifyFn = std::function<void(std::string_view message)>;
+
+  /**
+   * @brief Attach to a store (must outlive the engine)
+   */
+  void begin(NexState& store);
+
+  /**
+   * @brief Set where notify actions and command replies are sent
+   */
+  void onNotify(NotifyFn fn) { notifyFn = std::move(fn); }
+
+  /**
+   * @brief Compile and add a rule
+   *
+   * The rule is evaluated once right away, so its action runs if the
+   * conditions already hold.
+   *
+   * @param text Rule text (see file description)
+   * @param error Receives a reason on failure (optional)
+   * @return Rule id, or -1 on error
+   */
+  int addRule(std::string_view text, std::string* error = nullptr);
+
+  /**
+   * @brief Remove a rule by id
+   * @return false if no rule has that id
+   */
+  bool removeRule(int id);
+
+  /**
+   * @brief Remove all rules
+   */
+  void clear();
+
+  /**
+   * @brief Number of rules installed
+   */
+  size_t size() const;
+
+  /**
+   * @brief Rule in text form, e.g. "light < 200 => ledOn = true" (empty if unused)
+   */
+  std::string describe(int id) const;
+
+  /**
+   * @brief Queue a rule command from another task (e.g. a BLE handler)
+   *
+   * Commands: `rule:add:<rule>`, `rule:del:<id>`, `rule:clear`, `rule:list`.
+   * Results are sent through the notify function on the next update().
+   *
+   * @return false if the queue is full or the command is too long
+   */
+  bool post(std::string_view command);
+
+  /**
+   * @brief Run queued commands (call in loop())
+   */
+  void update();
+
+  /**
+   * @brief Run one rule command immediately (owner task)
+   * @return false if the text is not a rule command
+   */
+  bool handleCommand(std::string_view command);
+
+  /**
+   * @brief Number of rule evaluations since begin()
+   */
+  uint32_t getEvaluations() const { return evaluations; }
+
+  /**
+   * @brief Compile rule text without installing it
+   */
+  static bool compile(std::string_view text, Rule& out, std::string* error = nullptr);
+
+private:
+  struct IndexEntry {
+    SmallString key;
+    uint8_t rule;
+  };
+
+  struct CommandText {
+    char text[NEXRULES_MAX_TEXT_LENGTH + 1];
+  };
+
+  static constexpr uint8_t kMaxCascadeDepth = 4;
+
+  NexState* store = nullptr;
+  NotifyFn notifyFn;
+  Rule rules[NEXRULES_MAX_RULES];
+  std::vector<IndexEntry> index; ///< (input key, rule id), sorted by key
+  CommandQueue<CommandText, 4> commands;
+  uint32_t evaluations = 0;
+  uint8_t depth = 0;
+
+  void onKeyChanged(std::string_view key);
+  void evaluate(Rule& rule);
+  void rebuildIndex();
+  void notify(std::string_view message);
+};
+
+} // namespace nexstate
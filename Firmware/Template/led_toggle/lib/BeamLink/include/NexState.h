@@ -1,12 +1,17 @@
 #pragma once
-#include <Arduino.h>
+#include "BeamPlatform.h"
+#include "NexStateSync.h"
+#include <atomic>
 #include <functional>
+#include <initializer_list>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <variant>
 
+class BeamScheduler;
+
 /**
  * @file NexState.h
  * @brief NexState - A Zustand-like state management system for ESP32
@@ -14,62 +19,14 @@
  * NexState provides efficient state management with change detection to avoid
  * unnecessary serial output loops. It tracks state changes and only outputs
  * when values actually change, preventing constant serial.print() calls.
+ *
+ * Threading: the store belongs to the task that calls update() (normally
+ * loop()). Other tasks, such as the NimBLE host task running onMessage
+ * handlers, must use post() to write and readSnapshot() to read.
  */
 
 namespace nexstate {
 
-/**
- * @brief Type-safe state value container without dynamic casting
- */
-template<typename T>
-class StateValue {
-public:
-    // Default constructor for variant compatibility
-    StateValue() : currentValue(T{}), previousValue(T{}), changed(false) {}
-    
-    explicit StateValue(const T& initialValue) 
-        : currentValue(initialValue), previousValue(initialValue), changed(false) {}
-    
-    void setValue(const T& newValue) {
-        if (newValue != currentValue) {
-            previousValue = currentValue;
-            currentValue = newValue;
-            changed = true;
-        }
-    }
-    
-    const T& getValue() const { return currentValue; }
-    const T& getPreviousValue() const { return previousValue; }
-    
-    bool hasChanged() const { return changed; }
-    
-    void markAsRead() { changed = false; }
-    
-    void reset() {
-        previousValue = currentValue;
-        changed = false;
-    }
-    
-    std::string toString() const {
-        if constexpr (std::is_same_v<T, bool>) {
-            return currentValue ? "true" : "false";
-        } else if constexpr (std::is_same_v<T, int> || std::is_same_v<T, long>) {
-            return std::to_string(currentValue);
-        } else if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
-            return std::to_string(currentValue);
-        } else if constexpr (std::is_same_v<T, std::string>) {
-            return "\"" + currentValue + "\"";
-        } else {
-            return "unknown";
-        }
-    }
-
-private:
-    T currentValue;
-    T previousValue;
-    bool changed;
-};
-
 /**
  * @brief Device information structure
  */
@@ -100,6 +57,29 @@ struct NexStateConfig {
     DeviceInfo deviceInfo; // Device information for output headers
 };
 
+/**
+ * @brief RAM used by a NexState store, broken down by category
+ * 
+ * Heap figures count requested bytes only; the allocator adds its own
+ * per-block overhead on top.
+ */
+struct MemoryStats {
+    size_t keyCount = 0;       ///< Number of keys in the store
+    size_t keyBytes = 0;       ///< Key storage (inline) plus heap for long keys
+    size_t valueBytes = 0;     ///< Value slots plus heap for long string values
+    size_t containerBytes = 0; ///< Array bookkeeping and unused capacity
+    size_t callbackBytes = 0;  ///< Change callbacks and computed-key definitions
+    size_t syncBytes = 0;      ///< Post queue and snapshot buffers
+    
+    size_t total() const {
+        return keyBytes + valueBytes + containerBytes + callbackBytes + syncBytes;
+    }
+    
+    size_t bytesPerKey() const {
+        return keyCount ? (keyBytes + valueBytes + containerBytes) / keyCount : 0;
+    }
+};
+
 /**
  * @brief Main NexState store class
  */
@@ -118,24 +98,39 @@ public:
     
     /**
      * @brief Set a state value
+     * 
+     * Integers are stored as int, uint32_t or int64_t depending on their
+     * width and signedness, strings (std::string or string literals) as
+     * SmallString. See StorageOf in NexStateTypes.h.
+     * 
      * @param key State key
      * @param value New value
      */
     template<typename T>
-    void set(const std::string& key, const T& value) {
-        auto it = stateValues.find(key);
-        if (it != stateValues.end()) {
+    void set(std::string_view key, const T& value) {
+        using S = storage_t<T>;
+        size_t pos = lowerBound(key);
+        bool changed = true;
+        if (pos < entries.size() && entries[pos].key.view() == key) {
             // Check if the existing value is of the same type
-            auto existingValue = std::get_if<StateValue<T>>(&it->second);
+            auto existingValue = std::get_if<StateValue<S>>(&entries[pos].value);
             if (existingValue) {
-                existingValue->setValue(value);
+                changed = existingValue->setValue(S(value));
             } else {
                 // Type mismatch, replace with new value
-                it->second = StateValue<T>(value);
+                entries[pos].value = StateValue<S>(S(value));
             }
         } else {
-            // Insert new value
-            stateValues.emplace(key, StateValue<T>(value));
+            // Insert new value, keeping entries sorted by key
+            entries.insert(entries.begin() + pos, Entry{SmallString(key), StateValue<S>(S(value))});
+        }
+        snapshotDirty |= changed;
+        
+        if (changed && !computeds.empty()) {
+            markDependentsDirty(key);
+        }
+        if (changed && (!listeners.empty() || !keyObservers.empty() || changeCallback)) {
+            notifyChange(pos);
         }
         
         if (config.outputOnChange) {
@@ -143,39 +138,119 @@ public:
         }
     }
     
+    /**
+     * @brief Queue a state write from another task
+     * 
+     * Safe to call from any task or callback. The write is applied by the
+     * owner task on its next update(). Keys and strings longer than
+     * NEXSTATE_MAX_KEY_LENGTH / NEXSTATE_MAX_STRING_LENGTH are truncated.
+     * 
+     * @param key State key
+     * @param value New value (bool, integer, floating point or string)
+     * @return false if the command queue is full and the write was dropped
+     */
+    template<typename T>
+    bool post(std::string_view key, const T& value) {
+        using S = storage_t<T>;
+        StateRecord cmd;
+        cmd.setKey(key);
+        if constexpr (std::is_same_v<S, SmallString>) {
+            cmd.setString(std::string_view(value));
+        } else {
+            cmd.setValue(static_cast<S>(value));
+        }
+        
+        if (!commandQueue.push(cmd)) {
+            droppedPosts.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+    
+    /**
+     * @brief Copy the most recently published state
+     * 
+     * Safe to call from any task; never blocks the owner task. The snapshot
+     * reflects the store as of the owner's last update().
+     * 
+     * @param out Destination snapshot
+     * @return true if a consistent snapshot was copied
+     */
+    bool readSnapshot(StateSnapshot& out) const {
+        return snapshot.read(out);
+    }
+    
+    /**
+     * @brief Number of post() calls rejected because the queue was full
+     */
+    uint32_t getDroppedPosts() const {
+        return droppedPosts.load(std::memory_order_relaxed);
+    }
+    
     /**
      * @brief Get a state value
      * @param key State key
-     * @param defaultValue Default value if key doesn't exist
+     * @param defaultValue Default value if key doesn't exist or has another type
      * @return Current value
      */
     template<typename T>
-    T get(const std::string& key, const T& defaultValue = T{}) const {
-        auto it = stateValues.find(key);
-        if (it != stateValues.end()) {
-            auto value = std::get_if<StateValue<T>>(&it->second);
-            if (value) {
-                return value->getValue();
-            }
+    T get(std::string_view key, const T& defaultValue = T{}) const {
+        if (dirtyComputed) refreshComputed(key);
+        if (auto value = findValue<T>(key)) {
+            return toUserType<T>(*value);
         }
         return defaultValue;
     }
     
+    /**
+     * @brief Read any numeric or boolean key as a double
+     * @param key State key
+     * @param out Receives the value (bools read as 0/1)
+     * @return false if the key is missing or holds a string
+     */
+    bool getNumeric(std::string_view key, double& out) const;
+    
+    /**
+     * @brief Storage type of a key
+     * @param key State key
+     * @param out Receives the type
+     * @return false if the key is missing
+     */
+    bool getType(std::string_view key, RecordType& out) const;
+    
+    /**
+     * @brief Set a numeric key without changing its stored type
+     * 
+     * Existing bool/integer/floating-point keys keep their type (bools
+     * become value != 0, integers are rounded). New keys are created with
+     * `typeIfNew`.
+     * 
+     * @param key State key
+     * @param value New value
+     * @param typeIfNew Storage type for a key that does not exist yet
+     * @return false if the key holds a string
+     */
+    bool setNumeric(std::string_view key, double value, RecordType typeIfNew = RecordType::Double);
+    
+    /**
+     * @brief Check whether a key exists
+     * @param key State key
+     */
+    bool contains(std::string_view key) const {
+        if (dirtyComputed) refreshComputed(key);
+        return find(key) != nullptr;
+    }
+    
     /**
      * @brief Check if a state value has changed
      * @param key State key
      * @return true if the value has changed since last check
      */
     template<typename T>
-    bool hasChanged(const std::string& key) const {
-        auto it = stateValues.find(key);
-        if (it != stateValues.end()) {
-            auto value = std::get_if<StateValue<T>>(&it->second);
-            if (value) {
-                return value->hasChanged();
-            }
-        }
-        return false;
+    bool hasChanged(std::string_view key) const {
+        if (dirtyComputed) refreshComputed(key);
+        auto value = findValue<T>(key);
+        return value && value->hasChanged();
     }
     
     /**
@@ -183,13 +258,9 @@ public:
      * @param key State key
      */
     template<typename T>
-    void markAsRead(const std::string& key) {
-        auto it = stateValues.find(key);
-        if (it != stateValues.end()) {
-            auto value = std::get_if<StateValue<T>>(&it->second);
-            if (value) {
-                value->markAsRead();
-            }
+    void markAsRead(std::string_view key) {
+        if (auto value = const_cast<StateValue<storage_t<T>>*>(findValue<T>(key))) {
+            value->markAsRead();
         }
     }
     
@@ -197,140 +268,161 @@ public:
      * @brief Get all changed state keys
      * @return Vector of keys that have changed
      */
-    std::vector<std::string> getChangedKeys() const {
-        std::vector<std::string> changed;
-        for (const auto& pair : stateValues) {
-            // Check each possible type for changes
-            if (std::visit([](const auto& value) { return value.hasChanged(); }, pair.second)) {
-                changed.push_back(pair.first);
-            }
-        }
-        return changed;
-    }
+    std::vector<std::string> getChangedKeys() const;
     
     /**
      * @brief Check if any state has changed
      * @return true if any state value has changed
      */
-    bool hasAnyChanged() const {
-        for (const auto& pair : stateValues) {
-            if (std::visit([](const auto& value) { return value.hasChanged(); }, pair.second)) {
-                return true;
-            }
-        }
-        return false;
-    }
+    bool hasAnyChanged() const;
     
     /**
      * @brief Mark all states as read
      */
-    void markAllAsRead() {
-        for (auto& pair : stateValues) {
-            std::visit([](auto& value) { value.markAsRead(); }, pair.second);
-        }
-    }
+    void markAllAsRead();
     
     /**
      * @brief Update the state store (call this in loop())
+     * 
+     * Applies writes queued with post(), publishes a new snapshot if anything
+     * changed, and handles interval output.
      */
-    void update() {
-        unsigned long now = millis();
-        
-        if (config.outputOnInterval && (now - lastOutputTime >= config.outputIntervalMs)) {
-            outputState();
-            lastOutputTime = now;
-        }
-    }
+    void update();
     
+    /**
+     * @brief Run interval output from a timer instead of checking it in update()
+     *
+     * No-op unless config.outputOnInterval is set. The scheduler must outlive
+     * the store and run on the same task as update().
+     * @param scheduler Scheduler driven from loop()
+     */
+    void attachScheduler(BeamScheduler& scheduler);
+
     /**
      * @brief Force output of current state
      */
-    void outputState() {
-        if (!config.enableSerialOutput) return;
-        
-        if (config.enableJsonFormat) {
-            outputJsonState();
-        } else {
-            outputTextState();
-        }
-        
-        markAllAsRead();
-        lastOutputTime = millis();
-    }
+    void outputState();
     
     /**
      * @brief Get state as JSON string with device info
      * @return JSON representation of current state with device info
      */
-    std::string getStateAsJson() const {
-        std::string json = "{";
-        json += "\"device\":\"" + config.deviceInfo.deviceName + "\",";
-        json += "\"id\":\"" + config.deviceInfo.deviceId + "\",";
-        json += "\"type\":\"" + config.deviceInfo.deviceType + "\",";
-        json += "\"fw\":\"" + config.deviceInfo.firmwareVersion + "\",";
-        json += "\"state\":{";
-        
-        bool first = true;
-        for (const auto& pair : stateValues) {
-            if (!first) json += ",";
-            json += "\"" + pair.first + "\":";
-            std::visit([&json](const auto& value) { json += value.toString(); }, pair.second);
-            first = false;
-        }
-        
-        json += "}}";
-        return json;
-    }
+    std::string getStateAsJson() const;
     
     /**
      * @brief Get state as text string with device info
      * @return Text representation of current state with device info
      */
-    std::string getStateAsText() const {
-        std::string text = "Device: " + config.deviceInfo.deviceName;
-        text += " (ID: " + config.deviceInfo.deviceId;
-        text += ", Type: " + config.deviceInfo.deviceType;
-        text += ", FW: " + config.deviceInfo.firmwareVersion + ")";
-        text += " | State: ";
-        
-        bool first = true;
-        for (const auto& pair : stateValues) {
-            if (!first) text += ", ";
-            text += pair.first + "=";
-            std::visit([&text](const auto& value) { 
-                std::string val = value.toString();
-                // Remove quotes for text format
-                if (val.front() == '"' && val.back() == '"') {
-                    val = val.substr(1, val.length() - 2);
-                }
-                text += val;
-            }, pair.second);
-            first = false;
-        }
-        
-        return text;
-    }
+    std::string getStateAsText() const;
     
     /**
      * @brief Subscribe to state changes
+     * 
+     * Called on the owner task for every key whose value changes, with the
+     * key and the new value formatted as a JSON literal.
+     * 
      * @param callback Function to call when state changes
      */
     void subscribe(std::function<void(const std::string&, const std::string&)> callback) {
         changeCallback = callback;
     }
     
+    /**
+     * @brief Call a function whenever one key changes value
+     * 
+     * The callback runs inside set() (or update() for posted writes) on the
+     * owner task, only when the stored value actually changes, including
+     * the first time the key is set. It does not fire for values of another
+     * type. Several callbacks may watch the same key.
+     * 
+     * @param key State key to watch
+     * @param callback Receives the new value
+     * 
+     * @example
+     * ```cpp
+     * State().onChange<bool>("ledOn", [](bool on) { LOG_PIN("LED %s", on ? "ON" : "OFF"); });
+     * ```
+     */
+    template<typename T>
+    void onChange(std::string_view key, std::function<void(const T&)> callback) {
+        listeners.push_back(Listener{SmallString(key), [callback](const StateValueVariant& value) {
+            if (auto typed = std::get_if<StateValue<storage_t<T>>>(&value)) {
+                callback(toUserType<T>(*typed));
+            }
+        }});
+    }
+    
+    /**
+     * @brief Call a function whenever any key changes value
+     * 
+     * Same timing as onChange(), but untyped and for every key. Used by
+     * modules that keep their own per-key index, such as RuleEngine.
+     * 
+     * @param callback Receives the key that changed
+     */
+    void onAnyChange(std::function<void(std::string_view key)> callback) {
+        keyObservers.push_back(std::move(callback));
+    }
+    
+    /**
+     * @brief Define a key whose value is derived from other keys
+     * 
+     * The function is re-run only after one of its inputs changed, and only
+     * when the result is needed: on get()/hasChanged() of the key, or at the
+     * next update() (which publishes it to snapshots). Several input changes
+     * between two reads cost one evaluation. The result is stored like any
+     * other key, so it appears in JSON output and fires onChange() callbacks
+     * when it changes. Computed keys may use other computed keys as inputs.
+     * 
+     * @param key Key to hold the result (do not set() it directly)
+     * @param inputs Keys the function reads
+     * @param fn Pure function of the store returning the value
+     * 
+     * @example
+     * ```cpp
+     * State().compute<bool>("alarm", {"temp", "threshold"}, [](const NexState& s) {
+     *     return s.get<float>("temp") > s.get<float>("threshold");
+     * });
+     * ```
+     */
+    template<typename T>
+    void compute(std::string_view key, std::initializer_list<std::string_view> inputs,
+                 std::function<T(const NexState&)> fn) {
+        SmallString name(key);
+        addComputed(key, inputs, [name, fn](NexState& store) {
+            store.set(name.view(), fn(store));
+        });
+    }
+    
     /**
      * @brief Clear all state
      */
     void clear() {
-        stateValues.clear();
+        entries.clear();
+        for (auto& computed : computeds) {
+            computed.dirty = true;
+        }
+        dirtyComputed = computeds.size();
+        snapshotDirty = true;
     }
     
+    /**
+     * @brief Pre-allocate room for a number of keys
+     * @param keyCount Expected number of keys
+     */
+    void reserve(size_t keyCount) { entries.reserve(keyCount); }
+    
     /**
      * @brief Get number of state values
      * @return Count of state values
      */
-    size_t size() const { return stateValues.size(); }
+    size_t size() const { return entries.size(); }
+    
+    /**
+     * @brief Report how much RAM the store is using
+     * @return Byte counts per category
+     */
+    MemoryStats getMemoryStats() const;
 
 private:
     NexStateConfig config;
@@ -339,26 +431,81 @@ private:
     using StateValueVariant = std::variant<
         StateValue<bool>,
         StateValue<int>,
+        StateValue<uint32_t>,
+        StateValue<int64_t>,
         StateValue<float>,
-        StateValue<std::string>
+        StateValue<double>,
+        StateValue<SmallString>
     >;
     
-    std::unordered_map<std::string, StateValueVariant> stateValues;
+    // One contiguous, key-sorted array: lookups are a binary search and
+    // iteration walks memory linearly instead of chasing hash-node pointers
+    struct Entry {
+        SmallString key;
+        StateValueVariant value;
+    };
+    
+    struct Listener {
+        SmallString key;
+        std::function<void(const StateValueVariant&)> fn;
+    };
+    
+    struct Computed {
+        SmallString key;
+        std::vector<SmallString> inputs;
+        std::function<void(NexState&)> evaluate;
+        bool dirty;
+    };
+    
+    std::vector<Entry> entries;
+    std::vector<Listener> listeners;
+    std::vector<std::function<void(std::string_view)>> keyObservers;
+    std::vector<Computed> computeds;
+    size_t dirtyComputed = 0;
     std::function<void(const std::string&, const std::string&)> changeCallback;
     unsigned long lastOutputTime = 0;
+    bool intervalScheduled = false;
     
-    void checkAndOutput() {
-        if (config.enableChangeDetection && hasAnyChanged()) {
-            outputState();
-        }
+    // Cross-task access (see NexStateSync.h)
+    CommandQueue<StateRecord, NEXSTATE_COMMAND_QUEUE_CAPACITY> commandQueue;
+    SnapshotBuffer<StateSnapshot> snapshot;
+    StateSnapshot snapshotScratch;
+    uint32_t snapshotVersion = 0;
+    bool snapshotDirty = true;
+    std::atomic<uint32_t> droppedPosts{0};
+    
+    size_t lowerBound(std::string_view key) const;
+    const Entry* find(std::string_view key) const;
+    
+    template<typename T>
+    const StateValue<storage_t<T>>* findValue(std::string_view key) const {
+        const Entry* entry = find(key);
+        return entry ? std::get_if<StateValue<storage_t<T>>>(&entry->value) : nullptr;
     }
     
-    void outputJsonState() {
-        Serial.println(getStateAsJson().c_str());
+    template<typename T>
+    static T toUserType(const StateValue<storage_t<T>>& value) {
+        if constexpr (std::is_same_v<storage_t<T>, SmallString>) {
+            return T(value.getValue().c_str());
+        } else {
+            return static_cast<T>(value.getValue());
+        }
     }
     
-    void outputTextState() {
-        Serial.println(getStateAsText().c_str());
+    void notifyChange(size_t pos);
+    void addComputed(std::string_view key, std::initializer_list<std::string_view> inputs,
+                     std::function<void(NexState&)> evaluate);
+    void markDependentsDirty(std::string_view key);
+    void evaluateComputed(size_t index);
+    void refreshComputed(std::string_view key) const;
+    void refreshAllComputed() const;
+    void applyPendingCommands();
+    void publishSnapshot();
+    
+    void checkAndOutput() {
+        if (config.enableChangeDetection && hasAnyChanged()) {
+            outputState();
+        }
     }
 };
 
@@ -0,0 +1,325 @@
+#pragma once
+#include "NexStateTypes.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+/**
+ * @file NexStateSync.h
+ * @brief Lock-free primitives that let other tasks talk to a NexState store
+ *
+ * The store itself is owned by a single task (normally the Arduino loop()).
+ * Other tasks such as the NimBLE host task never touch it directly:
+ * - writes are posted into a bounded multi-producer command queue that the
+ *   owner drains in update()
+ * - reads copy a double-buffered snapshot guarded by a per-buffer sequence
+ *   counter, so a reader never blocks the owner and never sees a torn view
+ */
+
+namespace nexstate {
+
+#ifndef NEXSTATE_MAX_KEY_LENGTH
+#define NEXSTATE_MAX_KEY_LENGTH 23
+#endif
+
+#ifndef NEXSTATE_MAX_STRING_LENGTH
+#define NEXSTATE_MAX_STRING_LENGTH 31
+#endif
+
+#ifndef NEXSTATE_SNAPSHOT_CAPACITY
+#define NEXSTATE_SNAPSHOT_CAPACITY 16
+#endif
+
+#ifndef NEXSTATE_COMMAND_QUEUE_CAPACITY
+#define NEXSTATE_COMMAND_QUEUE_CAPACITY 16
+#endif
+
+/**
+ * @brief Type tag for fixed-size state records
+ */
+enum class RecordType : uint8_t {
+  Bool,
+  Int,
+  UInt,
+  Int64,
+  Float,
+  Double,
+  String
+};
+
+/**
+ * @brief Record type tag for a NexState storage type (see storage_t)
+ */
+template<typename S>
+constexpr RecordType recordTypeOf() {
+  if constexpr (std::is_same_v<S, bool>) return RecordType::Bool;
+  else if constexpr (std::is_same_v<S, int>) return RecordType::Int;
+  else if constexpr (std::is_same_v<S, uint32_t>) return RecordType::UInt;
+  else if constexpr (std::is_same_v<S, int64_t>) return RecordType::Int64;
+  else if constexpr (std::is_same_v<S, float>) return RecordType::Float;
+  else if constexpr (std::is_same_v<S, double>) return RecordType::Double;
+  else return RecordType::String;
+}
+
+/**
+ * @brief Fixed-size, trivially copyable key/value pair
+ *
+ * Used both as a queued write command and as a snapshot entry. Keys and
+ * string values longer than the compile-time limits are truncated.
+ */
+struct StateRecord {
+  char key[NEXSTATE_MAX_KEY_LENGTH + 1];
+  RecordType type;
+  union {
+    bool b;
+    int32_t i;
+    uint32_t u;
+    float f;
+    uint32_t wide[2]; // int64_t/double, split to keep the record 4-byte aligned
+  } num;
+  char str[NEXSTATE_MAX_STRING_LENGTH + 1];
+
+  void setKey(std::string_view k) { copyTruncated(key, sizeof(key), k); }
+  void setString(std::string_view v) { type = RecordType::String; copyTruncated(str, sizeof(str), v); }
+
+  /**
+   * @brief Store a numeric or boolean value of NexState storage type S
+   */
+  template<typename S>
+  void setValue(const S& v) {
+    type = recordTypeOf<S>();
+    if constexpr (std::is_same_v<S, bool>) num.b = v;
+    else if constexpr (std::is_same_v<S, int>) num.i = v;
+    else if constexpr (std::is_same_v<S, uint32_t>) num.u = v;
+    else if constexpr (std::is_same_v<S, float>) num.f = v;
+    else if constexpr (std::is_same_v<S, SmallString>) copyTruncated(str, sizeof(str), v.view());
+    else memcpy(num.wide, &v, sizeof(v));
+  }
+
+  /**
+   * @brief Read the value as storage type S (caller checks `type`)
+   */
+  template<typename S>
+  S value() const {
+    if constexpr (std::is_same_v<S, bool>) return num.b;
+    else if constexpr (std::is_same_v<S, int>) return num.i;
+    else if constexpr (std::is_same_v<S, uint32_t>) return num.u;
+    else if constexpr (std::is_same_v<S, float>) return num.f;
+    else if constexpr (std::is_same_v<S, SmallString>) return SmallString(str);
+    else {
+      S v;
+      memcpy(&v, num.wide, sizeof(v));
+      return v;
+    }
+  }
+
+  static void copyTruncated(char* dst, size_t size, std::string_view src) {
+    size_t len = src.size() < size - 1 ? src.size() : size - 1;
+    for (size_t i = 0; i < len; i++) {
+      dst[i] = src[i];
+    }
+    dst[len] = '\0';
+  }
+};
+
+static_assert(std::is_trivially_copyable<StateRecord>::value, "StateRecord must be trivially copyable");
+
+/**
+ * @brief Consistent copy of the store published by the owner task
+ */
+struct StateSnapshot {
+  uint32_t version = 0;  ///< Incremented on every publish
+  uint16_t count = 0;    ///< Valid entries in `entries`
+  uint16_t dropped = 0;  ///< Keys that did not fit into the snapshot
+  StateRecord entries[NEXSTATE_SNAPSHOT_CAPACITY];
+
+  const StateRecord* find(std::string_view key) const {
+    for (uint16_t i = 0; i < count; i++) {
+      if (key == entries[i].key) {
+        return &entries[i];
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Typed lookup with the same type rules as NexState::get()
+   */
+  template<typename T>
+  T get(std::string_view key, const T& defaultValue = T{}) const {
+    using S = storage_t<T>;
+    const StateRecord* rec = find(key);
+    if (!rec || rec->type != recordTypeOf<S>()) return defaultValue;
+    if constexpr (std::is_same_v<S, SmallString>) {
+      return T(rec->str);
+    } else {
+      return static_cast<T>(rec->value<S>());
+    }
+  }
+};
+
+static_assert(std::is_trivially_copyable<StateSnapshot>::value, "StateSnapshot must be trivially copyable");
+
+/**
+ * @brief Single-writer, multi-reader latest-value register
+ *
+ * The writer fills the buffer that readers are not pointed at, then flips the
+ * published index, so it never waits for readers. Each buffer carries a
+ * sequence counter (odd while being written) that lets a reader detect the
+ * rare case where the writer lapped it mid-copy and retry. All shared words
+ * are accessed atomically, which keeps the scheme data-race free.
+ */
+template<typename T>
+class SnapshotBuffer {
+  static_assert(std::is_trivially_copyable<T>::value, "SnapshotBuffer needs a trivially copyable type");
+
+public:
+  SnapshotBuffer() {
+    T empty{};
+    storeWords(slots[0], empty);
+    storeWords(slots[1], empty);
+  }
+
+  /**
+   * @brief Publish a new value (owner task only)
+   */
+  void write(const T& value) {
+    uint32_t target = published.load(std::memory_order_relaxed) ^ 1u;
+    Slot& slot = slots[target];
+    uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    storeWords(slot, value);
+    slot.seq.store(seq + 2, std::memory_order_release);
+    published.store(target, std::memory_order_release);
+  }
+
+  /**
+   * @brief Copy the latest published value (any task)
+   * @param out Destination for the copy (undefined contents on failure)
+   * @param maxAttempts Upper bound on retries when the writer laps the reader
+   * @return true if a consistent copy was made
+   */
+  bool read(T& out, int maxAttempts = 64) const {
+    for (int attempt = 0; attempt < maxAttempts; attempt++) {
+      const Slot& slot = slots[published.load(std::memory_order_acquire)];
+      uint32_t before = slot.seq.load(std::memory_order_acquire);
+      if (before & 1u) continue;
+
+      // Copy straight into `out`; it is only meaningful if the check passes
+      unsigned char* dst = reinterpret_cast<unsigned char*>(&out);
+      for (size_t i = 0; i < kWords; i++) {
+        uint32_t word = slot.words[i].load(std::memory_order_relaxed);
+        memcpy(dst + i * sizeof(uint32_t), &word, bytesInWord(i));
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if (slot.seq.load(std::memory_order_relaxed) == before) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  static constexpr size_t kWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+  struct Slot {
+    std::atomic<uint32_t> seq{0};
+    std::atomic<uint32_t> words[kWords];
+  };
+
+  static constexpr size_t bytesInWord(size_t i) {
+    return (i + 1) * sizeof(uint32_t) <= sizeof(T) ? sizeof(uint32_t) : sizeof(T) - i * sizeof(uint32_t);
+  }
+
+  static void storeWords(Slot& slot, const T& value) {
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(&value);
+    for (size_t i = 0; i < kWords; i++) {
+      uint32_t word = 0;
+      memcpy(&word, src + i * sizeof(uint32_t), bytesInWord(i));
+      slot.words[i].store(word, std::memory_order_relaxed);
+    }
+  }
+
+  Slot slots[2];
+  std::atomic<uint32_t> published{0};
+};
+
+/**
+ * @brief Bounded lock-free multi-producer queue with a single consumer
+ *
+ * Classic sequence-numbered ring: producers claim a cell with one CAS and
+ * hand it to the consumer by releasing the cell's sequence number, so no
+ * producer ever waits on a lock held by another task.
+ *
+ * @tparam T Trivially copyable element type
+ * @tparam Capacity Number of cells (power of two)
+ */
+template<typename T, size_t Capacity>
+class CommandQueue {
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+  static_assert(std::is_trivially_copyable<T>::value, "CommandQueue needs a trivially copyable type");
+
+public:
+  CommandQueue() {
+    for (size_t i = 0; i < Capacity; i++) {
+      cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Enqueue an element (any task)
+   * @return false if the queue is full
+   */
+  bool push(const T& item) {
+    size_t pos = tail.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells[pos & (Capacity - 1)];
+      size_t seq = cell.seq.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          cell.value = item;
+          cell.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Dequeue an element (consumer task only)
+   * @return false if the queue is empty
+   */
+  bool pop(T& item) {
+    Cell& cell = cells[head & (Capacity - 1)];
+    size_t seq = cell.seq.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(head + 1) < 0) {
+      return false;
+    }
+    item = cell.value;
+    cell.seq.store(head + Capacity, std::memory_order_release);
+    head++;
+    return true;
+  }
+
+private:
+  struct Cell {
+    std::atomic<size_t> seq;
+    T value;
+  };
+
+  Cell cells[Capacity];
+  std::atomic<size_t> tail{0};
+  size_t head = 0;
+};
+
+} // namespace nexstate
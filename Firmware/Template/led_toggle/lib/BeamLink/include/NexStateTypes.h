@@ -0,0 +1,247 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * @file NexStateTypes.h
+ * @brief Value types used by the NexState store
+ *
+ * - SmallString: 24-byte string that keeps up to 22 characters inline
+ * - StorageOf<T>: maps the type passed to set()/get() onto the stored type
+ * - StateValue<T>: current/previous value pair with a change flag
+ */
+
+namespace nexstate {
+
+/**
+ * @brief Compact string with a small inline buffer
+ *
+ * Strings of up to kInlineCapacity characters (keys, short status values)
+ * live inside the object, so a store entry needs no separate heap node.
+ * Longer strings fall back to a single heap allocation.
+ */
+class SmallString {
+public:
+  static constexpr size_t kInlineCapacity = 22;
+
+  SmallString() { setInline("", 0); }
+  SmallString(const char* s) { assign(std::string_view(s ? s : "")); }
+  SmallString(const std::string& s) { assign(std::string_view(s)); }
+  SmallString(std::string_view s) { assign(s); }
+  SmallString(const SmallString& other) { assign(other.view()); }
+
+  SmallString(SmallString&& other) noexcept {
+    memcpy(storage, other.storage, sizeof(storage));
+    other.setInline("", 0);
+  }
+
+  SmallString& operator=(const SmallString& other) {
+    if (this != &other) {
+      release();
+      assign(other.view());
+    }
+    return *this;
+  }
+
+  SmallString& operator=(SmallString&& other) noexcept {
+    if (this != &other) {
+      release();
+      memcpy(storage, other.storage, sizeof(storage));
+      other.setInline("", 0);
+    }
+    return *this;
+  }
+
+  ~SmallString() { release(); }
+
+  const char* c_str() const { return isHeap() ? heapRep().ptr : storage; }
+  size_t size() const { return isHeap() ? heapRep().len : tag(); }
+  bool empty() const { return size() == 0; }
+  bool isInline() const { return !isHeap(); }
+  std::string_view view() const { return std::string_view(c_str(), size()); }
+  std::string str() const { return std::string(c_str(), size()); }
+
+  /**
+   * @brief Heap bytes owned by this string (0 when stored inline)
+   */
+  size_t heapBytes() const { return isHeap() ? heapRep().len + 1 : 0; }
+
+  friend bool operator==(const SmallString& a, const SmallString& b) { return a.view() == b.view(); }
+  friend bool operator!=(const SmallString& a, const SmallString& b) { return !(a == b); }
+
+private:
+  static constexpr uint8_t kHeapTag = 0xFF;
+  static constexpr size_t kTagIndex = kInlineCapacity + 1;
+
+  struct HeapRep {
+    char* ptr;
+    size_t len;
+  };
+  static_assert(sizeof(HeapRep) <= kTagIndex, "heap representation must fit before the tag byte");
+
+  // Inline: characters, NUL, length in the last byte. Heap: HeapRep, kHeapTag.
+  alignas(void*) char storage[kInlineCapacity + 2];
+
+  uint8_t tag() const { return static_cast<uint8_t>(storage[kTagIndex]); }
+  bool isHeap() const { return tag() == kHeapTag; }
+
+  HeapRep heapRep() const {
+    HeapRep rep;
+    memcpy(&rep, storage, sizeof(rep));
+    return rep;
+  }
+
+  void setInline(const char* s, size_t len) {
+    memcpy(storage, s, len);
+    storage[len] = '\0';
+    storage[kTagIndex] = static_cast<char>(len);
+  }
+
+  void assign(std::string_view s) {
+    if (s.size() <= kInlineCapacity) {
+      setInline(s.data(), s.size());
+      return;
+    }
+    HeapRep rep{new char[s.size() + 1], s.size()};
+    memcpy(rep.ptr, s.data(), s.size());
+    rep.ptr[s.size()] = '\0';
+    memcpy(storage, &rep, sizeof(rep));
+    storage[kTagIndex] = static_cast<char>(kHeapTag);
+  }
+
+  void release() {
+    if (isHeap()) {
+      delete[] heapRep().ptr;
+    }
+  }
+};
+
+static_assert(sizeof(SmallString) == 24, "SmallString is expected to be 24 bytes");
+
+/**
+ * @brief Maps a user-facing type onto the type NexState stores
+ *
+ * Lets set("count", 5u), set("uptime", millis()) or set("name", "abc") pick
+ * a storage slot without every integer width needing its own alternative.
+ */
+template<typename T, typename = void>
+struct StorageOf {
+  static_assert(sizeof(T) == 0, "NexState does not support this value type");
+};
+
+template<>
+struct StorageOf<bool> { using type = bool; };
+
+template<typename T>
+struct StorageOf<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+  // 64-bit unsigned values share the int64_t slot
+  using type = std::conditional_t<(sizeof(T) > 4), int64_t,
+               std::conditional_t<std::is_signed_v<T>, int, uint32_t>>;
+};
+
+template<>
+struct StorageOf<float> { using type = float; };
+
+template<>
+struct StorageOf<double> { using type = double; };
+
+template<>
+struct StorageOf<std::string> { using type = SmallString; };
+
+template<>
+struct StorageOf<std::string_view> { using type = SmallString; };
+
+template<>
+struct StorageOf<SmallString> { using type = SmallString; };
+
+template<>
+struct StorageOf<const char*> { using type = SmallString; };
+
+template<>
+struct StorageOf<char*> { using type = SmallString; };
+
+template<typename T>
+using storage_t = typename StorageOf<std::decay_t<T>>::type;
+
+static_assert(sizeof(int) == 4, "NexState assumes a 32-bit int");
+
+/**
+ * @brief Type-safe state value container without dynamic casting
+ */
+template<typename T>
+class StateValue {
+public:
+    // Default constructor for variant compatibility
+    StateValue() : currentValue(T{}), previousValue(T{}), changed(false) {}
+
+    explicit StateValue(const T& initialValue)
+        : currentValue(initialValue), previousValue(initialValue), changed(false) {}
+
+    bool setValue(const T& newValue) {
+        if (newValue != currentValue) {
+            previousValue = currentValue;
+            currentValue = newValue;
+            changed = true;
+            return true;
+        }
+        return false;
+    }
+
+    const T& getValue() const { return currentValue; }
+    const T& getPreviousValue() const { return previousValue; }
+
+    bool hasChanged() const { return changed; }
+
+    void markAsRead() { changed = false; }
+
+    void reset() {
+        previousValue = currentValue;
+        changed = false;
+    }
+
+    /**
+     * @brief Append the current value as a JSON literal
+     */
+    void appendTo(std::string& out) const {
+        if constexpr (std::is_same_v<T, bool>) {
+            out += currentValue ? "true" : "false";
+        } else if constexpr (std::is_same_v<T, SmallString>) {
+            out += '"';
+            out.append(currentValue.c_str(), currentValue.size());
+            out += '"';
+        } else {
+            out += std::to_string(currentValue);
+        }
+    }
+
+    std::string toString() const {
+        std::string out;
+        appendTo(out);
+        return out;
+    }
+
+    /**
+     * @brief Heap bytes owned by this value beyond sizeof(StateValue)
+     */
+    size_t heapBytes() const {
+        if constexpr (std::is_same_v<T, SmallString>) {
+            return currentValue.heapBytes() + previousValue.heapBytes();
+        } else {
+            return 0;
+        }
+    }
+
+private:
+    T currentValue;
+    T previousValue;
+    bool changed;
+};
+
+// Wide numeric types must not grow the variant beyond the string alternative
+static_assert(sizeof(StateValue<int64_t>) <= sizeof(StateValue<SmallString>), "int64_t widens the variant");
+static_assert(sizeof(StateValue<double>) <= sizeof(StateValue<SmallString>), "double widens the variant");
+
+} // namespace nexstate
@@ -0,0 +1,128 @@
+#pragma once
+#include "NexState.h"
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @file OutputBindings.h
+ * @brief Drive GPIO outputs from boolean NexState keys
+ *
+ * Instead of writing pins from loop() every iteration, declare once which key
+ * drives which pin. Pins are then written only when a bound key changes, and
+ * all pins that changed since the last flush() are updated together with one
+ * set-register and one clear-register write.
+ *
+ * @example
+ * ```cpp
+ * OutputBindings outputs;
+ *
+ * void setup() {
+ *   initialize(config);
+ *   outputs.begin(State());
+ *   outputs.bindOutput("ledOn", LED_PIN, LED_ACTIVE_HIGH);
+ *   outputs.bindOutputs(cfg.actuatorPins, "actuator"); // actuator0, actuator1, ...
+ * }
+ *
+ * void loop() {
+ *   update();          // applies posted writes, fires change callbacks
+ *   outputs.flush();   // one register write for everything that changed
+ * }
+ * ```
+ */
+
+namespace nexstate {
+
+/**
+ * @brief Binds boolean state keys to output pins with batched register writes
+ */
+class OutputBindings {
+public:
+  /// Writes the given pin masks (bit n = GPIO n) high and low
+  using MaskWriter = void (*)(uint64_t setMask, uint64_t clearMask);
+  /// Configures a pin as an output
+  using PinSetup = void (*)(uint8_t pin);
+
+  static constexpr uint8_t kMaxPin = 63;
+
+  /**
+   * @brief Constructor
+   * @param writer Register writer (default: ESP32 GPIO W1TS/W1TC registers)
+   * @param setup Pin configuration function (default: pinMode(pin, OUTPUT))
+   */
+  explicit OutputBindings(MaskWriter writer = writeGpioMasks, PinSetup setup = configureOutputPin);
+
+  /**
+   * @brief Attach the state store whose keys drive the pins
+   * @param store State store (must outlive this object)
+   */
+  void begin(NexState& store) { this->store = &store; }
+
+  /**
+   * @brief Drive a pin from a boolean key
+   *
+   * If the key already exists its current value is queued right away;
+   * otherwise the pin is written when the key is first set.
+   *
+   * @param key Boolean state key
+   * @param pin GPIO number (0-63)
+   * @param activeHigh true if `key == true` means the pin is driven high
+   * @return false if begin() was not called, or the pin is out of range or already bound
+   */
+  bool bindOutput(std::string_view key, uint8_t pin, bool activeHigh = true);
+
+  /**
+   * @brief Bind a comma-separated pin list (e.g. BeamConfig::actuatorPins)
+   *
+   * Pin i in the list is driven by key `<keyPrefix><i>`. Entries that are
+   * not a pin number (e.g. "x", "1 2") are skipped and logged; the keys of
+   * the entries after them keep their list position.
+   *
+   * @param pinList Pins such as "25,26,27"
+   * @param keyPrefix Key prefix, e.g. "actuator" gives actuator0, actuator1, ...
+   * @param activeHigh Polarity shared by all pins in the list
+   * @return Number of pins bound
+   */
+  size_t bindOutputs(std::string_view pinList, std::string_view keyPrefix, bool activeHigh = true);
+
+  /**
+   * @brief Write all pending pin changes (call after update() in loop())
+   * @return true if the registers were written
+   */
+  bool flush();
+
+  /**
+   * @brief Pins currently bound (bit n = GPIO n)
+   */
+  uint64_t getBoundMask() const { return bound; }
+
+  /**
+   * @brief Number of register writes issued by flush()
+   */
+  uint32_t getRegisterWrites() const { return registerWrites; }
+
+  /**
+   * @brief Default writer for the chip's GPIO set/clear registers
+   */
+  static void writeGpioMasks(uint64_t setMask, uint64_t clearMask);
+
+  /**
+   * @brief Default pin setup: configure as a push-pull output
+   */
+  static void configureOutputPin(uint8_t pin);
+
+private:
+  NexState* store = nullptr;
+  MaskWriter writer;
+  PinSetup setup;
+
+  uint64_t bound = 0;        ///< Pins with a binding
+  uint64_t known = 0;        ///< Pins whose level has been written at least once
+  uint64_t levels = 0;       ///< Last written level per pin
+  uint64_t pendingSet = 0;   ///< Pins to drive high on next flush()
+  uint64_t pendingClear = 0; ///< Pins to drive low on next flush()
+  uint32_t registerWrites = 0;
+
+  void queue(uint8_t pin, bool high);
+};
+
+} // namespace nexstate
@@ -0,0 +1,193 @@
+#pragma once
+#include "NexState.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+/**
+ * @file StateBroadcast.h
+ * @brief Selected NexState keys as a compact advertising payload
+ *
+ * Scanners can read a few values (LED state, one sensor reading) from the
+ * manufacturer-specific data without connecting. Keys are given a small id
+ * once; the payload is rebuilt when one of them changes, at most once per
+ * minIntervalMs, and handed to a sink such as BeamLink::setBroadcastData().
+ *
+ * Payload, version 1 (all multi-byte values little-endian):
+ *
+ *     company id (2) | version (1) | sequence (1) | field...
+ *     field = tag (1: id << 3 | type) | value
+ *
+ * | type | value |
+ * |------|-------|
+ * | 0 / 1 | none: bool false / true |
+ * | 2 / 3 / 4 | int8 / int16 / int32 (smallest that fits; scaled by 10^decimals) |
+ * | 5 | float32 |
+ * | 6 | length (1) + UTF-8 bytes |
+ *
+ * The sequence number changes whenever the content does, so a scanner can
+ * skip packets it has already seen. Fields that do not fit the capacity are
+ * left out (never cut) and reported in BroadcastResult.
+ *
+ * @example
+ * ```cpp
+ * StateBroadcast broadcast;
+ *
+ * void setup() {
+ *   broadcast.add(0, "ledOn");
+ *   broadcast.add(1, "temperature", 1);   // 21.5 -> int16 215
+ *   broadcast.setCapacity(beam.getBroadcastCapacity());
+ *   broadcast.onPayload([](const uint8_t* data, size_t size) { beam.setBroadcastData(data, size); });
+ *   broadcast.begin(State());
+ * }
+ *
+ * void loop() {
+ *   update();
+ *   broadcast.update();
+ * }
+ * ```
+ */
+
+#ifndef STATE_BROADCAST_MAX_KEYS
+#define STATE_BROADCAST_MAX_KEYS 8
+#endif
+
+namespace nexstate {
+
+/// Payload format version written after the company id
+constexpr uint8_t kBroadcastVersion = 1;
+/// Legacy advertising and scan response PDUs carry at most 31 bytes of AD data
+constexpr size_t kLegacyAdvBytes = 31;
+/// Bluetooth SIG "no company" id, for development; use your own in production
+constexpr uint16_t kBroadcastTestCompanyId = 0xFFFF;
+
+enum class BroadcastType : uint8_t {
+  False = 0,
+  True = 1,
+  Int8 = 2,
+  Int16 = 3,
+  Int32 = 4,
+  Float = 5,
+  Text = 6
+};
+
+/**
+ * @brief Outcome of building a payload
+ */
+struct BroadcastResult {
+  size_t size = 0;                  ///< Payload bytes, including company id and header
+  uint8_t included = 0;             ///< Keys written
+  uint8_t dropped = 0;              ///< Keys left out: missing, or no room
+  const char* firstDropped = nullptr; ///< Key of the first one left out
+};
+
+/**
+ * @brief One decoded field (see decodeBroadcast())
+ */
+struct BroadcastField {
+  uint8_t id = 0;
+  BroadcastType type = BroadcastType::False;
+  double number = 0;         ///< Bools as 0/1; scaled integers still scaled
+  std::string_view text;     ///< Type Text only; points into the payload
+};
+
+class StateBroadcast {
+public:
+  using Sink = std::function<void(const uint8_t* data, size_t size)>;
+
+  static constexpr uint32_t kNever = UINT32_MAX;
+  static constexpr uint8_t kMaxId = 31;
+
+  explicit StateBroadcast(uint16_t companyId = kBroadcastTestCompanyId) : companyId(companyId) {}
+
+  /**
+   * @brief Include a key in the payload, in the order added
+   * @param id 0-31, what scanners see instead of the key name
+   * @param key State key (copied)
+   * @param decimals For float/double keys: send round(value * 10^decimals)
+   *                 as an integer instead of a 4-byte float
+   * @return false if id is out of range or in use, or STATE_BROADCAST_MAX_KEYS are added
+   */
+  bool add(uint8_t id, std::string_view key, uint8_t decimals = 0);
+
+  /**
+   * @brief Bytes available for manufacturer data, company id included
+   *
+   * Call again when the room changes (e.g. a new device name); the next
+   * update() rebuilds the payload and warns again if keys no longer fit.
+   */
+  void setCapacity(size_t bytes) {
+    capacity = bytes < sizeof(buffer) ? bytes : sizeof(buffer);
+    dirty = true;
+    warned = false;
+  }
+
+  void onPayload(Sink sink) { this->sink = std::move(sink); }
+
+  /**
+   * @brief Watch the store and send the first payload on the next update()
+   *
+   * Registers a change observer, so this object must live as long as the store.
+   * @param minIntervalMs Minimum time between two payloads
+   */
+  void begin(NexState& store, uint32_t minIntervalMs = 1000);
+
+  /**
+   * @brief Send a new payload if a key changed and the rate limit allows
+   *
+   * Call from the task that owns the store, after NexState::update().
+   * @return Milliseconds until a held-back change may be sent, or kNever
+   */
+  uint32_t update(uint32_t nowMs = millis());
+
+  /**
+   * @brief Encode the keys into out (does not touch the rate limit or sequence)
+   */
+  BroadcastResult build(const NexState& store, uint8_t sequence, uint8_t* out, size_t capacity) const;
+
+  /// Result of the last payload sent
+  const BroadcastResult& lastResult() const { return last; }
+
+  uint32_t getPayloadsSent() const { return sent; }
+  uint32_t getChangesCoalesced() const { return coalesced; }
+
+private:
+  struct Key {
+    SmallString name;
+    uint8_t id;
+    uint8_t decimals;
+  };
+
+  uint16_t companyId;
+  Key keys[STATE_BROADCAST_MAX_KEYS];
+  uint8_t keyCount = 0;
+  size_t capacity = kLegacyAdvBytes - 5;  ///< Flags AD (3) + AD header (2) leave 26
+  Sink sink;
+
+  NexState* store = nullptr;
+  uint32_t minIntervalMs = 1000;
+  uint32_t lastSentMs = 0;
+  bool dirty = false;
+  bool warned = false;
+  uint8_t sequence = 0;
+  uint8_t buffer[kLegacyAdvBytes];
+  size_t bufferSize = 0;
+  BroadcastResult last;
+  uint32_t sent = 0;
+  uint32_t coalesced = 0;
+
+  bool watches(std::string_view key) const;
+};
+
+/**
+ * @brief Decode a version 1 payload (for scanners and tests)
+ * @param sequence Receives the sequence number (optional)
+ * @param companyId Receives the company id (optional)
+ * @return Fields in the payload (only the first maxFields are stored), or -1
+ *         if it is malformed or another version
+ */
+int decodeBroadcast(const uint8_t* data, size_t size, BroadcastField* fields, size_t maxFields,
+                    uint8_t* sequence = nullptr, uint16_t* companyId = nullptr);
+
+} // namespace nexstate
@@ -14,3 +14,12 @@
 // Characteristic UUID (Read + Write + Notify)
 // Used for bidirectional communication with the client
 #define BMLK_CHARACTERISTIC_UUID "12345678-1234-1234-1234-1234567890ac"
+
+// Suggested UUIDs for BeamLink::addStream() (Notify; one CCCD each)
+#define BMLK_STATE_STREAM_UUID "12345678-1234-1234-1234-1234567890ad"
+#define BMLK_TELEMETRY_STREAM_UUID "12345678-1234-1234-1234-1234567890ae"
+#define BMLK_LOG_STREAM_UUID "12345678-1234-1234-1234-1234567890af"
+
+// GATT layout version (Read, uint32 little-endian); see BeamGattLayout.h.
+// Registered first, so its handle is the same for every layout
+#define BMLK_LAYOUT_UUID "12345678-1234-1234-1234-1234567890aa"
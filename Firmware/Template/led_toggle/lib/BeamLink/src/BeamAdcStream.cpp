@@ -0,0 +1,473 @@
+#include "BeamAdcStream.h"
+#include "BeamConfig.h"
+
+#if defined(ARDUINO) && defined(ESP32)
+#include <esp_idf_version.h>
+#include <soc/soc_caps.h>
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include <esp_adc/adc_continuous.h>
+#else
+#include <driver/adc.h>
+#endif
+#endif
+
+namespace {
+
+constexpr uint32_t kTaskReadTimeoutMs = 20;
+
+#if defined(ARDUINO) && defined(ESP32)
+// The ESP32 digital controller's lower limit, across all channels
+constexpr uint32_t kDmaMinTotalHz = 20000;
+
+constexpr uint32_t kTaskStackBytes = 4096;
+constexpr UBaseType_t kTaskPriority = 5;  // above loop(), below the NimBLE host
+#endif
+
+} // namespace
+
+int beamAdc1Channel(uint8_t pin) {
+  switch (pin) {
+    case 36: return 0;
+    case 37: return 1;
+    case 38: return 2;
+    case 39: return 3;
+    case 32: return 4;
+    case 33: return 5;
+    case 34: return 6;
+    case 35: return 7;
+    default: return -1;
+  }
+}
+
+// ============================================================================
+// ESP32 DMA Source
+// ============================================================================
+
+#if defined(ARDUINO) && defined(ESP32)
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+struct BeamDmaAdcCallbacks {
+  static bool IRAM_ATTR onOverflow(adc_continuous_handle_t, const adc_continuous_evt_data_t*, void* arg) {
+    static_cast<BeamDmaAdc*>(arg)->overflowCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+};
+#endif
+
+BeamDmaAdc::~BeamDmaAdc() {
+  release();
+}
+
+bool BeamDmaAdc::begin(const uint8_t* pins, size_t count, uint32_t rateHz) {
+  release();
+  if (!pins || count == 0 || count > BEAM_SAMPLER_MAX_CHANNELS) return false;
+
+  const uint32_t totalHz = rateHz * count;
+  if (totalHz < kDmaMinTotalHz || totalHz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) {
+    Serial.printf("BeamDmaAdc: %lu Hz in total is outside %lu..%lu Hz\n", static_cast<unsigned long>(totalHz),
+                  static_cast<unsigned long>(kDmaMinTotalHz),
+                  static_cast<unsigned long>(SOC_ADC_SAMPLE_FREQ_THRES_HIGH));
+    return false;
+  }
+
+  adc_digi_pattern_config_t pattern[BEAM_SAMPLER_MAX_CHANNELS] = {};
+  for (int8_t& index : channelIndex) index = -1;
+  for (size_t i = 0; i < count; i++) {
+    const int channel = beamAdc1Channel(pins[i]);
+    if (channel < 0) {
+      Serial.printf("BeamDmaAdc: GPIO%u is not an ADC1 pin\n", pins[i]);
+      return false;
+    }
+    channelIndex[channel] = static_cast<int8_t>(i);
+    pattern[i].atten = ADC_ATTEN_DB_11;
+    pattern[i].channel = static_cast<uint8_t>(channel);
+    pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+  }
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+  adc_continuous_handle_cfg_t handleCfg = {};
+  handleCfg.max_store_buf_size = sizeof(raw) * 4;
+  handleCfg.conv_frame_size = sizeof(raw);
+  adc_continuous_handle_t h = nullptr;
+  if (adc_continuous_new_handle(&handleCfg, &h) != ESP_OK) {
+    Serial.println("BeamDmaAdc: adc_continuous_new_handle failed");
+    return false;
+  }
+  handle = h;
+  initialized = true;
+
+  for (size_t i = 0; i < count; i++) pattern[i].unit = ADC_UNIT_1;
+  adc_continuous_config_t cfg = {};
+  cfg.pattern_num = count;
+  cfg.adc_pattern = pattern;
+  cfg.sample_freq_hz = totalHz;
+  cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  cfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+  adc_continuous_evt_cbs_t callbacks = {};
+  callbacks.on_pool_ovf = &BeamDmaAdcCallbacks::onOverflow;
+  if (adc_continuous_config(h, &cfg) != ESP_OK ||
+      adc_continuous_register_event_callbacks(h, &callbacks, this) != ESP_OK) {
+    Serial.println("BeamDmaAdc: adc_continuous_config failed");
+    release();
+    return false;
+  }
+#else
+  uint32_t mask = 0;
+  for (size_t i = 0; i < count; i++) mask |= 1u << pattern[i].channel;
+  adc_digi_init_config_t init = {};
+  init.max_store_buf_size = sizeof(raw) * 4;
+  init.conv_num_each_intr = sizeof(raw);
+  init.adc1_chan_mask = mask;
+  init.adc2_chan_mask = 0;
+  if (adc_digi_initialize(&init) != ESP_OK) {
+    Serial.println("BeamDmaAdc: adc_digi_initialize failed");
+    return false;
+  }
+  initialized = true;
+
+  for (size_t i = 0; i < count; i++) pattern[i].unit = 0;  // ADC1
+  adc_digi_configuration_t cfg = {};
+  cfg.conv_limit_en = 1;   // required on the ESP32
+  cfg.conv_limit_num = 250;
+  cfg.pattern_num = count;
+  cfg.adc_pattern = pattern;
+  cfg.sample_freq_hz = totalHz;
+  cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  cfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+  if (adc_digi_controller_configure(&cfg) != ESP_OK) {
+    Serial.println("BeamDmaAdc: adc_digi_controller_configure failed");
+    release();
+    return false;
+  }
+#endif
+  return true;
+}
+
+bool BeamDmaAdc::start() {
+  if (!initialized || running) return false;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+  running = adc_continuous_start(static_cast<adc_continuous_handle_t>(handle)) == ESP_OK;
+#else
+  running = adc_digi_start() == ESP_OK;
+#endif
+  return running;
+}
+
+void BeamDmaAdc::stop() {
+  if (!running) return;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+  adc_continuous_stop(static_cast<adc_continuous_handle_t>(handle));
+#else
+  adc_digi_stop();
+#endif
+  running = false;
+}
+
+void BeamDmaAdc::release() {
+  stop();
+  if (!initialized) return;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+  adc_continuous_deinit(static_cast<adc_continuous_handle_t>(handle));
+#else
+  adc_digi_deinitialize();
+#endif
+  handle = nullptr;
+  initialized = false;
+}
+
+size_t BeamDmaAdc::read(BeamAdcConversion* out, size_t max, uint32_t timeoutMs, uint32_t& endUs) {
+  if (!running) return 0;
+  uint32_t got = 0;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+  const esp_err_t err = adc_continuous_read(static_cast<adc_continuous_handle_t>(handle), raw, sizeof(raw), &got,
+                                            timeoutMs);
+#else
+  esp_err_t err = adc_digi_read_bytes(raw, sizeof(raw), &got, timeoutMs);
+  if (err == ESP_ERR_INVALID_STATE) {
+    // Pool was full and a frame was lost; what was read is still valid
+    overflowCount.fetch_add(1, std::memory_order_relaxed);
+    err = ESP_OK;
+  }
+#endif
+  if (err != ESP_OK) return 0;
+  endUs = micros();
+
+  size_t n = 0;
+  for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= got && n < max; i += SOC_ADC_DIGI_RESULT_BYTES) {
+    const adc_digi_output_data_t* result = reinterpret_cast<const adc_digi_output_data_t*>(&raw[i]);
+    const uint32_t channel = result->type1.channel;
+    if (channel < 8 && channelIndex[channel] >= 0) {
+      out[n++] = BeamAdcConversion{static_cast<uint8_t>(channelIndex[channel]),
+                                   static_cast<uint16_t>(result->type1.data)};
+    }
+  }
+  return n;
+}
+
+#endif
+
+// ============================================================================
+// Simulated Source
+// ============================================================================
+
+void BeamSimDmaAdc::setFrameSize(size_t conversions) {
+  frameSize = conversions == 0 ? 1 : (conversions > BEAM_ADC_FRAME ? BEAM_ADC_FRAME : conversions);
+}
+
+bool BeamSimDmaAdc::begin(const uint8_t* pins, size_t count, uint32_t rateHz) {
+  if (!pins || count == 0 || count > BEAM_SAMPLER_MAX_CHANNELS || rateHz == 0) return false;
+  channels = static_cast<uint8_t>(count);
+  periodNs = 1000000000u / rateHz;
+  clockNs = 0;
+  nextChannel = 0;
+  return true;
+}
+
+bool BeamSimDmaAdc::start() {
+  if (channels == 0) return false;
+  if (realTime) clockNs = static_cast<uint64_t>(static_cast<uint32_t>(micros())) * 1000;
+  started = true;
+  return true;
+}
+
+size_t BeamSimDmaAdc::read(BeamAdcConversion* out, size_t max, uint32_t timeoutMs, uint32_t& endUs) {
+  if (!started) {
+    if (realTime) delay(timeoutMs);
+    return 0;
+  }
+  const size_t n = frameSize < max ? frameSize : max;
+  for (size_t i = 0; i < n; i++) {
+    const uint8_t channel = nextChannel;
+    out[i] = BeamAdcConversion{channel, signals.read(channel, static_cast<uint32_t>(clockNs / 1000))};
+    if (++nextChannel == channels) {
+      nextChannel = 0;
+      clockNs += periodNs;
+    }
+  }
+  endUs = static_cast<uint32_t>(clockNs / 1000);
+
+  // Like the DMA: the frame is only there once its last conversion is
+  while (realTime && static_cast<int32_t>(endUs - static_cast<uint32_t>(micros())) > 0) delay(1);
+  return n;
+}
+
+// ============================================================================
+// Stream
+// ============================================================================
+
+BeamAdcStream::~BeamAdcStream() {
+  stop();
+#if defined(ARDUINO) && defined(ESP32)
+  if (finished) vSemaphoreDelete(finished);
+#endif
+}
+
+bool BeamAdcStream::begin(BeamAdcSource& source, const uint8_t* pins, size_t count, uint32_t rateHz,
+                          size_t blockSamples) {
+  if (isRunning() || !pins || count == 0 || count > BEAM_SAMPLER_MAX_CHANNELS || rateHz == 0) return false;
+  if (blockSamples == 0 || blockSamples > BEAM_ADC_BLOCK) return false;
+  if (!source.begin(pins, count, rateHz)) return false;
+
+  this->source = &source;
+  for (size_t i = 0; i < count; i++) this->pins[i] = pins[i];
+  channels = static_cast<uint8_t>(count);
+  rate = rateHz;
+  blockSize = blockSamples;
+
+  for (int i = 0; i < 2; i++) {
+    blocks[i] = BeamAdcBlock{};
+    state[i].store(kFree, std::memory_order_relaxed);
+  }
+  writing = 0;
+  reading = -1;
+  lastTaken = 1;
+  blockStarted = false;
+  fullChannels = 0;
+  sequence = 0;
+  resetStats();
+  return true;
+}
+
+bool BeamAdcStream::begin(BeamAdcSource& source, const BeamConfig& cfg, uint32_t rateHz, size_t blockSamples) {
+  uint8_t parsed[BEAM_SAMPLER_MAX_CHANNELS];
+  const size_t count = beamParsePins(cfg.sensorPins, parsed, BEAM_SAMPLER_MAX_CHANNELS);
+  if (count == 0) {
+    Serial.printf("BeamAdcStream: invalid SENSOR_PINS \"%s\"\n", cfg.sensorPins.c_str());
+    return false;
+  }
+  return begin(source, parsed, count, rateHz, blockSamples);
+}
+
+size_t BeamAdcStream::pump(uint32_t timeoutMs) {
+  if (!source) return 0;
+  uint32_t endUs = 0;
+  const size_t n = source->read(frame, BEAM_ADC_FRAME, timeoutMs, endUs);
+  if (n == 0) return 0;
+
+  // The frame's samples are evenly spaced and end at endUs
+  const uint32_t frameUs = static_cast<uint32_t>(static_cast<uint64_t>(n / channels) * 1000000u / rate);
+  const uint32_t startUs = endUs - frameUs;
+  if (!timed.load(std::memory_order_relaxed)) {
+    firstUs.store(startUs, std::memory_order_relaxed);
+    timed.store(true, std::memory_order_relaxed);
+  }
+
+  uint16_t position[BEAM_SAMPLER_MAX_CHANNELS] = {};
+  for (size_t i = 0; i < n; i++) {
+    const uint8_t ch = frame[i].channel;
+    if (ch >= channels) continue;
+    if (blocks[writing].count[ch] >= blockSize) publish();  // uneven channels: close early
+    BeamAdcBlock& block = blocks[writing];
+    if (!blockStarted) {
+      block.firstUs = startUs + static_cast<uint32_t>(static_cast<uint64_t>(position[ch]) * 1000000u / rate);
+      blockStarted = true;
+    }
+    block.values[ch][block.count[ch]++] = frame[i].value;
+    position[ch]++;
+    if (block.count[ch] == blockSize && ++fullChannels == channels) publish();
+  }
+
+  lastUs.store(endUs, std::memory_order_relaxed);
+  conversions.fetch_add(static_cast<uint32_t>(n), std::memory_order_relaxed);
+  return n;
+}
+
+void BeamAdcStream::publish() {
+  const uint8_t done = writing;
+  const uint8_t other = done ^ 1;
+  blocks[done].sequence = sequence++;
+  blocks[done].channels = channels;
+  state[done].store(kReady, std::memory_order_release);
+  filled.fetch_add(1, std::memory_order_relaxed);
+
+  // Find a block to fill next. With the consumer behind, one is dropped:
+  // the older one if it was never taken, else the one just finished.
+  bool published = true;
+  for (;;) {
+    uint8_t s = state[other].load(std::memory_order_acquire);
+    if (s == kFree) {
+      writing = other;
+      break;
+    }
+    if (s == kReady && state[other].compare_exchange_strong(s, kFree, std::memory_order_acq_rel)) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      writing = other;
+      break;
+    }
+    if (s == kReading) {
+      uint8_t expected = kReady;
+      if (state[done].compare_exchange_strong(expected, kFree, std::memory_order_acq_rel)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        writing = done;
+        published = false;
+        break;
+      }
+      // The consumer took `done` meanwhile, so it released `other`
+    }
+  }
+
+  BeamAdcBlock& next = blocks[writing];
+  for (uint16_t& count : next.count) count = 0;
+  blockStarted = false;
+  fullChannels = 0;
+  if (published && blockReady) blockReady();
+}
+
+const BeamAdcBlock* BeamAdcStream::next() {
+  release();
+  const uint8_t order[2] = {static_cast<uint8_t>(lastTaken ^ 1), lastTaken};
+  for (uint8_t i : order) {
+    uint8_t expected = kReady;
+    if (state[i].compare_exchange_strong(expected, kReading, std::memory_order_acq_rel)) {
+      reading = static_cast<int8_t>(i);
+      lastTaken = i;
+      return &blocks[i];
+    }
+  }
+  return nullptr;
+}
+
+void BeamAdcStream::release() {
+  if (reading < 0) return;
+  state[reading].store(kFree, std::memory_order_release);
+  reading = -1;
+}
+
+BeamAdcStreamStats BeamAdcStream::stats() const {
+  BeamAdcStreamStats s;
+  s.conversions = conversions.load(std::memory_order_relaxed);
+  s.blocks = filled.load(std::memory_order_relaxed);
+  s.dropped = dropped.load(std::memory_order_relaxed);
+  s.driverOverflows = source ? source->overflows() - overflowBase : 0;
+  const uint32_t elapsedUs = lastUs.load(std::memory_order_relaxed) - firstUs.load(std::memory_order_relaxed);
+  if (channels && elapsedUs) {
+    s.sustainedHz = static_cast<uint32_t>(static_cast<uint64_t>(s.conversions) * 1000000u / channels / elapsedUs);
+  }
+  return s;
+}
+
+void BeamAdcStream::resetStats() {
+  conversions.store(0, std::memory_order_relaxed);
+  filled.store(0, std::memory_order_relaxed);
+  dropped.store(0, std::memory_order_relaxed);
+  firstUs.store(0, std::memory_order_relaxed);
+  lastUs.store(0, std::memory_order_relaxed);
+  timed.store(false, std::memory_order_relaxed);
+  overflowBase = source ? source->overflows() : 0;
+}
+
+// ============================================================================
+// Acquisition Task
+// ============================================================================
+
+#if defined(ARDUINO) && defined(ESP32)
+
+void BeamAdcStream::taskEntry(void* arg) {
+  BeamAdcStream* self = static_cast<BeamAdcStream*>(arg);
+  while (self->running.load(std::memory_order_relaxed)) self->pump(kTaskReadTimeoutMs);
+  xSemaphoreGive(self->finished);
+  vTaskDelete(nullptr);
+}
+
+bool BeamAdcStream::start() {
+  if (!source || isRunning()) return false;
+  if (!finished) finished = xSemaphoreCreateBinary();
+  if (!finished || !source->start()) return false;
+  running.store(true, std::memory_order_relaxed);
+  if (xTaskCreatePinnedToCore(taskEntry, "beam_adc", kTaskStackBytes, this, kTaskPriority, &task,
+                              tskNO_AFFINITY) != pdPASS) {
+    Serial.println("BeamAdcStream: could not start the acquisition task");
+    running.store(false, std::memory_order_relaxed);
+    source->stop();
+    return false;
+  }
+  return true;
+}
+
+void BeamAdcStream::stop() {
+  if (!isRunning()) return;
+  running.store(false, std::memory_order_relaxed);
+  xSemaphoreTake(finished, portMAX_DELAY);  // task leaves within one read timeout
+  task = nullptr;
+  source->stop();
+}
+
+#else
+
+bool BeamAdcStream::start() {
+  if (!source || isRunning() || !source->start()) return false;
+  running.store(true, std::memory_order_relaxed);
+  worker = std::thread([this] {
+    while (running.load(std::memory_order_relaxed)) pump(kTaskReadTimeoutMs);
+  });
+  return true;
+}
+
+void BeamAdcStream::stop() {
+  if (!isRunning()) return;
+  running.store(false, std::memory_order_relaxed);
+  if (worker.joinable()) worker.join();
+  source->stop();
+}
+
+#endif
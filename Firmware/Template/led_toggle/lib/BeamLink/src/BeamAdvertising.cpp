@@ -0,0 +1,91 @@
+#include "BeamAdvertising.h"
+#include "BeamConfig.h"
+
+BeamAdvSteps beamAdvSteps(const BeamConfig& cfg) {
+  BeamAdvSteps steps;
+  steps.fastIntervalMs = static_cast<uint16_t>(cfg.bleAdvFastIntervalMs);
+  steps.fastMs = static_cast<uint32_t>(cfg.bleAdvFastMs);
+  steps.intervalMs = static_cast<uint16_t>(cfg.bleAdvIntervalMs);
+  steps.normalMs = static_cast<uint32_t>(cfg.bleAdvNormalMs);
+  steps.slowIntervalMs = static_cast<uint16_t>(cfg.bleAdvSlowIntervalMs);
+  return steps;
+}
+
+const char* beamAdvPhaseName(BeamAdvPhase phase) {
+  switch (phase) {
+    case BeamAdvPhase::Fast: return "fast";
+    case BeamAdvPhase::Normal: return "normal";
+    case BeamAdvPhase::Slow: return "slow";
+    default: return "off";
+  }
+}
+
+BeamAdvSchedule::BeamAdvSchedule(uint32_t nowMs) : phaseStartMs(nowMs), sinceMs(nowMs) {}
+
+void BeamAdvSchedule::configure(const BeamAdvSteps& steps) {
+  settings = steps;
+}
+
+void BeamAdvSchedule::restart(uint32_t nowMs) {
+  counters.restarts++;
+  enter(BeamAdvPhase::Fast, nowMs);
+  // Skip zero-length phases right away
+  update(nowMs);
+}
+
+void BeamAdvSchedule::stop(uint32_t nowMs) {
+  enter(BeamAdvPhase::Off, nowMs);
+}
+
+bool BeamAdvSchedule::update(uint32_t nowMs) {
+  bool changed = false;
+  while (current == BeamAdvPhase::Fast || current == BeamAdvPhase::Normal) {
+    if (nowMs - phaseStartMs < durationMs(current)) break;
+    // The new phase starts now, not at the old deadline: the radio only
+    // changes interval when the caller applies it
+    enter(current == BeamAdvPhase::Fast ? BeamAdvPhase::Normal : BeamAdvPhase::Slow, nowMs);
+    counters.steps++;
+    changed = true;
+  }
+  return changed;
+}
+
+uint32_t BeamAdvSchedule::intervalMs() const {
+  switch (current) {
+    case BeamAdvPhase::Fast: return settings.fastIntervalMs;
+    case BeamAdvPhase::Normal: return settings.intervalMs;
+    case BeamAdvPhase::Slow: return settings.slowIntervalMs;
+    default: return 0;
+  }
+}
+
+uint32_t BeamAdvSchedule::msUntilNext(uint32_t nowMs) const {
+  if (current != BeamAdvPhase::Fast && current != BeamAdvPhase::Normal) return kNever;
+  const uint32_t elapsed = nowMs - phaseStartMs;
+  const uint32_t duration = durationMs(current);
+  return elapsed >= duration ? 0 : duration - elapsed;
+}
+
+BeamAdvStats BeamAdvSchedule::stats(uint32_t nowMs) const {
+  BeamAdvStats s = counters;
+  s.timeMs[static_cast<uint8_t>(current)] += nowMs - sinceMs;
+  return s;
+}
+
+void BeamAdvSchedule::resetStats(uint32_t nowMs) {
+  counters = BeamAdvStats{};
+  sinceMs = nowMs;
+}
+
+uint32_t BeamAdvSchedule::durationMs(BeamAdvPhase phase) const {
+  if (phase == BeamAdvPhase::Fast) return settings.fastMs;
+  if (phase == BeamAdvPhase::Normal) return settings.normalMs;
+  return kNever;
+}
+
+void BeamAdvSchedule::enter(BeamAdvPhase phase, uint32_t nowMs) {
+  counters.timeMs[static_cast<uint8_t>(current)] += nowMs - sinceMs;
+  sinceMs = nowMs;
+  current = phase;
+  phaseStartMs = nowMs;
+}
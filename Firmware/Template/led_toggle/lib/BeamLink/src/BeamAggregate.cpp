@@ -0,0 +1,179 @@
+#include "BeamAggregate.h"
+
+// ============================================================================
+// Accumulators
+// ============================================================================
+
+void BeamAccumulator::add(const uint16_t* values, size_t count) {
+  while (count) {
+    // 65536 samples of at most 65535 still fit a 32-bit partial sum
+    const size_t chunk = count < 65536 ? count : 65536;
+    uint32_t partial = 0;
+    uint64_t partialSq = 0;
+    uint16_t chunkLo = lo;
+    uint16_t chunkHi = hi;
+    for (size_t i = 0; i < chunk; i++) {
+      const uint32_t v = values[i];
+      partial += v;
+      partialSq += v * v;
+      if (values[i] < chunkLo) chunkLo = values[i];
+      if (values[i] > chunkHi) chunkHi = values[i];
+    }
+    n += static_cast<uint32_t>(chunk);
+    sum += partial;
+    sumSq += partialSq;
+    lo = chunkLo;
+    hi = chunkHi;
+    values += chunk;
+    count -= chunk;
+  }
+}
+
+void BeamAccumulator::merge(const BeamAccumulator& other) {
+  n += other.n;
+  sum += other.sum;
+  sumSq += other.sumSq;
+  if (other.lo < lo) lo = other.lo;
+  if (other.hi > hi) hi = other.hi;
+}
+
+void BeamAccumulator::result(BeamWindow& w) const {
+  w.count = n;
+  if (!n) {
+    w.min = w.max = w.mean = w.variance = 0;
+    return;
+  }
+  const double mean = static_cast<double>(sum) / n;
+  const double variance = static_cast<double>(sumSq) / n - mean * mean;
+  w.min = lo;
+  w.max = hi;
+  w.mean = static_cast<float>(mean);
+  w.variance = variance > 0 ? static_cast<float>(variance) : 0.0f;
+}
+
+void BeamFloatAccumulator::merge(const BeamFloatAccumulator& other) {
+  if (!other.n) return;
+  if (!n) {
+    *this = other;
+    return;
+  }
+  const uint32_t total = n + other.n;
+  const float delta = other.runMean - runMean;
+  runMean += delta * other.n / total;
+  m2 += other.m2 + delta * delta * (static_cast<float>(n) * other.n / total);
+  n = total;
+  if (other.lo < lo) lo = other.lo;
+  if (other.hi > hi) hi = other.hi;
+}
+
+void BeamFloatAccumulator::result(BeamWindow& w) const {
+  w.count = n;
+  if (!n) {
+    w.min = w.max = w.mean = w.variance = 0;
+    return;
+  }
+  w.min = lo;
+  w.max = hi;
+  w.mean = runMean;
+  w.variance = m2 > 0 ? m2 / n : 0.0f;
+}
+
+// ============================================================================
+// Aggregator
+// ============================================================================
+
+bool BeamAggregator::begin(uint8_t channelCount, const Config& config) {
+  if (channelCount == 0 || channelCount > BEAM_SAMPLER_MAX_CHANNELS) {
+    Serial.printf("BeamAggregator: invalid channel count %u\n", channelCount);
+    return false;
+  }
+  count = channelCount;
+  cfg = config;
+  for (uint8_t ch = 0; ch < count; ch++) {
+    Channel& c = channels[ch];
+    c.tumbling.setLength(cfg.windowUs);
+    c.window.setLength(cfg.slidingUs);
+    c.ewma.setShift(cfg.ewmaShift);
+    c.tumbling.onWindow([this, ch](const BeamWindow& w) {
+      // Runs before the sample that closed the window is added anywhere
+      Channel& closing = channels[ch];
+      closing.closed = w;
+      closing.closed.ewma = closing.ewma.value();
+      if (closedFn) closedFn(ch, closing.closed);
+    });
+  }
+  reset();
+  return true;
+}
+
+void BeamAggregator::add(uint8_t channel, uint16_t value, uint32_t timeUs) {
+  if (channel >= count) return;
+  Channel& c = channels[channel];
+  c.tumbling.add(value, timeUs);
+  c.window.add(value, timeUs);
+  c.ewma.add(value);
+}
+
+void BeamAggregator::add(uint8_t channel, const BeamSample* samples, size_t n) {
+  for (size_t i = 0; i < n; i++) add(channel, samples[i].value, samples[i].timeUs);
+}
+
+void BeamAggregator::add(uint8_t channel, const uint16_t* values, size_t n, uint32_t firstUs,
+                         uint32_t rateHz) {
+  if (channel >= count || !rateHz) return;
+  Channel& c = channels[channel];
+  size_t i = 0;
+  while (i < n) {
+    // The first sample may close a window; the rest of the run up to the
+    // next boundary goes in as a block, so the EWMA matches sample by sample
+    add(channel, values[i], firstUs + beamSampleOffsetUs(i, rateHz));
+    const uint32_t startUs = firstUs + beamSampleOffsetUs(i + 1, rateHz);
+    size_t end = beamSampleIndexAt(c.tumbling.endUs() - firstUs, rateHz);
+    if (end <= i + 1) end = i + 1;
+    if (end > n) end = n;
+    const size_t run = end - (i + 1);
+    if (run) {
+      c.tumbling.add(values + i + 1, run, startUs, rateHz);
+      c.window.add(values + i + 1, run, startUs, rateHz);
+      for (size_t j = i + 1; j < end; j++) c.ewma.add(values[j]);
+    }
+    i = end;
+  }
+}
+
+void BeamAggregator::advanceTo(uint32_t nowUs) {
+  for (uint8_t ch = 0; ch < count; ch++) {
+    channels[ch].tumbling.advanceTo(nowUs);
+    channels[ch].window.advanceTo(nowUs);
+  }
+}
+
+const BeamWindow& BeamAggregator::last(uint8_t channel) const {
+  static const BeamWindow empty;
+  return channel < count ? channels[channel].closed : empty;
+}
+
+BeamWindow BeamAggregator::sliding(uint8_t channel) const {
+  if (channel >= count) return BeamWindow{};
+  BeamWindow w = channels[channel].window.stats();
+  w.ewma = channels[channel].ewma.value();
+  return w;
+}
+
+float BeamAggregator::ewma(uint8_t channel) const {
+  return channel < count ? channels[channel].ewma.value() : 0.0f;
+}
+
+uint32_t BeamAggregator::windows(uint8_t channel) const {
+  return channel < count ? channels[channel].tumbling.windows() : 0;
+}
+
+void BeamAggregator::reset() {
+  for (uint8_t ch = 0; ch < count; ch++) {
+    Channel& c = channels[ch];
+    c.tumbling.reset();
+    c.window.reset();
+    c.ewma.reset();
+    c.closed = BeamWindow{};
+  }
+}
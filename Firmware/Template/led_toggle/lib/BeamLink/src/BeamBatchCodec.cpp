@@ -0,0 +1,115 @@
+#include "BeamBatchCodec.h"
+#include "BeamUtils.h"
+
+// ============================================================================
+// Encoder
+// ============================================================================
+
+bool BeamBatchEncoder::begin(uint8_t* out, size_t capacity, uint8_t channel, uint8_t batchFormat) {
+  buffer = nullptr;
+  used = 0;
+  n = 0;
+  prevUs = 0;
+  prevDeltaUs = 0;
+  prevValue = 0;
+  if (!out || capacity < kBeamBatchHeader) return false;
+  if (batchFormat != kBeamBatchRaw && batchFormat != kBeamBatchDelta && batchFormat != kBeamBatchXor) {
+    return false;
+  }
+  buffer = out;
+  limit = capacity;
+  format = batchFormat;
+  buffer[0] = format;
+  buffer[1] = channel;
+  buffer[2] = 0;
+  used = kBeamBatchHeader;
+  return true;
+}
+
+bool BeamBatchEncoder::add(const BeamSample& sample) {
+  if (!buffer || n == 255) return false;
+
+  // The first sample, and every sample of a raw batch, is stored in full
+  if (n == 0 || format == kBeamBatchRaw) {
+    if (limit - used < kBeamBatchRawSample) return false;
+    BeamUtils::putLe(buffer + used, sample.timeUs, 4);
+    BeamUtils::putLe(buffer + used + 4, sample.value, 2);
+    used += kBeamBatchRawSample;
+  } else {
+    // Unsigned arithmetic: micros() wrapping between samples is fine
+    const uint32_t deltaUs = sample.timeUs - prevUs;
+    const uint32_t timeCode = beamZigzag(static_cast<int32_t>(deltaUs - prevDeltaUs));
+    const uint32_t valueCode = format == kBeamBatchXor
+                                   ? static_cast<uint32_t>(sample.value ^ prevValue)
+                                   : beamZigzag(static_cast<int32_t>(sample.value) - prevValue);
+    if (limit - used < beamVarintSize(timeCode) + beamVarintSize(valueCode)) return false;
+    used += beamPutVarint(buffer + used, timeCode);
+    used += beamPutVarint(buffer + used, valueCode);
+    prevDeltaUs = deltaUs;
+  }
+  prevUs = sample.timeUs;
+  prevValue = sample.value;
+  n++;
+  return true;
+}
+
+size_t BeamBatchEncoder::finish() {
+  if (!buffer || n == 0) return 0;
+  buffer[2] = static_cast<uint8_t>(n);
+  return used;
+}
+
+size_t beamEncodeBatch(uint8_t channel, const BeamSample* samples, size_t n, uint8_t* out,
+                       size_t capacity, uint8_t format, size_t& encoded) {
+  encoded = 0;
+  BeamBatchEncoder enc;
+  if (!enc.begin(out, capacity, channel, format)) return 0;
+  while (encoded < n && enc.add(samples[encoded])) encoded++;
+  return enc.finish();
+}
+
+// ============================================================================
+// Decoder
+// ============================================================================
+
+int beamDecodeDeltaBatch(const uint8_t* data, size_t size, uint8_t* channel, BeamSample* out,
+                         size_t maxSamples) {
+  if (!data || size < kBeamBatchHeader + kBeamBatchRawSample) return -1;
+  const uint8_t format = data[0];
+  if (format != kBeamBatchDelta && format != kBeamBatchXor) return -1;
+  const size_t count = data[2];
+  if (count == 0) return -1;
+
+  const uint8_t* p = data + kBeamBatchHeader;
+  const uint8_t* end = data + size;
+  uint32_t timeUs = BeamUtils::getLe(p, 4);
+  uint16_t value = static_cast<uint16_t>(BeamUtils::getLe(p + 4, 2));
+  uint32_t deltaUs = 0;
+  p += kBeamBatchRawSample;
+  if (maxSamples) out[0] = {timeUs, value};
+
+  for (size_t i = 1; i < count; i++) {
+    uint32_t timeCode, valueCode;
+    size_t len = beamGetVarint(p, end, timeCode);
+    if (!len) return -1;
+    p += len;
+    len = beamGetVarint(p, end, valueCode);
+    if (!len) return -1;
+    p += len;
+
+    deltaUs += static_cast<uint32_t>(beamUnzigzag(timeCode));
+    timeUs += deltaUs;
+    if (format == kBeamBatchXor) {
+      if (valueCode > 0xFFFF) return -1;
+      value = static_cast<uint16_t>(value ^ valueCode);
+    } else {
+      const int32_t next = value + beamUnzigzag(valueCode);
+      if (next < 0 || next > 0xFFFF) return -1;
+      value = static_cast<uint16_t>(next);
+    }
+    if (i < maxSamples) out[i] = {timeUs, value};
+  }
+  if (p != end) return -1;
+  if (channel) *channel = data[1];
+  return static_cast<int>(count);
+}
@@ -1,27 +1,211 @@
 #include "BeamConfig.h"
+#include "BeamStaticConfig.h"
+#include "BeamUtils.h"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#if defined(ARDUINO)
+#include <SPIFFS.h>
+#endif
+
+namespace {
+
+// ---- Field table: text keys, kinds and ranges in one place ----
 
 /**
- * @brief Load configuration from compile-time constants
- * 
- * Since we've moved to header-based configuration, this function
- * now simply sets the configuration to default values. The actual
- * configuration should be done using the beam.config.h header file
- * in the application code.
- * 
- * @param cfg Reference to BeamConfig structure to populate
- * @param path Path parameter (ignored, kept for compatibility)
- * @return true (always succeeds since we use defaults)
+ * @brief Calls v(key, field[, min, max[, step]]) for every configurable field
  */
-bool loadBeamConfig(BeamConfig& cfg, const char* path) {
-  // Configuration is now handled via compile-time constants
-  // This function is kept for compatibility but doesn't load from file
-  
-  Serial.println("Using default configuration (JSON loading removed)");
-  Serial.printf("  Device: %s (%s)\n", cfg.deviceName.c_str(), cfg.deviceId.c_str());
-  Serial.printf("  Type: %s, FW: %s\n", cfg.deviceType.c_str(), cfg.fwVersion.c_str());
-  Serial.printf("  BLE: %s, Power: %d dBm, Interval: %d ms\n", 
-                cfg.bleEnabled ? "enabled" : "disabled", cfg.blePowerDbm, cfg.bleAdvIntervalMs);
-  Serial.printf("  Service UUID: %s\n", cfg.bleServiceUuid.c_str());
-  
+template<typename Config, typename Visitor>
+void forEachField(Config& cfg, Visitor&& v) {
+  v("DEVICE_ID", cfg.deviceId);
+  v("DEVICE_NAME", cfg.deviceName);
+  v("DEVICE_TYPE", cfg.deviceType);
+  v("FIRMWARE_VERSION", cfg.fwVersion);
+  v("BLE_ENABLED", cfg.bleEnabled);
+  v("BLE_NAME", cfg.bleName);
+  v("BLE_POWER_DBM", cfg.blePowerDbm, beamcfg::kMinPowerDbm, beamcfg::kMaxPowerDbm, beamcfg::kPowerStepDb);
+  v("BLE_ADV_INTERVAL_MS", cfg.bleAdvIntervalMs, beamcfg::kMinAdvIntervalMs, beamcfg::kMaxAdvIntervalMs);
+  v("BLE_ADV_FAST_INTERVAL_MS", cfg.bleAdvFastIntervalMs, beamcfg::kMinAdvIntervalMs, beamcfg::kMaxAdvIntervalMs);
+  v("BLE_ADV_FAST_MS", cfg.bleAdvFastMs, 0, 3600000);
+  v("BLE_ADV_NORMAL_MS", cfg.bleAdvNormalMs, 0, 86400000);
+  v("BLE_ADV_SLOW_INTERVAL_MS", cfg.bleAdvSlowIntervalMs, beamcfg::kMinAdvIntervalMs, beamcfg::kMaxAdvIntervalMs);
+  v("BLE_SERVICE_UUID", cfg.bleServiceUuid);
+  v("BLE_CHARACTERISTIC_UUID", cfg.bleCharacteristicUuid);
+  v("WIFI_ENABLED", cfg.wifiEnabled);
+  v("WIFI_SSID", cfg.wifiSsid);
+  v("WIFI_PASSWORD", cfg.wifiPass);
+  v("WIFI_MODE", cfg.wifiMode);
+  v("CLOUD_ENABLED", cfg.cloudEnabled);
+  v("CLOUD_ENDPOINT", cfg.cloudEndpoint);
+  v("OTA_ENABLED", cfg.otaEnabled);
+  v("OTA_URL", cfg.otaUrl);
+  v("LED_PIN", cfg.ledPin, 0, beamcfg::kMaxPin);
+  v("LED_ACTIVE_HIGH", cfg.ledActiveHigh);
+  v("SENSOR_PINS", cfg.sensorPins);
+  v("ACTUATOR_PINS", cfg.actuatorPins);
+  v("REPORT_INTERVAL_MS", cfg.reportIntervalMs, 100, 86400000);
+  v("HEARTBEAT_MS", cfg.heartbeatMs, 0, 86400000);
+  v("AUTO_RECONNECT", cfg.autoReconnect);
+  v("LOG_LEVEL", cfg.logLevel);
+  v("SERIAL_BAUD", cfg.serialBaud, 9600, 2000000);
+  v("DEBUG_MODE", cfg.debugMode);
+  v("AUTH_TOKEN", cfg.authToken);
+  v("ENCRYPTION_ENABLED", cfg.encryption);
+  v("SENSOR_GAIN", cfg.sensorGain);
+  v("ZERO_OFFSET", cfg.zeroOffset);
+}
+
+/// Assigns the value of one KEY=VALUE line to the matching field
+struct LineParser {
+  std::string_view key;
+  std::string_view value;
+  bool matched = false;
+  bool valid = false;
+
+  void operator()(const char* name, std::string& field) {
+    if (!match(name)) return;
+    std::string_view v = value;
+    if (v.size() >= 2 && v.front() == '"' && v.back() == '"') v = v.substr(1, v.size() - 2);
+    field.assign(v.data(), v.size());
+    valid = true;
+  }
+  void operator()(const char* name, bool& field) {
+    if (match(name)) valid = BeamUtils::parseBool(value, field);
+  }
+  void operator()(const char* name, float& field) {
+    if (match(name)) valid = BeamUtils::parseFloat(value, field);
+  }
+  void operator()(const char* name, int& field, int32_t min, int32_t max, int32_t step = 1) {
+    int32_t parsed;
+    if (!match(name)) return;
+    valid = BeamUtils::parseInt(value, parsed) && parsed >= min && parsed <= max && (parsed - min) % step == 0;
+    if (valid) field = parsed;
+  }
+
+  bool match(const char* name) {
+    if (matched || key != name) return false;
+    matched = true;
+    return true;
+  }
+};
+
+// ---- File access (SPIFFS/LittleFS on the device, stdio on the host) ----
+
+#if defined(ARDUINO)
+struct FileStore {
+  fs::FS& fs;
+
+  bool size(const char* path, uint32_t& out) {
+    File f = fs.open(path, "r");
+    if (!f) return false;
+    out = f.size();
+    return true;
+  }
+  bool read(const char* path, std::vector<uint8_t>& out) {
+    File f = fs.open(path, "r");
+    if (!f) return false;
+    out.resize(f.size());
+    return f.read(out.data(), out.size()) == out.size();
+  }
+};
+#else
+struct FileStore {
+  bool size(const char* path, uint32_t& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    out = static_cast<uint32_t>(ftell(f));
+    fclose(f);
+    return true;
+  }
+  bool read(const char* path, std::vector<uint8_t>& out) {
+    uint32_t n;
+    if (!size(path, n)) return false;
+    FILE* f = fopen(path, "rb");
+    out.resize(n);
+    bool ok = fread(out.data(), 1, n, f) == n;
+    fclose(f);
+    return ok;
+  }
+};
+#endif
+
+constexpr size_t kMaxConfigFileSize = 4096;
+
+bool loadFrom(FileStore store, BeamConfig& cfg, const char* path, BeamConfigLoadInfo* info) {
+  BeamConfigLoadInfo local;
+  BeamConfigLoadInfo& result = info ? *info : local;
+  result = BeamConfigLoadInfo{};
+  const uint32_t start = micros();
+
+  uint32_t sourceSize = 0;
+  if (!store.size(path, sourceSize) || sourceSize > kMaxConfigFileSize) {
+    Serial.printf("Config: %s missing or too large, using defaults\n", path);
+    return false;
+  }
+
+  std::vector<uint8_t> buffer;
+  if (!store.read(path, buffer)) {
+    Serial.printf("Config: failed to read %s, using defaults\n", path);
+    return false;
+  }
+
+  std::string_view text(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+  parseBeamConfig(text, cfg, &result);
+  result.source = BeamConfigLoadInfo::Source::Text;
+  result.totalMicros = micros() - start;
+  Serial.printf("Config: parsed %s in %lu us (%u keys, %u rejected)\n", path,
+                (unsigned long)result.totalMicros, result.keysApplied, result.keysRejected);
   return true;
-}
\ No newline at end of file
+}
+
+} // namespace
+
+bool parseBeamConfig(std::string_view text, BeamConfig& cfg, BeamConfigLoadInfo* info) {
+  const uint32_t start = micros();
+  uint16_t applied = 0;
+  uint16_t rejected = 0;
+  std::string_view line;
+  unsigned lineNumber = 0;
+
+  while (BeamUtils::nextLine(text, line)) {
+    lineNumber++;
+    line = BeamUtils::trimView(line);
+    if (line.empty() || line.front() == '#') continue;
+
+    LineParser parser;
+    if (BeamUtils::splitPair(line, '=', parser.key, parser.value)) {
+      forEachField(cfg, parser);
+    }
+    if (parser.valid) {
+      applied++;
+    } else {
+      rejected++;
+      Serial.printf("Config: line %u %s: %.*s\n", lineNumber,
+                    parser.matched ? "has an invalid value" : "has an unknown key",
+                    static_cast<int>(line.size()), line.data());
+    }
+  }
+
+  if (info) {
+    info->keysApplied = applied;
+    info->keysRejected = rejected;
+    info->parseMicros = micros() - start;
+  }
+  return rejected == 0;
+}
+
+#if defined(ARDUINO)
+bool loadBeamConfig(fs::FS& fs, BeamConfig& cfg, const char* path, BeamConfigLoadInfo* info) {
+  return loadFrom(FileStore{fs}, cfg, path, info);
+}
+
+bool loadBeamConfig(BeamConfig& cfg, const char* path, BeamConfigLoadInfo* info) {
+  return loadBeamConfig(SPIFFS, cfg, path, info);
+}
+#else
+bool loadBeamConfig(BeamConfig& cfg, const char* path, BeamConfigLoadInfo* info) {
+  return loadFrom(FileStore{}, cfg, path, info);
+}
+#endif
@@ -0,0 +1,322 @@
+#include "BeamDsp.h"
+#include "BeamConfig.h"
+#include "BeamPlatform.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float kPi = 3.14159265359f;
+
+// BEAM_DSP_LANES int32 lanes: a SIMD register where the target has one,
+// plain loops otherwise (GCC and Clang lower the operators either way)
+typedef int32_t Lanes __attribute__((vector_size(BEAM_DSP_LANES * sizeof(int32_t))));
+constexpr size_t kLanes = BEAM_DSP_LANES;
+
+// Samples the median's fast path sorts per pass through its scratch buffer
+constexpr size_t kMedianChunk = 64;
+
+inline int16_t saturate(int64_t v) {
+  return static_cast<int16_t>(v < INT16_MIN ? INT16_MIN : v > INT16_MAX ? INT16_MAX : v);
+}
+
+inline int32_t clamp(int32_t v, int32_t limit) {
+  return v < -limit ? -limit : v > limit ? limit : v;
+}
+
+inline Lanes lanesMin(Lanes a, Lanes b) { return a < b ? a : b; }
+inline Lanes lanesMax(Lanes a, Lanes b) { return a < b ? b : a; }
+
+// Median of window values, by insertion sort (reference)
+int16_t medianOf(const int16_t* values, size_t window) {
+  int16_t sorted[BEAM_DSP_MAX_MEDIAN];
+  for (size_t i = 0; i < window; i++) {
+    size_t j = i;
+    while (j > 0 && sorted[j - 1] > values[i]) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = values[i];
+  }
+  return sorted[window / 2];
+}
+
+int16_t quantize(float coefficient) {
+  return saturate(std::lround(coefficient * 16384.0f));
+}
+
+// RBJ cookbook section, normalized by a0 and quantized to Q14
+BeamBiquad::Coefficients design(float b0, float b1, float b2, float a0, float a1, float a2) {
+  BeamBiquad::Coefficients c;
+  c.b0 = quantize(b0 / a0);
+  c.b1 = quantize(b1 / a0);
+  c.b2 = quantize(b2 / a0);
+  c.a1 = quantize(a1 / a0);
+  c.a2 = quantize(a2 / a0);
+  return c;
+}
+
+} // namespace
+
+// ============================================================================
+// Calibration
+// ============================================================================
+
+BeamCalibration BeamCalibration::from(float gain, float zeroOffset, uint32_t fullScale) {
+  BeamCalibration cal;
+  cal.offset = static_cast<int32_t>(std::lround(zeroOffset * fullScale));
+  cal.gainQ12 = clamp(static_cast<int32_t>(std::lround(gain * 4096.0f)), 32767);
+  return cal;
+}
+
+BeamCalibration BeamCalibration::fromConfig(const BeamConfig& cfg, uint32_t fullScale) {
+  return from(cfg.sensorGain, cfg.zeroOffset, fullScale);
+}
+
+void BeamCalibration::processScalar(const uint16_t* in, int16_t* out, size_t n) const {
+  const int64_t gain = clamp(gainQ12, 32767);
+  for (size_t i = 0; i < n; i++) {
+    const int64_t diff = std::min<int64_t>(std::max<int64_t>(static_cast<int64_t>(in[i]) - offset, -65535), 65535);
+    out[i] = saturate((diff * gain + 2048) >> 12);
+  }
+}
+
+void BeamCalibration::process(const uint16_t* in, int16_t* out, size_t n) const {
+  // All in int32 (65535 x 32767 + 2048 still fits), with no dependency
+  // between samples: the compiler vectorizes this loop to the target's width
+  const int32_t gain = clamp(gainQ12, 32767);
+  const int32_t off = clamp(offset, 131071);  // beyond this every difference clamps anyway
+  for (size_t i = 0; i < n; i++) {
+    const int32_t diff = std::min(std::max(static_cast<int32_t>(in[i]) - off, -65535), 65535);
+    const int32_t v = (diff * gain + 2048) >> 12;
+    out[i] = static_cast<int16_t>(std::min(std::max(v, int32_t(INT16_MIN)), int32_t(INT16_MAX)));
+  }
+}
+
+// ============================================================================
+// Median
+// ============================================================================
+
+bool BeamMedianFilter::begin(size_t window) {
+  if (window == 0 || window > BEAM_DSP_MAX_MEDIAN || window % 2 == 0) {
+    Serial.printf("BeamDsp: median window %u must be 1, 3, 5, 7 or 9\n", static_cast<unsigned>(window));
+    return false;
+  }
+  length = window;
+  primed = false;
+  return true;
+}
+
+void BeamMedianFilter::prime(int16_t first) {
+  std::fill(history, history + length - 1, first);
+  primed = true;
+}
+
+void BeamMedianFilter::processScalar(int16_t* data, size_t n) {
+  if (n == 0 || length == 1) return;
+  if (!primed) prime(data[0]);
+  int16_t window[BEAM_DSP_MAX_MEDIAN];
+  for (size_t i = 0; i < n; i++) {
+    std::copy(history, history + length - 1, window);
+    window[length - 1] = data[i];
+    std::copy(window + 1, window + length, history);
+    data[i] = medianOf(window, length);
+  }
+}
+
+void BeamMedianFilter::process(int16_t* data, size_t n) {
+  if (n == 0 || length == 1) return;
+  if (!primed) prime(data[0]);
+
+  // scratch = [history | chunk]: window i is scratch[i .. i + length)
+  const size_t past = length - 1;
+  int16_t scratch[BEAM_DSP_MAX_MEDIAN + kMedianChunk];
+  for (size_t start = 0; start < n; start += kMedianChunk) {
+    const size_t count = std::min(kMedianChunk, n - start);
+    std::copy(history, history + past, scratch);
+    std::copy(data + start, data + start + count, scratch + past);
+
+    size_t i = 0;
+    for (; i + kLanes <= count; i += kLanes) {
+      // Sort the window of kLanes outputs at once (odd-even transposition)
+      Lanes w[BEAM_DSP_MAX_MEDIAN];
+      for (size_t k = 0; k < length; k++) {
+        for (size_t l = 0; l < kLanes; l++) w[k][l] = scratch[i + k + l];
+      }
+      for (size_t pass = 0; pass < length; pass++) {
+        for (size_t k = pass & 1; k + 1 < length; k += 2) {
+          const Lanes lo = lanesMin(w[k], w[k + 1]);
+          w[k + 1] = lanesMax(w[k], w[k + 1]);
+          w[k] = lo;
+        }
+      }
+      for (size_t l = 0; l < kLanes; l++) data[start + i + l] = static_cast<int16_t>(w[length / 2][l]);
+    }
+    for (; i < count; i++) data[start + i] = medianOf(scratch + i, length);
+
+    std::copy(scratch + count, scratch + count + past, history);
+  }
+}
+
+// ============================================================================
+// Moving Average
+// ============================================================================
+
+bool BeamMovingAverage::begin(size_t window) {
+  if (window == 0 || window > BEAM_DSP_MAX_AVERAGE || (window & (window - 1))) {
+    Serial.printf("BeamDsp: moving average window %u is not a power of two up to %u\n",
+                  static_cast<unsigned>(window), static_cast<unsigned>(BEAM_DSP_MAX_AVERAGE));
+    return false;
+  }
+  length = window;
+  shift = 0;
+  while ((size_t(1) << shift) < window) shift++;
+  primed = false;
+  return true;
+}
+
+void BeamMovingAverage::prime(int16_t first) {
+  std::fill(history, history + length, first);
+  pos = 0;
+  primed = true;
+}
+
+void BeamMovingAverage::processScalar(int16_t* data, size_t n) {
+  if (n == 0 || length == 1) return;
+  if (!primed) prime(data[0]);
+  const int32_t half = static_cast<int32_t>(length / 2);
+  for (size_t i = 0; i < n; i++) {
+    history[pos] = data[i];
+    pos = (pos + 1) & (length - 1);
+    int32_t sum = 0;
+    for (size_t k = 0; k < length; k++) sum += history[k];
+    data[i] = static_cast<int16_t>((sum + half) >> shift);
+  }
+}
+
+void BeamMovingAverage::process(int16_t* data, size_t n) {
+  if (n == 0 || length == 1) return;
+  if (!primed) prime(data[0]);
+
+  // Running sum: one add and one subtract per sample
+  int32_t sum = 0;
+  for (size_t k = 0; k < length; k++) sum += history[k];
+  const int32_t half = static_cast<int32_t>(length / 2);
+  const size_t mask = length - 1;
+  size_t p = pos;
+  for (size_t i = 0; i < n; i++) {
+    sum += data[i] - history[p];
+    history[p] = data[i];
+    p = (p + 1) & mask;
+    data[i] = static_cast<int16_t>((sum + half) >> shift);
+  }
+  pos = p;
+}
+
+// ============================================================================
+// Biquad
+// ============================================================================
+
+BeamBiquad::Coefficients BeamBiquad::lowPass(float sampleHz, float cutoffHz, float q) {
+  const float w0 = 2 * kPi * cutoffHz / sampleHz;
+  const float cw = std::cos(w0);
+  const float alpha = std::sin(w0) / (2 * q);
+  return design((1 - cw) / 2, 1 - cw, (1 - cw) / 2, 1 + alpha, -2 * cw, 1 - alpha);
+}
+
+BeamBiquad::Coefficients BeamBiquad::highPass(float sampleHz, float cutoffHz, float q) {
+  const float w0 = 2 * kPi * cutoffHz / sampleHz;
+  const float cw = std::cos(w0);
+  const float alpha = std::sin(w0) / (2 * q);
+  return design((1 + cw) / 2, -(1 + cw), (1 + cw) / 2, 1 + alpha, -2 * cw, 1 - alpha);
+}
+
+BeamBiquad::Coefficients BeamBiquad::bandPass(float sampleHz, float centerHz, float q) {
+  const float w0 = 2 * kPi * centerHz / sampleHz;
+  const float cw = std::cos(w0);
+  const float alpha = std::sin(w0) / (2 * q);
+  return design(alpha, 0, -alpha, 1 + alpha, -2 * cw, 1 - alpha);
+}
+
+void BeamBiquad::begin(const Coefficients& coefficients) {
+  c = coefficients;
+  reset();
+}
+
+void BeamBiquad::reset() {
+  x1 = x2 = y1 = y2 = 0;
+  err = 0;
+}
+
+int16_t BeamBiquad::step(int16_t x) {
+  const int64_t acc = static_cast<int64_t>(c.b0) * x + static_cast<int64_t>(c.b1) * x1 +
+                      static_cast<int64_t>(c.b2) * x2 - static_cast<int64_t>(c.a1) * y1 -
+                      static_cast<int64_t>(c.a2) * y2 + err;
+  const int16_t y = saturate(acc >> 14);
+  err = static_cast<int32_t>(acc & 0x3FFF);
+  x2 = x1;
+  x1 = x;
+  y2 = y1;
+  y1 = y;
+  return y;
+}
+
+void BeamBiquad::processScalar(int16_t* data, size_t n) {
+  for (size_t i = 0; i < n; i++) data[i] = step(data[i]);
+}
+
+void BeamBiquad::process(int16_t* data, size_t n) {
+  // The feedback leaves nothing to run in lanes; instead the coefficients
+  // and state stay in registers. Each 16 x 16 product fits an int32; their
+  // sum needs up to 34 bits.
+  const int32_t b0 = c.b0, b1 = c.b1, b2 = c.b2, a1 = c.a1, a2 = c.a2;
+  int32_t sx1 = x1, sx2 = x2, sy1 = y1, sy2 = y2, e = err;
+  for (size_t i = 0; i < n; i++) {
+    const int32_t x = data[i];
+    const int64_t acc = int64_t(b0 * x) + int64_t(b1 * sx1) + int64_t(b2 * sx2) -
+                        int64_t(a1 * sy1) - int64_t(a2 * sy2) + e;
+    const int32_t y = saturate(acc >> 14);
+    e = static_cast<int32_t>(acc & 0x3FFF);
+    sx2 = sx1;
+    sx1 = x;
+    sy2 = sy1;
+    sy1 = y;
+    data[i] = static_cast<int16_t>(y);
+  }
+  x1 = static_cast<int16_t>(sx1);
+  x2 = static_cast<int16_t>(sx2);
+  y1 = static_cast<int16_t>(sy1);
+  y2 = static_cast<int16_t>(sy2);
+  err = e;
+}
+
+// ============================================================================
+// Pipeline
+// ============================================================================
+
+bool BeamDspPipeline::begin(const Config& config) {
+  if (!median.begin(config.medianWindow) || !average.begin(config.averageWindow)) return false;
+  cfg = config;
+  biquad.begin(cfg.filter);
+  return true;
+}
+
+void BeamDspPipeline::reset() {
+  median.reset();
+  average.reset();
+  biquad.reset();
+}
+
+void BeamDspPipeline::process(const uint16_t* in, int16_t* out, size_t n) {
+  cfg.calibration.process(in, out, n);
+  median.process(out, n);
+  average.process(out, n);
+  if (cfg.filterEnabled) biquad.process(out, n);
+}
+
+void BeamDspPipeline::processScalar(const uint16_t* in, int16_t* out, size_t n) {
+  cfg.calibration.processScalar(in, out, n);
+  median.processScalar(out, n);
+  average.processScalar(out, n);
+  if (cfg.filterEnabled) biquad.processScalar(out, n);
+}
@@ -0,0 +1,103 @@
+#include "BeamEvents.h"
+
+BeamEventFlags::BeamEventFlags() : statsSinceMs(millis()) {}
+
+// Returns true if the consumer should be woken
+bool BeamEventFlags::record(uint32_t events) {
+  const uint32_t now = static_cast<uint32_t>(micros());
+  const uint32_t mask = wakeMask.load(std::memory_order_relaxed);
+  signalCount.fetch_add(1, std::memory_order_relaxed);
+  const uint32_t before = pending.fetch_or(events, std::memory_order_acq_rel);
+  if (!(events & mask)) return false;
+  // Latency is measured from the first event that could wake the consumer
+  if (!(before & mask)) firstSignalUs.store(now, std::memory_order_relaxed);
+  return true;
+}
+
+uint32_t BeamEventFlags::take() {
+  if (!(pending.load(std::memory_order_acquire) & wakeMask.load(std::memory_order_relaxed))) return 0;
+  const uint32_t events = pending.exchange(0, std::memory_order_acq_rel);
+  const uint32_t latency = static_cast<uint32_t>(micros()) - firstSignalUs.load(std::memory_order_relaxed);
+  counters.wakeups++;
+  counters.lastLatencyUs = latency;
+  counters.totalLatencyUs += latency;
+  if (latency > counters.maxLatencyUs) counters.maxLatencyUs = latency;
+  return events;
+}
+
+BeamEventStats BeamEventFlags::stats() const {
+  BeamEventStats s = counters;
+  s.signals = signalCount.load(std::memory_order_relaxed);
+  s.elapsedMs = static_cast<uint32_t>(millis()) - statsSinceMs;
+  return s;
+}
+
+void BeamEventFlags::resetStats() {
+  counters = BeamEventStats{};
+  signalCount.store(0, std::memory_order_relaxed);
+  statsSinceMs = millis();
+}
+
+#if defined(ARDUINO) && defined(ESP32)
+
+void BeamEventFlags::signal(uint32_t events) {
+  if (!record(events)) return;
+  if (TaskHandle_t task = waiter.load(std::memory_order_acquire)) {
+    xTaskNotifyGive(task);
+  }
+}
+
+void BeamEventFlags::signalFromISR(uint32_t events) {
+  if (!record(events)) return;
+  if (TaskHandle_t task = waiter.load(std::memory_order_acquire)) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(task, &woken);
+    if (woken) portYIELD_FROM_ISR();
+  }
+}
+
+uint32_t BeamEventFlags::wait(uint32_t timeoutMs) {
+  waiter.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+  const uint32_t start = millis();
+  for (;;) {
+    // Drop a wake whose events an earlier wait() already returned
+    ulTaskNotifyTake(pdTRUE, 0);
+    if (const uint32_t events = take()) return events;
+
+    const uint32_t waited = millis() - start;
+    if (timeoutMs != UINT32_MAX && waited >= timeoutMs) {
+      counters.timeouts++;
+      return 0;
+    }
+    const TickType_t ticks = (timeoutMs == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs - waited);
+    ulTaskNotifyTake(pdTRUE, ticks ? ticks : 1);
+  }
+}
+
+#else
+
+void BeamEventFlags::signal(uint32_t events) {
+  if (!record(events)) return;
+  // Taking the lock orders this against the consumer's predicate check
+  std::lock_guard<std::mutex> lock(mutex);
+  wakeup.notify_one();
+}
+
+uint32_t BeamEventFlags::wait(uint32_t timeoutMs) {
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto ready = [this] {
+      return (pending.load(std::memory_order_acquire) & wakeMask.load(std::memory_order_relaxed)) != 0;
+    };
+    if (timeoutMs == UINT32_MAX) {
+      wakeup.wait(lock, ready);
+    } else {
+      wakeup.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready);
+    }
+  }
+  if (const uint32_t events = take()) return events;
+  counters.timeouts++;
+  return 0;
+}
+
+#endif
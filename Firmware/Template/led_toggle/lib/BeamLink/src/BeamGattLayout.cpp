@@ -0,0 +1,62 @@
+#include "BeamGattLayout.h"
+#include "BeamStaticConfig.h"
+#include "BeamStreams.h"
+
+namespace {
+
+// FNV-1a, 32 bit: a few bytes per attribute, no table needed
+constexpr uint32_t kFnvOffset = 2166136261u;
+constexpr uint32_t kFnvPrime = 16777619u;
+
+constexpr uint8_t kTagService = 'S';
+constexpr uint8_t kTagCharacteristic = 'C';
+
+} // namespace
+
+void BeamGattLayout::clear() {
+  value = kFnvOffset;
+  attributes = 0;
+  mix(kFormat);
+}
+
+bool BeamGattLayout::addService(const char* uuid) {
+  mix(kTagService);
+  attributes++;
+  return mixUuid(uuid);
+}
+
+bool BeamGattLayout::addCharacteristic(const char* uuid, uint8_t properties) {
+  mix(kTagCharacteristic);
+  mix(properties);
+  attributes += (properties & BEAM_STREAM_NOTIFY) ? 3 : 2;
+  return mixUuid(uuid);
+}
+
+void BeamGattLayout::mix(uint8_t byte) {
+  value = (value ^ byte) * kFnvPrime;
+}
+
+bool BeamGattLayout::mixUuid(const char* uuid) {
+  // Binary form, so "...90AB" and "...90ab" give the same layout
+  const bool valid = beamcfg::isUuid128(uuid);
+  const beamcfg::Uuid128 parsed = beamcfg::parseUuid128(uuid);
+  for (uint8_t b : parsed.bytes) mix(b);
+  return valid;
+}
+
+void BeamConnectTimer::connected(uint32_t nowUs) {
+  counters.connections++;
+  connectedAtUs = nowUs;
+  waiting = true;
+}
+
+bool BeamConnectTimer::command(uint32_t nowUs) {
+  if (!waiting) return false;
+  waiting = false;
+  const uint32_t elapsed = nowUs - connectedAtUs;
+  counters.measured++;
+  counters.lastUs = elapsed;
+  if (elapsed > counters.maxUs) counters.maxUs = elapsed;
+  counters.totalUs += elapsed;
+  return true;
+}
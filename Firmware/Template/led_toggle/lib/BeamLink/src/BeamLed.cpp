@@ -0,0 +1,352 @@
+#include "BeamLed.h"
+#include "BeamPlatform.h"
+#include <algorithm>
+
+#if defined(ARDUINO) && defined(ESP32)
+#include <driver/ledc.h>
+#include <esp_idf_version.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#endif
+
+// ============================================================================
+// ESP32 LEDC Driver
+// ============================================================================
+
+#if defined(ARDUINO) && defined(ESP32)
+
+namespace {
+
+constexpr ledc_mode_t kMode = LEDC_LOW_SPEED_MODE;
+
+// The hardware ramp can end a little after the requested time
+constexpr int64_t kFadeSlackUs = 2000;
+
+bool configureTimer(uint8_t timerNum, ledc_clk_cfg_t clock) {
+  ledc_timer_config_t timer = {};
+  timer.speed_mode = kMode;
+  timer.duty_resolution = static_cast<ledc_timer_bit_t>(BEAM_LED_PWM_BITS);
+  timer.timer_num = static_cast<ledc_timer_t>(timerNum);
+  timer.freq_hz = BEAM_LED_PWM_HZ;
+  timer.clk_cfg = clock;
+  return ledc_timer_config(&timer) == ESP_OK;
+}
+
+} // namespace
+
+BeamLedcDriver::~BeamLedcDriver() {
+  for (void* t : {timer, fadeTimer}) {
+    if (!t) continue;
+    esp_timer_stop(static_cast<esp_timer_handle_t>(t));
+    esp_timer_delete(static_cast<esp_timer_handle_t>(t));
+  }
+}
+
+bool BeamLedcDriver::begin(uint8_t pin, bool activeHigh) {
+  // The 8 MHz RTC clock keeps running in light sleep, so does the PWM
+  if (configureTimer(timerNum, LEDC_USE_RTC8M_CLK)) {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RC_FAST, ESP_PD_OPTION_ON);
+#else
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC8M, ESP_PD_OPTION_ON);
+#endif
+  } else if (configureTimer(timerNum, LEDC_AUTO_CLK)) {
+    Serial.printf("BeamLed: no RTC clock for LEDC, the LED pauses in light sleep\n");
+  } else {
+    Serial.printf("BeamLed: LEDC timer %u failed (%u bits at %u Hz)\n", timerNum, BEAM_LED_PWM_BITS,
+                  BEAM_LED_PWM_HZ);
+    return false;
+  }
+
+  ledc_channel_config_t ch = {};
+  ch.gpio_num = pin;
+  ch.speed_mode = kMode;
+  ch.channel = static_cast<ledc_channel_t>(channel);
+  ch.timer_sel = static_cast<ledc_timer_t>(timerNum);
+  ch.duty = 0;
+  ch.hpoint = 0;
+  ch.flags.output_invert = activeHigh ? 0 : 1;
+  if (ledc_channel_config(&ch) != ESP_OK) {
+    Serial.printf("BeamLed: LEDC channel %u on pin %u failed\n", channel, pin);
+    return false;
+  }
+
+  // Shared by all channels; already installed is fine
+  const esp_err_t fadeErr = ledc_fade_func_install(0);
+  if (fadeErr != ESP_OK && fadeErr != ESP_ERR_INVALID_STATE) {
+    Serial.printf("BeamLed: LEDC fade service failed\n");
+    return false;
+  }
+
+  if (!timer) {
+    esp_timer_create_args_t args = {};
+    args.callback = &BeamLedcDriver::timerEntry;
+    args.arg = this;
+    args.name = "beam_led";
+    esp_timer_handle_t handle = nullptr;
+    if (esp_timer_create(&args, &handle) != ESP_OK) {
+      Serial.printf("BeamLed: esp_timer failed\n");
+      return false;
+    }
+    timer = handle;
+  }
+#if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 0, 0)
+  if (!fadeTimer) {
+    esp_timer_create_args_t args = {};
+    args.callback = &BeamLedcDriver::fadeDoneEntry;
+    args.arg = this;
+    args.name = "beam_led_fade";
+    esp_timer_handle_t handle = nullptr;
+    if (esp_timer_create(&args, &handle) != ESP_OK) {
+      Serial.printf("BeamLed: esp_timer failed\n");
+      return false;
+    }
+    fadeTimer = handle;
+  }
+#endif
+  ready = true;
+  return true;
+}
+
+void BeamLedcDriver::setDuty(uint32_t duty) {
+  request(std::min(duty, kMaxDuty), 0);
+}
+
+void BeamLedcDriver::fadeTo(uint32_t duty, uint32_t ms) {
+  request(std::min(duty, kMaxDuty), ms);
+}
+
+void BeamLedcDriver::request(uint32_t duty, uint32_t ms) {
+  if (!ready) return;
+  std::lock_guard<std::mutex> guard(lock);
+#if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 0, 0)
+  // No ledc_fade_stop(): the LEDC call would block until the fade ends (up to
+  // a minute with led:fade), stalling loop() or the esp_timer task
+  const int64_t now = esp_timer_get_time();
+  if (now < fadeEndUs) {
+    if (!held) esp_timer_start_once(static_cast<esp_timer_handle_t>(fadeTimer), fadeEndUs - now);
+    held = true;
+    heldDuty = duty;
+    heldMs = ms;
+    return;
+  }
+#endif
+  write(duty, ms);
+}
+
+// Called with lock held
+void BeamLedcDriver::write(uint32_t duty, uint32_t ms) {
+  const auto ch = static_cast<ledc_channel_t>(channel);
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+  ledc_fade_stop(kMode, ch);
+#endif
+  if (ms == 0) {
+    ledc_set_duty_and_update(kMode, ch, duty, 0);
+    fadeEndUs = 0;
+  } else {
+    ledc_set_fade_time_and_start(kMode, ch, duty, ms, LEDC_FADE_NO_WAIT);
+    fadeEndUs = esp_timer_get_time() + ms * 1000LL + kFadeSlackUs;
+  }
+}
+
+bool BeamLedcDriver::startTimer(uint32_t periodMs, TickFn fn, void* arg) {
+  if (!timer || periodMs == 0) return false;
+  stopTimer();
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    tickFn = fn;
+    tickArg = arg;
+  }
+  return esp_timer_start_periodic(static_cast<esp_timer_handle_t>(timer), periodMs * 1000ULL) == ESP_OK;
+}
+
+void BeamLedcDriver::stopTimer() {
+  // Fails harmlessly when the timer is not running
+  if (timer) esp_timer_stop(static_cast<esp_timer_handle_t>(timer));
+}
+
+uint32_t BeamLedcDriver::nowMs() const {
+  return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+}
+
+// Runs on the esp_timer task
+void BeamLedcDriver::timerEntry(void* arg) {
+  auto* self = static_cast<BeamLedcDriver*>(arg);
+  TickFn fn;
+  void* fnArg;
+  {
+    std::lock_guard<std::mutex> guard(self->lock);
+    fn = self->tickFn;
+    fnArg = self->tickArg;
+  }
+  if (fn) fn(fnArg);
+}
+
+// Runs on the esp_timer task when the fade that held a change back has ended
+void BeamLedcDriver::fadeDoneEntry(void* arg) {
+  auto* self = static_cast<BeamLedcDriver*>(arg);
+  std::lock_guard<std::mutex> guard(self->lock);
+  if (!self->held) return;
+  self->held = false;
+  self->write(self->heldDuty, self->heldMs);
+}
+
+#endif
+
+// ============================================================================
+// Simulated Driver
+// ============================================================================
+
+bool BeamSimLedDriver::begin(uint8_t pin, bool) {
+  ledPin = pin;
+  from = to = 0;
+  fadeStart = fadeEnd = now;
+  return true;
+}
+
+void BeamSimLedDriver::setDuty(uint32_t duty) {
+  writeCount++;
+  from = to = std::min(duty, kMaxDuty);
+  fadeStart = fadeEnd = now;
+}
+
+void BeamSimLedDriver::fadeTo(uint32_t duty, uint32_t ms) {
+  if (ms == 0) {
+    setDuty(duty);
+    return;
+  }
+  writeCount++;
+  from = this->duty();
+  to = std::min(duty, kMaxDuty);
+  fadeStart = now;
+  fadeEnd = now + ms;
+}
+
+bool BeamSimLedDriver::startTimer(uint32_t periodMs, TickFn fn, void* arg) {
+  if (periodMs == 0) return false;
+  period = periodMs;
+  nextTick = now + periodMs;
+  tickFn = fn;
+  tickArg = arg;
+  return true;
+}
+
+void BeamSimLedDriver::advance(uint32_t ms) {
+  const uint32_t end = now + ms;
+  while (period && nextTick <= end) {
+    now = nextTick;
+    nextTick += period;
+    tickFn(tickArg);
+  }
+  now = end;
+}
+
+uint32_t BeamSimLedDriver::duty() const {
+  if (now >= fadeEnd) return to;
+  const int64_t span = static_cast<int64_t>(to) - from;
+  return static_cast<uint32_t>(from + span * (now - fadeStart) / (fadeEnd - fadeStart));
+}
+
+// ============================================================================
+// LED
+// ============================================================================
+
+BeamLed::~BeamLed() {
+  stop();
+}
+
+bool BeamLed::begin(BeamLedDriver& drv, uint8_t pin, bool activeHigh) {
+  stop();
+  driver = nullptr;
+  if (!drv.begin(pin, activeHigh)) return false;
+  driver = &drv;
+  apply();
+  return true;
+}
+
+void BeamLed::set(bool on) {
+  lit = on;
+  blinking = false;
+  apply();
+}
+
+bool BeamLed::blink(uint32_t periodMs) {
+  if (periodMs < BEAM_LED_MIN_PERIOD_MS) {
+    Serial.printf("BeamLed: blink period %lu ms is below %u ms\n", static_cast<unsigned long>(periodMs),
+                  BEAM_LED_MIN_PERIOD_MS);
+    return false;
+  }
+  period = periodMs;
+  blinking = true;
+  apply();
+  return true;
+}
+
+void BeamLed::setBrightness(uint8_t percent) {
+  level = std::min<uint8_t>(percent, 100);
+  apply();
+}
+
+void BeamLed::setFade(uint32_t ms) {
+  fade = ms;
+  apply();
+}
+
+uint32_t BeamLed::dutyFor(uint8_t percent) {
+  const uint32_t p = std::min<uint32_t>(percent, 100);
+  if (p == 0) return 0;
+  return std::max<uint32_t>(1, BeamLedDriver::kMaxDuty * p * p / 10000);
+}
+
+void BeamLed::apply() {
+  if (!driver) return;
+  std::lock_guard<std::mutex> guard(lock);
+  // esp_timer_stop() does not wait for a tick that is already running; that
+  // tick finds blinkActive cleared, or comes before nextStepMs, and leaves the LED
+  driver->stopTimer();
+  blinkActive = blinking;
+  if (!blinking) {
+    show(driver, lit ? dutyFor(level) : 0, fade);
+    return;
+  }
+
+  // A ramp a little shorter than the half period ends before the next step
+  const uint32_t half = period / 2;
+  blinkDuty = dutyFor(level);
+  blinkRampMs = std::min(fade, half - half / 8);
+  blinkHalfMs = half;
+  phaseOn = true;
+  show(driver, blinkDuty, blinkRampMs);
+  nextStepMs = driver->nowMs() + half;
+  driver->startTimer(half, &BeamLed::tick, this);
+}
+
+void BeamLed::stop() {
+  if (!driver) return;
+  std::lock_guard<std::mutex> guard(lock);
+  blinkActive = false;
+  driver->stopTimer();
+}
+
+void BeamLed::show(BeamLedDriver* driver, uint32_t duty, uint32_t ms) {
+  if (ms) {
+    driver->fadeTo(duty, ms);
+  } else {
+    driver->setDuty(duty);
+  }
+}
+
+// Runs in the driver's timer context, not on the loop task
+void BeamLed::tick(void* arg) {
+  auto* self = static_cast<BeamLed*>(arg);
+  std::lock_guard<std::mutex> guard(self->lock);
+  if (!self->blinkActive) return;
+  // A tick of the timer apply() replaced comes about when the new one started,
+  // a half period early; the timer never fires early, only late
+  const int32_t early = static_cast<int32_t>(self->nextStepMs - self->driver->nowMs());
+  if (early > static_cast<int32_t>(self->blinkHalfMs / 2)) return;
+  self->nextStepMs += self->blinkHalfMs;
+  self->phaseOn = !self->phaseOn;
+  show(self->driver, self->phaseOn ? self->blinkDuty : 0, self->blinkRampMs);
+  self->stepCount.fetch_add(1, std::memory_order_relaxed);
+}
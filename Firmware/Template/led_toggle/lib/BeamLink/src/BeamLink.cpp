@@ -1,6 +1,32 @@
 #include "BeamLink.h"
 #include "Uuids.h"
 
+#if defined(CONFIG_NIMBLE_CPP_IDF)
+#include "services/gap/ble_svc_gap.h"
+#else
+#include "nimble/nimble/host/services/gap/include/services/gap/ble_svc_gap.h"
+#endif
+
+namespace {
+
+BeamChangeReport& reportFor(BeamChangeReport* report, BeamChangeReport& local, const char* setting) {
+  BeamChangeReport& out = report ? *report : local;
+  out = BeamChangeReport{};
+  out.setting = setting;
+  return out;
+}
+
+// Legacy advertising and scan response PDUs carry at most 31 bytes of AD data
+constexpr size_t kLegacyAdvBytes = 31;
+
+uint16_t toAdvUnits(uint16_t intervalMs) {
+  // 0.625 ms per unit; BLE spec range 32..16384 units (20..10240 ms)
+  uint16_t units = (intervalMs * 16) / 10;
+  return std::max((uint16_t)32, std::min((uint16_t)16384, units));
+}
+
+} // namespace
+
 // Callback classes
 class BeamLink::ServerCallbacks : public NimBLEServerCallbacks {
 public:
@@ -8,16 +34,50 @@ public:
   
   void onConnect(NimBLEServer* pServer) override {
     if (beamLink) {
+      BeamPower::Hold hold(beamLink->power, BeamPowerReason::Handler);
       beamLink->deviceConnected = true;
+      beamLink->peerMtu = kDefaultMtu;
+      beamLink->connectTimer.connected();
       Serial.println("Client connected");
+      {
+        std::lock_guard<std::mutex> guard(beamLink->advMutex);
+        beamLink->advSchedule.stop();
+      }
+      if (beamLink->connectionHandler) {
+        beamLink->connectionHandler(true);
+      }
+      if (beamLink->power) beamLink->power->activity();
+      beamLink->events.signal(BEAM_EVENT_CONNECT);
     }
   }
 
   void onDisconnect(NimBLEServer* pServer) override {
     if (beamLink) {
+      BeamPower::Hold hold(beamLink->power, BeamPowerReason::Handler);
       beamLink->deviceConnected = false;
+      beamLink->peerMtu = kDefaultMtu;
+      beamLink->streams.clearSubscriptions();
       Serial.println("Client disconnected, restarting advertising");
+      {
+        // Fast burst again so the client (or another one) finds us quickly
+        std::lock_guard<std::mutex> guard(beamLink->advMutex);
+        beamLink->advSchedule.restart();
+        beamLink->applyAdvInterval(static_cast<uint16_t>(beamLink->advSchedule.intervalMs()));
+      }
       NimBLEDevice::startAdvertising();
+      if (beamLink->connectionHandler) {
+        beamLink->connectionHandler(false);
+      }
+      if (beamLink->power) beamLink->power->activity();
+      beamLink->events.signal(BEAM_EVENT_DISCONNECT);
+    }
+  }
+
+  // NimBLEDevice::getMTU() is only what we offered; this is what the client took
+  void onMTUChange(uint16_t mtu, ble_gap_conn_desc* desc) override {
+    if (beamLink) {
+      beamLink->peerMtu = mtu;
+      Serial.printf("MTU negotiated: %u bytes\n", mtu);
     }
   }
   
@@ -35,8 +95,12 @@ public:
     std::string rxValue = pCharacteristic->getValue();
     
     if (rxValue.length() > 0) {
-      beamLink->messagesReceived++;
-      Serial.printf("RX [%u]: %s\n", beamLink->messagesReceived, rxValue.c_str());
+      // Full speed until the handler returns, then linger for a follow-up command
+      BeamPower::Hold hold(beamLink->power, BeamPowerReason::Handler);
+      if (beamLink->power) beamLink->power->activity();
+      beamLink->connectTimer.command();
+      const uint32_t received = ++beamLink->messagesReceived;
+      Serial.printf("RX [%u]: %s\n", received, rxValue.c_str());
       
       if (beamLink->messageHandler) {
         // Reply function that sends via TX notify
@@ -48,6 +112,16 @@ public:
         
         beamLink->messageHandler(rxValue, reply);
       }
+      // After the handler, so whatever it posted is visible to the woken loop
+      beamLink->events.signal(BEAM_EVENT_RX);
+    }
+  }
+
+  void onStatus(NimBLECharacteristic* pCharacteristic, Status s, int code) override {
+    (void)pCharacteristic;
+    (void)code;
+    if (beamLink && (s == SUCCESS_NOTIFY || s == SUCCESS_INDICATE)) {
+      beamLink->events.signal(BEAM_EVENT_TX_DONE);
     }
   }
   
@@ -55,6 +129,41 @@ private:
   BeamLink* beamLink;
 };
 
+class BeamLink::StreamCallbacks : public NimBLECharacteristicCallbacks {
+public:
+  StreamCallbacks(BeamLink* beamLink, BeamStreamId id) : beamLink(beamLink), id(id) {}
+
+  void onWrite(NimBLECharacteristic* pCharacteristic) override {
+    const std::string value = pCharacteristic->getValue();
+    if (value.empty()) return;
+    BeamPower::Hold hold(beamLink->power, BeamPowerReason::Handler);
+    if (beamLink->power) beamLink->power->activity();
+    beamLink->connectTimer.command();
+    beamLink->streams.countReceived(id);
+    const BeamStreamHandler& handler = beamLink->streams[id].handler;
+    if (handler) handler(reinterpret_cast<const uint8_t*>(value.data()), value.size());
+    beamLink->events.signal(BEAM_EVENT_RX);
+  }
+
+  void onSubscribe(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc, uint16_t subValue) override {
+    (void)pCharacteristic;
+    (void)desc;
+    // Bit 0: notifications, bit 1: indications (not offered)
+    beamLink->streams.setSubscribed(id, subValue & 0x0001);
+    beamLink->events.signal(BEAM_EVENT_SUBSCRIBE);
+  }
+
+  void onStatus(NimBLECharacteristic* pCharacteristic, Status s, int code) override {
+    (void)pCharacteristic;
+    (void)code;
+    if (s == SUCCESS_NOTIFY) beamLink->events.signal(BEAM_EVENT_TX_DONE);
+  }
+
+private:
+  BeamLink* beamLink;
+  BeamStreamId id;
+};
+
 // BeamLink implementation
 BeamLink::BeamLink() : deviceConnected(false), initialized(false) {
   // Initialize callback objects
@@ -79,22 +188,42 @@ bool BeamLink::begin(const char* deviceName, int8_t advPowerDbm, uint16_t advInt
   }
   
   // Validate parameters
-  if (advPowerDbm < -12 || advPowerDbm > 9) {
-    Serial.printf("Warning: Invalid advertising power %d dBm, clamping to range [-12, 9]\n", advPowerDbm);
-    advPowerDbm = std::max((int8_t)-12, std::min((int8_t)9, advPowerDbm));
+  if (!beamcfg::powerValid(advPowerDbm)) {
+    Serial.printf("Warning: Invalid advertising power %d dBm, using the next level down in [-12, 9]\n", advPowerDbm);
+    const int clamped = std::max(beamcfg::kMinPowerDbm, std::min(beamcfg::kMaxPowerDbm, (int)advPowerDbm));
+    advPowerDbm = static_cast<int8_t>(clamped - (clamped - beamcfg::kMinPowerDbm) % beamcfg::kPowerStepDb);
   }
   
-  if (advIntervalMs < 20 || advIntervalMs > 10240) {
+  if (advIntervalMs < beamcfg::kMinAdvIntervalMs || advIntervalMs > beamcfg::kMaxAdvIntervalMs) {
     Serial.printf("Warning: Invalid advertising interval %d ms, clamping to range [20, 10240]\n", advIntervalMs);
-    advIntervalMs = std::max((uint16_t)20, std::min((uint16_t)10240, advIntervalMs));
+    advIntervalMs = std::max((uint16_t)beamcfg::kMinAdvIntervalMs,
+                             std::min((uint16_t)beamcfg::kMaxAdvIntervalMs, advIntervalMs));
   }
   
   this->deviceName = deviceName;
   
   // Set UUIDs (use defaults from Uuids.h if not provided)
-  this->serviceUuid = serviceUuid ? serviceUuid : BMLK_SERVICE_UUID;
-  this->characteristicUuid = characteristicUuid ? characteristicUuid : BMLK_CHARACTERISTIC_UUID;
+  this->serviceUuid = NimBLEUUID(serviceUuid ? serviceUuid : BMLK_SERVICE_UUID);
+  this->characteristicUuid = NimBLEUUID(characteristicUuid ? characteristicUuid : BMLK_CHARACTERISTIC_UUID);
+  
+  return start(advPowerDbm, advIntervalMs);
+}
+
+bool BeamLink::begin(const BeamStaticConfig& config) {
+  if (initialized) {
+    Serial.println("BeamLink already initialized");
+    return false;
+  }
   
+  // Checked by BEAM_STATIC_ASSERT_CONFIG(); UUID bytes are already parsed
+  deviceName = config.bleName;
+  serviceUuid = NimBLEUUID(config.serviceUuid.bytes, sizeof(config.serviceUuid.bytes), false);
+  characteristicUuid = NimBLEUUID(config.characteristicUuid.bytes, sizeof(config.characteristicUuid.bytes), false);
+  
+  return start(static_cast<int8_t>(config.blePowerDbm), static_cast<uint16_t>(config.bleAdvIntervalMs));
+}
+
+bool BeamLink::start(int8_t advPowerDbm, uint16_t advIntervalMs) {
   Serial.println("Initializing BeamLink BLE...");
   Serial.printf("  Advertising Power: %d dBm\n", advPowerDbm);
   Serial.printf("  Advertising Interval: %d ms\n", advIntervalMs);
@@ -104,8 +233,11 @@ bool BeamLink::begin(const char* deviceName, int8_t advPowerDbm, uint16_t advInt
   Serial.println("BLE device initialized");
   
   // Set BLE power
-  NimBLEDevice::setPower(static_cast<esp_power_level_t>(advPowerDbm), ESP_BLE_PWR_TYPE_ADV);
-  NimBLEDevice::setPower(static_cast<esp_power_level_t>(advPowerDbm), ESP_BLE_PWR_TYPE_DEFAULT);
+  if (!applyPower(advPowerDbm)) {
+    Serial.printf("Warning: TX power %d dBm not accepted\n", advPowerDbm);
+  }
+  this->advPowerDbm = advPowerDbm;
+  this->advIntervalMs = advIntervalMs;
   
   // Create BLE Server
   pServer = NimBLEDevice::createServer();
@@ -114,7 +246,9 @@ bool BeamLink::begin(const char* deviceName, int8_t advPowerDbm, uint16_t advInt
     return false;
   }
   
-  pServer->setCallbacks(serverCallbacks.get());
+  // BeamLink owns the callbacks: deinit() in end() must not delete them, since
+  // the next begin() (e.g. setUuids()) registers the same object again
+  pServer->setCallbacks(serverCallbacks.get(), false);
   
   // Set MTU to maximum supported value for larger message support
   // Default is 23 bytes, we request 512 bytes (maximum for NimBLE)
@@ -126,8 +260,17 @@ bool BeamLink::begin(const char* deviceName, int8_t advPowerDbm, uint16_t advInt
     return false;
   }
   
-  // Start advertising with configured interval
-  if (!startAdvertising(advIntervalMs)) {
+  // Start advertising with the first phase of the schedule
+  uint16_t firstIntervalMs;
+  {
+    std::lock_guard<std::mutex> guard(advMutex);
+    BeamAdvSteps steps = advSchedule.steps();
+    steps.intervalMs = advIntervalMs;
+    advSchedule.configure(steps);
+    advSchedule.restart();
+    firstIntervalMs = static_cast<uint16_t>(advSchedule.intervalMs());
+  }
+  if (!startAdvertising(firstIntervalMs)) {
     Serial.println("Failed to start advertising");
     return false;
   }
@@ -138,10 +281,15 @@ bool BeamLink::begin(const char* deviceName, int8_t advPowerDbm, uint16_t advInt
   messagesSent = 0;
   errorCount = 0;
   
-  Serial.printf("BeamLink ready, advertising as: %s\n", deviceName);
-  Serial.printf("Service UUID: %s\n", this->serviceUuid.c_str());
-  Serial.printf("Characteristic UUID: %s\n", this->characteristicUuid.c_str());
-  Serial.printf("MTU: %d bytes\n", NimBLEDevice::getMTU());
+  Serial.printf("BeamLink ready, advertising as: %s\n", deviceName.c_str());
+  Serial.printf("Service UUID: %s\n", serviceUuid.toString().c_str());
+  Serial.printf("Characteristic UUID: %s\n", characteristicUuid.toString().c_str());
+  for (BeamStreamId id = 0; id < streams.size(); id++) {
+    Serial.printf("Stream %s: %s\n", streams[id].name, streams[id].uuid);
+  }
+  Serial.printf("GATT layout: %08lx (%u attributes)\n", static_cast<unsigned long>(layout.hash()),
+                layout.attributeCount());
+  Serial.printf("Preferred MTU: %d bytes\n", NimBLEDevice::getMTU());
   
   return true;
 }
@@ -150,15 +298,24 @@ bool BeamLink::setupService() {
   if (!pServer) return false;
   
   // Create BLE Service
-  NimBLEService* pService = pServer->createService(serviceUuid.c_str());
+  NimBLEService* pService = pServer->createService(serviceUuid);
   if (!pService) {
     Serial.println("Failed to create BLE service");
     return false;
   }
   
+  // Registration order fixes the handles; the layout hash records it
+  const NimBLEUUID layoutUuid(BMLK_LAYOUT_UUID);
+  if (characteristicUuid == layoutUuid) {
+    Serial.printf("Characteristic UUID %s is reserved for the layout version\n", BMLK_LAYOUT_UUID);
+    return false;
+  }
+  layout.clear();
+  layout.addService(serviceUuid.toString().c_str());
+
   // Create Main Characteristic (Read + Write + WriteNoResponse + Notify)
   pChar = pService->createCharacteristic(
-    characteristicUuid.c_str(),
+    characteristicUuid,
     NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_NR | NIMBLE_PROPERTY::NOTIFY
   );
   if (!pChar) {
@@ -167,6 +324,43 @@ bool BeamLink::setupService() {
   }
   
   pChar->setCallbacks(rxCallbacks.get());
+  layout.addCharacteristic(characteristicUuid.toString().c_str(),
+                           BEAM_STREAM_READ | BEAM_STREAM_WRITE | BEAM_STREAM_NOTIFY);
+
+  // Dedicated streams, after the main characteristic so its handle stays put
+  for (BeamStreamId id = 0; id < streams.size(); id++) {
+    const BeamStream& s = streams[id];
+    const NimBLEUUID uuid(s.uuid);
+    if (uuid == characteristicUuid || uuid == serviceUuid || uuid == layoutUuid) {
+      Serial.printf("Stream %s: UUID %s already in use\n", s.name, s.uuid);
+      return false;
+    }
+    uint32_t properties = 0;
+    if (s.properties & BEAM_STREAM_NOTIFY) properties |= NIMBLE_PROPERTY::NOTIFY;
+    if (s.properties & BEAM_STREAM_WRITE) properties |= NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_NR;
+    if (s.properties & BEAM_STREAM_READ) properties |= NIMBLE_PROPERTY::READ;
+    streamChars[id] = pService->createCharacteristic(uuid, properties);
+    if (!streamChars[id]) {
+      Serial.printf("Failed to create stream characteristic %s\n", s.name);
+      return false;
+    }
+    if (!streamCallbacks[id]) streamCallbacks[id] = std::make_unique<StreamCallbacks>(this, id);
+    streamChars[id]->setCallbacks(streamCallbacks[id].get());
+    layout.addCharacteristic(s.uuid, s.properties);
+  }
+
+  // Layout version last, so the main characteristic and the streams keep the
+  // handles they had before it existed
+  pLayoutChar = pService->createCharacteristic(layoutUuid, NIMBLE_PROPERTY::READ);
+  if (!pLayoutChar) {
+    Serial.println("Failed to create layout characteristic");
+    return false;
+  }
+  layout.addCharacteristic(BMLK_LAYOUT_UUID, BEAM_STREAM_READ);
+
+  uint8_t version[4];
+  for (size_t i = 0; i < sizeof(version); i++) version[i] = static_cast<uint8_t>(layout.hash() >> (8 * i));
+  pLayoutChar->setValue(version, sizeof(version));
   
   // Start the service
   if (!pService->start()) {
@@ -184,18 +378,16 @@ bool BeamLink::startAdvertising(uint16_t intervalMs) {
     return false;
   }
   
-  pAdvertising->addServiceUUID(serviceUuid.c_str());
+  pAdvertising->addServiceUUID(serviceUuid);
   pAdvertising->setScanResponse(true);
   
-  // Convert ms to BLE units (0.625ms per unit)
-  // intervalMs / 0.625 = intervalMs * 1.6
-  uint16_t intervalUnits = (intervalMs * 16) / 10;
-  
-  // BLE spec: minimum is 20ms (32 units), maximum is 10240ms (16384 units)
-  intervalUnits = std::max((uint16_t)32, std::min((uint16_t)16384, intervalUnits));
-  
+  uint16_t intervalUnits = toAdvUnits(intervalMs);
   pAdvertising->setMinInterval(intervalUnits);
   pAdvertising->setMaxInterval(intervalUnits);
+  {
+    std::lock_guard<std::mutex> guard(advMutex);
+    if (!broadcastData.empty()) applyScanResponse();
+  }
   
   if (!NimBLEDevice::startAdvertising()) {
     Serial.println("Failed to start advertising");
@@ -205,10 +397,249 @@ bool BeamLink::startAdvertising(uint16_t intervalMs) {
   return true;
 }
 
+bool BeamLink::applyPower(int8_t dbm) {
+  // ESP32 power levels are 3 dB steps from -12 dBm (ESP_PWR_LVL_N12 = 0) to +9 dBm;
+  // callers pass a level (beamcfg::powerValid), so nothing is rounded here
+  const int level = (dbm - beamcfg::kMinPowerDbm) / beamcfg::kPowerStepDb;
+  NimBLEDevice::setPower(static_cast<esp_power_level_t>(level), ESP_BLE_PWR_TYPE_ADV);
+  NimBLEDevice::setPower(static_cast<esp_power_level_t>(level), ESP_BLE_PWR_TYPE_DEFAULT);
+  return NimBLEDevice::getPower(ESP_BLE_PWR_TYPE_ADV) == dbm;
+}
+
+bool BeamLink::setAdvPower(int8_t dbm, BeamChangeReport* report) {
+  BeamChangeReport local;
+  BeamChangeReport& out = reportFor(report, local, "BLE_POWER_DBM");
+  if (!initialized || !beamcfg::powerValid(dbm)) return false;
+
+  // Takes effect on the next radio event; nothing is stopped
+  if (!applyPower(dbm)) {
+    applyPower(advPowerDbm);
+    return false;
+  }
+  advPowerDbm = dbm;
+  out.ok = true;
+  return true;
+}
+
+bool BeamLink::setAdvInterval(uint16_t intervalMs, BeamChangeReport* report) {
+  BeamChangeReport local;
+  BeamChangeReport& out = reportFor(report, local, "BLE_ADV_INTERVAL_MS");
+  if (!initialized || intervalMs < beamcfg::kMinAdvIntervalMs || intervalMs > beamcfg::kMaxAdvIntervalMs) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> guard(advMutex);
+  BeamAdvSteps steps = advSchedule.steps();
+  steps.intervalMs = intervalMs;
+  advSchedule.configure(steps);
+
+  // Other phases pick the interval up when the schedule reaches normal
+  if (advSchedule.phase() != BeamAdvPhase::Normal) {
+    advIntervalMs = intervalMs;
+    out.ok = true;
+    return true;
+  }
+
+  const bool wasAdvertising = NimBLEDevice::getAdvertising()->isAdvertising();
+  const uint32_t start = micros();
+  out.ok = applyAdvInterval(intervalMs);
+  if (!out.ok) {
+    steps.intervalMs = advIntervalMs;
+    advSchedule.configure(steps);
+    applyAdvInterval(advIntervalMs);
+  } else {
+    advIntervalMs = intervalMs;
+  }
+  out.downtimeUs = wasAdvertising ? micros() - start : 0;
+  return out.ok;
+}
+
+bool BeamLink::setAdvSchedule(const BeamAdvSteps& steps, BeamChangeReport* report) {
+  BeamChangeReport local;
+  BeamChangeReport& out = reportFor(report, local, "BLE_ADV_SCHEDULE");
+  auto validInterval = [](uint16_t ms) {
+    return ms >= beamcfg::kMinAdvIntervalMs && ms <= beamcfg::kMaxAdvIntervalMs;
+  };
+  if (!initialized || !validInterval(steps.fastIntervalMs) || !validInterval(steps.intervalMs) ||
+      !validInterval(steps.slowIntervalMs)) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> guard(advMutex);
+  const BeamAdvSteps previous = advSchedule.steps();
+  const uint32_t before = advSchedule.intervalMs();
+  advSchedule.configure(steps);
+  advSchedule.update();
+
+  const bool wasAdvertising = NimBLEDevice::getAdvertising()->isAdvertising();
+  const uint32_t start = micros();
+  out.ok = advSchedule.intervalMs() == before ||
+           applyAdvInterval(static_cast<uint16_t>(advSchedule.intervalMs()));
+  if (!out.ok) {
+    advSchedule.configure(previous);
+    applyAdvInterval(static_cast<uint16_t>(before));
+  } else {
+    advIntervalMs = steps.intervalMs;
+  }
+  out.downtimeUs = wasAdvertising && advSchedule.intervalMs() != before ? micros() - start : 0;
+  return out.ok;
+}
+
+void BeamLink::restartAdvertising() {
+  if (!initialized) return;
+  std::lock_guard<std::mutex> guard(advMutex);
+  if (advSchedule.phase() == BeamAdvPhase::Off) return;
+  const uint32_t before = advSchedule.intervalMs();
+  advSchedule.restart();
+  if (advSchedule.intervalMs() != before) {
+    applyAdvInterval(static_cast<uint16_t>(advSchedule.intervalMs()));
+  }
+}
+
+BeamAdvPhase BeamLink::getAdvPhase() const {
+  std::lock_guard<std::mutex> guard(advMutex);
+  return advSchedule.phase();
+}
+
+BeamAdvStats BeamLink::getAdvStats() const {
+  std::lock_guard<std::mutex> guard(advMutex);
+  return advSchedule.stats();
+}
+
+size_t BeamLink::getBroadcastCapacity() const {
+  // Name AD (length, type, name) and manufacturer AD header (length, type)
+  const size_t used = 2 + deviceName.size() + 2;
+  return used < kLegacyAdvBytes ? kLegacyAdvBytes - used : 0;
+}
+
+bool BeamLink::setBroadcastData(const uint8_t* data, size_t size) {
+  if (!initialized || (size && !data) || size > getBroadcastCapacity()) return false;
+  std::lock_guard<std::mutex> guard(advMutex);
+  broadcastData.assign(reinterpret_cast<const char*>(data), size);
+  applyScanResponse();
+  return true;
+}
+
+void BeamLink::applyScanResponse() {
+  NimBLEAdvertisementData response;
+  response.setName(deviceName);
+  // A longer name may have pushed the data out: keep the name, drop the data
+  if (!broadcastData.empty() && broadcastData.size() <= getBroadcastCapacity()) {
+    response.setManufacturerData(broadcastData);
+  }
+  // Replaces the scan response in place, no advertising gap
+  NimBLEDevice::getAdvertising()->setScanResponseData(response);
+}
+
+bool BeamLink::applyAdvInterval(uint16_t intervalMs) {
+  NimBLEAdvertising* adv = NimBLEDevice::getAdvertising();
+  const bool wasAdvertising = adv->isAdvertising();
+  if (wasAdvertising) adv->stop();
+  adv->setMinInterval(toAdvUnits(intervalMs));
+  adv->setMaxInterval(toAdvUnits(intervalMs));
+  return !wasAdvertising || adv->start();
+}
+
+uint32_t BeamLink::msUntilAdvStep() const {
+  if (!initialized) return UINT32_MAX;
+  std::lock_guard<std::mutex> guard(advMutex);
+  return advSchedule.msUntilNext();
+}
+
+bool BeamLink::setDeviceName(const char* name, BeamChangeReport* report) {
+  BeamChangeReport local;
+  BeamChangeReport& out = reportFor(report, local, "BLE_NAME");
+  if (!initialized || !name || !*name || strlen(name) > beamcfg::kMaxNameLength) return false;
+
+  NimBLEAdvertising* adv = NimBLEDevice::getAdvertising();
+  const bool wasAdvertising = adv->isAdvertising();
+  const uint32_t start = micros();
+  if (wasAdvertising) adv->stop();
+
+  // GAP name characteristic, then the name carried in the advertising data
+  out.ok = ble_svc_gap_device_name_set(name) == 0;
+  if (out.ok) {
+    adv->setName(name);
+    out.ok = !wasAdvertising || adv->start();
+  }
+  if (!out.ok) {
+    ble_svc_gap_device_name_set(deviceName.c_str());
+    adv->setName(deviceName);
+    if (wasAdvertising) adv->start();
+  } else {
+    deviceName = name;
+    std::lock_guard<std::mutex> guard(advMutex);
+    if (!broadcastData.empty()) applyScanResponse();
+  }
+  out.downtimeUs = wasAdvertising ? micros() - start : 0;
+  return out.ok;
+}
+
+bool BeamLink::setUuids(const char* serviceUuid, const char* characteristicUuid, BeamChangeReport* report) {
+  BeamChangeReport local;
+  BeamChangeReport& out = reportFor(report, local, "BLE_SERVICE_UUID");
+  if (!initialized || !beamcfg::isUuid128(serviceUuid) || !beamcfg::isUuid128(characteristicUuid)) return false;
+
+  // Keep copies: end() + begin() overwrite the members
+  const std::string name = deviceName;
+  const std::string oldService = this->serviceUuid.toString();
+  const std::string oldCharacteristic = this->characteristicUuid.toString();
+  const int8_t power = advPowerDbm;
+  const uint16_t interval = advIntervalMs;
+
+  out.restarted = true;
+  const uint32_t start = micros();
+  end();
+  out.ok = begin(name.c_str(), power, interval, serviceUuid, characteristicUuid);
+  if (!out.ok) {
+    end();
+    begin(name.c_str(), power, interval, oldService.c_str(), oldCharacteristic.c_str());
+  }
+  out.downtimeUs = micros() - start;
+  return out.ok;
+}
+
+size_t BeamLink::reconfigure(const BeamConfig& cfg, BeamChangeReport* reports, size_t maxReports) {
+  size_t count = 0;
+  auto next = [&]() { return count < maxReports && reports ? &reports[count] : nullptr; };
+
+  if (cfg.blePowerDbm != advPowerDbm) {
+    setAdvPower(static_cast<int8_t>(cfg.blePowerDbm), next());
+    count++;
+  }
+  if (cfg.bleAdvIntervalMs != advIntervalMs) {
+    setAdvInterval(static_cast<uint16_t>(cfg.bleAdvIntervalMs), next());
+    count++;
+  }
+  const BeamAdvSteps steps = beamAdvSteps(cfg);
+  BeamAdvSteps running;
+  {
+    std::lock_guard<std::mutex> guard(advMutex);
+    running = advSchedule.steps();
+  }
+  if (steps != running) {
+    setAdvSchedule(steps, next());
+    count++;
+  }
+  if (cfg.bleName != deviceName) {
+    setDeviceName(cfg.bleName.c_str(), next());
+    count++;
+  }
+  if (NimBLEUUID(cfg.bleServiceUuid) != serviceUuid || NimBLEUUID(cfg.bleCharacteristicUuid) != characteristicUuid) {
+    setUuids(cfg.bleServiceUuid.c_str(), cfg.bleCharacteristicUuid.c_str(), next());
+    count++;
+  }
+  return count;
+}
+
 void BeamLink::onMessage(MessageHandler handler) {
   messageHandler = handler;
 }
 
+void BeamLink::onConnectionChange(ConnectionHandler handler) {
+  connectionHandler = handler;
+}
+
 bool BeamLink::notify(const std::string& msg) {
   if (!initialized || !pChar || !deviceConnected) {
     errorCount++;
@@ -220,27 +651,70 @@ bool BeamLink::notify(const std::string& msg) {
     return false;
   }
   
-  // Validate message size (MTU - 3 bytes for ATT header)
-  uint16_t maxSize = NimBLEDevice::getMTU() - 3;
-  if (msg.length() > maxSize) {
+  // NimBLE copies the value into its own buffer, so the lock only covers queueing
+  BeamPower::Hold hold(power, BeamPowerReason::Tx);
+
+  // Validate message size (negotiated MTU - 3 bytes for ATT header)
+  uint16_t maxSize = getMTU() - 3;
+  const bool truncated = msg.length() > maxSize;
+  if (truncated) {
     Serial.printf("Warning: Message size %zu exceeds MTU %u, truncating\n", msg.length(), maxSize);
     errorCount++;
-    // Truncate message to fit MTU
-    std::string truncated = msg.substr(0, maxSize);
-    pChar->setValue(truncated);
-  } else {
-    pChar->setValue(msg);
   }
+
+  // Replies come from the NimBLE host task, everything else from loop(): one
+  // task's value must not go out under the other's notify()
+  uint32_t sent;
+  {
+    std::lock_guard<std::mutex> guard(txMutex);
+    pChar->setValue(reinterpret_cast<const uint8_t*>(msg.data()), truncated ? maxSize : msg.length());
+    pChar->notify();
+    sent = ++messagesSent;
+  }
+  Serial.printf("TX [%u]: %s\n", sent, msg.c_str());
   
-  pChar->notify();
-  messagesSent++;
-  Serial.printf("TX [%u]: %s\n", messagesSent, msg.c_str());
-  
+  return true;
+}
+
+BeamStreamId BeamLink::addStream(const char* name, const char* uuid, uint8_t properties,
+                                 BeamStreamHandler handler) {
+  if (initialized) {
+    Serial.println("addStream() must be called before begin()");
+    return kBeamNoStream;
+  }
+  const BeamStreamId id = streams.add(name, uuid, properties, std::move(handler));
+  if (id == kBeamNoStream) {
+    Serial.printf("Invalid stream %s\n", name ? name : "(null)");
+  }
+  return id;
+}
+
+bool BeamLink::notify(BeamStreamId id, const uint8_t* data, size_t size) {
+  if (!initialized || id >= streams.size() || !streamChars[id] || !(streams[id].properties & BEAM_STREAM_NOTIFY) ||
+      !data || size == 0) {
+    errorCount++;
+    return false;
+  }
+  if (!isSubscribed(id)) {
+    streams.countSkipped(id);
+    return false;
+  }
+
+  BeamPower::Hold hold(power, BeamPowerReason::Tx);
+  const size_t maxSize = getMTU() - 3;
+  const bool truncated = size > maxSize;
+  streamChars[id]->setValue(data, truncated ? maxSize : size);
+  streamChars[id]->notify();
+  streams.countSent(id, truncated);
   return true;
 }
 
 uint16_t BeamLink::getMTU() const {
-  if (!initialized) return 23; // Default BLE MTU
+  return deviceConnected ? peerMtu.load() : kDefaultMtu;
+}
+
+uint16_t BeamLink::getPreferredMTU() const {
+  if (!initialized) return kDefaultMtu;
   return NimBLEDevice::getMTU();
 }
 
@@ -253,14 +727,27 @@ void BeamLink::resetStats() {
   messagesReceived = 0;
   messagesSent = 0;
   errorCount = 0;
+  streams.resetStats();
   startTime = millis();
   Serial.println("Statistics reset");
 }
 
 void BeamLink::loop() {
-  // Reserved for future use (timers, heartbeats, etc.)
-  // Reduced delay for better responsiveness
-  delay(1);
+  // The NimBLE host task delivers events; only the advertising schedule is
+  // stepped here. No delay, so the caller decides how long loop() sleeps.
+  if (!initialized) return;
+  std::lock_guard<std::mutex> guard(advMutex);
+  const uint32_t before = advSchedule.intervalMs();
+  if (!advSchedule.update() || advSchedule.intervalMs() == before) return;
+  if (!applyAdvInterval(static_cast<uint16_t>(advSchedule.intervalMs()))) {
+    errorCount++;
+  }
+  Serial.printf("Advertising: %s phase, %lu ms\n", beamAdvPhaseName(advSchedule.phase()),
+                (unsigned long)advSchedule.intervalMs());
+}
+
+NimBLEServerCallbacks* BeamLink::getServerCallbacks() const {
+  return serverCallbacks.get();
 }
 
 void BeamLink::end() {
@@ -271,9 +758,16 @@ void BeamLink::end() {
     if (pServer) {
       pServer->getAdvertising()->stop();
     }
+    {
+      std::lock_guard<std::mutex> guard(advMutex);
+      advSchedule.stop();
+    }
     
     pChar = nullptr;
+    pLayoutChar = nullptr;
     pServer = nullptr;
+    std::fill(std::begin(streamChars), std::end(streamChars), nullptr);
+    streams.clearSubscriptions();
     
     NimBLEDevice::deinit(true);
     
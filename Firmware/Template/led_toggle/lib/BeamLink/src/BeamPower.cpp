@@ -0,0 +1,195 @@
+#include "BeamPower.h"
+
+#if defined(ARDUINO) && defined(ESP32)
+#include <esp_idf_version.h>
+#include <esp_timer.h>
+#endif
+
+namespace {
+
+uint64_t platformClockUs() {
+#if defined(ARDUINO) && defined(ESP32)
+  // 64-bit: micros() wraps after 71 minutes, idle stretches can be longer
+  return static_cast<uint64_t>(esp_timer_get_time());
+#else
+  return static_cast<uint64_t>(micros());
+#endif
+}
+
+#if defined(ARDUINO) && defined(ESP32) && CONFIG_PM_ENABLE
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+using PmConfig = esp_pm_config_t;
+#elif CONFIG_IDF_TARGET_ESP32S3
+using PmConfig = esp_pm_config_esp32s3_t;
+#elif CONFIG_IDF_TARGET_ESP32S2
+using PmConfig = esp_pm_config_esp32s2_t;
+#elif CONFIG_IDF_TARGET_ESP32C3
+using PmConfig = esp_pm_config_esp32c3_t;
+#else
+using PmConfig = esp_pm_config_esp32_t;
+#endif
+
+bool configurePm(uint16_t maxMhz, uint16_t minMhz, bool lightSleep) {
+  PmConfig pm = {};
+  pm.max_freq_mhz = maxMhz;
+  pm.min_freq_mhz = minMhz;
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+  pm.light_sleep_enable = lightSleep;
+#else
+  if (lightSleep) {
+    Serial.println("BeamPower: CONFIG_FREERTOS_USE_TICKLESS_IDLE is off, frequency scaling only");
+  }
+#endif
+  const esp_err_t err = esp_pm_configure(&pm);
+  if (err != ESP_OK) {
+    Serial.printf("BeamPower: esp_pm_configure failed (%s)\n", esp_err_to_name(err));
+    return false;
+  }
+  return true;
+}
+#endif
+
+} // namespace
+
+BeamPower::BeamPower(uint64_t (*clockUs)()) : clock(clockUs ? clockUs : platformClockUs) {
+  sinceUs = clock();
+}
+
+BeamPower::~BeamPower() {
+  end();
+}
+
+bool BeamPower::begin(const BeamPowerConfig& cfg) {
+  std::lock_guard<std::mutex> guard(mutex);
+  config = cfg;
+  if (config.minFreqMhz > config.maxFreqMhz) config.minFreqMhz = config.maxFreqMhz;
+
+  const bool wasManaged = managed;
+  managed = false;
+#if defined(ARDUINO) && defined(ESP32) && CONFIG_PM_ENABLE
+  if (!lock && esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "beamlink", &lock) != ESP_OK) {
+    lock = nullptr;
+    Serial.println("BeamPower: esp_pm_lock_create failed");
+  }
+  if (lock) {
+    // Take the lock before scaling down if work is already pending
+    if (lockHeld && !wasManaged) esp_pm_lock_acquire(lock);
+    managed = configurePm(config.maxFreqMhz, config.minFreqMhz, config.lightSleep);
+    if (!managed && lockHeld) esp_pm_lock_release(lock);
+  }
+#elif defined(ARDUINO) && defined(ESP32)
+  (void)wasManaged;
+  Serial.println("BeamPower: CONFIG_PM_ENABLE is off, accounting only");
+#else
+  (void)wasManaged;
+#endif
+
+  transition(clock());
+  return managed;
+}
+
+void BeamPower::end() {
+  std::lock_guard<std::mutex> guard(mutex);
+#if defined(ARDUINO) && defined(ESP32) && CONFIG_PM_ENABLE
+  if (managed) {
+    configurePm(config.maxFreqMhz, config.maxFreqMhz, false);
+    if (lockHeld) esp_pm_lock_release(lock);
+  }
+  if (lock) {
+    esp_pm_lock_delete(lock);
+    lock = nullptr;
+  }
+#endif
+  managed = false;
+  lockHeld = false;
+}
+
+void BeamPower::acquire(BeamPowerReason reason) {
+  std::lock_guard<std::mutex> guard(mutex);
+  const uint8_t r = static_cast<uint8_t>(reason);
+  pending[r]++;
+  pendingTotal++;
+  counters.acquires[r]++;
+  transition(clock());
+}
+
+void BeamPower::release(BeamPowerReason reason) {
+  std::lock_guard<std::mutex> guard(mutex);
+  const uint8_t r = static_cast<uint8_t>(reason);
+  if (pending[r] == 0) return;
+  pending[r]--;
+  pendingTotal--;
+  transition(clock());
+}
+
+void BeamPower::activity() {
+  std::lock_guard<std::mutex> guard(mutex);
+  if (config.lingerMs == 0) return;
+  const uint64_t now = clock();
+  const uint64_t until = now + static_cast<uint64_t>(config.lingerMs) * 1000;
+  if (until > lingerUntilUs) lingerUntilUs = until;
+  transition(now);
+}
+
+uint32_t BeamPower::update() {
+  std::lock_guard<std::mutex> guard(mutex);
+  const uint64_t now = clock();
+  transition(now);
+  if (current != BeamPowerState::Linger) return kNever;
+  // Round up so the wakeup lands after the deadline, not just before it
+  return static_cast<uint32_t>((lingerUntilUs - now + 999) / 1000);
+}
+
+BeamPowerState BeamPower::state() const {
+  std::lock_guard<std::mutex> guard(mutex);
+  return current;
+}
+
+bool BeamPower::holdsLock() const {
+  std::lock_guard<std::mutex> guard(mutex);
+  return lockHeld;
+}
+
+BeamPowerStats BeamPower::stats() const {
+  std::lock_guard<std::mutex> guard(mutex);
+  BeamPowerStats s = counters;
+  s.timeUs[static_cast<uint8_t>(current)] += clock() - sinceUs;
+  return s;
+}
+
+void BeamPower::resetStats() {
+  std::lock_guard<std::mutex> guard(mutex);
+  counters = BeamPowerStats{};
+  sinceUs = clock();
+}
+
+BeamPowerState BeamPower::evaluate(uint64_t nowUs) const {
+  if (pendingTotal > 0) return BeamPowerState::Busy;
+  if (nowUs < lingerUntilUs) return BeamPowerState::Linger;
+  return BeamPowerState::Idle;
+}
+
+// Caller holds the mutex
+void BeamPower::transition(uint64_t nowUs) {
+  const BeamPowerState next = evaluate(nowUs);
+  if (next == current) return;
+
+  counters.timeUs[static_cast<uint8_t>(current)] += nowUs - sinceUs;
+  sinceUs = nowUs;
+  if (current == BeamPowerState::Idle) counters.lockTaken++;
+  current = next;
+  setLock(next != BeamPowerState::Idle);
+}
+
+void BeamPower::setLock(bool hold) {
+  if (hold == lockHeld) return;
+  lockHeld = hold;
+#if defined(ARDUINO) && defined(ESP32) && CONFIG_PM_ENABLE
+  if (!managed) return;
+  if (hold) {
+    esp_pm_lock_acquire(lock);
+  } else {
+    esp_pm_lock_release(lock);
+  }
+#endif
+}
@@ -0,0 +1,206 @@
+#include "BeamReport.h"
+#include "BeamUtils.h"
+
+// ============================================================================
+// Filter
+// ============================================================================
+
+void BeamReportFilter::begin(const BeamReportPolicy& policy) {
+  p = policy;
+  hasValue = false;
+  reportedOnce = false;
+  reportedAbove = false;
+  pending = false;
+}
+
+bool BeamReportFilter::offer(float value, uint32_t nowMs) {
+  current = value;
+  hasValue = true;
+  counters.offered++;
+
+  bool meaningful = !reportedOnce || std::fabs(value - lastSent) > p.deadband;
+  if (reportedOnce && !std::isnan(p.threshold)) {
+    const bool above = value >= (reportedAbove ? p.threshold - p.hysteresis : p.threshold);
+    if (above != reportedAbove) meaningful = true;
+  }
+  return decide(meaningful, nowMs);
+}
+
+bool BeamReportFilter::offerChange(bool changed, uint32_t nowMs) {
+  hasValue = true;
+  counters.offered++;
+  return decide(!reportedOnce || changed, nowMs);
+}
+
+bool BeamReportFilter::decide(bool meaningful, uint32_t nowMs) {
+  // A change that has been undone before it went out is dropped as well
+  pending = false;
+  if (meaningful && (!reportedOnce || nowMs - lastSentMs >= p.minIntervalMs)) {
+    markSent(nowMs);
+    return true;
+  }
+  pending = meaningful;
+  counters.suppressed++;
+  return false;
+}
+
+void BeamReportFilter::markSent(uint32_t nowMs) {
+  if (!std::isnan(p.threshold)) {
+    reportedAbove = current >= (reportedOnce && reportedAbove ? p.threshold - p.hysteresis : p.threshold);
+  }
+  lastSent = current;
+  lastSentMs = nowMs;
+  reportedOnce = true;
+  pending = false;
+  counters.sent++;
+}
+
+uint32_t BeamReportFilter::update(uint32_t nowMs) {
+  if (!reportedOnce) return kNever;
+  const uint32_t elapsed = nowMs - lastSentMs;
+  uint32_t wait = kNever;
+
+  if (pending) {
+    if (elapsed >= p.minIntervalMs) {
+      markSent(nowMs);
+      return 0;
+    }
+    wait = p.minIntervalMs - elapsed;
+  }
+  if (p.heartbeatMs && hasValue) {
+    if (elapsed >= p.heartbeatMs) {
+      markSent(nowMs);
+      counters.heartbeats++;
+      return 0;
+    }
+    if (p.heartbeatMs - elapsed < wait) wait = p.heartbeatMs - elapsed;
+  }
+  return wait;
+}
+
+// ============================================================================
+// Reporter
+// ============================================================================
+
+void BeamReporter::setDefaultPolicy(const BeamReportPolicy& policy) {
+  fallback = policy;
+  for (size_t i = 0; i < count; i++) {
+    if (!signals[i].ownPolicy) signals[i].filter.setPolicy(policy);
+  }
+}
+
+bool BeamReporter::setPolicy(std::string_view key, const BeamReportPolicy& policy) {
+  Signal* s = find(key);
+  if (!s) s = add(key);
+  if (!s) return false;
+  s->filter.setPolicy(policy);
+  s->ownPolicy = true;
+  return true;
+}
+
+bool BeamReporter::offer(std::string_view key, std::string_view value, uint32_t nowMs) {
+  Signal* s = find(key);
+  if (!s) s = add(key);
+  if (!active) {
+    if (s) {
+      s->value.assign(value.data(), value.size());
+      s->offered = true;
+    }
+    return false;
+  }
+  if (!s) {
+    unfiltered.offered++;
+    unfiltered.sent++;
+    if (reportFn) reportFn(std::string(key), std::string(value));
+    return true;
+  }
+  s->value.assign(value.data(), value.size());
+  s->offered = true;
+  return decide(*s, nowMs);
+}
+
+bool BeamReporter::decide(Signal& s, uint32_t nowMs) {
+  float number;
+  bool sendNow;
+  if (BeamUtils::parseFloat(s.value, number)) {
+    // From text to a number: start over, so the deadband has a reference
+    if (!s.numeric && s.filter.hasReported()) s.filter.begin(s.filter.policy());
+    sendNow = s.filter.offer(number, nowMs);
+  } else {
+    sendNow = s.filter.offerChange(s.value != s.sentText || s.numeric, nowMs);
+  }
+  if (sendNow) send(s);
+  return sendNow;
+}
+
+void BeamReporter::setActive(bool on, uint32_t nowMs) {
+  if (on == active) return;
+  active = on;
+  if (!active) return;
+  for (size_t i = 0; i < count; i++) {
+    Signal& s = signals[i];
+    s.filter.begin(s.filter.policy());
+    if (s.offered) decide(s, nowMs);
+  }
+}
+
+uint32_t BeamReporter::update(uint32_t nowMs) {
+  if (!active) return kNever;
+  uint32_t wait = kNever;
+  for (size_t i = 0; i < count; i++) {
+    uint32_t next = signals[i].filter.update(nowMs);
+    if (next == 0) {
+      send(signals[i]);
+      next = signals[i].filter.update(nowMs);
+    }
+    if (next < wait) wait = next;
+  }
+  return wait;
+}
+
+BeamReportStats BeamReporter::stats() const {
+  BeamReportStats total = unfiltered;
+  for (size_t i = 0; i < count; i++) {
+    const BeamReportStats& s = signals[i].filter.stats();
+    total.offered += s.offered;
+    total.sent += s.sent;
+    total.suppressed += s.suppressed;
+    total.heartbeats += s.heartbeats;
+  }
+  return total;
+}
+
+void BeamReporter::resetStats() {
+  unfiltered = BeamReportStats{};
+  for (size_t i = 0; i < count; i++) signals[i].filter.resetStats();
+}
+
+BeamReporter::Signal* BeamReporter::find(std::string_view key) {
+  for (size_t i = 0; i < count; i++) {
+    if (signals[i].key == key) return &signals[i];
+  }
+  return nullptr;
+}
+
+BeamReporter::Signal* BeamReporter::add(std::string_view key) {
+  if (count == BEAM_REPORT_MAX_SIGNALS) {
+    // Once, not on every state change of the untracked key
+    if (!warned) {
+      Serial.printf("BeamReporter: more than %u signals, \"%.*s\" and later keys are sent unfiltered\n",
+                    static_cast<unsigned>(BEAM_REPORT_MAX_SIGNALS), static_cast<int>(key.size()), key.data());
+      warned = true;
+    }
+    return nullptr;
+  }
+  Signal& s = signals[count++];
+  s.key.assign(key.data(), key.size());
+  s.filter.begin(fallback);
+  return &s;
+}
+
+void BeamReporter::send(Signal& s) {
+  s.sentText = s.value;
+  float number;
+  s.numeric = BeamUtils::parseFloat(s.value, number);
+  if (reportFn) reportFn(s.key, s.value);
+}
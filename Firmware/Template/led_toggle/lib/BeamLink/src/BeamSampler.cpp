@@ -0,0 +1,310 @@
+#include "BeamSampler.h"
+#include "BeamBatchCodec.h"
+#include "BeamConfig.h"
+#include "BeamUtils.h"
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+constexpr float kTwoPi = 6.28318530718f;
+
+} // namespace
+
+size_t beamParsePins(std::string_view text, uint8_t* pins, size_t maxPins) {
+  size_t count = 0;
+  while (!text.empty()) {
+    const size_t comma = text.find(',');
+    int32_t pin = 0;
+    if (count >= maxPins || !BeamUtils::parseInt(BeamUtils::trimView(text.substr(0, comma)), pin)) return 0;
+    if (pin < 0 || pin > 63) return 0;
+    pins[count++] = static_cast<uint8_t>(pin);
+    if (comma == std::string_view::npos) break;
+    text.remove_prefix(comma + 1);
+  }
+  return count;
+}
+
+size_t beamBatchSamples(size_t capacity) {
+  if (capacity < kBeamBatchHeader + kBeamBatchRawSample) return 0;
+  const size_t max = (capacity - kBeamBatchHeader) / kBeamBatchRawSample;
+  return max > 255 ? 255 : max;
+}
+
+size_t beamEncodeBatch(uint8_t channel, const BeamSample* samples, size_t n, uint8_t* out, size_t capacity) {
+  const size_t max = beamBatchSamples(capacity);
+  if (n > max) n = max;
+  if (n == 0) return 0;
+  out[0] = kBeamBatchRaw;
+  out[1] = channel;
+  out[2] = static_cast<uint8_t>(n);
+  uint8_t* p = out + kBeamBatchHeader;
+  for (size_t i = 0; i < n; i++, p += kBeamBatchRawSample) {
+    BeamUtils::putLe(p, samples[i].timeUs, 4);
+    BeamUtils::putLe(p + 4, samples[i].value, 2);
+  }
+  return kBeamBatchHeader + n * kBeamBatchRawSample;
+}
+
+int beamDecodeBatch(const uint8_t* data, size_t size, uint8_t* channel, BeamSample* out, size_t maxSamples) {
+  if (!data || size < kBeamBatchHeader) return -1;
+  if (data[0] == kBeamBatchDelta || data[0] == kBeamBatchXor) {
+    return beamDecodeDeltaBatch(data, size, channel, out, maxSamples);
+  }
+  if (data[0] != kBeamBatchRaw) return -1;
+  const size_t count = data[2];
+  if (size != kBeamBatchHeader + count * kBeamBatchRawSample) return -1;
+  if (channel) *channel = data[1];
+  const uint8_t* p = data + kBeamBatchHeader;
+  for (size_t i = 0; i < count && i < maxSamples; i++, p += kBeamBatchRawSample) {
+    out[i].timeUs = BeamUtils::getLe(p, 4);
+    out[i].value = static_cast<uint16_t>(BeamUtils::getLe(p + 4, 2));
+  }
+  return static_cast<int>(count);
+}
+
+// ============================================================================
+// Sources
+// ============================================================================
+
+void BeamSimAdc::setSignal(uint8_t channel, const Signal& signal) {
+  if (channel < BEAM_SAMPLER_MAX_CHANNELS) signals[channel] = signal;
+}
+
+uint16_t BeamSimAdc::read(uint8_t channel, uint32_t timeUs) {
+  readCount++;
+  if (channel >= BEAM_SAMPLER_MAX_CHANNELS) return 0;
+  const Signal& s = signals[channel];
+  float value = s.offset;
+  if (s.amplitude != 0 && s.frequencyHz != 0) {
+    // Phase from the time modulo one period keeps float precision over hours
+    const uint32_t periodUs = static_cast<uint32_t>(1e6f / s.frequencyHz);
+    const float phase = periodUs ? static_cast<float>(timeUs % periodUs) / periodUs : 0.0f;
+    value += s.amplitude * std::sin(kTwoPi * phase);
+  }
+  if (s.noise != 0) {
+    noiseState = noiseState * 1664525u + 1013904223u;
+    value += s.noise * (static_cast<float>(noiseState >> 8) / 8388608.0f - 1.0f);
+  }
+  if (value < 0) value = 0;
+  if (value > 4095) value = 4095;
+  return static_cast<uint16_t>(std::lround(value));
+}
+
+#if defined(ARDUINO)
+bool BeamAnalogAdc::begin(const uint8_t* pins, size_t count) {
+  if (count > BEAM_SAMPLER_MAX_CHANNELS) return false;
+  analogReadResolution(12);
+  for (size_t i = 0; i < count; i++) {
+    this->pins[i] = pins[i];
+    pinMode(pins[i], INPUT);
+    analogSetPinAttenuation(pins[i], ADC_11db);
+  }
+  return true;
+}
+
+uint16_t BeamAnalogAdc::read(uint8_t channel, uint32_t timeUs) {
+  (void)timeUs;
+  return static_cast<uint16_t>(analogRead(pins[channel]));
+}
+#endif
+
+// ============================================================================
+// Sampler
+// ============================================================================
+
+BeamSampler::~BeamSampler() {
+  stop();
+#if defined(ARDUINO) && defined(ESP32)
+  if (timer) esp_timer_delete(timer);
+#endif
+}
+
+bool BeamSampler::begin(BeamAdc& adc, const uint8_t* pins, size_t count, uint32_t rateHz) {
+  if (isRunning() || !pins || count == 0 || count > BEAM_SAMPLER_MAX_CHANNELS) return false;
+  if (rateHz == 0 || rateHz > BEAM_SAMPLER_MAX_RATE_HZ) return false;
+  if (!adc.begin(pins, count)) return false;
+
+  this->adc = &adc;
+  for (size_t i = 0; i < count; i++) {
+    this->pins[i] = pins[i];
+    rings[i].clear();
+    latestValue[i].store(0, std::memory_order_relaxed);
+    readyArmed[i] = true;
+  }
+  channels = static_cast<uint8_t>(count);
+  rate = rateHz;
+  period = 1000000u / rateHz;
+  scheduled = false;
+  resetStats();
+  return true;
+}
+
+bool BeamSampler::begin(BeamAdc& adc, const BeamConfig& cfg, uint32_t rateHz) {
+  uint8_t parsed[BEAM_SAMPLER_MAX_CHANNELS];
+  const size_t count = beamParsePins(cfg.sensorPins, parsed, BEAM_SAMPLER_MAX_CHANNELS);
+  if (count == 0) {
+    Serial.printf("BeamSampler: invalid SENSOR_PINS \"%s\"\n", cfg.sensorPins.c_str());
+    return false;
+  }
+  return begin(adc, parsed, count, rateHz);
+}
+
+void BeamSampler::onBatchReady(size_t threshold, ReadyFn fn) {
+  readyThreshold = threshold;
+  ready = std::move(fn);
+}
+
+void BeamSampler::tick(uint32_t nowUs) {
+  if (!adc) return;
+
+  // Lateness against the ideal schedule; resync after a long stall
+  if (!scheduled) {
+    nextDueUs = nowUs;
+    scheduled = true;
+  }
+  const int32_t late = static_cast<int32_t>(nowUs - nextDueUs);
+  if (late > 0) {
+    const uint32_t lateUs = static_cast<uint32_t>(late);
+    if (lateUs > period / 2) lateTicks.fetch_add(1, std::memory_order_relaxed);
+    if (lateUs > maxLatenessUs.load(std::memory_order_relaxed)) {
+      maxLatenessUs.store(lateUs, std::memory_order_relaxed);
+    }
+  }
+  nextDueUs = (late > 0 && static_cast<uint32_t>(late) > 10 * period) ? nowUs + period : nextDueUs + period;
+
+  for (uint8_t ch = 0; ch < channels; ch++) {
+    const BeamSample sample{nowUs, adc->read(ch, nowUs)};
+    latestValue[ch].store(sample.value, std::memory_order_relaxed);
+    if (!rings[ch].push(sample)) {
+      overruns.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    samples.fetch_add(1, std::memory_order_relaxed);
+
+    if (ready && readyThreshold) {
+      const size_t queued = rings[ch].size();
+      if (queued < readyThreshold) {
+        readyArmed[ch] = true;
+      } else if (readyArmed[ch]) {
+        readyArmed[ch] = false;
+        ready();
+      }
+    }
+  }
+  ticks.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t BeamSampler::available(uint8_t channel) const {
+  return channel < channels ? rings[channel].size() : 0;
+}
+
+size_t BeamSampler::read(uint8_t channel, BeamSample* out, size_t max) {
+  if (channel >= channels) return 0;
+  size_t n = 0;
+  while (n < max && rings[channel].pop(out[n])) n++;
+  return n;
+}
+
+size_t BeamSampler::readBatch(uint8_t channel, uint8_t* out, size_t capacity, uint8_t format) {
+  BeamBatchEncoder enc;
+  if (channel >= channels || !enc.begin(out, capacity, channel, format)) return 0;
+
+  // A sample leaves the ring only once it is in the batch
+  BeamSample s;
+  while (rings[channel].peek(s) && enc.add(s)) rings[channel].pop(s);
+  const size_t size = enc.finish();
+  if (size) batches++;
+  return size;
+}
+
+void BeamSampler::discard(uint8_t channel) {
+  if (channel < channels) rings[channel].clear();
+}
+
+uint16_t BeamSampler::latest(uint8_t channel) const {
+  return channel < channels ? latestValue[channel].load(std::memory_order_relaxed) : 0;
+}
+
+BeamSamplerStats BeamSampler::stats() const {
+  BeamSamplerStats s;
+  s.ticks = ticks.load(std::memory_order_relaxed);
+  s.samples = samples.load(std::memory_order_relaxed);
+  s.overruns = overruns.load(std::memory_order_relaxed);
+  s.lateTicks = lateTicks.load(std::memory_order_relaxed);
+  s.maxLatenessUs = maxLatenessUs.load(std::memory_order_relaxed);
+  s.batches = batches;
+  return s;
+}
+
+void BeamSampler::resetStats() {
+  ticks.store(0, std::memory_order_relaxed);
+  samples.store(0, std::memory_order_relaxed);
+  overruns.store(0, std::memory_order_relaxed);
+  lateTicks.store(0, std::memory_order_relaxed);
+  maxLatenessUs.store(0, std::memory_order_relaxed);
+  batches = 0;
+}
+
+// ============================================================================
+// Timer
+// ============================================================================
+
+#if defined(ARDUINO) && defined(ESP32)
+
+void BeamSampler::timerCallback(void* arg) {
+  static_cast<BeamSampler*>(arg)->tick(static_cast<uint32_t>(esp_timer_get_time()));
+}
+
+bool BeamSampler::start() {
+  if (!adc || isRunning()) return false;
+  if (!timer) {
+    esp_timer_create_args_t args = {};
+    args.callback = &BeamSampler::timerCallback;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;  // analogRead() is not ISR-safe
+    args.name = "beam_sampler";
+    if (esp_timer_create(&args, &timer) != ESP_OK) {
+      Serial.println("BeamSampler: esp_timer_create failed");
+      return false;
+    }
+  }
+  scheduled = false;
+  if (esp_timer_start_periodic(timer, period) != ESP_OK) return false;
+  running.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void BeamSampler::stop() {
+  if (!isRunning()) return;
+  esp_timer_stop(timer);
+  running.store(false, std::memory_order_relaxed);
+}
+
+#else
+
+bool BeamSampler::start() {
+  if (!adc || isRunning()) return false;
+  scheduled = false;
+  running.store(true, std::memory_order_relaxed);
+  worker = std::thread([this] {
+    auto next = std::chrono::steady_clock::now();
+    while (running.load(std::memory_order_relaxed)) {
+      tick(static_cast<uint32_t>(micros()));
+      next += std::chrono::microseconds(period);
+      // Fell behind: resync instead of replaying missed ticks back-to-back
+      const auto now = std::chrono::steady_clock::now();
+      if (next <= now) next = now + std::chrono::microseconds(period);
+      std::this_thread::sleep_until(next);
+    }
+  });
+  return true;
+}
+
+void BeamSampler::stop() {
+  if (!isRunning()) return;
+  running.store(false, std::memory_order_relaxed);
+  if (worker.joinable()) worker.join();
+}
+
+#endif
@@ -0,0 +1,265 @@
+#include "BeamScheduler.h"
+
+namespace {
+
+// Slot width per level, as a shift: 1 ms, 64 ms, 4096 ms
+constexpr uint8_t kLevelShift[3] = {0, 6, 12};
+
+// Longest delta the top level can hold; later deadlines are parked in its
+// last slot and re-placed when that slot cascades
+constexpr uint32_t kMaxPlacement = (64u << 12) - 1;
+
+inline uint64_t rotateRight(uint64_t bits, unsigned shift) {
+  shift &= 63;
+  return shift ? (bits >> shift) | (bits << (64 - shift)) : bits;
+}
+
+inline uint8_t lowestBit(uint64_t bits) {
+  return static_cast<uint8_t>(__builtin_ctzll(bits));
+}
+
+// Wrap-safe "a is before b" relative to a reference point
+inline bool earlier(uint32_t a, uint32_t b, uint32_t reference) {
+  return a - reference < b - reference;
+}
+
+} // namespace
+
+BeamScheduler::BeamScheduler(uint32_t nowMs) : now(nowMs) {
+  for (auto& level : heads) {
+    for (auto& head : level) head = kNone;
+  }
+  for (int i = BEAM_SCHEDULER_MAX_TIMERS - 1; i >= 0; i--) {
+    timers[i].next = freeList;
+    freeList = static_cast<uint8_t>(i);
+  }
+}
+
+BeamTimerId BeamScheduler::after(uint32_t delayMs, Callback fn, uint32_t nowMs) {
+  return schedule(delayMs, 0, std::move(fn), nowMs);
+}
+
+BeamTimerId BeamScheduler::every(uint32_t periodMs, Callback fn, uint32_t nowMs, uint32_t firstDelayMs) {
+  if (periodMs == 0) return 0;
+  return schedule(firstDelayMs == kNever ? periodMs : firstDelayMs, periodMs, std::move(fn), nowMs);
+}
+
+BeamTimerId BeamScheduler::schedule(uint32_t delayMs, uint32_t periodMs, Callback fn, uint32_t nowMs) {
+  if (!fn) return 0;
+  if (freeList == kNone) {
+    Serial.printf("BeamScheduler: no free timer (max %d)\n", BEAM_SCHEDULER_MAX_TIMERS);
+    return 0;
+  }
+
+  const uint8_t index = freeList;
+  Timer& t = timers[index];
+  freeList = t.next;
+
+  t.fn = std::move(fn);
+  t.period = periodMs;
+  t.deadline = nowMs + delayMs;
+  // Slot `now` has already been expired; the earliest a new timer can run is the next tick
+  if (static_cast<int32_t>(t.deadline - now) <= 0) t.deadline = now + 1;
+  t.armed = true;
+  active++;
+  place(index);
+
+  return (static_cast<uint32_t>(t.generation) << 8) | (index + 1u);
+}
+
+BeamScheduler::Timer* BeamScheduler::lookup(BeamTimerId id) {
+  return const_cast<Timer*>(static_cast<const BeamScheduler*>(this)->lookup(id));
+}
+
+const BeamScheduler::Timer* BeamScheduler::lookup(BeamTimerId id) const {
+  const uint32_t slot = id & 0xFF;
+  if (slot == 0 || slot > BEAM_SCHEDULER_MAX_TIMERS) return nullptr;
+  const Timer& t = timers[slot - 1];
+  if (!t.armed || t.generation != static_cast<uint16_t>(id >> 8)) return nullptr;
+  return &t;
+}
+
+bool BeamScheduler::cancel(BeamTimerId& id) {
+  Timer* t = lookup(id);
+  id = 0;
+  if (!t) return false;
+
+  const uint8_t index = static_cast<uint8_t>(t - timers);
+  if (index == firing) {
+    // Its callback is on the stack; expire() releases it afterwards
+    t->armed = false;
+    return true;
+  }
+  unlink(index);
+  release(index);
+  return true;
+}
+
+bool BeamScheduler::isScheduled(BeamTimerId id) const {
+  return lookup(id) != nullptr;
+}
+
+void BeamScheduler::place(uint8_t index) {
+  Timer& t = timers[index];
+  const uint32_t delta = t.deadline - now;
+  uint32_t key = t.deadline;
+
+  if (delta < (1u << 6)) {
+    t.level = 0;
+  } else if (delta < (1u << 12)) {
+    t.level = 1;
+  } else {
+    t.level = 2;
+    if (delta > kMaxPlacement) key = now + kMaxPlacement;
+  }
+  t.slot = static_cast<uint8_t>((key >> kLevelShift[t.level]) & (kSlots - 1));
+
+  uint8_t& head = heads[t.level][t.slot];
+  t.prev = kNone;
+  t.next = head;
+  if (head != kNone) timers[head].prev = index;
+  head = index;
+  occupied[t.level] |= 1ull << t.slot;
+  t.linked = true;
+}
+
+void BeamScheduler::unlink(uint8_t index) {
+  Timer& t = timers[index];
+  if (!t.linked) return;
+  uint8_t& head = heads[t.level][t.slot];
+  if (t.prev != kNone) {
+    timers[t.prev].next = t.next;
+  } else {
+    head = t.next;
+  }
+  if (t.next != kNone) timers[t.next].prev = t.prev;
+  if (head == kNone) occupied[t.level] &= ~(1ull << t.slot);
+  t.linked = false;
+}
+
+void BeamScheduler::release(uint8_t index) {
+  Timer& t = timers[index];
+  t.fn = nullptr;
+  t.armed = false;
+  t.generation++;
+  t.next = freeList;
+  freeList = index;
+  active--;
+}
+
+void BeamScheduler::cascade(uint8_t level) {
+  const uint8_t slot = static_cast<uint8_t>((now >> kLevelShift[level]) & (kSlots - 1));
+  uint8_t index = heads[level][slot];
+  heads[level][slot] = kNone;
+  occupied[level] &= ~(1ull << slot);
+  while (index != kNone) {
+    const uint8_t next = timers[index].next;
+    timers[index].linked = false;
+    place(index);
+    index = next;
+  }
+}
+
+size_t BeamScheduler::expire(uint32_t nowMs) {
+  const uint8_t slot = static_cast<uint8_t>(now & (kSlots - 1));
+  size_t ran = 0;
+
+  // Every timer in this slot is due now; anything scheduled meanwhile lands in a later slot
+  while (heads[0][slot] != kNone) {
+    const uint8_t index = heads[0][slot];
+    Timer& t = timers[index];
+    unlink(index);
+    ran++;
+
+    if (t.period == 0) {
+      Callback fn = std::move(t.fn);
+      release(index);
+      fn();
+      continue;
+    }
+
+    firing = index;
+    t.fn();
+    firing = kNone;
+    if (!t.armed) {
+      release(index);
+      continue;
+    }
+    t.deadline += t.period;
+    if (static_cast<int32_t>(t.deadline - nowMs) <= 0) {
+      // run() was late: skip the periods missed entirely, keeping the phase
+      t.deadline += ((nowMs - t.deadline) / t.period + 1) * t.period;
+    }
+    place(index);
+  }
+  return ran;
+}
+
+bool BeamScheduler::nextEvent(uint32_t& tick) const {
+  bool found = false;
+  // Level 0: the next non-empty 1 ms slot is an expiry
+  if (uint64_t bits = rotateRight(occupied[0], now + 1)) {
+    tick = now + 1 + lowestBit(bits);
+    found = true;
+  }
+  // Levels 1 and 2: the next non-empty slot boundary is a cascade
+  for (uint8_t level = 1; level < kLevels; level++) {
+    const uint32_t base = (now >> kLevelShift[level]) + 1;
+    if (uint64_t bits = rotateRight(occupied[level], base)) {
+      const uint32_t boundary = (base + lowestBit(bits)) << kLevelShift[level];
+      if (!found || earlier(boundary, tick, now)) tick = boundary;
+      found = true;
+    }
+  }
+  return found;
+}
+
+uint32_t BeamScheduler::earliestIn(uint8_t level, uint8_t slot) const {
+  uint8_t index = heads[level][slot];
+  uint32_t best = timers[index].deadline;
+  for (index = timers[index].next; index != kNone; index = timers[index].next) {
+    if (earlier(timers[index].deadline, best, now)) best = timers[index].deadline;
+  }
+  return best;
+}
+
+size_t BeamScheduler::run(uint32_t nowMs) {
+  size_t ran = 0;
+  while (static_cast<int32_t>(nowMs - now) > 0) {
+    uint32_t tick;
+    if (!nextEvent(tick) || static_cast<int32_t>(tick - nowMs) > 0) {
+      now = nowMs; // nothing due in between: jump
+      break;
+    }
+    now = tick;
+    if ((now & ((1u << 12) - 1)) == 0) cascade(2);
+    if ((now & ((1u << 6) - 1)) == 0) cascade(1);
+    ran += expire(nowMs);
+  }
+  return ran;
+}
+
+uint32_t BeamScheduler::msUntilNext(uint32_t nowMs) const {
+  if (active == 0) return kNever;
+
+  bool found = false;
+  uint32_t deadline = 0;
+  // The nearest non-empty slot of each level holds that level's earliest deadline
+  if (uint64_t bits = rotateRight(occupied[0], now + 1)) {
+    deadline = now + 1 + lowestBit(bits);
+    found = true;
+  }
+  for (uint8_t level = 1; level < kLevels; level++) {
+    const uint32_t base = (now >> kLevelShift[level]) + 1;
+    if (uint64_t bits = rotateRight(occupied[level], base)) {
+      const uint8_t slot = static_cast<uint8_t>((base + lowestBit(bits)) & (kSlots - 1));
+      const uint32_t candidate = earliestIn(level, slot);
+      if (!found || earlier(candidate, deadline, now)) deadline = candidate;
+      found = true;
+    }
+  }
+  if (!found) return 0; // only a periodic timer whose callback is running
+
+  const int32_t remaining = static_cast<int32_t>(deadline - nowMs);
+  return remaining > 0 ? static_cast<uint32_t>(remaining) : 0;
+}
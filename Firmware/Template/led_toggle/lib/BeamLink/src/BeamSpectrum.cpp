@@ -0,0 +1,243 @@
+#include "BeamSpectrum.h"
+#include "BeamPlatform.h"
+#include <cmath>
+#include <utility>
+
+static_assert(BEAM_FFT_MAX_SIZE >= BEAM_FFT_MIN_SIZE && (BEAM_FFT_MAX_SIZE & (BEAM_FFT_MAX_SIZE - 1)) == 0,
+              "BEAM_FFT_MAX_SIZE must be a power of two, at least BEAM_FFT_MIN_SIZE");
+
+namespace {
+
+constexpr size_t kQuarter = BEAM_FFT_MAX_SIZE / 4;
+constexpr double kPi = 3.14159265358979323846;
+
+// Taylor series: accurate to double precision on [0, pi/2]
+constexpr double constexprSin(double x) {
+  double term = x, sum = x;
+  for (int i = 1; i < 14; i++) {
+    term *= -x * x / ((2 * i) * (2 * i + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+// sin(2 pi k / BEAM_FFT_MAX_SIZE) for the first quarter wave. Built by the
+// compiler and const, so it is placed in flash (.rodata) on the ESP32.
+struct SineTable {
+  float v[kQuarter + 1];
+  constexpr SineTable() : v() {
+    for (size_t k = 0; k <= kQuarter; k++) v[k] = static_cast<float>(constexprSin(2 * kPi * k / BEAM_FFT_MAX_SIZE));
+  }
+};
+constexpr SineTable kSine{};
+
+struct Twiddle {
+  float c, s;  ///< W = c - i s = exp(-2 pi i k / BEAM_FFT_MAX_SIZE)
+};
+
+// k from 0 to BEAM_FFT_MAX_SIZE / 2 (angle 0 to pi)
+inline Twiddle twiddle(size_t k) {
+  if (k <= kQuarter) return {kSine.v[kQuarter - k], kSine.v[k]};
+  return {-kSine.v[k - kQuarter], kSine.v[2 * kQuarter - k]};
+}
+
+// (re, im) x (c - i s)
+inline void rotate(float re, float im, Twiddle w, float& outRe, float& outIm) {
+  outRe = re * w.c + im * w.s;
+  outIm = im * w.c - re * w.s;
+}
+
+inline float hann(size_t i, size_t n) {
+  const size_t k = i <= n / 2 ? i : n - i;
+  return 0.5f - 0.5f * twiddle(k * (BEAM_FFT_MAX_SIZE / n)).c;
+}
+
+} // namespace
+
+// ============================================================================
+// Complex FFT
+// ============================================================================
+
+bool beamFftComplex(float* data, size_t points) {
+  if (points == 0 || (points & (points - 1)) || points > BEAM_FFT_MAX_SIZE / 2) return false;
+
+  // Bit-reversed order, so every pass below works in place
+  for (size_t i = 1, j = 0; i < points; i++) {
+    size_t bit = points >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) {
+      std::swap(data[2 * i], data[2 * j]);
+      std::swap(data[2 * i + 1], data[2 * j + 1]);
+    }
+  }
+
+  size_t stages = 0;
+  while ((size_t(1) << stages) < points) stages++;
+
+  // An odd number of radix-2 stages: do the first one alone (twiddle 1)
+  size_t span = 1;
+  if (stages & 1) {
+    for (size_t k = 0; k < 2 * points; k += 4) {
+      const float re = data[k + 2], im = data[k + 3];
+      data[k + 2] = data[k] - re;
+      data[k + 3] = data[k + 1] - im;
+      data[k] += re;
+      data[k + 1] += im;
+    }
+    span = 2;
+  }
+
+  // Radix-4 passes: two radix-2 stages (span and 2 x span) per pass over
+  // the data, 3 complex multiplies per 4 points instead of 4
+  for (; span < points; span *= 4) {
+    const size_t step = BEAM_FFT_MAX_SIZE / (4 * span);
+    for (size_t j = 0; j < span; j++) {
+      const Twiddle w1 = twiddle(j * step);
+      const Twiddle w2 = twiddle(2 * j * step);
+      for (size_t k = j; k < points; k += 4 * span) {
+        float* a0 = data + 2 * k;
+        float* a1 = data + 2 * (k + span);
+        float* a2 = data + 2 * (k + 2 * span);
+        float* a3 = data + 2 * (k + 3 * span);
+
+        // First stage: pairs (a0, a1) and (a2, a3), twiddle w2
+        float tRe, tIm;
+        rotate(a1[0], a1[1], w2, tRe, tIm);
+        const float b0Re = a0[0] + tRe, b0Im = a0[1] + tIm;
+        const float b1Re = a0[0] - tRe, b1Im = a0[1] - tIm;
+        rotate(a3[0], a3[1], w2, tRe, tIm);
+        const float b2Re = a2[0] + tRe, b2Im = a2[1] + tIm;
+        const float b3Re = a2[0] - tRe, b3Im = a2[1] - tIm;
+
+        // Second stage: pairs (b0, b2) with w1 and (b1, b3) with w1 x -i
+        rotate(b2Re, b2Im, w1, tRe, tIm);
+        a0[0] = b0Re + tRe;
+        a0[1] = b0Im + tIm;
+        a2[0] = b0Re - tRe;
+        a2[1] = b0Im - tIm;
+        rotate(b3Re, b3Im, w1, tRe, tIm);
+        a1[0] = b1Re + tIm;
+        a1[1] = b1Im - tRe;
+        a3[0] = b1Re - tIm;
+        a3[1] = b1Im + tRe;
+      }
+    }
+  }
+  return true;
+}
+
+// ============================================================================
+// Spectrum
+// ============================================================================
+
+bool BeamSpectrum::begin(const Config& config) {
+  n = 0;
+  const size_t size = config.size;
+  if (size < BEAM_FFT_MIN_SIZE || size > BEAM_FFT_MAX_SIZE || (size & (size - 1))) {
+    Serial.printf("BeamSpectrum: size %u must be a power of two from %u to %u\n", static_cast<unsigned>(size),
+                  static_cast<unsigned>(BEAM_FFT_MIN_SIZE), static_cast<unsigned>(BEAM_FFT_MAX_SIZE));
+    return false;
+  }
+  if (!(config.rateHz > 0) || config.bands == 0 || config.bands > BEAM_SPECTRUM_MAX_BANDS) {
+    Serial.printf("BeamSpectrum: invalid rate or band count %u\n", config.bands);
+    return false;
+  }
+  for (size_t b = 0; b <= config.bands; b++) {
+    edges[b] = config.bandEdgesHz ? config.bandEdgesHz[b] : config.rateHz / 2 * b / config.bands;
+    if (edges[b] < 0 || (b > 0 && !(edges[b] > edges[b - 1]))) {
+      Serial.printf("BeamSpectrum: band edges must ascend from 0 Hz or more\n");
+      return false;
+    }
+  }
+  cfg = config;
+  cfg.bandEdgesHz = nullptr;  // copied into edges
+  n = size;
+  result = BeamSpectrumFeatures{};
+  return true;
+}
+
+bool BeamSpectrum::analyze(const uint16_t* samples, size_t count) { return run(samples, count); }
+bool BeamSpectrum::analyze(const int16_t* samples, size_t count) { return run(samples, count); }
+bool BeamSpectrum::analyze(const float* samples, size_t count) { return run(samples, count); }
+
+template <typename T>
+bool BeamSpectrum::run(const T* samples, size_t count) {
+  if (n == 0 || count < n) return false;
+
+  // Mean, then the centred and windowed block
+  float sum = 0;
+  for (size_t i = 0; i < n; i++) sum += static_cast<float>(samples[i]);
+  const float mean = sum / n;
+
+  float sumSq = 0, windowSum = 0, windowSq = 0;
+  for (size_t i = 0; i < n; i++) {
+    const float x = static_cast<float>(samples[i]) - mean;
+    const float w = cfg.window == kBeamWindowHann ? hann(i, n) : 1.0f;
+    sumSq += x * x;
+    windowSum += w;
+    windowSq += w * w;
+    work[i] = x * w;
+  }
+
+  // Even samples as real parts, odd ones as imaginary: an N/2-point FFT
+  const size_t half = n / 2;
+  beamFftComplex(work, half);
+
+  // Split into the N-point real spectrum: X[k] = E[k] + W^k O[k], k = 0 .. N/2
+  const size_t step = BEAM_FFT_MAX_SIZE / n;
+  for (size_t k = 0; k <= half; k++) {
+    const size_t a = k % half, b = (half - k) % half;
+    const float zRe = work[2 * a], zIm = work[2 * a + 1];
+    const float cRe = work[2 * b], cIm = -work[2 * b + 1];  // conj(Z[N/2 - k])
+    const float eRe = 0.5f * (zRe + cRe), eIm = 0.5f * (zIm + cIm);
+    const float oRe = 0.5f * (zIm - cIm), oIm = -0.5f * (zRe - cRe);
+    float tRe, tIm;
+    rotate(oRe, oIm, twiddle(k * step), tRe, tIm);
+    const float xRe = eRe + tRe, xIm = eIm + tIm;
+    mag[k] = xRe * xRe + xIm * xIm;  // power for now
+  }
+
+  BeamSpectrumFeatures f;
+  f.samples = static_cast<uint32_t>(n);
+  f.mean = mean;
+  f.rms = std::sqrt(sumSq / n);
+  f.bands = cfg.bands;
+
+  // Parseval: sum of |X|^2 = N x sum of (x w)^2; one-sided bins count twice
+  const float energyScale = 1.0f / (static_cast<float>(n) * windowSq);
+  const float hz = binHz();
+  size_t band = 0;
+  size_t peak = 1;
+  for (size_t k = 0; k <= half; k++) {
+    const bool twoSided = k != 0 && k != half;
+    const float power = mag[k];
+    const float f0 = k * hz;
+    // Bands are [low, high), the last one [low, high]
+    while (band + 1 < cfg.bands && f0 >= edges[band + 1]) band++;
+    const bool last = band + 1 == cfg.bands;
+    if (f0 >= edges[band] && (f0 < edges[band + 1] || (last && f0 == edges[band + 1]))) {
+      f.bandEnergy[band] += power * energyScale * (twoSided ? 2 : 1);
+    }
+
+    mag[k] = std::sqrt(power) * (twoSided ? 2 : 1) / windowSum;
+    if (k > 0 && mag[k] > mag[peak]) peak = k;
+  }
+
+  // Parabola through the log magnitudes of the peak bin and its neighbours:
+  // a window's main lobe is close to a Gaussian, so this is far more
+  // accurate than a parabola through the magnitudes themselves
+  float offset = 0;
+  f.peakAmplitude = mag[peak];
+  if (peak < half && mag[peak - 1] > 0 && mag[peak + 1] > 0) {
+    const float left = std::log(mag[peak - 1]), mid = std::log(mag[peak]), right = std::log(mag[peak + 1]);
+    const float denom = left - 2 * mid + right;
+    if (denom < 0) {
+      offset = 0.5f * (left - right) / denom;
+      f.peakAmplitude = std::exp(mid - 0.25f * (left - right) * offset);
+    }
+  }
+  f.peakHz = (peak + offset) * hz;
+  result = f;
+  return true;
+}
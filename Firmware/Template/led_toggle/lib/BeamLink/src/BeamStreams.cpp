@@ -0,0 +1,74 @@
+#include "BeamStreams.h"
+#include "BeamStaticConfig.h"
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+bool sameUuid(const char* a, const char* b) {
+  for (size_t i = 0; i < 36; i++) {
+    if (tolower(static_cast<unsigned char>(a[i])) != tolower(static_cast<unsigned char>(b[i]))) return false;
+  }
+  return true;
+}
+
+} // namespace
+
+BeamStreamId BeamStreams::add(const char* name, const char* uuid, uint8_t properties, BeamStreamHandler handler) {
+  const uint8_t known = BEAM_STREAM_NOTIFY | BEAM_STREAM_WRITE | BEAM_STREAM_READ;
+  if (count >= BEAM_MAX_STREAMS || !name || !*name || !beamcfg::isUuid128(uuid)) return kBeamNoStream;
+  if (properties == 0 || (properties & ~known)) return kBeamNoStream;
+  if ((properties & BEAM_STREAM_WRITE) && !handler) return kBeamNoStream;
+  for (uint8_t i = 0; i < count; i++) {
+    if (strcmp(streams[i].name, name) == 0 || sameUuid(streams[i].uuid, uuid)) return kBeamNoStream;
+  }
+
+  BeamStream& s = streams[count];
+  s.name = name;
+  memcpy(s.uuid, uuid, 36);
+  s.uuid[36] = '\0';
+  s.properties = properties;
+  s.handler = std::move(handler);
+  counters[count] = BeamStreamStats{};
+  return count++;
+}
+
+BeamStreamId BeamStreams::find(const char* nameOrUuid) const {
+  if (!nameOrUuid) return kBeamNoStream;
+  const bool uuid = beamcfg::isUuid128(nameOrUuid);
+  for (uint8_t i = 0; i < count; i++) {
+    if (uuid ? sameUuid(streams[i].uuid, nameOrUuid) : strcmp(streams[i].name, nameOrUuid) == 0) return i;
+  }
+  return kBeamNoStream;
+}
+
+void BeamStreams::setSubscribed(BeamStreamId id, bool on) {
+  if (id >= count) return;
+  if (on) {
+    subscribed.fetch_or(1u << id, std::memory_order_relaxed);
+  } else {
+    subscribed.fetch_and(~(1u << id), std::memory_order_relaxed);
+  }
+}
+
+void BeamStreams::countSent(BeamStreamId id, bool truncated) {
+  if (id >= count) return;
+  counters[id].sent++;
+  if (truncated) counters[id].truncated++;
+}
+
+void BeamStreams::countSkipped(BeamStreamId id) {
+  if (id < count) counters[id].skipped++;
+}
+
+void BeamStreams::countReceived(BeamStreamId id) {
+  if (id < count) counters[id].received++;
+}
+
+BeamStreamStats BeamStreams::stats(BeamStreamId id) const {
+  return id < count ? counters[id] : BeamStreamStats{};
+}
+
+void BeamStreams::resetStats() {
+  for (uint8_t i = 0; i < count; i++) counters[i] = BeamStreamStats{};
+}
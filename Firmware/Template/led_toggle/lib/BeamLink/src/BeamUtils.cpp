@@ -1,6 +1,7 @@
 #include "BeamUtils.h"
 #include <algorithm>
 #include <cctype>
+#include <cstdlib>
 #include <sstream>
 
 namespace BeamUtils {
@@ -121,5 +122,74 @@ std::string formatUptime(unsigned long uptimeMs) {
   return result;
 }
 
+std::string_view trimView(std::string_view str) {
+  size_t first = str.find_first_not_of(" \t\n\r");
+  if (first == std::string_view::npos) return std::string_view();
+  size_t last = str.find_last_not_of(" \t\n\r");
+  return str.substr(first, last - first + 1);
+}
+
+bool nextLine(std::string_view& text, std::string_view& line) {
+  if (text.empty()) return false;
+  size_t end = text.find('\n');
+  line = text.substr(0, end);
+  text = (end == std::string_view::npos) ? std::string_view() : text.substr(end + 1);
+  if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+  return true;
+}
+
+bool splitPair(std::string_view str, char separator, std::string_view& key, std::string_view& value) {
+  size_t pos = str.find(separator);
+  if (pos == std::string_view::npos) return false;
+  key = trimView(str.substr(0, pos));
+  value = trimView(str.substr(pos + 1));
+  return !key.empty();
+}
+
+bool parseInt(std::string_view str, int32_t& out) {
+  str = trimView(str);
+  bool negative = !str.empty() && str.front() == '-';
+  if (!str.empty() && (str.front() == '-' || str.front() == '+')) str.remove_prefix(1);
+  if (str.empty()) return false;
+
+  int64_t value = 0;
+  for (char c : str) {
+    if (c < '0' || c > '9') return false;
+    value = value * 10 + (c - '0');
+    if (value > static_cast<int64_t>(INT32_MAX) + 1) return false;
+  }
+  if (negative) value = -value;
+  if (value > INT32_MAX || value < INT32_MIN) return false;
+  out = static_cast<int32_t>(value);
+  return true;
+}
+
+bool parseFloat(std::string_view str, float& out) {
+  str = trimView(str);
+  char buffer[32];
+  if (str.empty() || str.size() >= sizeof(buffer)) return false;
+  str.copy(buffer, str.size());
+  buffer[str.size()] = '\0';
+  char* end = nullptr;
+  float value = strtof(buffer, &end);
+  if (end != buffer + str.size()) return false;
+  out = value;
+  return true;
+}
+
+bool parseBool(std::string_view str, bool& out) {
+  str = trimView(str);
+  auto is = [str](const char* word) {
+    size_t i = 0;
+    for (; word[i]; i++) {
+      if (i >= str.size() || tolower(static_cast<unsigned char>(str[i])) != word[i]) return false;
+    }
+    return i == str.size();
+  };
+  if (is("true") || is("1") || is("yes") || is("on")) { out = true; return true; }
+  if (is("false") || is("0") || is("no") || is("off")) { out = false; return true; }
+  return false;
+}
+
 } // namespace BeamUtils
 
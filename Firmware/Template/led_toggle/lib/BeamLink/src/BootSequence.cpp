@@ -0,0 +1,173 @@
+#include "BootSequence.h"
+#include <algorithm>
+#include <cstring>
+
+// ---- BootTimeline ----
+
+bool BootTimeline::mark(const char* phase) {
+  const uint32_t now = micros();
+  const size_t i = count.fetch_add(1, std::memory_order_relaxed);
+  if (i >= BOOT_MAX_MARKERS) {
+    count.store(BOOT_MAX_MARKERS, std::memory_order_relaxed);
+    return false;
+  }
+  markers[i] = Marker{phase, now};
+  return true;
+}
+
+size_t BootTimeline::size() const {
+  return std::min<size_t>(count.load(std::memory_order_acquire), BOOT_MAX_MARKERS);
+}
+
+const char* BootTimeline::name(size_t i) const {
+  return i < size() ? markers[i].name : nullptr;
+}
+
+uint32_t BootTimeline::at(size_t i) const {
+  return i < size() ? markers[i].micros : 0;
+}
+
+uint32_t BootTimeline::at(const char* phase) const {
+  for (size_t i = 0; i < size(); i++) {
+    if (markers[i].name && strcmp(markers[i].name, phase) == 0) return markers[i].micros;
+  }
+  return 0;
+}
+
+bool BootTimeline::report() {
+  if (reported) return false;
+  reported = true;
+
+  // Markers from parallel tasks may be out of order
+  Marker sorted[BOOT_MAX_MARKERS];
+  const size_t n = size();
+  std::copy(markers, markers + n, sorted);
+  std::sort(sorted, sorted + n, [](const Marker& a, const Marker& b) { return a.micros < b.micros; });
+
+  Serial.println("Boot timeline (us since reset):");
+  uint32_t previous = 0;
+  for (size_t i = 0; i < n; i++) {
+    Serial.printf("  %-16s %9lu  (+%lu)\n", sorted[i].name, (unsigned long)sorted[i].micros,
+                  (unsigned long)(sorted[i].micros - previous));
+    previous = sorted[i].micros;
+  }
+  return true;
+}
+
+// ---- BootSequencer ----
+
+bool BootSequencer::then(uint32_t delayMs, Step step) {
+  if (running || count >= BOOT_MAX_STEPS) return false;
+  steps[count++] = Entry{delayMs, std::move(step)};
+  return true;
+}
+
+void BootSequencer::start(uint32_t nowMs) {
+  next = 0;
+  lastMs = nowMs;
+  running = true;
+}
+
+bool BootSequencer::update(uint32_t nowMs) {
+  if (!running) return !isFinished();
+  // Catch up if loop() was late, keeping the spacing between steps
+  while (next < count && nowMs - lastMs >= steps[next].delayMs) {
+    lastMs += steps[next].delayMs;
+    if (steps[next].step) steps[next].step();
+    next++;
+  }
+  return !isFinished();
+}
+
+uint32_t BootSequencer::msUntilNext(uint32_t nowMs) const {
+  if (!running || isFinished()) return UINT32_MAX;
+  const uint32_t elapsed = nowMs - lastMs;
+  return elapsed >= steps[next].delayMs ? 0 : steps[next].delayMs - elapsed;
+}
+
+// ---- BootTask ----
+
+BootTask::~BootTask() {
+  wait();
+#if defined(ARDUINO) && defined(ESP32)
+  if (finished) vSemaphoreDelete(finished);
+#endif
+}
+
+#if defined(ARDUINO) && defined(ESP32)
+
+void BootTask::entry(void* arg) {
+  BootTask* self = static_cast<BootTask*>(arg);
+  self->fn();
+  // Last access to self: the waiter may destroy the BootTask right after
+  xSemaphoreGive(self->finished);
+  vTaskDelete(nullptr);
+}
+
+bool BootTask::start(const char* name, std::function<void()> work, uint32_t stackBytes) {
+  if (!isDone()) return false;
+  fn = std::move(work);
+  if (!finished) finished = xSemaphoreCreateBinary();
+  done.store(false, std::memory_order_relaxed);
+
+#if CONFIG_FREERTOS_UNICORE
+  const BaseType_t core = tskNO_AFFINITY;
+#else
+  const BaseType_t core = xPortGetCoreID() == 0 ? 1 : 0;
+#endif
+  if (!finished || xTaskCreatePinnedToCore(entry, name, stackBytes, this, uxTaskPriorityGet(nullptr),
+                                           nullptr, core) != pdPASS) {
+    Serial.printf("BootTask: could not start %s, running inline\n", name);
+    fn();
+    done.store(true, std::memory_order_release);
+    return false;
+  }
+  return true;
+}
+
+bool BootTask::wait(uint32_t timeoutMs) {
+  if (done.load(std::memory_order_acquire)) return true;
+  const TickType_t ticks = (timeoutMs == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+  if (xSemaphoreTake(finished, ticks) != pdTRUE) return false;
+  done.store(true, std::memory_order_release);
+  return true;
+}
+
+bool BootTask::isDone() const {
+  if (done.load(std::memory_order_acquire)) return true;
+  if (xSemaphoreTake(finished, 0) != pdTRUE) return false;
+  done.store(true, std::memory_order_release);
+  return true;
+}
+
+#else
+
+bool BootTask::start(const char* name, std::function<void()> work, uint32_t stackBytes) {
+  (void)name;
+  (void)stackBytes;
+  if (!isDone()) return false;
+  if (thread.joinable()) thread.join();
+  fn = std::move(work);
+  done.store(false, std::memory_order_relaxed);
+  thread = std::thread([this] {
+    fn();
+    done.store(true, std::memory_order_release);
+  });
+  return true;
+}
+
+bool BootTask::isDone() const {
+  return done.load(std::memory_order_acquire);
+}
+
+bool BootTask::wait(uint32_t timeoutMs) {
+  const uint32_t start = millis();
+  while (!isDone()) {
+    if (timeoutMs != UINT32_MAX && millis() - start >= timeoutMs) return false;
+    delay(1);
+  }
+  if (thread.joinable()) thread.join();
+  return true;
+}
+
+#endif
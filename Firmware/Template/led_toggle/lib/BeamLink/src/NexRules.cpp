@@ -0,0 +1,273 @@
+#include "NexRules.h"
+#include "BeamUtils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace nexstate {
+
+namespace {
+
+using BeamUtils::trimView;
+
+bool fail(std::string* error, const char* reason) {
+  if (error) *error = reason;
+  return false;
+}
+
+/// Parses true/false or a number; integers without '.' or exponent are Int
+bool parseLiteral(std::string_view s, double& value, RecordType& type) {
+  if (s == "true" || s == "false") {
+    value = (s == "true") ? 1 : 0;
+    type = RecordType::Bool;
+    return true;
+  }
+  char buffer[32];
+  if (s.empty() || s.size() >= sizeof(buffer)) return false;
+  std::copy(s.begin(), s.end(), buffer);
+  buffer[s.size()] = '\0';
+  char* end = nullptr;
+  value = strtod(buffer, &end);
+  if (end != buffer + s.size()) return false;
+  type = (s.find_first_of(".eE") == std::string_view::npos) ? RecordType::Int : RecordType::Float;
+  return true;
+}
+
+bool parseCondition(std::string_view s, RuleCondition& out) {
+  size_t pos = s.find_first_of("<>=!");
+  if (pos == std::string_view::npos || pos == 0) return false;
+  bool withEquals = pos + 1 < s.size() && s[pos + 1] == '=';
+  switch (s[pos]) {
+    case '<': out.op = withEquals ? RuleOp::LessEqual : RuleOp::Less; break;
+    case '>': out.op = withEquals ? RuleOp::GreaterEqual : RuleOp::Greater; break;
+    case '=': if (!withEquals) return false; out.op = RuleOp::Equal; break;
+    default:  if (!withEquals) return false; out.op = RuleOp::NotEqual; break;
+  }
+  std::string_view key = trimView(s.substr(0, pos));
+  RecordType ignored;
+  if (key.empty() || !parseLiteral(trimView(s.substr(pos + (withEquals ? 2 : 1))), out.operand, ignored)) {
+    return false;
+  }
+  out.key = SmallString(key);
+  return true;
+}
+
+const char* opText(RuleOp op) {
+  static const char* const kText[] = {"<", "<=", ">", ">=", "==", "!="};
+  return kText[static_cast<uint8_t>(op)];
+}
+
+} // namespace
+
+bool RuleCondition::matches(double value) const {
+  switch (op) {
+    case RuleOp::Less:         return value < operand;
+    case RuleOp::LessEqual:    return value <= operand;
+    case RuleOp::Greater:      return value > operand;
+    case RuleOp::GreaterEqual: return value >= operand;
+    case RuleOp::Equal:        return value == operand;
+    case RuleOp::NotEqual:     return value != operand;
+  }
+  return false;
+}
+
+bool RuleEngine::compile(std::string_view text, Rule& out, std::string* error) {
+  out = Rule{};
+  size_t arrow = text.find("=>");
+  if (arrow == std::string_view::npos) return fail(error, "missing =>");
+
+  // Conditions, joined with &&
+  std::string_view conditions = text.substr(0, arrow);
+  while (true) {
+    size_t split = conditions.find("&&");
+    if (out.conditionCount >= NEXRULES_MAX_CONDITIONS) return fail(error, "too many conditions");
+    if (!parseCondition(trimView(conditions.substr(0, split)), out.conditions[out.conditionCount])) {
+      return fail(error, "bad condition");
+    }
+    out.conditionCount++;
+    if (split == std::string_view::npos) break;
+    conditions.remove_prefix(split + 2);
+  }
+
+  // Action: notify:<text> or key = value
+  std::string_view action = trimView(text.substr(arrow + 2));
+  if (action.substr(0, 7) == "notify:") {
+    std::string_view message = trimView(action.substr(7));
+    if (message.empty()) return fail(error, "empty notification");
+    out.action = Rule::Action::Notify;
+    out.target = SmallString(message);
+  } else {
+    size_t eq = action.find('=');
+    if (eq == std::string_view::npos) return fail(error, "bad action");
+    std::string_view key = trimView(action.substr(0, eq));
+    if (key.empty() || !parseLiteral(trimView(action.substr(eq + 1)), out.value, out.valueType)) {
+      return fail(error, "bad action");
+    }
+    out.action = Rule::Action::SetKey;
+    out.target = SmallString(key);
+  }
+  out.used = true;
+  return true;
+}
+
+void RuleEngine::begin(NexState& store) {
+  this->store = &store;
+  store.onAnyChange([this](std::string_view key) { onKeyChanged(key); });
+}
+
+int RuleEngine::addRule(std::string_view text, std::string* error) {
+  if (!store) {
+    fail(error, "not started");
+    return -1;
+  }
+  Rule compiled;
+  if (!compile(text, compiled, error)) return -1;
+
+  for (int id = 0; id < NEXRULES_MAX_RULES; id++) {
+    if (!rules[id].used) {
+      rules[id] = compiled;
+      rebuildIndex();
+      evaluate(rules[id]);
+      return id;
+    }
+  }
+  fail(error, "rule table full");
+  return -1;
+}
+
+bool RuleEngine::removeRule(int id) {
+  if (id < 0 || id >= NEXRULES_MAX_RULES || !rules[id].used) return false;
+  rules[id] = Rule{};
+  rebuildIndex();
+  return true;
+}
+
+void RuleEngine::clear() {
+  for (auto& rule : rules) rule = Rule{};
+  index.clear();
+}
+
+size_t RuleEngine::size() const {
+  return static_cast<size_t>(std::count_if(std::begin(rules), std::end(rules),
+                                           [](const Rule& rule) { return rule.used; }));
+}
+
+std::string RuleEngine::describe(int id) const {
+  if (id < 0 || id >= NEXRULES_MAX_RULES || !rules[id].used) return std::string();
+  const Rule& rule = rules[id];
+  std::string text;
+  char number[24];
+  for (uint8_t i = 0; i < rule.conditionCount; i++) {
+    if (i) text += " && ";
+    snprintf(number, sizeof(number), "%g", rule.conditions[i].operand);
+    text += rule.conditions[i].key.str() + " " + opText(rule.conditions[i].op) + " " + number;
+  }
+  if (rule.action == Rule::Action::Notify) {
+    return text + " => notify:" + rule.target.str();
+  }
+  if (rule.valueType == RecordType::Bool) {
+    snprintf(number, sizeof(number), "%s", rule.value != 0 ? "true" : "false");
+  } else {
+    snprintf(number, sizeof(number), "%g", rule.value);
+  }
+  return text + " => " + rule.target.str() + " = " + number;
+}
+
+void RuleEngine::rebuildIndex() {
+  index.clear();
+  for (uint8_t id = 0; id < NEXRULES_MAX_RULES; id++) {
+    for (uint8_t i = 0; rules[id].used && i < rules[id].conditionCount; i++) {
+      index.push_back(IndexEntry{rules[id].conditions[i].key, id});
+    }
+  }
+  std::sort(index.begin(), index.end(), [](const IndexEntry& a, const IndexEntry& b) {
+    return a.key.view() < b.key.view() || (a.key == b.key && a.rule < b.rule);
+  });
+  // A rule reading the same key twice only needs one entry
+  index.erase(std::unique(index.begin(), index.end(), [](const IndexEntry& a, const IndexEntry& b) {
+    return a.key == b.key && a.rule == b.rule;
+  }), index.end());
+}
+
+void RuleEngine::onKeyChanged(std::string_view key) {
+  auto it = std::lower_bound(index.begin(), index.end(), key,
+      [](const IndexEntry& entry, std::string_view k) { return entry.key.view() < k; });
+  if (it == index.end() || it->key.view() != key) return;
+
+  // Actions may set keys that trigger further rules; stop runaway chains
+  if (depth >= kMaxCascadeDepth) return;
+  depth++;
+  for (size_t i = static_cast<size_t>(it - index.begin()); i < index.size() && index[i].key.view() == key; i++) {
+    evaluate(rules[index[i].rule]);
+  }
+  depth--;
+}
+
+void RuleEngine::evaluate(Rule& rule) {
+  evaluations++;
+  bool result = true;
+  for (uint8_t i = 0; i < rule.conditionCount && result; i++) {
+    double value;
+    result = store->getNumeric(rule.conditions[i].key.view(), value) && rule.conditions[i].matches(value);
+  }
+
+  const bool rising = result && !rule.active;
+  rule.active = result;
+  if (!rising) return;
+
+  if (rule.action == Rule::Action::Notify) {
+    notify(rule.target.view());
+  } else {
+    store->setNumeric(rule.target.view(), rule.value, rule.valueType);
+  }
+}
+
+void RuleEngine::notify(std::string_view message) {
+  if (notifyFn) notifyFn(message);
+}
+
+bool RuleEngine::post(std::string_view command) {
+  CommandText cmd;
+  if (command.size() > NEXRULES_MAX_TEXT_LENGTH) return false;
+  std::copy(command.begin(), command.end(), cmd.text);
+  cmd.text[command.size()] = '\0';
+  return commands.push(cmd);
+}
+
+void RuleEngine::update() {
+  CommandText cmd;
+  while (commands.pop(cmd)) {
+    handleCommand(cmd.text);
+  }
+}
+
+bool RuleEngine::handleCommand(std::string_view command) {
+  if (command.substr(0, 5) != "rule:") return false;
+  std::string_view args = command.substr(5);
+
+  if (args.substr(0, 4) == "add:") {
+    std::string error;
+    int id = addRule(args.substr(4), &error);
+    notify(id >= 0 ? "RULE " + std::to_string(id) + " OK" : "RULE ERR " + error);
+  } else if (args.substr(0, 4) == "del:") {
+    int32_t id;
+    if (!BeamUtils::parseInt(args.substr(4), id)) {
+      notify("RULE ERR invalid id");
+    } else {
+      notify(removeRule(id) ? "RULE " + std::to_string(id) + " DELETED" : std::string("RULE ERR unknown id"));
+    }
+  } else if (args == "clear") {
+    clear();
+    notify("RULES CLEARED");
+  } else if (args == "list") {
+    for (int id = 0; id < NEXRULES_MAX_RULES; id++) {
+      if (rules[id].used) notify(std::to_string(id) + ": " + describe(id));
+    }
+    notify("RULES " + std::to_string(size()));
+  } else {
+    notify("RULE ERR unknown command");
+  }
+  return true;
+}
+
+} // namespace nexstate
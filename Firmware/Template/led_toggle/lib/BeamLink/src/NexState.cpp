@@ -1,5 +1,7 @@
 #include "NexState.h"
-#include <Arduino.h>
+#include "BeamScheduler.h"
+#include <algorithm>
+#include <cmath>
 
 namespace nexstate {
 
@@ -10,6 +12,309 @@ NexState::NexState(const NexStateConfig& config) : config(config) {
     lastOutputTime = millis();
 }
 
+size_t NexState::lowerBound(std::string_view key) const {
+    auto it = std::lower_bound(entries.begin(), entries.end(), key,
+        [](const Entry& entry, std::string_view k) { return entry.key.view() < k; });
+    return static_cast<size_t>(it - entries.begin());
+}
+
+const NexState::Entry* NexState::find(std::string_view key) const {
+    size_t pos = lowerBound(key);
+    if (pos < entries.size() && entries[pos].key.view() == key) {
+        return &entries[pos];
+    }
+    return nullptr;
+}
+
+std::vector<std::string> NexState::getChangedKeys() const {
+    std::vector<std::string> changed;
+    for (const auto& entry : entries) {
+        // Check each possible type for changes
+        if (std::visit([](const auto& value) { return value.hasChanged(); }, entry.value)) {
+            changed.push_back(entry.key.str());
+        }
+    }
+    return changed;
+}
+
+bool NexState::hasAnyChanged() const {
+    for (const auto& entry : entries) {
+        if (std::visit([](const auto& value) { return value.hasChanged(); }, entry.value)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void NexState::markAllAsRead() {
+    for (auto& entry : entries) {
+        std::visit([](auto& value) { value.markAsRead(); }, entry.value);
+    }
+}
+
+void NexState::update() {
+    applyPendingCommands();
+    refreshAllComputed();
+    if (snapshotDirty) {
+        publishSnapshot();
+    }
+    
+    unsigned long now = millis();
+    
+    if (config.outputOnInterval && !intervalScheduled && (now - lastOutputTime >= config.outputIntervalMs)) {
+        outputState();
+        lastOutputTime = now;
+    }
+}
+
+void NexState::attachScheduler(BeamScheduler& scheduler) {
+    if (!config.outputOnInterval || intervalScheduled) return;
+    intervalScheduled = scheduler.every(config.outputIntervalMs, [this] { outputState(); }) != 0;
+}
+
+void NexState::outputState() {
+    if (!config.enableSerialOutput) return;
+    
+    if (config.enableJsonFormat) {
+        Serial.println(getStateAsJson().c_str());
+    } else {
+        Serial.println(getStateAsText().c_str());
+    }
+    
+    markAllAsRead();
+    lastOutputTime = millis();
+}
+
+std::string NexState::getStateAsJson() const {
+    refreshAllComputed();
+    std::string json;
+    json.reserve(96 + entries.size() * 24);
+    json += "{\"device\":\"";
+    json += config.deviceInfo.deviceName;
+    json += "\",\"id\":\"";
+    json += config.deviceInfo.deviceId;
+    json += "\",\"type\":\"";
+    json += config.deviceInfo.deviceType;
+    json += "\",\"fw\":\"";
+    json += config.deviceInfo.firmwareVersion;
+    json += "\",\"state\":{";
+    
+    bool first = true;
+    for (const auto& entry : entries) {
+        if (!first) json += ',';
+        json += '"';
+        json.append(entry.key.c_str(), entry.key.size());
+        json += "\":";
+        std::visit([&json](const auto& value) { value.appendTo(json); }, entry.value);
+        first = false;
+    }
+    
+    json += "}}";
+    return json;
+}
+
+std::string NexState::getStateAsText() const {
+    refreshAllComputed();
+    std::string text = "Device: " + config.deviceInfo.deviceName;
+    text += " (ID: " + config.deviceInfo.deviceId;
+    text += ", Type: " + config.deviceInfo.deviceType;
+    text += ", FW: " + config.deviceInfo.firmwareVersion + ")";
+    text += " | State: ";
+    
+    bool first = true;
+    for (const auto& entry : entries) {
+        if (!first) text += ", ";
+        text.append(entry.key.c_str(), entry.key.size());
+        text += '=';
+        std::visit([&text](const auto& value) {
+            std::string val = value.toString();
+            // Remove quotes for text format
+            if (val.size() >= 2 && val.front() == '"' && val.back() == '"') {
+                val = val.substr(1, val.length() - 2);
+            }
+            text += val;
+        }, entry.value);
+        first = false;
+    }
+    
+    return text;
+}
+
+bool NexState::getNumeric(std::string_view key, double& out) const {
+    if (dirtyComputed) refreshComputed(key);
+    const Entry* entry = find(key);
+    if (!entry) return false;
+    return std::visit([&out](const auto& value) {
+        using S = std::decay_t<decltype(value.getValue())>;
+        if constexpr (std::is_same_v<S, SmallString>) {
+            return false;
+        } else {
+            out = static_cast<double>(value.getValue());
+            return true;
+        }
+    }, entry->value);
+}
+
+bool NexState::getType(std::string_view key, RecordType& out) const {
+    if (dirtyComputed) refreshComputed(key);
+    const Entry* entry = find(key);
+    if (!entry) return false;
+    out = std::visit([](const auto& v) {
+        return recordTypeOf<std::decay_t<decltype(v.getValue())>>();
+    }, entry->value);
+    return true;
+}
+
+bool NexState::setNumeric(std::string_view key, double value, RecordType typeIfNew) {
+    RecordType type = typeIfNew;
+    if (const Entry* entry = find(key)) {
+        type = std::visit([](const auto& v) {
+            return recordTypeOf<std::decay_t<decltype(v.getValue())>>();
+        }, entry->value);
+    }
+    
+    switch (type) {
+        case RecordType::Bool:   set(key, value != 0); break;
+        case RecordType::Int:    set(key, static_cast<int>(std::lround(value))); break;
+        case RecordType::UInt:   set(key, static_cast<uint32_t>(std::llround(value))); break;
+        case RecordType::Int64:  set(key, static_cast<int64_t>(std::llround(value))); break;
+        case RecordType::Float:  set(key, static_cast<float>(value)); break;
+        case RecordType::Double: set(key, value); break;
+        case RecordType::String: return false;
+    }
+    return true;
+}
+
+MemoryStats NexState::getMemoryStats() const {
+    MemoryStats stats;
+    stats.keyCount = entries.size();
+    for (const auto& entry : entries) {
+        stats.keyBytes += sizeof(entry.key) + entry.key.heapBytes();
+        stats.valueBytes += sizeof(entry.value) +
+            std::visit([](const auto& value) { return value.heapBytes(); }, entry.value);
+    }
+    stats.containerBytes = sizeof(entries) + (entries.capacity() - entries.size()) * sizeof(Entry);
+    stats.callbackBytes = sizeof(changeCallback) + sizeof(listeners) + listeners.capacity() * sizeof(Listener) +
+                          sizeof(keyObservers) + keyObservers.capacity() * sizeof(keyObservers[0]) +
+                          sizeof(computeds) + computeds.capacity() * sizeof(Computed);
+    for (const auto& computed : computeds) {
+        stats.callbackBytes += computed.inputs.capacity() * sizeof(SmallString);
+    }
+    stats.syncBytes = sizeof(commandQueue) + sizeof(snapshot) + sizeof(snapshotScratch);
+    return stats;
+}
+
+void NexState::notifyChange(size_t pos) {
+    // Copy the key: a callback may insert keys and move the entries
+    const SmallString key = entries[pos].key;
+    for (size_t i = 0; i < listeners.size(); i++) {
+        if (listeners[i].key != key) continue;
+        if (const Entry* entry = find(key.view())) {
+            listeners[i].fn(entry->value);
+        }
+    }
+    
+    for (size_t i = 0; i < keyObservers.size(); i++) {
+        keyObservers[i](key.view());
+    }
+    
+    if (changeCallback) {
+        if (const Entry* entry = find(key.view())) {
+            changeCallback(key.str(), std::visit([](const auto& value) { return value.toString(); }, entry->value));
+        }
+    }
+}
+
+void NexState::addComputed(std::string_view key, std::initializer_list<std::string_view> inputs,
+                           std::function<void(NexState&)> evaluate) {
+    Computed computed{SmallString(key), {}, std::move(evaluate), true};
+    computed.inputs.reserve(inputs.size());
+    for (std::string_view input : inputs) {
+        computed.inputs.emplace_back(input);
+    }
+    computeds.push_back(std::move(computed));
+    dirtyComputed++;
+}
+
+void NexState::markDependentsDirty(std::string_view key) {
+    for (size_t i = 0; i < computeds.size(); i++) {
+        Computed& computed = computeds[i];
+        if (computed.dirty) continue;
+        for (const auto& input : computed.inputs) {
+            if (input.view() == key) {
+                computed.dirty = true;
+                dirtyComputed++;
+                // Keys computed from this one are stale too
+                markDependentsDirty(computed.key.view());
+                break;
+            }
+        }
+    }
+}
+
+void NexState::evaluateComputed(size_t index) {
+    // Cleared first so a dependency cycle cannot recurse forever
+    computeds[index].dirty = false;
+    dirtyComputed--;
+    computeds[index].evaluate(*this);
+}
+
+void NexState::refreshComputed(std::string_view key) const {
+    // Reads stay const for callers; refreshing the cached value is not a visible change
+    NexState* self = const_cast<NexState*>(this);
+    for (size_t i = 0; i < computeds.size(); i++) {
+        if (computeds[i].dirty && computeds[i].key.view() == key) {
+            self->evaluateComputed(i);
+            return;
+        }
+    }
+}
+
+void NexState::refreshAllComputed() const {
+    NexState* self = const_cast<NexState*>(this);
+    for (size_t i = 0; i < computeds.size() && dirtyComputed; i++) {
+        if (computeds[i].dirty) {
+            self->evaluateComputed(i);
+        }
+    }
+}
+
+void NexState::applyPendingCommands() {
+    StateRecord cmd;
+    while (commandQueue.pop(cmd)) {
+        const std::string_view key(cmd.key);
+        switch (cmd.type) {
+            case RecordType::Bool:   set(key, cmd.value<bool>()); break;
+            case RecordType::Int:    set(key, cmd.value<int>()); break;
+            case RecordType::UInt:   set(key, cmd.value<uint32_t>()); break;
+            case RecordType::Int64:  set(key, cmd.value<int64_t>()); break;
+            case RecordType::Float:  set(key, cmd.value<float>()); break;
+            case RecordType::Double: set(key, cmd.value<double>()); break;
+            case RecordType::String: set(key, std::string_view(cmd.str)); break;
+        }
+    }
+}
+
+void NexState::publishSnapshot() {
+    StateSnapshot& snap = snapshotScratch;
+    snap.version = ++snapshotVersion;
+    snap.count = 0;
+    snap.dropped = 0;
+    
+    for (const auto& entry : entries) {
+        if (snap.count >= NEXSTATE_SNAPSHOT_CAPACITY) {
+            snap.dropped++;
+            continue;
+        }
+        StateRecord& rec = snap.entries[snap.count++];
+        rec.setKey(entry.key.view());
+        std::visit([&rec](const auto& value) { rec.setValue(value.getValue()); }, entry.value);
+    }
+    
+    snapshot.write(snap);
+    snapshotDirty = false;
+}
+
 bool initialize(const NexStateConfig& config) {
     if (g_nexState) {
         return false; // Already initialized
@@ -0,0 +1,128 @@
+#include "OutputBindings.h"
+#include "BeamUtils.h"
+#include <string>
+
+#if defined(ARDUINO) && defined(ESP32)
+#include <soc/gpio_reg.h>
+#include <soc/soc.h>
+#endif
+
+namespace nexstate {
+
+OutputBindings::OutputBindings(MaskWriter writer, PinSetup setup)
+    : writer(writer), setup(setup) {}
+
+bool OutputBindings::bindOutput(std::string_view key, uint8_t pin, bool activeHigh) {
+  if (!store) {
+    Serial.println("OutputBindings: begin() not called");
+    return false;
+  }
+  if (pin > kMaxPin) {
+    Serial.printf("OutputBindings: pin %u out of range\n", pin);
+    return false;
+  }
+  const uint64_t bit = 1ULL << pin;
+  if (bound & bit) {
+    Serial.printf("OutputBindings: pin %u already bound\n", pin);
+    return false;
+  }
+
+  if (setup) {
+    setup(pin);
+  }
+  bound |= bit;
+
+  store->onChange<bool>(key, [this, pin, activeHigh](const bool& on) {
+    queue(pin, on == activeHigh);
+  });
+
+  if (store->contains(key)) {
+    queue(pin, store->get<bool>(key) == activeHigh);
+  }
+  return true;
+}
+
+size_t OutputBindings::bindOutputs(std::string_view pinList, std::string_view keyPrefix, bool activeHigh) {
+  size_t count = 0;
+  size_t index = 0;  // list position, so a rejected entry does not renumber the keys after it
+  while (!pinList.empty()) {
+    const size_t comma = pinList.find(',');
+    const std::string_view item = BeamUtils::trimView(pinList.substr(0, comma));
+
+    int32_t pin = 0;
+    if (BeamUtils::parseInt(item, pin) && pin >= 0 && pin <= kMaxPin) {
+      std::string key(keyPrefix);
+      key += std::to_string(index);
+      if (bindOutput(key, static_cast<uint8_t>(pin), activeHigh)) {
+        count++;
+      }
+    } else {
+      Serial.printf("OutputBindings: ignoring pin entry '%.*s'\n", static_cast<int>(item.size()), item.data());
+    }
+
+    index++;
+    if (comma == std::string_view::npos) break;
+    pinList.remove_prefix(comma + 1);
+  }
+  return count;
+}
+
+void OutputBindings::queue(uint8_t pin, bool high) {
+  const uint64_t bit = 1ULL << pin;
+  if (high) {
+    pendingSet |= bit;
+    pendingClear &= ~bit;
+  } else {
+    pendingClear |= bit;
+    pendingSet &= ~bit;
+  }
+}
+
+bool OutputBindings::flush() {
+  // Skip pins already at the requested level (e.g. toggled twice since the last flush)
+  uint64_t setMask = pendingSet & ~(known & levels);
+  uint64_t clearMask = pendingClear & ~(known & ~levels);
+  pendingSet = 0;
+  pendingClear = 0;
+
+  if (!setMask && !clearMask) {
+    return false;
+  }
+
+  writer(setMask, clearMask);
+  registerWrites++;
+  known |= setMask | clearMask;
+  levels = (levels | setMask) & ~clearMask;
+  return true;
+}
+
+void OutputBindings::writeGpioMasks(uint64_t setMask, uint64_t clearMask) {
+#if defined(ARDUINO) && defined(ESP32)
+  // Write-one-to-set / write-one-to-clear registers: other pins are untouched
+  if (setMask & 0xFFFFFFFFULL) REG_WRITE(GPIO_OUT_W1TS_REG, static_cast<uint32_t>(setMask));
+  if (clearMask & 0xFFFFFFFFULL) REG_WRITE(GPIO_OUT_W1TC_REG, static_cast<uint32_t>(clearMask));
+#ifdef GPIO_OUT1_W1TS_REG
+  if (setMask >> 32) REG_WRITE(GPIO_OUT1_W1TS_REG, static_cast<uint32_t>(setMask >> 32));
+  if (clearMask >> 32) REG_WRITE(GPIO_OUT1_W1TC_REG, static_cast<uint32_t>(clearMask >> 32));
+#endif
+#elif defined(ARDUINO)
+  for (uint8_t pin = 0; pin <= kMaxPin; pin++) {
+    const uint64_t bit = 1ULL << pin;
+    if (setMask & bit) digitalWrite(pin, HIGH);
+    if (clearMask & bit) digitalWrite(pin, LOW);
+  }
+#else
+  (void)setMask;
+  (void)clearMask;
+#endif
+}
+
+void OutputBindings::configureOutputPin(uint8_t pin) {
+#if defined(ARDUINO)
+  pinMode(pin, OUTPUT);
+#else
+  (void)pin;
+#endif
+}
+
+} // namespace nexstate
@@ -0,0 +1,225 @@
+#include "StateBroadcast.h"
+#include "BeamUtils.h"
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace nexstate {
+
+namespace {
+
+constexpr size_t kHeaderBytes = 4;  // company id, version, sequence
+
+uint8_t tagOf(uint8_t id, BroadcastType type) {
+  return static_cast<uint8_t>((id << 3) | static_cast<uint8_t>(type));
+}
+
+// Smallest signed width that holds value; 0 if not even int32 does
+size_t encodeInt(uint8_t id, int64_t value, uint8_t* out) {
+  if (value >= INT8_MIN && value <= INT8_MAX) {
+    out[0] = tagOf(id, BroadcastType::Int8);
+    BeamUtils::putLe(out + 1, static_cast<uint32_t>(value), 1);
+    return 2;
+  }
+  if (value >= INT16_MIN && value <= INT16_MAX) {
+    out[0] = tagOf(id, BroadcastType::Int16);
+    BeamUtils::putLe(out + 1, static_cast<uint32_t>(value), 2);
+    return 3;
+  }
+  if (value >= INT32_MIN && value <= INT32_MAX) {
+    out[0] = tagOf(id, BroadcastType::Int32);
+    BeamUtils::putLe(out + 1, static_cast<uint32_t>(value), 4);
+    return 5;
+  }
+  return 0;
+}
+
+} // namespace
+
+bool StateBroadcast::add(uint8_t id, std::string_view key, uint8_t decimals) {
+  if (id > kMaxId || keyCount >= STATE_BROADCAST_MAX_KEYS || key.empty()) return false;
+  for (uint8_t i = 0; i < keyCount; i++) {
+    if (keys[i].id == id) return false;
+  }
+  keys[keyCount++] = Key{SmallString(key), id, decimals};
+  dirty = true;
+  return true;
+}
+
+void StateBroadcast::begin(NexState& store, uint32_t minIntervalMs) {
+  this->store = &store;
+  this->minIntervalMs = minIntervalMs;
+  dirty = true;
+  store.onAnyChange([this](std::string_view key) {
+    if (!watches(key)) return;
+    if (dirty) coalesced++;
+    dirty = true;
+  });
+}
+
+uint32_t StateBroadcast::update(uint32_t nowMs) {
+  if (!store || !dirty) return kNever;
+  const uint32_t elapsed = nowMs - lastSentMs;
+  if (sent > 0 && elapsed < minIntervalMs) return minIntervalMs - elapsed;
+  dirty = false;
+
+  uint8_t next[kLegacyAdvBytes];
+  const BroadcastResult result = build(*store, sequence, next, capacity);
+
+  // Back to what is already on air (e.g. toggled twice): nothing to send
+  if (sent > 0 && result.size == bufferSize &&
+      memcmp(next + kHeaderBytes, buffer + kHeaderBytes, result.size - kHeaderBytes) == 0) {
+    return kNever;
+  }
+
+  if (result.dropped && !warned) {
+    Serial.printf("StateBroadcast: %u key(s) missing or over %u bytes, first: %s\n", result.dropped,
+                  static_cast<unsigned>(capacity), result.firstDropped);
+    warned = true;
+  }
+
+  if (result.size >= kHeaderBytes) next[3] = ++sequence;
+  memcpy(buffer, next, result.size);
+  bufferSize = result.size;
+  last = result;
+  lastSentMs = nowMs;
+  sent++;
+  if (sink) sink(buffer, bufferSize);
+  return kNever;
+}
+
+BroadcastResult StateBroadcast::build(const NexState& store, uint8_t seq, uint8_t* out, size_t cap) const {
+  BroadcastResult result;
+  auto drop = [&result](const Key& key) {
+    if (!result.firstDropped) result.firstDropped = key.name.c_str();
+    result.dropped++;
+  };
+
+  if (cap < kHeaderBytes) {
+    for (uint8_t i = 0; i < keyCount; i++) drop(keys[i]);
+    return result;
+  }
+  BeamUtils::putLe(out, companyId, 2);
+  out[2] = kBroadcastVersion;
+  out[3] = seq;
+  size_t pos = kHeaderBytes;
+
+  for (uint8_t i = 0; i < keyCount; i++) {
+    const Key& key = keys[i];
+    const std::string_view name = key.name.view();
+    uint8_t field[kLegacyAdvBytes];
+    size_t n = 0;
+
+    RecordType type;
+    if (store.getType(name, type)) {
+      double number = 0;
+      switch (type) {
+        case RecordType::Bool:
+          field[0] = tagOf(key.id, store.get<bool>(name) ? BroadcastType::True : BroadcastType::False);
+          n = 1;
+          break;
+        case RecordType::Int:
+        case RecordType::UInt:
+        case RecordType::Int64:
+          store.getNumeric(name, number);
+          n = encodeInt(key.id, static_cast<int64_t>(number), field);
+          break;
+        case RecordType::Float:
+        case RecordType::Double:
+          store.getNumeric(name, number);
+          if (key.decimals) {
+            n = encodeInt(key.id, std::llround(number * std::pow(10.0, key.decimals)), field);
+          } else {
+            const float f = static_cast<float>(number);
+            uint32_t bits;
+            memcpy(&bits, &f, sizeof(bits));
+            field[0] = tagOf(key.id, BroadcastType::Float);
+            BeamUtils::putLe(field + 1, bits, 4);
+            n = 5;
+          }
+          break;
+        case RecordType::String: {
+          const std::string text = store.get<std::string>(name);
+          if (text.size() + 2 <= sizeof(field)) {
+            field[0] = tagOf(key.id, BroadcastType::Text);
+            field[1] = static_cast<uint8_t>(text.size());
+            memcpy(field + 2, text.data(), text.size());
+            n = text.size() + 2;
+          }
+          break;
+        }
+      }
+    }
+
+    // Never cut a field: a scanner would misread everything after it
+    if (n == 0 || pos + n > cap) {
+      drop(key);
+      continue;
+    }
+    memcpy(out + pos, field, n);
+    pos += n;
+    result.included++;
+  }
+
+  result.size = pos;
+  return result;
+}
+
+bool StateBroadcast::watches(std::string_view key) const {
+  for (uint8_t i = 0; i < keyCount; i++) {
+    if (keys[i].name.view() == key) return true;
+  }
+  return false;
+}
+
+int decodeBroadcast(const uint8_t* data, size_t size, BroadcastField* fields, size_t maxFields,
+                    uint8_t* sequence, uint16_t* companyId) {
+  if (!data || size < kHeaderBytes || data[2] != kBroadcastVersion) return -1;
+  if (companyId) *companyId = static_cast<uint16_t>(BeamUtils::getLe(data, 2));
+  if (sequence) *sequence = data[3];
+
+  size_t pos = kHeaderBytes;
+  int count = 0;
+  while (pos < size) {
+    BroadcastField f;
+    f.id = data[pos] >> 3;
+    f.type = static_cast<BroadcastType>(data[pos] & 0x07);
+    pos++;
+
+    size_t width = 0;
+    switch (f.type) {
+      case BroadcastType::False: f.number = 0; break;
+      case BroadcastType::True: f.number = 1; break;
+      case BroadcastType::Int8: width = 1; break;
+      case BroadcastType::Int16: width = 2; break;
+      case BroadcastType::Int32:
+      case BroadcastType::Float: width = 4; break;
+      case BroadcastType::Text:
+        if (pos >= size) return -1;
+        width = 1 + data[pos];
+        break;
+      default: return -1;
+    }
+    if (pos + width > size) return -1;
+
+    const uint32_t raw = width && f.type != BroadcastType::Text ? BeamUtils::getLe(data + pos, width) : 0;
+    if (f.type == BroadcastType::Int8) f.number = static_cast<int8_t>(raw);
+    if (f.type == BroadcastType::Int16) f.number = static_cast<int16_t>(raw);
+    if (f.type == BroadcastType::Int32) f.number = static_cast<int32_t>(raw);
+    if (f.type == BroadcastType::Float) {
+      float value;
+      memcpy(&value, &raw, sizeof(value));
+      f.number = value;
+    }
+    if (f.type == BroadcastType::Text) {
+      f.text = std::string_view(reinterpret_cast<const char*>(data + pos + 1), width - 1);
+    }
+    pos += width;
+
+    if (static_cast<size_t>(count) < maxFields) fields[count] = f;
+    count++;
+  }
+  return count;
+}
+
+} // namespace nexstate
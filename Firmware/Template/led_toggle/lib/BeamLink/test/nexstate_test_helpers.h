@@ -0,0 +1,22 @@
+#pragma once
+#include "NexState.h"
+
+/**
+ * @file nexstate_test_helpers.h
+ * @brief Fixtures shared by the NexState-based test suites
+ *
+ * Included by relative path (`#include "../nexstate_test_helpers.h"`) from
+ * the test_<name>/ suite folders.
+ */
+
+namespace nexstate {
+
+/// Store config with serial output off, so tests only see their own output.
+inline NexStateConfig quietConfig() {
+    NexStateConfig config;
+    config.enableSerialOutput = false;
+    config.outputOnChange = false;
+    return config;
+}
+
+} // namespace nexstate
@@ -0,0 +1,290 @@
+/**
+ * @file test_beam_adc_stream.cpp
+ * @brief Tests for continuous ADC capture: block assembly, double buffering and rates
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beam_adc_stream`).
+ * BeamSimDmaAdc stands in for the DMA, in virtual time except for the
+ * threaded test.
+ */
+
+#include <unity.h>
+#include "BeamAdcStream.h"
+#include "BeamConfig.h"
+#include <cstdio>
+
+static const uint8_t kPins[] = {34, 35};
+
+// Channel 0 at 100 counts, channel 1 at 3000
+static void flatSignals(BeamSimDmaAdc& adc) {
+    BeamSimAdc::Signal s;
+    s.offset = 100;
+    adc.setSignal(0, s);
+    s.offset = 3000;
+    adc.setSignal(1, s);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Setup Tests
+// ============================================================================
+
+void test_adc1_channel_map() {
+    TEST_ASSERT_EQUAL_INT(6, beamAdc1Channel(34));
+    TEST_ASSERT_EQUAL_INT(7, beamAdc1Channel(35));
+    TEST_ASSERT_EQUAL_INT(0, beamAdc1Channel(36));
+    TEST_ASSERT_EQUAL_INT(4, beamAdc1Channel(32));
+    TEST_ASSERT_EQUAL_INT(-1, beamAdc1Channel(25)); // ADC2
+    TEST_ASSERT_EQUAL_INT(-1, beamAdc1Channel(2));
+}
+
+void test_begin_validation() {
+    BeamSimDmaAdc adc;
+    BeamAdcStream stream;
+    TEST_ASSERT_FALSE(stream.begin(adc, kPins, 0, 20000));
+    TEST_ASSERT_FALSE(stream.begin(adc, kPins, 2, 0));
+    TEST_ASSERT_FALSE(stream.begin(adc, kPins, 2, 20000, 0));
+    TEST_ASSERT_FALSE(stream.begin(adc, kPins, 2, 20000, BEAM_ADC_BLOCK + 1));
+    TEST_ASSERT_FALSE(stream.start()); // no begin() yet
+    TEST_ASSERT_EQUAL_UINT32(0, stream.pump());
+
+    TEST_ASSERT_TRUE(stream.begin(adc, kPins, 2, 20000));
+    TEST_ASSERT_EQUAL_UINT8(2, stream.channelCount());
+    TEST_ASSERT_EQUAL_UINT8(35, stream.pin(1));
+    TEST_ASSERT_EQUAL_UINT32(BEAM_ADC_BLOCK, stream.blockSamples());
+
+    BeamConfig cfg;
+    cfg.sensorPins = "34,35,36";
+    TEST_ASSERT_TRUE(stream.begin(adc, cfg, 10000, 64));
+    TEST_ASSERT_EQUAL_UINT8(3, stream.channelCount());
+}
+
+// ============================================================================
+// Block Tests
+// ============================================================================
+
+void test_blocks_are_deinterleaved_and_timed() {
+    BeamSimDmaAdc adc;
+    flatSignals(adc);
+    adc.setFrameSize(64); // 32 per channel, 3.2 ms at 10 kHz
+    BeamAdcStream stream;
+    TEST_ASSERT_TRUE(stream.begin(adc, kPins, 2, 10000, 64));
+    TEST_ASSERT_TRUE(adc.start());
+
+    TEST_ASSERT_EQUAL_UINT32(64, stream.pump());
+    TEST_ASSERT_NULL(stream.next()); // half a block
+    TEST_ASSERT_EQUAL_UINT32(64, stream.pump());
+
+    const BeamAdcBlock* block = stream.next();
+    TEST_ASSERT_NOT_NULL(block);
+    TEST_ASSERT_EQUAL_UINT32(0, block->sequence);
+    TEST_ASSERT_EQUAL_UINT8(2, block->channels);
+    TEST_ASSERT_EQUAL_UINT16(64, block->count[0]);
+    TEST_ASSERT_EQUAL_UINT16(64, block->count[1]);
+    TEST_ASSERT_EQUAL_UINT32(0, block->firstUs);
+    for (size_t i = 0; i < 64; i++) {
+        TEST_ASSERT_EQUAL_UINT16(100, block->values[0][i]);
+        TEST_ASSERT_EQUAL_UINT16(3000, block->values[1][i]);
+    }
+    TEST_ASSERT_NULL(stream.next());
+
+    stream.pump();
+    stream.pump();
+    block = stream.next();
+    TEST_ASSERT_NOT_NULL(block);
+    TEST_ASSERT_EQUAL_UINT32(1, block->sequence);
+    TEST_ASSERT_EQUAL_UINT32(6400, block->firstUs);
+    stream.release();
+    TEST_ASSERT_EQUAL_UINT32(0, stream.stats().dropped);
+}
+
+void test_busy_consumer_drops_newest() {
+    BeamSimDmaAdc adc;
+    adc.setFrameSize(64);
+    BeamAdcStream stream;
+    TEST_ASSERT_TRUE(stream.begin(adc, kPins, 2, 10000, 32));
+    TEST_ASSERT_TRUE(adc.start());
+
+    stream.pump(); // block 0
+    const BeamAdcBlock* held = stream.next();
+    TEST_ASSERT_NOT_NULL(held);
+
+    // The task fills the other buffer, and has nowhere to hand it over
+    stream.pump();
+    stream.pump();
+    stream.pump();
+    TEST_ASSERT_EQUAL_UINT32(0, held->sequence); // untouched while held
+    TEST_ASSERT_EQUAL_UINT32(3, stream.stats().dropped);
+    TEST_ASSERT_NULL(stream.next());
+
+    // Released: the next block gets through, the gap shows in its sequence
+    stream.pump();
+    const BeamAdcBlock* block = stream.next();
+    TEST_ASSERT_NOT_NULL(block);
+    TEST_ASSERT_EQUAL_UINT32(4, block->sequence);
+}
+
+void test_absent_consumer_keeps_newest() {
+    BeamSimDmaAdc adc;
+    adc.setFrameSize(64);
+    BeamAdcStream stream;
+    TEST_ASSERT_TRUE(stream.begin(adc, kPins, 2, 10000, 32));
+    TEST_ASSERT_TRUE(adc.start());
+
+    for (int i = 0; i < 5; i++) stream.pump();
+    const BeamAdcStreamStats s = stream.stats();
+    TEST_ASSERT_EQUAL_UINT32(5, s.blocks);
+    TEST_ASSERT_EQUAL_UINT32(4, s.dropped);
+
+    const BeamAdcBlock* block = stream.next();
+    TEST_ASSERT_NOT_NULL(block);
+    TEST_ASSERT_EQUAL_UINT32(4, block->sequence);
+}
+
+void test_uneven_frames_fill_blocks() {
+    BeamSimDmaAdc adc;
+    flatSignals(adc);
+    adc.setFrameSize(45); // odd: frames end mid-round
+    BeamAdcStream stream;
+    TEST_ASSERT_TRUE(stream.begin(adc, kPins, 2, 10000, 50));
+    TEST_ASSERT_TRUE(adc.start());
+
+    uint32_t expected = 0;
+    for (int i = 0; i < 40; i++) {
+        stream.pump();
+        while (const BeamAdcBlock* block = stream.next()) {
+            TEST_ASSERT_EQUAL_UINT32(expected++, block->sequence);
+            TEST_ASSERT_EQUAL_UINT16(50, block->count[0]);
+            TEST_ASSERT_EQUAL_UINT16(50, block->count[1]);
+            TEST_ASSERT_EQUAL_UINT16(100, block->values[0][49]);
+            TEST_ASSERT_EQUAL_UINT16(3000, block->values[1][49]);
+        }
+        stream.release();
+    }
+    TEST_ASSERT_EQUAL_UINT32(18, expected); // 1800 conversions, 100 per block
+    TEST_ASSERT_EQUAL_UINT32(0, stream.stats().dropped);
+}
+
+// ============================================================================
+// Rate Tests
+// ============================================================================
+
+void test_sustained_rate_and_callback() {
+    BeamSimDmaAdc adc;
+    adc.setFrameSize(64);
+    BeamAdcStream stream;
+    TEST_ASSERT_TRUE(stream.begin(adc, kPins, 2, 10000, 64));
+    int calls = 0;
+    stream.onBlock([&calls] { calls++; });
+    TEST_ASSERT_TRUE(adc.start());
+
+    for (int i = 0; i < 20; i++) {
+        stream.pump();
+        stream.next();
+        stream.release();
+    }
+    const BeamAdcStreamStats s = stream.stats();
+    TEST_ASSERT_EQUAL_INT(10, calls);
+    TEST_ASSERT_EQUAL_UINT32(1280, s.conversions);
+    TEST_ASSERT_EQUAL_UINT32(10000, s.sustainedHz);
+    TEST_ASSERT_EQUAL_UINT32(0, s.driverOverflows);
+
+    stream.resetStats();
+    TEST_ASSERT_EQUAL_UINT32(0, stream.stats().sustainedHz);
+}
+
+void test_threaded_capture() {
+    BeamSimDmaAdc adc;
+    adc.setRealTime(true);
+    BeamAdcStream stream;
+    TEST_ASSERT_TRUE(stream.begin(adc, kPins, 2, 20000));
+    TEST_ASSERT_TRUE(stream.start());
+    TEST_ASSERT_TRUE(stream.isRunning());
+
+    uint32_t taken = 0, gaps = 0, expected = 0;
+    const unsigned long until = millis() + 300;
+    while (millis() < until) {
+        while (const BeamAdcBlock* block = stream.next()) {
+            if (block->sequence != expected) gaps++;
+            expected = block->sequence + 1;
+            taken++;
+        }
+        stream.release();
+        delay(1);
+    }
+    stream.stop();
+    TEST_ASSERT_FALSE(stream.isRunning());
+
+    const BeamAdcStreamStats s = stream.stats();
+    TEST_ASSERT_TRUE(taken > 10); // ~23 blocks of 12.8 ms
+    TEST_ASSERT_EQUAL_UINT32(0, gaps); // the consumer polls far faster than blocks fill
+    TEST_ASSERT_EQUAL_UINT32(0, s.dropped);
+    TEST_ASSERT_TRUE(s.sustainedHz > 19000 && s.sustainedHz < 21000);
+    printf("{\"bench\":\"adc_stream\",\"schema\":1,\"rate_hz\":20000,\"channels\":2,\"ms\":300,"
+           "\"sustained_hz\":%lu,\"blocks\":%lu,\"dropped\":%lu}\n",
+           static_cast<unsigned long>(s.sustainedHz), static_cast<unsigned long>(s.blocks),
+           static_cast<unsigned long>(s.dropped));
+}
+
+void test_pump_cost() {
+    BeamSimDmaAdc adc;
+    BeamAdcStream stream;
+    TEST_ASSERT_TRUE(stream.begin(adc, kPins, 2, 40000));
+    TEST_ASSERT_TRUE(adc.start());
+
+    // Mostly BeamSimDmaAdc's signal generation; an upper bound for the sort
+    const uint32_t frames = 2000;
+    const unsigned long start = micros();
+    for (uint32_t i = 0; i < frames; i++) {
+        stream.pump();
+        stream.next();
+        stream.release();
+    }
+    const unsigned long elapsed = micros() - start;
+    TEST_ASSERT_EQUAL_UINT32(0, stream.stats().dropped);
+    printf("{\"bench\":\"adc_stream_pump\",\"schema\":1,\"frame\":%u,\"frames\":%lu,\"ns_per_conversion\":%.1f}\n",
+           static_cast<unsigned>(BEAM_ADC_FRAME), static_cast<unsigned long>(frames),
+           elapsed * 1000.0 / (static_cast<double>(frames) * BEAM_ADC_FRAME));
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Setup Tests
+    RUN_TEST(test_adc1_channel_map);
+    RUN_TEST(test_begin_validation);
+
+    // Block Tests
+    RUN_TEST(test_blocks_are_deinterleaved_and_timed);
+    RUN_TEST(test_busy_consumer_drops_newest);
+    RUN_TEST(test_absent_consumer_keeps_newest);
+    RUN_TEST(test_uneven_frames_fill_blocks);
+
+    // Rate Tests
+    RUN_TEST(test_sustained_rate_and_callback);
+    RUN_TEST(test_threaded_capture);
+    RUN_TEST(test_pump_cost);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
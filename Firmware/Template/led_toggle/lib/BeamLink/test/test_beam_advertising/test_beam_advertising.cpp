@@ -0,0 +1,228 @@
+/**
+ * @file test_beam_advertising.cpp
+ * @brief Tests for the BeamAdvSchedule fast/normal/slow advertising phases
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beam_advertising`).
+ * Time is passed explicitly, so the tests do not depend on millis().
+ */
+
+#include <unity.h>
+#include "BeamAdvertising.h"
+#include "BeamConfig.h"
+#include <cstdio>
+
+static BeamAdvSteps defaultSteps() {
+    BeamAdvSteps steps;
+    steps.fastIntervalMs = 20;
+    steps.fastMs = 30000;
+    steps.intervalMs = 100;
+    steps.normalMs = 60000;
+    steps.slowIntervalMs = 1285;
+    return steps;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Phase Tests
+// ============================================================================
+
+void test_adv_schedule_steps_down() {
+    BeamAdvSchedule s(0);
+    s.configure(defaultSteps());
+    TEST_ASSERT_TRUE(s.phase() == BeamAdvPhase::Off);
+    TEST_ASSERT_EQUAL_UINT32(BeamAdvSchedule::kNever, s.msUntilNext(0));
+
+    s.restart(0);
+    TEST_ASSERT_TRUE(s.phase() == BeamAdvPhase::Fast);
+    TEST_ASSERT_EQUAL_UINT32(20, s.intervalMs());
+    TEST_ASSERT_EQUAL_UINT32(30000, s.msUntilNext(0));
+
+    TEST_ASSERT_FALSE(s.update(29999));
+    TEST_ASSERT_TRUE(s.update(30000));
+    TEST_ASSERT_TRUE(s.phase() == BeamAdvPhase::Normal);
+    TEST_ASSERT_EQUAL_UINT32(100, s.intervalMs());
+    TEST_ASSERT_EQUAL_UINT32(60000, s.msUntilNext(30000));
+
+    TEST_ASSERT_TRUE(s.update(90000));
+    TEST_ASSERT_TRUE(s.phase() == BeamAdvPhase::Slow);
+    TEST_ASSERT_EQUAL_UINT32(1285, s.intervalMs());
+    TEST_ASSERT_EQUAL_UINT32(BeamAdvSchedule::kNever, s.msUntilNext(90000));
+    TEST_ASSERT_FALSE(s.update(10000000));
+}
+
+void test_adv_schedule_late_update_keeps_phase_length() {
+    BeamAdvSchedule s(0);
+    s.configure(defaultSteps());
+    s.restart(0);
+
+    // update() came late: the radio stayed fast until now, so normal
+    // starts now and still lasts its full 60 s
+    TEST_ASSERT_TRUE(s.update(45000));
+    TEST_ASSERT_TRUE(s.phase() == BeamAdvPhase::Normal);
+    TEST_ASSERT_EQUAL_UINT32(60000, s.msUntilNext(45000));
+    TEST_ASSERT_EQUAL_UINT32(45000, s.stats(45000).timeMs[static_cast<uint8_t>(BeamAdvPhase::Fast)]);
+}
+
+void test_adv_schedule_zero_durations_skip() {
+    BeamAdvSteps steps = defaultSteps();
+    steps.fastMs = 0;
+    BeamAdvSchedule s(0);
+    s.configure(steps);
+    s.restart(0);
+    TEST_ASSERT_TRUE(s.phase() == BeamAdvPhase::Normal);
+
+    steps.normalMs = 0;
+    s.configure(steps);
+    s.restart(10);
+    TEST_ASSERT_TRUE(s.phase() == BeamAdvPhase::Slow);
+}
+
+void test_adv_schedule_restart_and_stop() {
+    BeamAdvSchedule s(0);
+    s.configure(defaultSteps());
+    s.restart(0);
+    s.update(30000);
+    s.update(90000);
+    TEST_ASSERT_TRUE(s.phase() == BeamAdvPhase::Slow);
+
+    // Button press or state change: burst again
+    s.restart(100000);
+    TEST_ASSERT_TRUE(s.phase() == BeamAdvPhase::Fast);
+    TEST_ASSERT_EQUAL_UINT32(30000, s.msUntilNext(100000));
+
+    // Connected
+    s.stop(101000);
+    TEST_ASSERT_TRUE(s.phase() == BeamAdvPhase::Off);
+    TEST_ASSERT_EQUAL_UINT32(0, s.intervalMs());
+    TEST_ASSERT_FALSE(s.update(200000));
+}
+
+void test_adv_schedule_configure_keeps_phase_start() {
+    BeamAdvSchedule s(0);
+    s.configure(defaultSteps());
+    s.restart(0);
+
+    BeamAdvSteps shorter = defaultSteps();
+    shorter.fastMs = 10000;
+    s.configure(shorter);
+    TEST_ASSERT_EQUAL_UINT32(0, s.msUntilNext(12000));
+    TEST_ASSERT_TRUE(s.update(12000));
+    TEST_ASSERT_TRUE(s.phase() == BeamAdvPhase::Normal);
+}
+
+void test_adv_schedule_millis_wraparound() {
+    const uint32_t start = 0xFFFFF000u;
+    BeamAdvSchedule s(start);
+    s.configure(defaultSteps());
+    s.restart(start);
+    TEST_ASSERT_FALSE(s.update(start + 20000)); // crosses 0
+    TEST_ASSERT_TRUE(s.update(start + 30000));
+    TEST_ASSERT_TRUE(s.phase() == BeamAdvPhase::Normal);
+}
+
+// ============================================================================
+// Counter Tests
+// ============================================================================
+
+void test_adv_schedule_time_per_phase() {
+    BeamAdvSchedule s(0);
+    s.configure(defaultSteps());
+    s.restart(0);
+    s.update(30000);
+    s.update(90000);
+    s.stop(100000);   // connect after 10 s slow
+    s.restart(160000); // disconnect after 60 s connected
+    s.update(170000);
+
+    BeamAdvStats st = s.stats(175000);
+    TEST_ASSERT_EQUAL_UINT32(45000, st.timeMs[static_cast<uint8_t>(BeamAdvPhase::Fast)]);
+    TEST_ASSERT_EQUAL_UINT32(60000, st.timeMs[static_cast<uint8_t>(BeamAdvPhase::Normal)]);
+    TEST_ASSERT_EQUAL_UINT32(10000, st.timeMs[static_cast<uint8_t>(BeamAdvPhase::Slow)]);
+    TEST_ASSERT_EQUAL_UINT32(60000, st.timeMs[static_cast<uint8_t>(BeamAdvPhase::Off)]);
+    TEST_ASSERT_EQUAL_UINT32(175000, st.totalMs());
+    TEST_ASSERT_EQUAL_UINT32(2, st.restarts);
+    TEST_ASSERT_EQUAL_UINT32(2, st.steps);
+
+    s.resetStats(175000);
+    TEST_ASSERT_EQUAL_UINT32(0, s.stats(175000).totalMs());
+}
+
+// One hour unconnected: how many advertising events does the schedule send
+// compared with a fixed 100 ms interval?
+void test_adv_schedule_event_budget() {
+    BeamAdvSchedule s(0);
+    s.configure(defaultSteps());
+    s.restart(0);
+    const uint32_t hourMs = 3600000;
+    for (uint32_t t = 0; t < hourMs; t += 1000) s.update(t);
+
+    const BeamAdvStats st = s.stats(hourMs);
+    const uint32_t events = st.timeMs[0] / 20 + st.timeMs[1] / 100 + st.timeMs[2] / 1285;
+    const uint32_t fixedEvents = hourMs / 100;
+    printf("{\"bench\":\"adv_schedule\",\"schema\":1,\"window_s\":3600,\"adv_events\":%lu,\"fixed_100ms_events\":%lu}\n",
+           static_cast<unsigned long>(events), static_cast<unsigned long>(fixedEvents));
+    TEST_ASSERT_TRUE(events * 5 < fixedEvents);
+}
+
+// ============================================================================
+// Config Tests
+// ============================================================================
+
+void test_adv_steps_from_config() {
+    BeamConfig cfg;
+    TEST_ASSERT_TRUE(parseBeamConfig("BLE_ADV_FAST_INTERVAL_MS=30\nBLE_ADV_FAST_MS=0\n"
+                                     "BLE_ADV_INTERVAL_MS=250\nBLE_ADV_NORMAL_MS=5000\n"
+                                     "BLE_ADV_SLOW_INTERVAL_MS=2000\n", cfg));
+    const BeamAdvSteps steps = beamAdvSteps(cfg);
+    TEST_ASSERT_EQUAL_UINT32(30, steps.fastIntervalMs);
+    TEST_ASSERT_EQUAL_UINT32(0, steps.fastMs);
+    TEST_ASSERT_EQUAL_UINT32(250, steps.intervalMs);
+    TEST_ASSERT_EQUAL_UINT32(5000, steps.normalMs);
+    TEST_ASSERT_EQUAL_UINT32(2000, steps.slowIntervalMs);
+
+    TEST_ASSERT_FALSE(parseBeamConfig("BLE_ADV_SLOW_INTERVAL_MS=20000\n", cfg));
+    TEST_ASSERT_EQUAL_INT(2000, cfg.bleAdvSlowIntervalMs);
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Phase Tests
+    RUN_TEST(test_adv_schedule_steps_down);
+    RUN_TEST(test_adv_schedule_late_update_keeps_phase_length);
+    RUN_TEST(test_adv_schedule_zero_durations_skip);
+    RUN_TEST(test_adv_schedule_restart_and_stop);
+    RUN_TEST(test_adv_schedule_configure_keeps_phase_start);
+    RUN_TEST(test_adv_schedule_millis_wraparound);
+
+    // Counter Tests
+    RUN_TEST(test_adv_schedule_time_per_phase);
+    RUN_TEST(test_adv_schedule_event_budget);
+
+    // Config Tests
+    RUN_TEST(test_adv_steps_from_config);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
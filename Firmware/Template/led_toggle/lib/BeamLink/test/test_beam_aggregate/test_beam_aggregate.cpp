@@ -0,0 +1,463 @@
+/**
+ * @file test_beam_aggregate.cpp
+ * @brief Tests for windowed statistics: accumulators, EWMA, tumbling and sliding windows
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beam_aggregate`).
+ * Results are checked against a naive two-pass computation; the throughput
+ * test prints samples per second for each path.
+ */
+
+#include <unity.h>
+#include "BeamAggregate.h"
+#include <cstdio>
+#include <vector>
+
+// Deterministic 12-bit values with some spread
+static uint16_t noisy(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return static_cast<uint16_t>(1500 + (state >> 22));
+}
+
+// Two-pass reference
+static BeamWindow naive(const uint16_t* values, size_t n) {
+    BeamWindow w;
+    w.count = static_cast<uint32_t>(n);
+    double sum = 0;
+    w.min = 65535;
+    w.max = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += values[i];
+        if (values[i] < w.min) w.min = values[i];
+        if (values[i] > w.max) w.max = values[i];
+    }
+    const double mean = sum / n;
+    double sq = 0;
+    for (size_t i = 0; i < n; i++) sq += (values[i] - mean) * (values[i] - mean);
+    w.mean = static_cast<float>(mean);
+    w.variance = static_cast<float>(sq / n);
+    return w;
+}
+
+static void assertWindow(const BeamWindow& expected, const BeamWindow& actual) {
+    TEST_ASSERT_EQUAL_UINT32(expected.count, actual.count);
+    TEST_ASSERT_EQUAL_FLOAT(expected.min, actual.min);
+    TEST_ASSERT_EQUAL_FLOAT(expected.max, actual.max);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, expected.mean, actual.mean);
+    TEST_ASSERT_FLOAT_WITHIN(expected.variance * 1e-4f + 1e-3f, expected.variance, actual.variance);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Accumulator Tests
+// ============================================================================
+
+void test_fixed_accumulator_matches_naive() {
+    std::vector<uint16_t> values(5000);
+    uint32_t state = 1;
+    for (uint16_t& v : values) v = noisy(state);
+
+    BeamAccumulator one, block;
+    for (uint16_t v : values) one.add(v);
+    block.add(values.data(), values.size());
+
+    BeamWindow a, b;
+    one.result(a);
+    block.result(b);
+    assertWindow(naive(values.data(), values.size()), a);
+    assertWindow(a, b);
+
+    BeamAccumulator empty;
+    BeamWindow e;
+    empty.result(e);
+    TEST_ASSERT_EQUAL_UINT32(0, e.count);
+    TEST_ASSERT_EQUAL_FLOAT(0, e.mean);
+}
+
+void test_fixed_accumulator_full_scale_is_exact() {
+    // 16-bit extremes over more than one 32-bit partial-sum chunk
+    std::vector<uint16_t> values(70000);
+    for (size_t i = 0; i < values.size(); i++) values[i] = (i & 1) ? 65535 : 0;
+    BeamAccumulator acc;
+    acc.add(values.data(), values.size());
+    BeamWindow w;
+    acc.result(w);
+    TEST_ASSERT_EQUAL_UINT32(70000, w.count);
+    TEST_ASSERT_EQUAL_FLOAT(0, w.min);
+    TEST_ASSERT_EQUAL_FLOAT(65535, w.max);
+    TEST_ASSERT_EQUAL_FLOAT(32767.5f, w.mean);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 32767.5f * 32767.5f, w.variance);
+}
+
+void test_merge_equals_single_pass() {
+    std::vector<uint16_t> values(3000);
+    uint32_t state = 7;
+    for (uint16_t& v : values) v = noisy(state);
+
+    BeamAccumulator left, right, all;
+    left.add(values.data(), 1000);
+    right.add(values.data() + 1000, 2000);
+    all.add(values.data(), values.size());
+    left.merge(right);
+    left.merge(BeamAccumulator{});
+
+    BeamWindow merged, single;
+    left.result(merged);
+    all.result(single);
+    assertWindow(single, merged);
+
+    BeamFloatAccumulator fl, fr, fa, fe;
+    for (size_t i = 0; i < values.size(); i++) {
+        (i < 1000 ? fl : fr).add(values[i]);
+        fa.add(values[i]);
+    }
+    fe.merge(fl);  // into an empty one
+    fe.merge(fr);
+    BeamWindow fm, fs;
+    fe.result(fm);
+    fa.result(fs);
+    assertWindow(single, fs);
+    TEST_ASSERT_FLOAT_WITHIN(1e-2f, fs.mean, fm.mean);
+    TEST_ASSERT_FLOAT_WITHIN(fs.variance * 1e-3f, fs.variance, fm.variance);
+}
+
+void test_ewma_converges() {
+    BeamEwma fixed(3);
+    BeamFloatEwma real(0.125f);
+    TEST_ASSERT_FALSE(fixed.hasValue());
+    fixed.add(1000);
+    real.add(1000);
+    TEST_ASSERT_EQUAL_FLOAT(1000, fixed.value()); // primed with the first sample
+
+    for (int i = 0; i < 200; i++) {
+        fixed.add(2000);
+        real.add(2000);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 2000, fixed.value());
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 2000, real.value());
+
+    // One step: alpha = 1/8 of the difference
+    BeamEwma step(3);
+    step.add(0);
+    step.add(800);
+    TEST_ASSERT_EQUAL_FLOAT(100, step.value());
+
+    fixed.reset();
+    TEST_ASSERT_FALSE(fixed.hasValue());
+}
+
+// ============================================================================
+// Window Tests
+// ============================================================================
+
+void test_tumbling_boundaries_and_gaps() {
+    BeamTumblingWindow<BeamAccumulator> win(1000);
+    std::vector<BeamWindow> closed;
+    win.onWindow([&closed](const BeamWindow& w) { closed.push_back(w); });
+
+    TEST_ASSERT_FALSE(win.add(10, 5000));
+    TEST_ASSERT_FALSE(win.add(20, 5999));
+    TEST_ASSERT_TRUE(win.add(30, 6000)); // closes [5000, 6000)
+    TEST_ASSERT_EQUAL_UINT32(1, closed.size());
+    TEST_ASSERT_EQUAL_UINT32(5000, closed[0].startUs);
+    TEST_ASSERT_EQUAL_UINT32(6000, closed[0].endUs);
+    TEST_ASSERT_EQUAL_UINT32(2, closed[0].count);
+    TEST_ASSERT_EQUAL_FLOAT(15, closed[0].mean);
+
+    // A gap of several windows: one report, aligned to the grid
+    TEST_ASSERT_TRUE(win.add(40, 9500));
+    TEST_ASSERT_EQUAL_UINT32(2, closed.size());
+    TEST_ASSERT_EQUAL_UINT32(6000, closed[1].startUs);
+    TEST_ASSERT_EQUAL_UINT32(1, closed[1].count);
+    TEST_ASSERT_EQUAL_UINT32(9000, win.current().startUs);
+
+    // No sample, but time has moved on
+    TEST_ASSERT_FALSE(win.advanceTo(9999));
+    TEST_ASSERT_TRUE(win.advanceTo(10000));
+    TEST_ASSERT_FALSE(win.advanceTo(20000)); // nothing left to close
+    TEST_ASSERT_EQUAL_UINT32(3, win.windows());
+    TEST_ASSERT_EQUAL_FLOAT(40, win.last().mean);
+}
+
+void test_late_samples_stay_in_current_window() {
+    // The report advanced the window before the samples queued up to then were added
+    BeamTumblingWindow<BeamAccumulator> win(1000000);
+    std::vector<BeamWindow> closed;
+    win.onWindow([&closed](const BeamWindow& w) { closed.push_back(w); });
+    win.add(100, 0);
+    TEST_ASSERT_TRUE(win.advanceTo(1020000));
+    TEST_ASSERT_EQUAL_UINT32(1000000, win.current().startUs);
+
+    for (uint32_t t = 990000; t <= 1020000; t += 10000) {
+        TEST_ASSERT_FALSE(win.add(200, t));  // no spurious empty window
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, closed.size());
+    TEST_ASSERT_EQUAL_UINT32(4, win.current().count);
+
+    // The grid is unchanged
+    TEST_ASSERT_TRUE(win.add(300, 2000000));
+    TEST_ASSERT_EQUAL_UINT32(1000000, win.last().startUs);
+    TEST_ASSERT_EQUAL_FLOAT(200, win.last().mean);
+    TEST_ASSERT_EQUAL_UINT32(2000000, win.current().startUs);
+
+    // Sliding: a late sample lands in the current pane instead of expiring all
+    BeamSlidingWindow<BeamAccumulator, 8> sliding(8000);
+    for (uint32_t t = 0; t < 8000; t += 100) sliding.add(100, t);
+    sliding.add(100, 7000);
+    BeamWindow w = sliding.stats();
+    TEST_ASSERT_EQUAL_UINT32(81, w.count);
+    TEST_ASSERT_EQUAL_UINT32(8000, w.endUs);
+}
+
+void test_tumbling_block_path_matches_samples() {
+    // 10 kHz, 1 ms windows: 10 samples each, blocks of 64 cross boundaries
+    const uint32_t rate = 10000;
+    BeamTumblingWindow<BeamAccumulator> perSample(1000), perBlock(1000);
+    std::vector<BeamWindow> a, b;
+    perSample.onWindow([&a](const BeamWindow& w) { a.push_back(w); });
+    perBlock.onWindow([&b](const BeamWindow& w) { b.push_back(w); });
+
+    uint32_t state = 3;
+    uint16_t block[64];
+    size_t total = 0;
+    for (int k = 0; k < 20; k++) {
+        const uint32_t firstUs = 250 + beamSampleOffsetUs(total, rate);
+        for (size_t i = 0; i < 64; i++) {
+            block[i] = noisy(state);
+            perSample.add(block[i], firstUs + beamSampleOffsetUs(i, rate));
+        }
+        perBlock.add(block, 64, firstUs, rate);
+        total += 64;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(127, a.size()); // 1280 samples
+    TEST_ASSERT_EQUAL_UINT32(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT32(a[i].startUs, b[i].startUs);
+        TEST_ASSERT_EQUAL_UINT32(10, b[i].count);
+        assertWindow(a[i], b[i]);
+    }
+}
+
+void test_sliding_window_expires_panes() {
+    // 8 panes of 1 ms
+    BeamSlidingWindow<BeamAccumulator, 8> win(8000);
+    TEST_ASSERT_EQUAL_UINT32(8000, win.lengthUs());
+
+    for (uint32_t t = 0; t < 8000; t += 100) win.add(100, t);
+    BeamWindow w = win.stats();
+    TEST_ASSERT_EQUAL_UINT32(80, w.count);
+    TEST_ASSERT_EQUAL_UINT32(0, w.startUs);
+    TEST_ASSERT_EQUAL_UINT32(8000, w.endUs);
+
+    // Four more panes at 300: the oldest four drop out
+    for (uint32_t t = 8000; t < 12000; t += 100) win.add(300, t);
+    w = win.stats();
+    TEST_ASSERT_EQUAL_UINT32(80, w.count);
+    TEST_ASSERT_EQUAL_FLOAT(200, w.mean);
+    TEST_ASSERT_EQUAL_FLOAT(100, w.min);
+    TEST_ASSERT_EQUAL_FLOAT(300, w.max);
+
+    // A long silence empties the window
+    win.advanceTo(100000);
+    TEST_ASSERT_EQUAL_UINT32(0, win.stats().count);
+
+    // Block path
+    BeamSlidingWindow<BeamAccumulator, 8> blocks(8000);
+    uint16_t ones[40];
+    for (uint16_t& v : ones) v = 1;
+    for (uint32_t k = 0; k < 3; k++) blocks.add(ones, 40, k * 4000, 10000);
+    TEST_ASSERT_EQUAL_UINT32(80, blocks.stats().count); // 120 added, the first 40 expired
+}
+
+// ============================================================================
+// Aggregator Tests
+// ============================================================================
+
+void test_aggregator_channels_and_callback() {
+    BeamAggregator agg;
+    TEST_ASSERT_FALSE(agg.begin(0, {}));
+    TEST_ASSERT_FALSE(agg.begin(BEAM_SAMPLER_MAX_CHANNELS + 1, {}));
+
+    BeamAggregator::Config cfg;
+    cfg.windowUs = 10000;
+    cfg.slidingUs = 80000;
+    cfg.ewmaShift = 2;
+    TEST_ASSERT_TRUE(agg.begin(2, cfg));
+
+    std::vector<std::pair<uint8_t, BeamWindow>> closed;
+    agg.onWindow([&closed](uint8_t ch, const BeamWindow& w) { closed.push_back({ch, w}); });
+
+    // Channel 0 by sample at 1 kHz, channel 1 in blocks at 1 kHz
+    BeamSample samples[10];
+    uint16_t values[10];
+    for (uint32_t k = 0; k < 3; k++) {
+        for (uint32_t i = 0; i < 10; i++) {
+            samples[i] = {(k * 10 + i) * 1000, static_cast<uint16_t>(100 * (k + 1))};
+            values[i] = static_cast<uint16_t>(1000 * (k + 1));
+        }
+        agg.add(0, samples, 10);
+        agg.add(1, values, 10, k * 10000, 1000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(4, closed.size()); // two windows each
+    TEST_ASSERT_EQUAL_UINT32(2, agg.windows(0));
+    TEST_ASSERT_EQUAL_UINT32(2, agg.windows(1));
+    TEST_ASSERT_EQUAL_FLOAT(200, agg.last(0).mean);
+    TEST_ASSERT_EQUAL_FLOAT(2000, agg.last(1).mean);
+    // EWMA at the close: 10 steps of alpha = 1/4 from 1000 towards 2000
+    const float closeEwma = agg.last(1).ewma;
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 2000 - 1000 * 0.0563f, closeEwma);
+
+    agg.advanceTo(30000);
+    TEST_ASSERT_EQUAL_UINT32(6, closed.size());
+    TEST_ASSERT_EQUAL_FLOAT(300, agg.last(0).mean);
+    TEST_ASSERT_EQUAL_FLOAT(agg.ewma(1), agg.last(1).ewma); // closed by time: no sample since
+
+    const BeamWindow s = agg.sliding(1);
+    TEST_ASSERT_EQUAL_UINT32(30, s.count);
+    TEST_ASSERT_EQUAL_FLOAT(2000, s.mean);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 3000 - (3000 - closeEwma) * 0.0563f, agg.ewma(1));
+
+    // Out-of-range channels are ignored
+    agg.add(5, 1, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, agg.last(5).count);
+
+    agg.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, agg.windows(0));
+    TEST_ASSERT_EQUAL_UINT32(0, agg.last(0).count);
+}
+
+void test_aggregator_block_ewma_matches_samples() {
+    BeamAggregator::Config cfg;
+    cfg.windowUs = 1000;
+    BeamAggregator bySample, byBlock;
+    TEST_ASSERT_TRUE(bySample.begin(1, cfg));
+    TEST_ASSERT_TRUE(byBlock.begin(1, cfg));
+    std::vector<BeamWindow> a, b;
+    bySample.onWindow([&a](uint8_t, const BeamWindow& w) { a.push_back(w); });
+    byBlock.onWindow([&b](uint8_t, const BeamWindow& w) { b.push_back(w); });
+
+    uint32_t state = 11;
+    uint16_t block[48];
+    for (uint32_t k = 0; k < 10; k++) {
+        const uint32_t firstUs = k * 48 * 50; // 20 kHz
+        for (uint32_t i = 0; i < 48; i++) {
+            block[i] = noisy(state);
+            bySample.add(0, block[i], firstUs + i * 50);
+        }
+        byBlock.add(0, block, 48, firstUs, 20000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(a.size(), b.size());
+    TEST_ASSERT_TRUE(a.size() > 20);
+    for (size_t i = 0; i < a.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT32(20, b[i].count);
+        TEST_ASSERT_EQUAL_FLOAT(a[i].mean, b[i].mean);
+        TEST_ASSERT_EQUAL_FLOAT(a[i].ewma, b[i].ewma);
+    }
+}
+
+// ============================================================================
+// Throughput
+// ============================================================================
+
+void test_aggregation_throughput() {
+    // One block of data, fed over and over
+    const size_t block = 1024;
+#ifdef ARDUINO
+    const size_t rounds = 64;
+#else
+    const size_t rounds = 1024;
+#endif
+    const size_t n = block * rounds;
+    std::vector<uint16_t> values(block);
+    std::vector<float> floats(block);
+    uint32_t state = 5;
+    for (size_t i = 0; i < block; i++) {
+        values[i] = noisy(state);
+        floats[i] = values[i];
+    }
+
+    // Raw accumulators
+    BeamAccumulator fixed;
+    unsigned long start = micros();
+    for (size_t r = 0; r < rounds; r++) fixed.add(values.data(), block);
+    const unsigned long fixedUs = micros() - start;
+
+    BeamFloatAccumulator welford;
+    start = micros();
+    for (size_t r = 0; r < rounds; r++) welford.add(floats.data(), block);
+    const unsigned long floatUs = micros() - start;
+
+    // Full aggregator (tumbling + sliding + EWMA) at 20 kHz, per sample and per block
+    BeamAggregator::Config cfg;
+    cfg.windowUs = 100000;
+    BeamAggregator perSample, perBlock;
+    perSample.begin(1, cfg);
+    perBlock.begin(1, cfg);
+    start = micros();
+    for (size_t i = 0; i < n; i++) perSample.add(0, values[i % block], static_cast<uint32_t>(i * 50));
+    const unsigned long sampleUs = micros() - start;
+    start = micros();
+    for (size_t i = 0; i < n; i += 256) {
+        perBlock.add(0, values.data() + i % block, 256, static_cast<uint32_t>(i * 50), 20000);
+    }
+    const unsigned long blockUs = micros() - start;
+
+    BeamWindow a, b;
+    fixed.result(a);
+    welford.result(b);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, a.mean, b.mean);
+    TEST_ASSERT_EQUAL_UINT32(perSample.windows(0), perBlock.windows(0));
+    TEST_ASSERT_EQUAL_FLOAT(perSample.last(0).mean, perBlock.last(0).mean);
+
+    auto rate = [n](unsigned long us) { return us ? n * 1e6 / us : 0.0; };
+    printf("{\"bench\":\"aggregate\",\"schema\":1,\"samples\":%lu,\"fixed_sps\":%.0f,\"float_sps\":%.0f,"
+           "\"aggregator_sample_sps\":%.0f,\"aggregator_block_sps\":%.0f}\n",
+           static_cast<unsigned long>(n), rate(fixedUs), rate(floatUs), rate(sampleUs), rate(blockUs));
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Accumulator Tests
+    RUN_TEST(test_fixed_accumulator_matches_naive);
+    RUN_TEST(test_fixed_accumulator_full_scale_is_exact);
+    RUN_TEST(test_merge_equals_single_pass);
+    RUN_TEST(test_ewma_converges);
+
+    // Window Tests
+    RUN_TEST(test_tumbling_boundaries_and_gaps);
+    RUN_TEST(test_late_samples_stay_in_current_window);
+    RUN_TEST(test_tumbling_block_path_matches_samples);
+    RUN_TEST(test_sliding_window_expires_panes);
+
+    // Aggregator Tests
+    RUN_TEST(test_aggregator_channels_and_callback);
+    RUN_TEST(test_aggregator_block_ewma_matches_samples);
+
+    // Throughput
+    RUN_TEST(test_aggregation_throughput);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
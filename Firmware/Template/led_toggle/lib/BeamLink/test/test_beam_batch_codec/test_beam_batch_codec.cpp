@@ -0,0 +1,336 @@
+/**
+ * @file test_beam_batch_codec.cpp
+ * @brief Tests for the delta/XOR batch formats: varints, round trips and compression
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beam_batch_codec`).
+ * The compression test encodes BeamSimAdc signals with timer jitter and
+ * prints bytes and encode cost per sample for each format.
+ */
+
+#include <unity.h>
+#include "BeamBatchCodec.h"
+#include <cstdio>
+#include <vector>
+
+#if !defined(ARDUINO) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+
+// CPU cycles where a counter is available, else 0
+static uint32_t cycleCount() {
+#if defined(ARDUINO) && defined(ESP32)
+    return ESP.getCycleCount();
+#elif defined(__x86_64__) || defined(__i386__)
+    return static_cast<uint32_t>(__rdtsc());
+#else
+    return 0;
+#endif
+}
+
+static const uint8_t kFormats[] = {kBeamBatchRaw, kBeamBatchDelta, kBeamBatchXor};
+
+// Bytes needed for everything, in batches of capacity bytes
+static size_t encodedSize(const std::vector<BeamSample>& in, uint8_t format, size_t capacity) {
+    std::vector<uint8_t> batch(capacity);
+    size_t offset = 0, bytes = 0, encoded = 1;
+    while (offset < in.size() && encoded) {
+        bytes += beamEncodeBatch(0, in.data() + offset, in.size() - offset, batch.data(), capacity, format, encoded);
+        offset += encoded;
+    }
+    return bytes;
+}
+
+// Encode everything in batches of capacity bytes, decode it back and compare
+static void roundTrip(const std::vector<BeamSample>& in, uint8_t format, size_t capacity) {
+    std::vector<uint8_t> batch(capacity);
+    BeamSample out[255];
+    size_t offset = 0;
+    while (offset < in.size()) {
+        size_t encoded = 0;
+        const size_t n = beamEncodeBatch(2, in.data() + offset, in.size() - offset, batch.data(),
+                                         capacity, format, encoded);
+        TEST_ASSERT_TRUE(n > 0 && n <= capacity);
+        TEST_ASSERT_TRUE(encoded > 0);
+
+        uint8_t channel = 0;
+        TEST_ASSERT_EQUAL_INT(static_cast<int>(encoded), beamDecodeBatch(batch.data(), n, &channel, out, 255));
+        TEST_ASSERT_EQUAL_UINT8(2, channel);
+        for (size_t i = 0; i < encoded; i++) {
+            TEST_ASSERT_EQUAL_UINT32(in[offset + i].timeUs, out[i].timeUs);
+            TEST_ASSERT_EQUAL_UINT16(in[offset + i].value, out[i].value);
+        }
+        offset += encoded;
+    }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Varint Tests
+// ============================================================================
+
+void test_zigzag_and_varint() {
+    TEST_ASSERT_EQUAL_UINT32(0, beamZigzag(0));
+    TEST_ASSERT_EQUAL_UINT32(1, beamZigzag(-1));
+    TEST_ASSERT_EQUAL_UINT32(2, beamZigzag(1));
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFFu, beamZigzag(INT32_MIN));
+    const int32_t values[] = {0, 1, -1, 63, -64, 64, 4095, -4095, INT32_MAX, INT32_MIN};
+    for (int32_t v : values) TEST_ASSERT_EQUAL_INT32(v, beamUnzigzag(beamZigzag(v)));
+
+    const uint32_t codes[] = {0, 127, 128, 16383, 16384, (1u << 21) - 1, 1u << 28, 0xFFFFFFFFu};
+    const size_t sizes[] = {1, 1, 2, 2, 3, 3, 5, 5};
+    uint8_t buf[5];
+    for (size_t i = 0; i < sizeof(codes) / sizeof(codes[0]); i++) {
+        TEST_ASSERT_EQUAL_UINT32(sizes[i], beamVarintSize(codes[i]));
+        TEST_ASSERT_EQUAL_UINT32(sizes[i], beamPutVarint(buf, codes[i]));
+        uint32_t back = 0;
+        TEST_ASSERT_EQUAL_UINT32(sizes[i], beamGetVarint(buf, buf + sizes[i], back));
+        TEST_ASSERT_EQUAL_UINT32(codes[i], back);
+        if (sizes[i] > 1) TEST_ASSERT_EQUAL_UINT32(0, beamGetVarint(buf, buf + sizes[i] - 1, back));
+    }
+    const uint8_t overlong[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+    uint32_t v = 0;
+    TEST_ASSERT_EQUAL_UINT32(0, beamGetVarint(overlong, overlong + sizeof(overlong), v));
+}
+
+// ============================================================================
+// Round Trip Tests
+// ============================================================================
+
+void test_steady_signal_is_small() {
+    std::vector<BeamSample> in;
+    for (uint32_t i = 0; i < 40; i++) in.push_back({1000000 + i * 5000, static_cast<uint16_t>(2000 + (i & 3))});
+
+    uint8_t batch[244];
+    size_t encoded = 0;
+    const size_t n = beamEncodeBatch(0, in.data(), in.size(), batch, sizeof(batch), kBeamBatchDelta, encoded);
+    TEST_ASSERT_EQUAL_UINT32(40, encoded);
+    // Header, first sample in full, then delta 5000 (2 bytes) once and 1+1 bytes after
+    TEST_ASSERT_EQUAL_UINT32(kBeamBatchHeader + kBeamBatchRawSample + 3 + 38 * 2, n);
+    TEST_ASSERT_EQUAL_UINT32(kBeamBatchHeader + 40 * kBeamBatchRawSample, encodedSize(in, kBeamBatchRaw, 244));
+    roundTrip(in, kBeamBatchDelta, 244);
+}
+
+void test_edge_values_round_trip() {
+    // Full-scale value jumps, irregular gaps and micros() wrapping mid-batch
+    std::vector<BeamSample> in;
+    uint32_t t = 0xFFFFF000u;
+    const uint16_t values[] = {0, 65535, 0, 1, 65534, 32768, 32767, 4095, 0};
+    for (size_t i = 0; i < 60; i++) {
+        t += (i % 7 == 0) ? 1000000u : 997u + (i % 5);
+        in.push_back({t, values[i % (sizeof(values) / sizeof(values[0]))]});
+    }
+    for (uint8_t format : kFormats) {
+        roundTrip(in, format, 244);
+        roundTrip(in, format, 20); // default MTU: a few samples per batch
+    }
+
+    // One sample
+    std::vector<BeamSample> one = {{42, 7}};
+    for (uint8_t format : kFormats) {
+        roundTrip(one, format, 20);
+        TEST_ASSERT_EQUAL_UINT32(kBeamBatchHeader + kBeamBatchRawSample, encodedSize(one, format, 20));
+    }
+}
+
+void test_random_round_trip() {
+    uint32_t state = 99;
+    auto next = [&state] { return state = state * 1664525u + 1013904223u; };
+    std::vector<BeamSample> in;
+    uint32_t t = 0;
+    for (size_t i = 0; i < 2000; i++) {
+        t += next() >> (next() % 32);
+        in.push_back({t, static_cast<uint16_t>(next() >> 16)});
+    }
+    for (uint8_t format : kFormats) roundTrip(in, format, 244);
+}
+
+void test_encoder_limits() {
+    uint8_t batch[600];
+    BeamBatchEncoder enc;
+    TEST_ASSERT_FALSE(enc.begin(batch, 2, 0));
+    TEST_ASSERT_FALSE(enc.begin(batch, sizeof(batch), 0, 9));
+    TEST_ASSERT_FALSE(enc.add({0, 0}));
+    TEST_ASSERT_EQUAL_UINT32(0, enc.finish());
+
+    // 255 samples at most, however small they are
+    TEST_ASSERT_TRUE(enc.begin(batch, sizeof(batch), 1, kBeamBatchDelta));
+    uint32_t added = 0;
+    while (enc.add({added * 10, 100})) added++;
+    TEST_ASSERT_EQUAL_UINT32(255, added);
+    TEST_ASSERT_EQUAL_UINT32(enc.size(), enc.finish());
+
+    // Not even the first sample fits
+    TEST_ASSERT_TRUE(enc.begin(batch, 8, 1, kBeamBatchDelta));
+    TEST_ASSERT_FALSE(enc.add({0, 0}));
+    TEST_ASSERT_EQUAL_UINT32(0, enc.finish());
+}
+
+void test_malformed_batches_rejected() {
+    std::vector<BeamSample> in;
+    for (uint32_t i = 0; i < 10; i++) in.push_back({i * 1000, static_cast<uint16_t>(i * 300)});
+    uint8_t batch[64];
+    size_t encoded = 0;
+    const size_t n = beamEncodeBatch(0, in.data(), in.size(), batch, sizeof(batch), kBeamBatchDelta, encoded);
+    BeamSample out[16];
+
+    TEST_ASSERT_EQUAL_INT(10, beamDecodeBatch(batch, n, nullptr, out, 16));
+    TEST_ASSERT_EQUAL_INT(10, beamDecodeBatch(batch, n, nullptr, out, 4)); // only 4 stored
+    TEST_ASSERT_EQUAL_INT(-1, beamDecodeBatch(batch, n - 1, nullptr, out, 16));
+    TEST_ASSERT_EQUAL_INT(-1, beamDecodeBatch(batch, n + 1, nullptr, out, 16)); // trailing byte
+    batch[2] = 11; // more samples than bytes
+    TEST_ASSERT_EQUAL_INT(-1, beamDecodeBatch(batch, n, nullptr, out, 16));
+    batch[2] = 10;
+    batch[0] = 4;
+    TEST_ASSERT_EQUAL_INT(-1, beamDecodeBatch(batch, n, nullptr, out, 16));
+
+    // A value delta that leaves 16 bits
+    const BeamSample low[] = {{0, 5}, {10, 0}};
+    beamEncodeBatch(0, low, 2, batch, sizeof(batch), kBeamBatchDelta, encoded);
+    batch[kBeamBatchHeader + kBeamBatchRawSample + 1] = 0x0B; // -6 instead of -5
+    TEST_ASSERT_EQUAL_INT(-1, beamDecodeBatch(batch, kBeamBatchHeader + kBeamBatchRawSample + 2, nullptr, out, 16));
+}
+
+void test_sampler_reads_delta_batches() {
+    BeamSimAdc adc;
+    BeamSimAdc::Signal s;
+    s.offset = 2000;
+    s.amplitude = 300;
+    s.frequencyHz = 5;
+    adc.setSignal(0, s);
+    const uint8_t pins[] = {34};
+    BeamSampler sampler;
+    TEST_ASSERT_TRUE(sampler.begin(adc, pins, 1, 1000));
+    for (uint32_t i = 0; i < 200; i++) sampler.tick(i * 1000 + (i % 3));
+
+    uint8_t batch[244];
+    BeamSample out[255];
+    uint32_t expectedUs = 0;
+    size_t total = 0, batches = 0, n;
+    while ((n = sampler.readBatch(0, batch, sizeof(batch), kBeamBatchXor)) > 0) {
+        const int count = beamDecodeBatch(batch, n, nullptr, out, 255);
+        TEST_ASSERT_TRUE(count > 0);
+        for (int i = 0; i < count; i++, total++) {
+            TEST_ASSERT_EQUAL_UINT32(expectedUs + (total % 3), out[i].timeUs);
+            expectedUs += 1000;
+        }
+        batches++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(200, total); // nothing lost between batches
+    TEST_ASSERT_TRUE(batches < 200 / beamBatchSamples(sizeof(batch)));
+    TEST_ASSERT_EQUAL_UINT32(0, sampler.available(0));
+}
+
+// ============================================================================
+// Compression
+// ============================================================================
+
+static void benchSignal(const char* name, const BeamSimAdc::Signal& signal, uint32_t rateHz) {
+    BeamSimAdc adc;
+    adc.setSignal(0, signal);
+    const size_t count = 4000;
+    std::vector<BeamSample> in(count);
+    const uint32_t period = 1000000 / rateHz;
+    uint32_t jitter = 12345;
+    for (size_t i = 0; i < count; i++) {
+        // esp_timer dispatch jitter of a few microseconds
+        jitter = jitter * 1664525u + 1013904223u;
+        const uint32_t t = static_cast<uint32_t>(i) * period + (jitter >> 29);
+        in[i] = {t, adc.read(0, t)};
+    }
+
+    const size_t capacity = 244;
+    size_t bytes[3] = {};
+    float cycles[3] = {}, ns[3] = {};
+    std::vector<uint8_t> batch(capacity);
+    for (size_t f = 0; f < 3; f++) {
+        roundTrip(in, kFormats[f], capacity);
+        bytes[f] = encodedSize(in, kFormats[f], capacity);
+
+        const int rounds = 10;
+        const unsigned long start = micros();
+        const uint32_t c0 = cycleCount();
+        for (int r = 0; r < rounds; r++) {
+            size_t offset = 0, encoded = 0;
+            while (offset < count) {
+                beamEncodeBatch(0, in.data() + offset, count - offset, batch.data(), capacity, kFormats[f], encoded);
+                offset += encoded;
+            }
+        }
+        cycles[f] = static_cast<float>(cycleCount() - c0) / (rounds * count);
+        ns[f] = (micros() - start) * 1000.0f / (rounds * count);
+    }
+    TEST_ASSERT_TRUE(bytes[1] < bytes[0]);
+
+    printf("{\"bench\":\"batch_codec\",\"schema\":1,\"signal\":\"%s\",\"rate_hz\":%lu,\"samples\":%lu,"
+           "\"raw_bytes\":%lu,\"delta_bytes\":%lu,\"xor_bytes\":%lu,\"delta_ratio\":%.2f,\"xor_ratio\":%.2f,"
+           "\"raw_cycles_per_sample\":%.1f,\"delta_cycles_per_sample\":%.1f,\"xor_cycles_per_sample\":%.1f,"
+           "\"delta_ns_per_sample\":%.1f}\n",
+           name, static_cast<unsigned long>(rateHz), static_cast<unsigned long>(count),
+           static_cast<unsigned long>(bytes[0]), static_cast<unsigned long>(bytes[1]),
+           static_cast<unsigned long>(bytes[2]), static_cast<float>(bytes[0]) / bytes[1],
+           static_cast<float>(bytes[0]) / bytes[2], cycles[0], cycles[1], cycles[2], ns[1]);
+}
+
+void test_compression_on_realistic_signals() {
+    BeamSimAdc::Signal s;
+
+    // Temperature-like: flat with a couple of counts of noise
+    s.offset = 1850;
+    s.noise = 3;
+    benchSignal("slow", s, 200);
+
+    // Vibration: 50 Hz at 1 kHz sampling, some noise
+    s.offset = 2048;
+    s.amplitude = 600;
+    s.frequencyHz = 50;
+    s.noise = 10;
+    benchSignal("vibration", s, 1000);
+
+    // Mostly noise: the worst case for delta coding
+    s.offset = 2048;
+    s.amplitude = 0;
+    s.noise = 400;
+    benchSignal("noisy", s, 1000);
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Varint Tests
+    RUN_TEST(test_zigzag_and_varint);
+
+    // Round Trip Tests
+    RUN_TEST(test_steady_signal_is_small);
+    RUN_TEST(test_edge_values_round_trip);
+    RUN_TEST(test_random_round_trip);
+    RUN_TEST(test_encoder_limits);
+    RUN_TEST(test_malformed_batches_rejected);
+    RUN_TEST(test_sampler_reads_delta_batches);
+
+    // Compression
+    RUN_TEST(test_compression_on_realistic_signals);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
@@ -0,0 +1,379 @@
+/**
+ * @file test_beam_dsp.cpp
+ * @brief Tests for the calibration and filter stages: known values and fast == scalar
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beam_dsp`).
+ * Every stage's process() must match its processScalar() bit for bit, over
+ * random data, odd block sizes and consecutive blocks. The throughput test
+ * prints blocks per second for both paths.
+ */
+
+#include <unity.h>
+#include "BeamDsp.h"
+#include "BeamConfig.h"
+#include "BeamPlatform.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static uint32_t rngState = 1;
+
+static uint32_t nextRandom() {
+    return rngState = rngState * 1664525u + 1013904223u;
+}
+
+// Raw 12-bit counts: a slow sine, noise and an occasional full-scale spike
+static std::vector<uint16_t> rawSignal(size_t n) {
+    std::vector<uint16_t> raw(n);
+    for (size_t i = 0; i < n; i++) {
+        int32_t v = 2048 + static_cast<int32_t>(1500 * std::sin(i * 0.01f)) + static_cast<int32_t>(nextRandom() >> 26) - 32;
+        if (nextRandom() % 50 == 0) v = (nextRandom() & 1) ? 4095 : 0;
+        raw[i] = static_cast<uint16_t>(v);
+    }
+    return raw;
+}
+
+static std::vector<int16_t> randomSamples(size_t n) {
+    std::vector<int16_t> data(n);
+    for (int16_t& v : data) v = static_cast<int16_t>(nextRandom() >> 16);
+    return data;
+}
+
+// Block sizes that exercise both the lane loops and their scalar tails
+static const size_t kBlockSizes[] = {1, 7, 8, 9, 63, 64, 65, 200, 256};
+
+// Run fast and scalar copies of a stage over the same blocks and compare
+template <typename Stage>
+static void checkStageBitExact(Stage& fast, Stage& scalar, const std::vector<int16_t>& input) {
+    std::vector<int16_t> a(input), b(input);
+    size_t offset = 0, k = 0;
+    while (offset < input.size()) {
+        const size_t n = std::min(kBlockSizes[k++ % (sizeof(kBlockSizes) / sizeof(kBlockSizes[0]))], input.size() - offset);
+        fast.process(a.data() + offset, n);
+        scalar.processScalar(b.data() + offset, n);
+        offset += n;
+    }
+    TEST_ASSERT_EQUAL_INT16_ARRAY(b.data(), a.data(), input.size());
+}
+
+void setUp(void) {
+    rngState = 1;
+}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Calibration Tests
+// ============================================================================
+
+void test_calibration_values() {
+    BeamCalibration cal = BeamCalibration::from(2.0f, 0.0f);
+    TEST_ASSERT_EQUAL_INT32(0, cal.offset);
+    TEST_ASSERT_EQUAL_INT32(8192, cal.gainQ12);
+
+    const uint16_t in[] = {0, 1, 100, 4095, 20000, 65535};
+    int16_t out[6];
+    cal.process(in, out, 6);
+    TEST_ASSERT_EQUAL_INT16(0, out[0]);
+    TEST_ASSERT_EQUAL_INT16(2, out[1]);
+    TEST_ASSERT_EQUAL_INT16(200, out[2]);
+    TEST_ASSERT_EQUAL_INT16(8190, out[3]);
+    TEST_ASSERT_EQUAL_INT16(32767, out[4]);  // saturated
+    TEST_ASSERT_EQUAL_INT16(32767, out[5]);
+
+    // Offset below zero and a negative gain
+    cal.offset = 1000;
+    cal.gainQ12 = -2048;  // -0.5
+    cal.process(in, out, 6);
+    TEST_ASSERT_EQUAL_INT16(500, out[0]);
+    TEST_ASSERT_EQUAL_INT16(450, out[2]);
+    TEST_ASSERT_EQUAL_INT16(-1547, out[3]);  // (3095 x -0.5) rounds up
+    TEST_ASSERT_EQUAL_INT16(-32267, out[5]);
+
+    // Fraction of full scale, as BeamConfig stores it
+    BeamConfig cfg;
+    cfg.sensorGain = 1.5f;
+    cfg.zeroOffset = 0.02f;
+    cal = BeamCalibration::fromConfig(cfg);
+    TEST_ASSERT_EQUAL_INT32(82, cal.offset);
+    TEST_ASSERT_EQUAL_INT32(6144, cal.gainQ12);
+    TEST_ASSERT_EQUAL_INT32(32767, BeamCalibration::from(100.0f, 0.0f).gainQ12);
+}
+
+void test_calibration_bit_exact() {
+    std::vector<uint16_t> in(1000);
+    for (uint16_t& v : in) v = static_cast<uint16_t>(nextRandom() >> 16);
+    std::vector<int16_t> a(in.size()), b(in.size());
+
+    // Includes offsets and gains far outside anything sensible
+    const int32_t offsets[] = {0, 82, 2048, -70000, 200000};
+    const int32_t gains[] = {4096, 1, -4096, 32767, -32767, 100000, -100000};
+    for (int32_t offset : offsets) {
+        for (int32_t gain : gains) {
+            BeamCalibration cal;
+            cal.offset = offset;
+            cal.gainQ12 = gain;
+            for (size_t n : kBlockSizes) {
+                cal.process(in.data(), a.data(), n);
+                cal.processScalar(in.data(), b.data(), n);
+                TEST_ASSERT_EQUAL_INT16_ARRAY(b.data(), a.data(), n);
+            }
+            cal.process(in.data(), a.data(), in.size());
+            cal.processScalar(in.data(), b.data(), in.size());
+            TEST_ASSERT_EQUAL_INT16_ARRAY(b.data(), a.data(), in.size());
+        }
+    }
+}
+
+// ============================================================================
+// Filter Tests
+// ============================================================================
+
+void test_moving_average_values() {
+    BeamMovingAverage avg;
+    TEST_ASSERT_FALSE(avg.begin(0));
+    TEST_ASSERT_FALSE(avg.begin(6));
+    TEST_ASSERT_FALSE(avg.begin(BEAM_DSP_MAX_AVERAGE * 2));
+    TEST_ASSERT_TRUE(avg.begin(4));
+    TEST_ASSERT_EQUAL_UINT32(4, avg.window());
+
+    // Primed with the first sample, then the window fills up
+    int16_t data[] = {100, 200, 300, 400, 500, -1000};
+    avg.process(data, 6);
+    TEST_ASSERT_EQUAL_INT16(100, data[0]);
+    TEST_ASSERT_EQUAL_INT16(125, data[1]);
+    TEST_ASSERT_EQUAL_INT16(175, data[2]);
+    TEST_ASSERT_EQUAL_INT16(250, data[3]);
+    TEST_ASSERT_EQUAL_INT16(350, data[4]);
+    TEST_ASSERT_EQUAL_INT16(50, data[5]);
+
+    // Window 1 is pass-through
+    TEST_ASSERT_TRUE(avg.begin(1));
+    int16_t same[] = {1, -2, 3};
+    avg.process(same, 3);
+    TEST_ASSERT_EQUAL_INT16(-2, same[1]);
+}
+
+void test_median_values() {
+    BeamMedianFilter median;
+    TEST_ASSERT_FALSE(median.begin(0));
+    TEST_ASSERT_FALSE(median.begin(4));
+    TEST_ASSERT_FALSE(median.begin(11));
+    TEST_ASSERT_TRUE(median.begin(3));
+
+    int16_t data[] = {10, 12, 4000, 11, 13, -3000, -3000, 12, 12};
+    median.process(data, 9);
+    const int16_t expected[] = {10, 10, 12, 12, 13, 11, -3000, -3000, 12};
+    TEST_ASSERT_EQUAL_INT16_ARRAY(expected, data, 9);
+
+    // A spike shorter than half the window disappears entirely
+    TEST_ASSERT_TRUE(median.begin(5));
+    std::vector<int16_t> flat(100, 500);
+    flat[40] = 32767;
+    flat[41] = -32768;
+    flat[70] = 0;
+    median.process(flat.data(), flat.size());
+    for (int16_t v : flat) TEST_ASSERT_EQUAL_INT16(500, v);
+}
+
+void test_filters_bit_exact() {
+    const std::vector<int16_t> input = randomSamples(3000);
+
+    for (size_t window = 1; window <= BEAM_DSP_MAX_AVERAGE; window *= 2) {
+        BeamMovingAverage fast, scalar;
+        TEST_ASSERT_TRUE(fast.begin(window));
+        TEST_ASSERT_TRUE(scalar.begin(window));
+        checkStageBitExact(fast, scalar, input);
+    }
+
+    for (size_t window = 1; window <= BEAM_DSP_MAX_MEDIAN; window += 2) {
+        BeamMedianFilter fast, scalar;
+        TEST_ASSERT_TRUE(fast.begin(window));
+        TEST_ASSERT_TRUE(scalar.begin(window));
+        checkStageBitExact(fast, scalar, input);
+    }
+
+    // Full-scale input drives the biquads into saturation
+    const BeamBiquad::Coefficients designs[] = {
+        BeamBiquad::lowPass(1000, 50), BeamBiquad::lowPass(20000, 40), BeamBiquad::highPass(1000, 100),
+        BeamBiquad::bandPass(1000, 60, 5.0f), BeamBiquad::Coefficients()};
+    for (const BeamBiquad::Coefficients& c : designs) {
+        BeamBiquad fast, scalar;
+        fast.begin(c);
+        scalar.begin(c);
+        checkStageBitExact(fast, scalar, input);
+    }
+}
+
+void test_biquad_response() {
+    const float fs = 1000;
+    BeamBiquad lp;
+    lp.begin(BeamBiquad::lowPass(fs, 20));
+
+    // DC passes at unity gain
+    std::vector<int16_t> dc(500, 10000);
+    lp.process(dc.data(), dc.size());
+    TEST_ASSERT_INT_WITHIN(3, 10000, dc.back());
+
+    // 200 Hz is ten times the cut-off: -40 dB for a second-order section
+    lp.reset();
+    std::vector<int16_t> tone(1000);
+    for (size_t i = 0; i < tone.size(); i++) tone[i] = static_cast<int16_t>(10000 * std::sin(2 * 3.14159265f * 200 * i / fs));
+    lp.process(tone.data(), tone.size());
+    int16_t peak = 0;
+    for (size_t i = 500; i < tone.size(); i++) peak = std::max<int16_t>(peak, static_cast<int16_t>(std::abs(tone[i])));
+    TEST_ASSERT_TRUE(peak < 150);
+
+    // High-pass removes DC
+    BeamBiquad hp;
+    hp.begin(BeamBiquad::highPass(fs, 20));
+    std::fill(dc.begin(), dc.end(), 10000);
+    hp.process(dc.data(), dc.size());
+    TEST_ASSERT_INT_WITHIN(3, 0, dc.back());
+}
+
+// ============================================================================
+// Pipeline Tests
+// ============================================================================
+
+static BeamDspPipeline::Config fullConfig() {
+    BeamDspPipeline::Config cfg;
+    cfg.calibration = BeamCalibration::from(1.25f, 0.5f);
+    cfg.medianWindow = 5;
+    cfg.averageWindow = 8;
+    cfg.filterEnabled = true;
+    cfg.filter = BeamBiquad::lowPass(1000, 50);
+    return cfg;
+}
+
+void test_pipeline() {
+    BeamDspPipeline fast, scalar;
+    BeamDspPipeline::Config cfg = fullConfig();
+    cfg.medianWindow = 4;
+    TEST_ASSERT_FALSE(fast.begin(cfg));
+
+    cfg = fullConfig();
+    TEST_ASSERT_TRUE(fast.begin(cfg));
+    TEST_ASSERT_TRUE(scalar.begin(cfg));
+    TEST_ASSERT_EQUAL_UINT32(8, fast.config().averageWindow);
+
+    const std::vector<uint16_t> raw = rawSignal(4000);
+    std::vector<int16_t> a(raw.size()), b(raw.size());
+    size_t offset = 0, k = 0;
+    while (offset < raw.size()) {
+        const size_t n = std::min(kBlockSizes[k++ % (sizeof(kBlockSizes) / sizeof(kBlockSizes[0]))], raw.size() - offset);
+        fast.process(raw.data() + offset, a.data() + offset, n);
+        scalar.processScalar(raw.data() + offset, b.data() + offset, n);
+        offset += n;
+    }
+    TEST_ASSERT_EQUAL_INT16_ARRAY(b.data(), a.data(), raw.size());
+
+    // reset() starts over: the same block gives the same output
+    std::vector<int16_t> first(256), again(256);
+    fast.reset();
+    fast.process(raw.data(), first.data(), 256);
+    fast.reset();
+    fast.process(raw.data(), again.data(), 256);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(first.data(), again.data(), 256);
+}
+
+// ============================================================================
+// Throughput
+// ============================================================================
+
+// Blocks per second through fn, for a 256-sample block
+template <typename Fn>
+static float blocksPerSecond(Fn fn, int rounds) {
+    const unsigned long start = micros();
+    for (int r = 0; r < rounds; r++) fn();
+    const unsigned long elapsed = micros() - start;
+    return elapsed ? rounds * 1e6f / elapsed : 0.0f;
+}
+
+void test_throughput() {
+    const size_t block = 256;
+#ifdef ARDUINO
+    const int rounds = 200;
+#else
+    const int rounds = 20000;
+#endif
+    const std::vector<uint16_t> raw = rawSignal(block);
+    std::vector<int16_t> data = randomSamples(block);
+    std::vector<int16_t> out(block);
+
+    BeamCalibration cal = BeamCalibration::from(1.25f, 0.02f);
+    BeamMedianFilter median;
+    median.begin(5);
+    BeamMovingAverage avg;
+    avg.begin(16);
+    BeamBiquad bq;
+    bq.begin(BeamBiquad::lowPass(1000, 50));
+    BeamDspPipeline pipeline;
+    pipeline.begin(fullConfig());
+
+    struct Result {
+        const char* stage;
+        float scalar, fast;
+    } results[] = {
+        {"calibration", blocksPerSecond([&] { cal.processScalar(raw.data(), out.data(), block); }, rounds),
+         blocksPerSecond([&] { cal.process(raw.data(), out.data(), block); }, rounds)},
+        {"median5", blocksPerSecond([&] { median.processScalar(data.data(), block); }, rounds),
+         blocksPerSecond([&] { median.process(data.data(), block); }, rounds)},
+        {"average16", blocksPerSecond([&] { avg.processScalar(data.data(), block); }, rounds),
+         blocksPerSecond([&] { avg.process(data.data(), block); }, rounds)},
+        {"biquad", blocksPerSecond([&] { bq.processScalar(data.data(), block); }, rounds),
+         blocksPerSecond([&] { bq.process(data.data(), block); }, rounds)},
+        {"pipeline", blocksPerSecond([&] { pipeline.processScalar(raw.data(), out.data(), block); }, rounds),
+         blocksPerSecond([&] { pipeline.process(raw.data(), out.data(), block); }, rounds)},
+    };
+
+    for (const Result& r : results) {
+        TEST_ASSERT_TRUE(r.fast > 0);
+        printf("{\"bench\":\"dsp\",\"schema\":1,\"stage\":\"%s\",\"block\":%lu,\"lanes\":%d,"
+               "\"scalar_blocks_per_s\":%.0f,\"fast_blocks_per_s\":%.0f,\"speedup\":%.2f}\n",
+               r.stage, static_cast<unsigned long>(block), BEAM_DSP_LANES, r.scalar, r.fast,
+               r.scalar > 0 ? r.fast / r.scalar : 0.0f);
+    }
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Calibration Tests
+    RUN_TEST(test_calibration_values);
+    RUN_TEST(test_calibration_bit_exact);
+
+    // Filter Tests
+    RUN_TEST(test_moving_average_values);
+    RUN_TEST(test_median_values);
+    RUN_TEST(test_filters_bit_exact);
+    RUN_TEST(test_biquad_response);
+
+    // Pipeline Tests
+    RUN_TEST(test_pipeline);
+
+    // Throughput
+    RUN_TEST(test_throughput);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
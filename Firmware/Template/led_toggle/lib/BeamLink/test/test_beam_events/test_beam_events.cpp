@@ -0,0 +1,177 @@
+/**
+ * @file test_beam_events.cpp
+ * @brief Tests for BeamEventFlags (wake-on-event for loop())
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beam_events`).
+ * The cross-thread tests and the polling vs. event benchmark are host only.
+ */
+
+#include <unity.h>
+#include "BeamEvents.h"
+#include <cstdio>
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Single-task Tests
+// ============================================================================
+
+void test_events_pending_returned_and_cleared() {
+    BeamEventFlags flags;
+    flags.signal(BEAM_EVENT_RX);
+    flags.signal(BEAM_EVENT_CONNECT);
+
+    TEST_ASSERT_EQUAL_UINT32(BEAM_EVENT_RX | BEAM_EVENT_CONNECT, flags.wait(0));
+    TEST_ASSERT_EQUAL_UINT32(0, flags.wait(0));
+
+    BeamEventStats s = flags.stats();
+    TEST_ASSERT_EQUAL_UINT32(2, s.signals);
+    TEST_ASSERT_EQUAL_UINT32(1, s.wakeups);
+    TEST_ASSERT_EQUAL_UINT32(1, s.timeouts);
+}
+
+void test_events_timeout() {
+    BeamEventFlags flags;
+    const unsigned long start = millis();
+    TEST_ASSERT_EQUAL_UINT32(0, flags.wait(20));
+    TEST_ASSERT_TRUE(millis() - start >= 19);
+    TEST_ASSERT_EQUAL_UINT32(1, flags.stats().timeouts);
+
+    flags.resetStats();
+    TEST_ASSERT_EQUAL_UINT32(0, flags.stats().timeouts);
+}
+
+void test_events_wake_mask() {
+    BeamEventFlags flags;
+    flags.setWakeMask(BEAM_EVENT_RX | BEAM_EVENT_USER);
+
+    // TX completions accumulate without waking
+    flags.signal(BEAM_EVENT_TX_DONE);
+    TEST_ASSERT_EQUAL_UINT32(0, flags.wait(5));
+
+    flags.signal(BEAM_EVENT_USER << 1);
+    TEST_ASSERT_EQUAL_UINT32(0, flags.wait(0));
+
+    flags.signal(BEAM_EVENT_RX);
+    TEST_ASSERT_EQUAL_UINT32(BEAM_EVENT_RX | BEAM_EVENT_TX_DONE | (BEAM_EVENT_USER << 1), flags.wait(0));
+}
+
+// ============================================================================
+// Cross-thread Tests (host only)
+// ============================================================================
+
+#ifndef ARDUINO
+#include <atomic>
+#include <thread>
+
+void test_events_wake_from_other_thread() {
+    BeamEventFlags flags;
+    std::thread producer([&] {
+        delay(20);
+        flags.signal(BEAM_EVENT_RX);
+    });
+
+    const unsigned long start = millis();
+    TEST_ASSERT_EQUAL_UINT32(BEAM_EVENT_RX, flags.wait(2000));
+    const unsigned long waited = millis() - start;
+    producer.join();
+
+    TEST_ASSERT_TRUE(waited >= 19 && waited < 500);
+    BeamEventStats s = flags.stats();
+    TEST_ASSERT_EQUAL_UINT32(1, s.wakeups);
+    TEST_ASSERT_TRUE(s.lastLatencyUs < 100000);
+}
+
+// Commands arrive every 20-60 ms; compare the old delay(10) polling loop with wait()
+void test_events_vs_polling_bench() {
+    const int commands = 40;
+
+    // Before: loop() polls a flag and sleeps 10 ms
+    std::atomic<uint32_t> posted{0};
+    std::atomic<unsigned long> postedAt{0};
+    unsigned long pollLatency = 0;
+    uint32_t pollWakeups = 0;
+    std::thread pollProducer([&] {
+        for (int i = 0; i < commands; i++) {
+            delay(20 + (i * 13) % 41);
+            postedAt.store(micros());
+            posted.fetch_add(1);
+        }
+    });
+    uint32_t seen = 0;
+    const unsigned long pollStart = millis();
+    while (seen < static_cast<uint32_t>(commands)) {
+        pollWakeups++;
+        if (posted.load() != seen) {
+            pollLatency += micros() - postedAt.load();
+            seen = posted.load();
+        }
+        delay(10);
+    }
+    const unsigned long pollMs = millis() - pollStart;
+    pollProducer.join();
+
+    // After: loop() blocks in wait()
+    BeamEventFlags flags;
+    std::thread eventProducer([&] {
+        for (int i = 0; i < commands; i++) {
+            delay(20 + (i * 13) % 41);
+            flags.signal(BEAM_EVENT_RX);
+        }
+    });
+    uint32_t handled = 0;
+    while (handled < static_cast<uint32_t>(commands)) {
+        if (flags.wait(1000)) handled++;
+    }
+    eventProducer.join();
+    BeamEventStats s = flags.stats();
+
+    const uint32_t pollMeanUs = static_cast<uint32_t>(pollLatency / commands);
+    printf("{\"bench\":\"loop_wake\",\"schema\":1,\"mode\":\"poll_10ms\",\"wakeups_per_s\":%.1f,\"latency_mean_us\":%lu}\n",
+           pollWakeups * 1000.0f / pollMs, static_cast<unsigned long>(pollMeanUs));
+    printf("{\"bench\":\"loop_wake\",\"schema\":1,\"mode\":\"event\",\"wakeups_per_s\":%.1f,\"latency_mean_us\":%lu,\"latency_max_us\":%lu}\n",
+           s.wakeupsPerSecond(), static_cast<unsigned long>(s.meanLatencyUs()),
+           static_cast<unsigned long>(s.maxLatencyUs));
+
+    TEST_ASSERT_EQUAL_UINT32(commands, s.wakeups);
+    TEST_ASSERT_TRUE(s.meanLatencyUs() < pollMeanUs);
+}
+#endif
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Single-task Tests
+    RUN_TEST(test_events_pending_returned_and_cleared);
+    RUN_TEST(test_events_timeout);
+    RUN_TEST(test_events_wake_mask);
+
+#ifndef ARDUINO
+    // Cross-thread Tests
+    RUN_TEST(test_events_wake_from_other_thread);
+    RUN_TEST(test_events_vs_polling_bench);
+#endif
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
@@ -0,0 +1,172 @@
+/**
+ * @file test_beam_gatt_layout.cpp
+ * @brief Tests for the GATT layout version and connect-to-first-command timing
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beam_gatt_layout`).
+ * Layouts are built as BeamLink::setupService() builds them.
+ */
+
+#include <unity.h>
+#include "BeamGattLayout.h"
+#include "BeamStreams.h"
+#include "Uuids.h"
+
+static const uint8_t kMainProperties = BEAM_STREAM_READ | BEAM_STREAM_WRITE | BEAM_STREAM_NOTIFY;
+
+// The LED template: service, commands, state stream, layout version
+static BeamGattLayout templateLayout() {
+    BeamGattLayout layout;
+    layout.addService(BMLK_SERVICE_UUID);
+    layout.addCharacteristic(BMLK_CHARACTERISTIC_UUID, kMainProperties);
+    layout.addCharacteristic(BMLK_STATE_STREAM_UUID, BEAM_STREAM_NOTIFY);
+    layout.addCharacteristic(BMLK_LAYOUT_UUID, BEAM_STREAM_READ);
+    return layout;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Layout Tests
+// ============================================================================
+
+void test_layout_hash_is_deterministic() {
+    const BeamGattLayout a = templateLayout();
+    const BeamGattLayout b = templateLayout();
+    TEST_ASSERT_EQUAL_UINT32(a.hash(), b.hash());
+
+    // Pinned: a different value means every cached central rediscovers
+    TEST_ASSERT_EQUAL_UINT32(0xc4a985b4u, a.hash());
+}
+
+void test_layout_hash_ignores_uuid_case() {
+    BeamGattLayout upper;
+    upper.addService("12345678-1234-1234-1234-1234567890AB");
+    upper.addCharacteristic("12345678-1234-1234-1234-1234567890AC", kMainProperties);
+    upper.addCharacteristic(BMLK_STATE_STREAM_UUID, BEAM_STREAM_NOTIFY);
+    upper.addCharacteristic(BMLK_LAYOUT_UUID, BEAM_STREAM_READ);
+    TEST_ASSERT_EQUAL_UINT32(templateLayout().hash(), upper.hash());
+}
+
+void test_layout_hash_changes_with_layout() {
+    const uint32_t base = templateLayout().hash();
+
+    // Streams in another order: other handles
+    BeamGattLayout reordered;
+    reordered.addService(BMLK_SERVICE_UUID);
+    reordered.addCharacteristic(BMLK_STATE_STREAM_UUID, BEAM_STREAM_NOTIFY);
+    reordered.addCharacteristic(BMLK_CHARACTERISTIC_UUID, kMainProperties);
+    reordered.addCharacteristic(BMLK_LAYOUT_UUID, BEAM_STREAM_READ);
+    TEST_ASSERT_TRUE(reordered.hash() != base);
+
+    // Same UUID, notify dropped: one attribute (CCCD) fewer
+    BeamGattLayout noNotify;
+    noNotify.addService(BMLK_SERVICE_UUID);
+    noNotify.addCharacteristic(BMLK_CHARACTERISTIC_UUID, kMainProperties);
+    noNotify.addCharacteristic(BMLK_STATE_STREAM_UUID, BEAM_STREAM_READ);
+    noNotify.addCharacteristic(BMLK_LAYOUT_UUID, BEAM_STREAM_READ);
+    TEST_ASSERT_TRUE(noNotify.hash() != base);
+
+    // Extra stream
+    BeamGattLayout extra;
+    extra.addService(BMLK_SERVICE_UUID);
+    extra.addCharacteristic(BMLK_CHARACTERISTIC_UUID, kMainProperties);
+    extra.addCharacteristic(BMLK_STATE_STREAM_UUID, BEAM_STREAM_NOTIFY);
+    extra.addCharacteristic(BMLK_LOG_STREAM_UUID, BEAM_STREAM_NOTIFY);
+    extra.addCharacteristic(BMLK_LAYOUT_UUID, BEAM_STREAM_READ);
+    TEST_ASSERT_TRUE(extra.hash() != base);
+
+    // clear() starts over
+    extra.clear();
+    extra.addService(BMLK_SERVICE_UUID);
+    extra.addCharacteristic(BMLK_CHARACTERISTIC_UUID, kMainProperties);
+    extra.addCharacteristic(BMLK_STATE_STREAM_UUID, BEAM_STREAM_NOTIFY);
+    extra.addCharacteristic(BMLK_LAYOUT_UUID, BEAM_STREAM_READ);
+    TEST_ASSERT_EQUAL_UINT32(base, extra.hash());
+}
+
+void test_layout_attribute_count() {
+    // service 1 + main 3 + state 3 + layout 2
+    TEST_ASSERT_EQUAL_INT(9, templateLayout().attributeCount());
+}
+
+void test_layout_rejects_bad_uuid() {
+    BeamGattLayout layout;
+    TEST_ASSERT_FALSE(layout.addService("not-a-uuid"));
+    TEST_ASSERT_FALSE(layout.addCharacteristic(nullptr, BEAM_STREAM_READ));
+    TEST_ASSERT_TRUE(layout.addCharacteristic(BMLK_LAYOUT_UUID, BEAM_STREAM_READ));
+}
+
+// ============================================================================
+// Connect Timer Tests
+// ============================================================================
+
+void test_connect_timer_first_command_only() {
+    BeamConnectTimer timer;
+    TEST_ASSERT_FALSE(timer.command(100)); // not connected
+
+    timer.connected(1000);
+    TEST_ASSERT_TRUE(timer.command(251000));
+    TEST_ASSERT_FALSE(timer.command(300000));
+
+    timer.connected(1000000);
+    TEST_ASSERT_TRUE(timer.command(1050000));
+
+    // Connected, then dropped before any command
+    timer.connected(2000000);
+
+    const BeamConnectStats& s = timer.stats();
+    TEST_ASSERT_EQUAL_UINT32(3, s.connections);
+    TEST_ASSERT_EQUAL_UINT32(2, s.measured);
+    TEST_ASSERT_EQUAL_UINT32(50000, s.lastUs);
+    TEST_ASSERT_EQUAL_UINT32(250000, s.maxUs);
+    TEST_ASSERT_EQUAL_UINT32(150000, s.meanUs());
+
+    timer.resetStats();
+    TEST_ASSERT_EQUAL_UINT32(0, timer.stats().connections);
+    TEST_ASSERT_EQUAL_UINT32(0, timer.stats().meanUs());
+}
+
+void test_connect_timer_micros_wraparound() {
+    BeamConnectTimer timer;
+    timer.connected(0xFFFFFF00u);
+    TEST_ASSERT_TRUE(timer.command(0x00000100u));
+    TEST_ASSERT_EQUAL_UINT32(0x200, timer.stats().lastUs);
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Layout Tests
+    RUN_TEST(test_layout_hash_is_deterministic);
+    RUN_TEST(test_layout_hash_ignores_uuid_case);
+    RUN_TEST(test_layout_hash_changes_with_layout);
+    RUN_TEST(test_layout_attribute_count);
+    RUN_TEST(test_layout_rejects_bad_uuid);
+
+    // Connect Timer Tests
+    RUN_TEST(test_connect_timer_first_command_only);
+    RUN_TEST(test_connect_timer_micros_wraparound);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
@@ -0,0 +1,231 @@
+/**
+ * @file test_beam_led.cpp
+ * @brief Tests for the LED: brightness curve, fades, hardware-timed blinking
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beam_led`).
+ * Runs against BeamSimLedDriver in virtual time, so the timing is exact and
+ * no test waits.
+ */
+
+#include <unity.h>
+#include "BeamLed.h"
+#include "BeamPlatform.h"
+
+static const uint32_t kFull = BeamLedDriver::kMaxDuty;
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Steady State Tests
+// ============================================================================
+
+void test_brightness_curve() {
+    TEST_ASSERT_EQUAL_UINT32(0, BeamLed::dutyFor(0));
+    TEST_ASSERT_EQUAL_UINT32(1, BeamLed::dutyFor(1));   // dim, but never off
+    TEST_ASSERT_EQUAL_UINT32(kFull / 4, BeamLed::dutyFor(50));
+    TEST_ASSERT_EQUAL_UINT32(kFull, BeamLed::dutyFor(100));
+    TEST_ASSERT_EQUAL_UINT32(kFull, BeamLed::dutyFor(250));  // clamped
+
+    uint32_t previous = 0;
+    for (int p = 1; p <= 100; p++) {
+        TEST_ASSERT_TRUE(BeamLed::dutyFor(p) >= previous);
+        previous = BeamLed::dutyFor(p);
+    }
+}
+
+void test_on_off_and_brightness() {
+    BeamSimLedDriver sim;
+    BeamLed led;
+    TEST_ASSERT_TRUE(led.begin(sim, 2, true));
+    TEST_ASSERT_EQUAL_UINT8(2, sim.pin());
+    TEST_ASSERT_EQUAL_UINT32(0, sim.duty());  // dark until set
+
+    led.set(true);
+    TEST_ASSERT_EQUAL_UINT32(kFull, sim.duty());
+    led.setBrightness(50);
+    TEST_ASSERT_EQUAL_UINT32(kFull / 4, sim.duty());
+    led.setBrightness(150);
+    TEST_ASSERT_EQUAL_UINT8(100, led.brightness());
+    led.set(false);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.duty());
+
+    // Brightness while off is remembered for the next on
+    led.setBrightness(20);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.duty());
+    led.set(true);
+    TEST_ASSERT_EQUAL_UINT32(BeamLed::dutyFor(20), sim.duty());
+
+    // Steady states need no timer, so nothing wakes the CPU
+    TEST_ASSERT_FALSE(sim.timerRunning());
+}
+
+void test_fade_ramps_in_hardware() {
+    BeamSimLedDriver sim;
+    BeamLed led;
+    led.begin(sim, 2, true);
+    led.setFade(400);
+
+    led.set(true);
+    const uint32_t writes = sim.writes();
+    TEST_ASSERT_TRUE(sim.isFading());
+    sim.advance(100);
+    TEST_ASSERT_UINT32_WITHIN(2, kFull / 4, sim.duty());
+    sim.advance(100);
+    TEST_ASSERT_UINT32_WITHIN(2, kFull / 2, sim.duty());
+    sim.advance(200);
+    TEST_ASSERT_EQUAL_UINT32(kFull, sim.duty());
+    TEST_ASSERT_EQUAL_UINT32(writes, sim.writes());  // one fadeTo(), no software steps
+
+    // A change during a fade starts from where the ramp is
+    led.set(false);
+    sim.advance(200);
+    led.set(true);
+    TEST_ASSERT_UINT32_WITHIN(2, kFull / 2, sim.duty());
+    sim.advance(400);
+    TEST_ASSERT_EQUAL_UINT32(kFull, sim.duty());
+}
+
+// ============================================================================
+// Blink Tests
+// ============================================================================
+
+void test_square_blink_runs_from_timer() {
+    BeamSimLedDriver sim;
+    BeamLed led;
+    led.begin(sim, 2, true);
+    led.setBrightness(60);
+
+    TEST_ASSERT_FALSE(led.blink(BEAM_LED_MIN_PERIOD_MS - 1));
+    TEST_ASSERT_FALSE(led.isBlinking());
+    TEST_ASSERT_TRUE(led.blink(1000));
+    TEST_ASSERT_TRUE(sim.timerRunning());
+    TEST_ASSERT_EQUAL_UINT32(BeamLed::dutyFor(60), sim.duty());  // starts on
+
+    sim.advance(499);
+    TEST_ASSERT_EQUAL_UINT32(BeamLed::dutyFor(60), sim.duty());
+    sim.advance(1);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.duty());
+    sim.advance(500);
+    TEST_ASSERT_EQUAL_UINT32(BeamLed::dutyFor(60), sim.duty());
+
+    // Ten seconds: 20 steps, every one started by the timer
+    sim.advance(10000 - 1000);
+    TEST_ASSERT_EQUAL_UINT32(20, led.steps());
+
+    // Brightness applies to the on phase; the pattern restarts on
+    led.setBrightness(100);
+    TEST_ASSERT_EQUAL_UINT32(kFull, sim.duty());
+
+    led.set(false);
+    TEST_ASSERT_FALSE(sim.timerRunning());
+    TEST_ASSERT_FALSE(led.isBlinking());
+    TEST_ASSERT_EQUAL_UINT32(0, sim.duty());
+}
+
+void test_breathing_blink() {
+    BeamSimLedDriver sim;
+    BeamLed led;
+    led.begin(sim, 2, true);
+    led.setFade(2000);  // longer than the half period: capped below it
+    led.blink(1000);
+
+    TEST_ASSERT_TRUE(sim.isFading());
+    sim.advance(219);
+    const uint32_t rising = sim.duty();
+    TEST_ASSERT_TRUE(rising > kFull / 4 && rising < kFull * 3 / 4);
+    sim.advance(281);   // 500 ms: the ramp (438 ms) has ended, the next one starts down
+    TEST_ASSERT_EQUAL_UINT32(0, sim.targetDuty());
+    sim.advance(438);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.duty());
+    sim.advance(62);
+    TEST_ASSERT_TRUE(sim.isFading());
+    TEST_ASSERT_EQUAL_UINT32(kFull, sim.targetDuty());
+
+    // A short fade leaves a plateau
+    led.setFade(100);
+    sim.advance(100);
+    TEST_ASSERT_EQUAL_UINT32(kFull, sim.duty());
+    TEST_ASSERT_FALSE(sim.isFading());
+}
+
+void test_tick_in_flight_after_change_is_dropped() {
+    BeamSimLedDriver sim;
+    BeamLed led;
+    led.begin(sim, 2, true);
+    led.blink(1000);
+    sim.advance(500);
+    TEST_ASSERT_EQUAL_UINT32(1, led.steps());
+
+    // A tick that was running when set() stopped the timer leaves the LED off
+    led.set(false);
+    sim.fireTick();
+    TEST_ASSERT_EQUAL_UINT32(0, sim.duty());
+    TEST_ASSERT_EQUAL_UINT32(1, led.steps());
+
+    // The same when a new blink replaced the timer: the new pattern starts on
+    led.blink(1000);
+    sim.advance(500);
+    TEST_ASSERT_EQUAL_UINT32(2, led.steps());
+    led.blink(400);
+    sim.fireTick();
+    TEST_ASSERT_EQUAL_UINT32(kFull, sim.duty());
+    TEST_ASSERT_EQUAL_UINT32(2, led.steps());
+
+    // ...and its own ticks still step it
+    sim.advance(200);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.duty());
+    TEST_ASSERT_EQUAL_UINT32(3, led.steps());
+}
+
+void test_unattached_led_is_inert() {
+    BeamSimLedDriver sim;  // outlives led
+    BeamLed led;
+    led.set(true);
+    led.setBrightness(10);
+    TEST_ASSERT_TRUE(led.blink(500));
+    TEST_ASSERT_TRUE(led.isBlinking());
+    TEST_ASSERT_EQUAL_UINT32(0, led.steps());
+
+    // begin() shows the state set so far
+    led.begin(sim, 4, false);
+    TEST_ASSERT_TRUE(sim.timerRunning());
+    TEST_ASSERT_EQUAL_UINT32(BeamLed::dutyFor(10), sim.duty());
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Steady State Tests
+    RUN_TEST(test_brightness_curve);
+    RUN_TEST(test_on_off_and_brightness);
+    RUN_TEST(test_fade_ramps_in_hardware);
+
+    // Blink Tests
+    RUN_TEST(test_square_blink_runs_from_timer);
+    RUN_TEST(test_breathing_blink);
+    RUN_TEST(test_tick_in_flight_after_change_is_dropped);
+    RUN_TEST(test_unattached_led_is_inert);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
@@ -0,0 +1,277 @@
+/**
+ * @file test_beam_power.cpp
+ * @brief Tests for the BeamPower lock policy and state accounting
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beam_power`).
+ * A fake clock drives the policy, so the tests do not depend on micros().
+ * On the board begin() may also configure esp_pm; the assertions hold either way.
+ */
+
+#include <unity.h>
+#include "BeamPower.h"
+#include <cstdio>
+
+static uint64_t fakeNowUs = 0;
+
+static uint64_t fakeClock() {
+    return fakeNowUs;
+}
+
+static void advanceMs(uint32_t ms) {
+    fakeNowUs += static_cast<uint64_t>(ms) * 1000;
+}
+
+void setUp(void) {
+    fakeNowUs = 1000000;
+}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Lock Policy Tests
+// ============================================================================
+
+void test_power_lock_only_while_pending() {
+    BeamPower power(fakeClock);
+    power.begin();
+    TEST_ASSERT_TRUE(power.state() == BeamPowerState::Idle);
+    TEST_ASSERT_FALSE(power.holdsLock());
+
+    power.acquire(BeamPowerReason::Handler);
+    TEST_ASSERT_TRUE(power.state() == BeamPowerState::Busy);
+    TEST_ASSERT_TRUE(power.holdsLock());
+
+    power.release(BeamPowerReason::Handler);
+    TEST_ASSERT_TRUE(power.state() == BeamPowerState::Idle);
+    TEST_ASSERT_FALSE(power.holdsLock());
+    TEST_ASSERT_EQUAL_UINT32(BeamPower::kNever, power.update());
+}
+
+void test_power_reasons_nest() {
+    BeamPower power(fakeClock);
+    power.begin();
+
+    power.acquire(BeamPowerReason::Handler);
+    power.acquire(BeamPowerReason::Tx);
+    power.acquire(BeamPowerReason::Tx);
+    power.release(BeamPowerReason::Handler);
+    TEST_ASSERT_TRUE(power.holdsLock());
+    power.release(BeamPowerReason::Tx);
+    TEST_ASSERT_TRUE(power.holdsLock());
+    power.release(BeamPowerReason::Tx);
+    TEST_ASSERT_FALSE(power.holdsLock());
+
+    // An unmatched release does not underflow into a stuck lock
+    power.release(BeamPowerReason::App);
+    power.acquire(BeamPowerReason::App);
+    power.release(BeamPowerReason::App);
+    TEST_ASSERT_FALSE(power.holdsLock());
+}
+
+void test_power_hold_scope() {
+    BeamPower power(fakeClock);
+    power.begin();
+    {
+        BeamPower::Hold hold(&power, BeamPowerReason::App);
+        TEST_ASSERT_TRUE(power.holdsLock());
+        BeamPower::Hold none(nullptr, BeamPowerReason::Tx);
+    }
+    TEST_ASSERT_FALSE(power.holdsLock());
+    TEST_ASSERT_EQUAL_UINT32(1, power.stats().acquires[static_cast<uint8_t>(BeamPowerReason::App)]);
+}
+
+// ============================================================================
+// Linger Tests
+// ============================================================================
+
+void test_power_linger_after_activity() {
+    BeamPowerConfig cfg;
+    cfg.lingerMs = 50;
+    BeamPower power(fakeClock);
+    power.begin(cfg);
+
+    power.acquire(BeamPowerReason::Handler);
+    power.activity();
+    advanceMs(2);
+    power.release(BeamPowerReason::Handler);
+    TEST_ASSERT_TRUE(power.state() == BeamPowerState::Linger);
+    TEST_ASSERT_TRUE(power.holdsLock());
+    TEST_ASSERT_EQUAL_UINT32(48, power.update());
+
+    fakeNowUs += 47500; // 0.5 ms left rounds up, so loop() wakes after the deadline
+    TEST_ASSERT_EQUAL_UINT32(1, power.update());
+    advanceMs(1);
+    TEST_ASSERT_EQUAL_UINT32(BeamPower::kNever, power.update());
+    TEST_ASSERT_TRUE(power.state() == BeamPowerState::Idle);
+    TEST_ASSERT_FALSE(power.holdsLock());
+}
+
+void test_power_activity_extends_linger() {
+    BeamPowerConfig cfg;
+    cfg.lingerMs = 50;
+    BeamPower power(fakeClock);
+    power.begin(cfg);
+
+    power.activity();
+    advanceMs(40);
+    power.activity();
+    advanceMs(40);
+    TEST_ASSERT_EQUAL_UINT32(10, power.update());
+    TEST_ASSERT_EQUAL_UINT32(1, power.stats().lockTaken);
+}
+
+void test_power_linger_disabled() {
+    BeamPowerConfig cfg;
+    cfg.lingerMs = 0;
+    BeamPower power(fakeClock);
+    power.begin(cfg);
+
+    power.activity();
+    TEST_ASSERT_TRUE(power.state() == BeamPowerState::Idle);
+    TEST_ASSERT_EQUAL_UINT32(BeamPower::kNever, power.update());
+}
+
+// ============================================================================
+// Accounting Tests
+// ============================================================================
+
+void test_power_time_per_state() {
+    BeamPowerConfig cfg;
+    cfg.lingerMs = 20;
+    BeamPower power(fakeClock);
+    power.begin(cfg);
+    power.resetStats();
+
+    advanceMs(100);                           // idle 100
+    power.acquire(BeamPowerReason::Handler);
+    power.activity();
+    advanceMs(5);                             // busy 5
+    power.release(BeamPowerReason::Handler);
+    advanceMs(30);
+    power.update();                           // linger until +20 is noticed at +30
+    advanceMs(65);                            // idle 65
+
+    BeamPowerStats s = power.stats();
+    TEST_ASSERT_EQUAL_UINT64(5000, s.timeUs[static_cast<uint8_t>(BeamPowerState::Busy)]);
+    TEST_ASSERT_EQUAL_UINT64(30000, s.timeUs[static_cast<uint8_t>(BeamPowerState::Linger)]);
+    TEST_ASSERT_EQUAL_UINT64(165000, s.timeUs[static_cast<uint8_t>(BeamPowerState::Idle)]);
+    TEST_ASSERT_EQUAL_UINT64(200000, s.totalUs());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 82.5f, s.percent(BeamPowerState::Idle));
+    TEST_ASSERT_EQUAL_UINT32(1, s.lockTaken);
+
+    power.resetStats();
+    TEST_ASSERT_EQUAL_UINT64(0, power.stats().totalUs());
+}
+
+// ============================================================================
+// Cross-thread Tests and Duty Cycle (host only)
+// ============================================================================
+
+#ifndef ARDUINO
+#include <thread>
+
+void test_power_concurrent_acquire_release() {
+    BeamPower power;
+    power.begin();
+
+    auto worker = [&](BeamPowerReason reason) {
+        for (int i = 0; i < 20000; i++) {
+            BeamPower::Hold hold(&power, reason);
+            if (i % 64 == 0) power.activity();
+        }
+    };
+    std::thread a(worker, BeamPowerReason::Handler);
+    std::thread b(worker, BeamPowerReason::Tx);
+    worker(BeamPowerReason::App);
+    a.join();
+    b.join();
+
+    TEST_ASSERT_TRUE(power.state() != BeamPowerState::Busy);
+    delay(60);
+    power.update();
+    TEST_ASSERT_FALSE(power.holdsLock());
+}
+
+// A node that gets one command a second (2 ms handler, 1 ms reply) and runs a
+// 1 ms timer every 500 ms: how much of the time may the CPU sleep?
+void test_power_duty_cycle() {
+    BeamPowerConfig cfg;
+    cfg.lingerMs = 50;
+    BeamPower power(fakeClock);
+    power.begin(cfg);
+    power.resetStats();
+
+    for (int second = 0; second < 60; second++) {
+        power.acquire(BeamPowerReason::Handler);
+        power.activity();
+        advanceMs(2);
+        power.acquire(BeamPowerReason::Tx);
+        advanceMs(1);
+        power.release(BeamPowerReason::Tx);
+        power.release(BeamPowerReason::Handler);
+
+        // loop() sleeps for what update() returns
+        advanceMs(power.update());
+        power.update();
+
+        advanceMs(500 - cfg.lingerMs);
+        { BeamPower::Hold hold(&power, BeamPowerReason::App); advanceMs(1); }
+        advanceMs(499);
+    }
+
+    const BeamPowerStats s = power.stats();
+    printf("{\"bench\":\"power_policy\",\"schema\":1,\"linger_ms\":%lu,\"busy_pct\":%.2f,\"linger_pct\":%.2f,\"idle_pct\":%.2f,\"lock_taken\":%lu}\n",
+           static_cast<unsigned long>(cfg.lingerMs), s.percent(BeamPowerState::Busy),
+           s.percent(BeamPowerState::Linger), s.percent(BeamPowerState::Idle),
+           static_cast<unsigned long>(s.lockTaken));
+
+    TEST_ASSERT_EQUAL_UINT32(120, s.lockTaken);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.4f, s.percent(BeamPowerState::Busy));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 4.7f, s.percent(BeamPowerState::Linger));
+    TEST_ASSERT_TRUE(s.percent(BeamPowerState::Idle) > 94.0f);
+}
+#endif
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Lock Policy Tests
+    RUN_TEST(test_power_lock_only_while_pending);
+    RUN_TEST(test_power_reasons_nest);
+    RUN_TEST(test_power_hold_scope);
+
+    // Linger Tests
+    RUN_TEST(test_power_linger_after_activity);
+    RUN_TEST(test_power_activity_extends_linger);
+    RUN_TEST(test_power_linger_disabled);
+
+    // Accounting Tests
+    RUN_TEST(test_power_time_per_state);
+
+#ifndef ARDUINO
+    // Cross-thread Tests and Duty Cycle
+    RUN_TEST(test_power_concurrent_acquire_release);
+    RUN_TEST(test_power_duty_cycle);
+#endif
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
@@ -0,0 +1,356 @@
+/**
+ * @file test_beam_report.cpp
+ * @brief Tests for report-by-exception filtering (deadband, threshold, intervals, heartbeat)
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beam_report`).
+ * Time is passed explicitly, so no test waits. The benchmark feeds a noisy,
+ * slowly drifting signal and prints how much traffic the filter saves.
+ */
+
+#include <unity.h>
+#include "BeamReport.h"
+#include "BeamPlatform.h"
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static uint32_t rngState = 1;
+
+static float randomUnit() {
+    rngState = rngState * 1664525u + 1013904223u;
+    return static_cast<float>(rngState >> 8) / (1u << 24) * 2 - 1;
+}
+
+static BeamReportPolicy deadbandPolicy(float deadband) {
+    BeamReportPolicy policy;
+    policy.deadband = deadband;
+    return policy;
+}
+
+struct Sent {
+    std::string key;
+    std::string value;
+};
+
+static std::vector<Sent> sent;
+
+void setUp(void) {
+    sent.clear();
+}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Filter Tests
+// ============================================================================
+
+void test_deadband() {
+    BeamReportFilter filter;
+    filter.begin(deadbandPolicy(0.5f));
+
+    TEST_ASSERT_TRUE(filter.offer(20.0f, 0));   // first value always goes out
+    TEST_ASSERT_FALSE(filter.offer(20.3f, 10));
+    TEST_ASSERT_FALSE(filter.offer(19.6f, 20));
+    TEST_ASSERT_TRUE(filter.offer(20.6f, 30));  // measured from 20.0, the last one sent
+    TEST_ASSERT_EQUAL_FLOAT(20.6f, filter.reported());
+    TEST_ASSERT_FALSE(filter.offer(20.9f, 40));
+    TEST_ASSERT_TRUE(filter.offer(20.0f, 50));
+
+    const BeamReportStats& s = filter.stats();
+    TEST_ASSERT_EQUAL_UINT32(6, s.offered);
+    TEST_ASSERT_EQUAL_UINT32(3, s.sent);
+    TEST_ASSERT_EQUAL_UINT32(3, s.suppressed);
+    TEST_ASSERT_EQUAL_UINT32(BeamReportFilter::kNever, filter.update(60));
+
+    // Deadband 0: every change, but not repeats
+    filter.begin(deadbandPolicy(0));
+    TEST_ASSERT_TRUE(filter.offer(1, 100));
+    TEST_ASSERT_FALSE(filter.offer(1, 110));
+    TEST_ASSERT_TRUE(filter.offer(1.001f, 120));
+}
+
+void test_threshold_with_hysteresis() {
+    BeamReportPolicy policy = deadbandPolicy(10);
+    policy.threshold = 50;
+    policy.hysteresis = 2;
+    BeamReportFilter filter;
+    filter.begin(policy);
+
+    TEST_ASSERT_TRUE(filter.offer(45, 0));
+    TEST_ASSERT_FALSE(filter.offer(49.9f, 10));
+    TEST_ASSERT_TRUE(filter.offer(50, 20));     // crossed upwards, within the deadband
+    TEST_ASSERT_FALSE(filter.offer(49, 30));    // still above threshold - hysteresis
+    TEST_ASSERT_FALSE(filter.offer(48.5f, 40));
+    TEST_ASSERT_TRUE(filter.offer(47.9f, 50));  // back down
+    TEST_ASSERT_FALSE(filter.offer(49, 60));    // not yet up again
+    TEST_ASSERT_TRUE(filter.offer(50.5f, 70));
+    TEST_ASSERT_EQUAL_UINT32(4, filter.stats().sent);
+}
+
+void test_min_interval_holds_and_releases_latest() {
+    BeamReportPolicy policy = deadbandPolicy(1);
+    policy.minIntervalMs = 1000;
+    BeamReportFilter filter;
+    filter.begin(policy);
+
+    TEST_ASSERT_TRUE(filter.offer(10, 0));
+    TEST_ASSERT_FALSE(filter.offer(15, 100));  // too soon
+    TEST_ASSERT_TRUE(filter.isPending());
+    TEST_ASSERT_FALSE(filter.offer(17, 200));
+    TEST_ASSERT_EQUAL_UINT32(500, filter.update(500));
+
+    TEST_ASSERT_EQUAL_UINT32(0, filter.update(1000));
+    TEST_ASSERT_EQUAL_FLOAT(17, filter.reported());  // the latest, not the first held
+    TEST_ASSERT_FALSE(filter.isPending());
+    TEST_ASSERT_EQUAL_UINT32(BeamReportFilter::kNever, filter.update(1100));
+
+    // A change undone before the interval ends is not sent at all
+    TEST_ASSERT_FALSE(filter.offer(20, 1200));
+    TEST_ASSERT_FALSE(filter.offer(17.5f, 1300));
+    TEST_ASSERT_FALSE(filter.isPending());
+    TEST_ASSERT_EQUAL_UINT32(BeamReportFilter::kNever, filter.update(2500));
+
+    // After a quiet period the first change goes out at once
+    TEST_ASSERT_TRUE(filter.offer(30, 5000));
+    TEST_ASSERT_EQUAL_UINT32(3, filter.stats().sent);
+}
+
+void test_heartbeat() {
+    BeamReportPolicy policy = deadbandPolicy(5);
+    policy.heartbeatMs = 10000;
+    BeamReportFilter filter;
+    filter.begin(policy);
+
+    TEST_ASSERT_EQUAL_UINT32(BeamReportFilter::kNever, filter.update(0));  // nothing to repeat yet
+    TEST_ASSERT_TRUE(filter.offer(3, 1000));
+    TEST_ASSERT_FALSE(filter.offer(4, 2000));
+    TEST_ASSERT_EQUAL_UINT32(9000, filter.update(2000));
+    TEST_ASSERT_EQUAL_UINT32(0, filter.update(11000));
+    TEST_ASSERT_EQUAL_FLOAT(4, filter.reported());
+    TEST_ASSERT_EQUAL_UINT32(1, filter.stats().heartbeats);
+
+    // A real report restarts the heartbeat
+    TEST_ASSERT_TRUE(filter.offer(20, 15000));
+    TEST_ASSERT_EQUAL_UINT32(10000, filter.update(15000));
+
+    // Millis wrap
+    filter.begin(policy);
+    TEST_ASSERT_TRUE(filter.offer(1, UINT32_MAX - 999));
+    TEST_ASSERT_EQUAL_UINT32(1000, filter.update(8000));
+    TEST_ASSERT_EQUAL_UINT32(0, filter.update(9000));
+}
+
+// ============================================================================
+// Reporter Tests
+// ============================================================================
+
+static void collect(BeamReporter& reporter) {
+    reporter.onReport([](const std::string& key, const std::string& value) { sent.push_back({key, value}); });
+}
+
+void test_reporter_numbers_and_text() {
+    BeamReporter reporter;
+    collect(reporter);
+    reporter.setDefaultPolicy(deadbandPolicy(0));
+    BeamReportPolicy temperature = deadbandPolicy(0.5f);
+    TEST_ASSERT_TRUE(reporter.setPolicy("temp", temperature));
+
+    TEST_ASSERT_TRUE(reporter.offer("temp", "21.0", 0));
+    TEST_ASSERT_FALSE(reporter.offer("temp", "21.2", 10));
+    TEST_ASSERT_TRUE(reporter.offer("temp", "22", 20));
+
+    TEST_ASSERT_TRUE(reporter.offer("ledStatus", "ON", 0));
+    TEST_ASSERT_FALSE(reporter.offer("ledStatus", "ON", 10));
+    TEST_ASSERT_TRUE(reporter.offer("ledStatus", "BLINKING", 20));
+    TEST_ASSERT_TRUE(reporter.offer("ledStatus", "ON", 30));
+
+    // Text to number and back is always a change
+    TEST_ASSERT_TRUE(reporter.offer("mode", "auto", 0));
+    TEST_ASSERT_TRUE(reporter.offer("mode", "3", 10));
+    TEST_ASSERT_FALSE(reporter.offer("mode", "3.0", 20));
+    TEST_ASSERT_TRUE(reporter.offer("mode", "auto", 30));
+
+    TEST_ASSERT_EQUAL(8, sent.size());
+    TEST_ASSERT_EQUAL_STRING("temp", sent[1].key.c_str());
+    TEST_ASSERT_EQUAL_STRING("22", sent[1].value.c_str());  // the text as offered
+    TEST_ASSERT_EQUAL_STRING("BLINKING", sent[3].value.c_str());
+    TEST_ASSERT_EQUAL(3, reporter.signalCount());
+
+    const BeamReportStats s = reporter.stats();
+    TEST_ASSERT_EQUAL_UINT32(11, s.offered);
+    TEST_ASSERT_EQUAL_UINT32(8, s.sent);
+    TEST_ASSERT_EQUAL_UINT32(3, s.suppressed);  // 21.2, ON again, 3.0
+}
+
+void test_reporter_interval_and_policy_change() {
+    BeamReporter reporter;
+    collect(reporter);
+    BeamReportPolicy policy;
+    policy.minIntervalMs = 1000;
+    reporter.setDefaultPolicy(policy);
+
+    TEST_ASSERT_TRUE(reporter.offer("ledStatus", "ON", 0));
+    TEST_ASSERT_FALSE(reporter.offer("ledStatus", "OFF", 100));
+    TEST_ASSERT_FALSE(reporter.offer("ledStatus", "ON", 200));  // back to what was sent
+    TEST_ASSERT_FALSE(reporter.offer("ledStatus", "BLINKING", 300));
+    TEST_ASSERT_EQUAL_UINT32(700, reporter.update(300));
+    TEST_ASSERT_EQUAL(1, sent.size());
+
+    TEST_ASSERT_EQUAL_UINT32(BeamReporter::kNever, reporter.update(1000));
+    TEST_ASSERT_EQUAL(2, sent.size());
+    TEST_ASSERT_EQUAL_STRING("BLINKING", sent[1].value.c_str());
+
+    // A new default reaches keys already seen
+    policy.minIntervalMs = 0;
+    policy.heartbeatMs = 5000;
+    reporter.setDefaultPolicy(policy);
+    TEST_ASSERT_TRUE(reporter.offer("ledStatus", "OFF", 1100));
+    TEST_ASSERT_EQUAL_UINT32(5000, reporter.update(1100));
+    TEST_ASSERT_EQUAL_UINT32(5000, reporter.update(6100));  // heartbeat sent, next one scheduled
+    TEST_ASSERT_EQUAL(4, sent.size());
+    TEST_ASSERT_EQUAL_STRING("OFF", sent[3].value.c_str());
+    TEST_ASSERT_EQUAL_UINT32(1, reporter.stats().heartbeats);
+}
+
+void test_reporter_capacity() {
+    BeamReporter reporter;
+    collect(reporter);
+    char key[16];
+    for (int i = 0; i < BEAM_REPORT_MAX_SIGNALS; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        TEST_ASSERT_TRUE(reporter.offer(key, "1", 0));
+    }
+    TEST_ASSERT_FALSE(reporter.setPolicy("extra", deadbandPolicy(1)));
+
+    // Keys beyond capacity are never dropped, only unfiltered
+    TEST_ASSERT_TRUE(reporter.offer("extra", "1", 0));
+    TEST_ASSERT_TRUE(reporter.offer("extra", "1", 10));
+    TEST_ASSERT_EQUAL(BEAM_REPORT_MAX_SIGNALS, reporter.signalCount());
+    TEST_ASSERT_EQUAL(BEAM_REPORT_MAX_SIGNALS + 2, sent.size());
+
+    reporter.resetStats();
+    TEST_ASSERT_EQUAL_UINT32(0, reporter.stats().offered);
+}
+
+void test_reporter_inactive_then_replays() {
+    BeamReporter reporter;
+    collect(reporter);
+    BeamReportPolicy policy = deadbandPolicy(1);
+    policy.heartbeatMs = 5000;
+    reporter.setDefaultPolicy(policy);
+
+    TEST_ASSERT_TRUE(reporter.offer("ledOn", "true", 0));
+    TEST_ASSERT_TRUE(reporter.offer("level", "10", 0));
+    sent.clear();
+    reporter.resetStats();
+
+    // Nobody listening: values are kept, nothing is sent, counted or heartbeated
+    reporter.setActive(false, 100);
+    TEST_ASSERT_FALSE(reporter.offer("ledOn", "false", 200));
+    TEST_ASSERT_FALSE(reporter.offer("level", "10.5", 300));
+    TEST_ASSERT_FALSE(reporter.offer("mode", "auto", 400));
+    TEST_ASSERT_EQUAL_UINT32(BeamReporter::kNever, reporter.update(9000));
+    TEST_ASSERT_EQUAL(0, sent.size());
+    TEST_ASSERT_EQUAL_UINT32(0, reporter.stats().offered);
+
+    // A listener arrives: every key's latest value goes out, even within the deadband
+    reporter.setActive(true, 10000);
+    TEST_ASSERT_EQUAL(3, sent.size());
+    TEST_ASSERT_EQUAL_STRING("false", sent[0].value.c_str());
+    TEST_ASSERT_EQUAL_STRING("10.5", sent[1].value.c_str());
+    TEST_ASSERT_EQUAL_STRING("auto", sent[2].value.c_str());
+    TEST_ASSERT_EQUAL_UINT32(3, reporter.stats().sent);
+
+    // Filtering resumes against what was just sent
+    TEST_ASSERT_FALSE(reporter.offer("level", "11", 10100));
+    TEST_ASSERT_EQUAL_UINT32(4900, reporter.update(10100));
+}
+
+// ============================================================================
+// Traffic Reduction
+// ============================================================================
+
+void test_traffic_reduction() {
+    // 10 Hz readings for an hour: a slow drift of a few counts per minute
+    // under ±4 counts of noise, and one step change
+    BeamReportPolicy policy = deadbandPolicy(16);
+    policy.minIntervalMs = 1000;
+    policy.heartbeatMs = 60000;
+    BeamReportFilter filter;
+    filter.begin(policy);
+
+    const uint32_t periodMs = 100, durationMs = 3600000;
+    uint32_t reports = 0, maxErrorAfterInterval = 0;
+    float worstError = 0;
+    unsigned long filterUs = 0;
+    for (uint32_t now = 0; now < durationMs; now += periodMs) {
+        float value = 2000 + 100 * std::sin(now / 600000.0f) + 4 * randomUnit();
+        if (now >= durationMs / 2) value += 500;
+
+        const unsigned long start = micros();
+        bool sendNow = filter.offer(value, now);
+        if (!sendNow && filter.update(now) == 0) sendNow = true;
+        filterUs += micros() - start;
+        if (sendNow) reports++;
+
+        // What the central shows never lags more than deadband + noise,
+        // except within one minimum interval of a jump
+        const float error = std::fabs(filter.reported() - value);
+        if (now % 10000 == 0 && now != durationMs / 2) worstError = std::max(worstError, error);
+        if (error > 16 + 8) maxErrorAfterInterval++;
+    }
+
+    const BeamReportStats& s = filter.stats();
+    TEST_ASSERT_EQUAL_UINT32(reports, s.sent);
+    TEST_ASSERT_EQUAL_UINT32(durationMs / periodMs, s.offered);
+    TEST_ASSERT_TRUE(s.reduction() > 20);
+    TEST_ASSERT_TRUE(worstError <= 16 + 8);
+    TEST_ASSERT_TRUE(maxErrorAfterInterval <= 1000 / periodMs);
+
+    printf("{\"bench\":\"report\",\"schema\":1,\"offered\":%lu,\"sent\":%lu,\"heartbeats\":%lu,"
+           "\"reduction\":%.1f,\"max_error\":%.1f,\"ns_per_offer\":%.0f}\n",
+           static_cast<unsigned long>(s.offered), static_cast<unsigned long>(s.sent),
+           static_cast<unsigned long>(s.heartbeats), s.reduction(), worstError,
+           1000.0f * filterUs / s.offered);
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Filter Tests
+    RUN_TEST(test_deadband);
+    RUN_TEST(test_threshold_with_hysteresis);
+    RUN_TEST(test_min_interval_holds_and_releases_latest);
+    RUN_TEST(test_heartbeat);
+
+    // Reporter Tests
+    RUN_TEST(test_reporter_numbers_and_text);
+    RUN_TEST(test_reporter_interval_and_policy_change);
+    RUN_TEST(test_reporter_capacity);
+    RUN_TEST(test_reporter_inactive_then_replays);
+
+    // Traffic Reduction
+    RUN_TEST(test_traffic_reduction);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
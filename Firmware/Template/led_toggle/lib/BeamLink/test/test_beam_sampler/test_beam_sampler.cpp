@@ -0,0 +1,350 @@
+/**
+ * @file test_beam_sampler.cpp
+ * @brief Tests for the fixed-rate sampler, its rings and the raw batch format
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beam_sampler`).
+ * Most tests drive tick() by hand with BeamSimAdc; one runs the real timer.
+ */
+
+#include <unity.h>
+#include "BeamConfig.h"
+#include "BeamSampler.h"
+#include <cstdio>
+
+// A channel that returns its read count, so order and gaps are visible
+class CountingAdc : public BeamAdc {
+public:
+    uint16_t read(uint8_t channel, uint32_t timeUs) override {
+        (void)timeUs;
+        return static_cast<uint16_t>(channel * 1000 + (next[channel]++));
+    }
+
+private:
+    uint16_t next[BEAM_SAMPLER_MAX_CHANNELS] = {};
+};
+
+static const uint8_t kPins[] = {34, 35};
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Ring Tests
+// ============================================================================
+
+void test_ring_push_pop_full_and_wrap() {
+    BeamRing<uint32_t, 4> ring;
+    uint32_t v = 0;
+    TEST_ASSERT_FALSE(ring.pop(v));
+
+    for (uint32_t i = 0; i < 4; i++) TEST_ASSERT_TRUE(ring.push(i));
+    TEST_ASSERT_FALSE(ring.push(99)); // full
+    TEST_ASSERT_EQUAL_UINT32(4, ring.size());
+
+    // Wrap around several times, order kept
+    for (uint32_t i = 4; i < 20; i++) {
+        TEST_ASSERT_TRUE(ring.pop(v));
+        TEST_ASSERT_EQUAL_UINT32(i - 4, v);
+        TEST_ASSERT_TRUE(ring.push(i));
+    }
+    ring.clear();
+    TEST_ASSERT_EQUAL_UINT32(0, ring.size());
+    TEST_ASSERT_FALSE(ring.pop(v));
+}
+
+// ============================================================================
+// Setup Tests
+// ============================================================================
+
+void test_parse_pins() {
+    uint8_t pins[BEAM_SAMPLER_MAX_CHANNELS];
+    TEST_ASSERT_EQUAL_UINT32(2, beamParsePins("34,35", pins, BEAM_SAMPLER_MAX_CHANNELS));
+    TEST_ASSERT_EQUAL_UINT8(34, pins[0]);
+    TEST_ASSERT_EQUAL_UINT8(35, pins[1]);
+    TEST_ASSERT_EQUAL_UINT32(3, beamParsePins(" 4, 36 ,39", pins, BEAM_SAMPLER_MAX_CHANNELS));
+    TEST_ASSERT_EQUAL_UINT8(36, pins[1]);
+
+    TEST_ASSERT_EQUAL_UINT32(0, beamParsePins("", pins, BEAM_SAMPLER_MAX_CHANNELS));
+    TEST_ASSERT_EQUAL_UINT32(0, beamParsePins("34,,35", pins, BEAM_SAMPLER_MAX_CHANNELS));
+    TEST_ASSERT_EQUAL_UINT32(0, beamParsePins("34,A0", pins, BEAM_SAMPLER_MAX_CHANNELS));
+    TEST_ASSERT_EQUAL_UINT32(0, beamParsePins("1,2,3", pins, 2));
+}
+
+void test_begin_validation() {
+    BeamSimAdc adc;
+    BeamSampler sampler;
+    TEST_ASSERT_FALSE(sampler.begin(adc, kPins, 0, 100));
+    TEST_ASSERT_FALSE(sampler.begin(adc, kPins, 2, 0));
+    TEST_ASSERT_FALSE(sampler.begin(adc, kPins, 2, BEAM_SAMPLER_MAX_RATE_HZ + 1));
+    TEST_ASSERT_FALSE(sampler.start()); // no begin() yet
+
+    TEST_ASSERT_TRUE(sampler.begin(adc, kPins, 2, 200));
+    TEST_ASSERT_EQUAL_UINT8(2, sampler.channelCount());
+    TEST_ASSERT_EQUAL_UINT8(35, sampler.pin(1));
+    TEST_ASSERT_EQUAL_UINT32(5000, sampler.periodUs());
+
+    BeamConfig cfg;
+    cfg.sensorPins = "32,33,34";
+    TEST_ASSERT_TRUE(sampler.begin(adc, cfg, 100));
+    TEST_ASSERT_EQUAL_UINT8(3, sampler.channelCount());
+    cfg.sensorPins = "none";
+    TEST_ASSERT_FALSE(sampler.begin(adc, cfg, 100));
+}
+
+// ============================================================================
+// Sampling Tests
+// ============================================================================
+
+void test_tick_samples_every_channel() {
+    BeamSimAdc adc;
+    BeamSimAdc::Signal flat;
+    flat.offset = 1000;
+    adc.setSignal(1, flat);
+
+    BeamSampler sampler;
+    TEST_ASSERT_TRUE(sampler.begin(adc, kPins, 2, 1000));
+    for (uint32_t i = 0; i < 10; i++) sampler.tick(5000 + i * 1000);
+
+    TEST_ASSERT_EQUAL_UINT32(10, sampler.available(0));
+    TEST_ASSERT_EQUAL_UINT32(10, sampler.available(1));
+    TEST_ASSERT_EQUAL_UINT32(20, adc.reads());
+    TEST_ASSERT_EQUAL_UINT16(2048, sampler.latest(0));
+    TEST_ASSERT_EQUAL_UINT16(1000, sampler.latest(1));
+
+    BeamSample out[16];
+    TEST_ASSERT_EQUAL_UINT32(10, sampler.read(1, out, 16));
+    TEST_ASSERT_EQUAL_UINT32(5000, out[0].timeUs);
+    TEST_ASSERT_EQUAL_UINT32(14000, out[9].timeUs);
+    TEST_ASSERT_EQUAL_UINT16(1000, out[9].value);
+
+    const BeamSamplerStats s = sampler.stats();
+    TEST_ASSERT_EQUAL_UINT32(10, s.ticks);
+    TEST_ASSERT_EQUAL_UINT32(20, s.samples);
+    TEST_ASSERT_EQUAL_UINT32(0, s.overruns);
+    TEST_ASSERT_EQUAL_UINT32(0, s.lateTicks);
+}
+
+void test_sim_adc_sine_is_bounded() {
+    BeamSimAdc adc;
+    BeamSimAdc::Signal sine;
+    sine.amplitude = 3000; // clipped at both rails
+    sine.frequencyHz = 10;
+    sine.noise = 50;
+    adc.setSignal(0, sine);
+
+    uint16_t lo = 4095, hi = 0;
+    for (uint32_t t = 0; t < 100000; t += 1000) {
+        const uint16_t v = adc.read(0, t);
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, lo);
+    TEST_ASSERT_EQUAL_UINT16(4095, hi);
+}
+
+void test_overrun_keeps_oldest() {
+    CountingAdc adc;
+    BeamSampler sampler;
+    TEST_ASSERT_TRUE(sampler.begin(adc, kPins, 1, 1000));
+    for (uint32_t i = 0; i < BEAM_SAMPLER_RING + 10; i++) sampler.tick(i * 1000);
+
+    TEST_ASSERT_EQUAL_UINT32(BEAM_SAMPLER_RING, sampler.available(0));
+    TEST_ASSERT_EQUAL_UINT32(10, sampler.stats().overruns);
+    TEST_ASSERT_EQUAL_UINT16(BEAM_SAMPLER_RING + 9, sampler.latest(0));
+
+    BeamSample first;
+    TEST_ASSERT_EQUAL_UINT32(1, sampler.read(0, &first, 1));
+    TEST_ASSERT_EQUAL_UINT16(0, first.value);
+
+    sampler.discard(0);
+    TEST_ASSERT_EQUAL_UINT32(0, sampler.available(0));
+}
+
+void test_lateness_against_schedule() {
+    CountingAdc adc;
+    BeamSampler sampler;
+    TEST_ASSERT_TRUE(sampler.begin(adc, kPins, 1, 1000));
+
+    sampler.tick(10000);
+    sampler.tick(11000);
+    sampler.tick(12300); // 300 us late: counted in max, not a late tick
+    sampler.tick(13000); // back on schedule (early is fine)
+    sampler.tick(14800); // 800 us late
+    TEST_ASSERT_EQUAL_UINT32(1, sampler.stats().lateTicks);
+    TEST_ASSERT_EQUAL_UINT32(800, sampler.stats().maxLatenessUs);
+
+    // A long stall resyncs instead of counting every later tick as late
+    sampler.tick(100000);
+    sampler.tick(101000);
+    TEST_ASSERT_EQUAL_UINT32(2, sampler.stats().lateTicks);
+
+    sampler.resetStats();
+    TEST_ASSERT_EQUAL_UINT32(0, sampler.stats().maxLatenessUs);
+}
+
+// ============================================================================
+// Batch Tests
+// ============================================================================
+
+void test_batch_roundtrip_fits_capacity() {
+    CountingAdc adc;
+    BeamSampler sampler;
+    TEST_ASSERT_TRUE(sampler.begin(adc, kPins, 2, 1000));
+    for (uint32_t i = 0; i < 100; i++) sampler.tick(0xFFFF0000u + i * 1000); // wraps micros()
+
+    // Default ATT MTU 23: 20 bytes of payload, 2 samples
+    uint8_t small[20];
+    TEST_ASSERT_EQUAL_UINT32(15, sampler.readBatch(1, small, sizeof(small)));
+    TEST_ASSERT_EQUAL_UINT32(0, sampler.readBatch(1, small, 8)); // no room for one sample
+
+    // MTU 247: 40 samples per notification
+    uint8_t batch[244];
+    const size_t n = sampler.readBatch(1, batch, sizeof(batch));
+    TEST_ASSERT_EQUAL_UINT32(kBeamBatchHeader + 40 * kBeamBatchRawSample, n);
+
+    uint8_t channel = 0xFF;
+    BeamSample out[64];
+    TEST_ASSERT_EQUAL_INT(40, beamDecodeBatch(batch, n, &channel, out, 64));
+    TEST_ASSERT_EQUAL_UINT8(1, channel);
+    TEST_ASSERT_EQUAL_UINT16(1002, out[0].value);
+    TEST_ASSERT_EQUAL_UINT32(0xFFFF0000u + 2000, out[0].timeUs);
+    TEST_ASSERT_EQUAL_UINT32(0xFFFF0000u + 41000, out[39].timeUs);
+    TEST_ASSERT_EQUAL_UINT32(58, sampler.available(1));
+    TEST_ASSERT_EQUAL_UINT32(2, sampler.stats().batches);
+
+    // Encoding samples read separately gives the same bytes
+    uint8_t again[244];
+    TEST_ASSERT_EQUAL_UINT32(40, beamBatchSamples(sizeof(again)));
+    TEST_ASSERT_EQUAL_UINT32(n, beamEncodeBatch(1, out, 40, again, sizeof(again)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(batch, again, n);
+    TEST_ASSERT_EQUAL_UINT32(15, beamEncodeBatch(1, out, 40, again, sizeof(small)));
+
+    TEST_ASSERT_EQUAL_INT(-1, beamDecodeBatch(batch, n - 1, &channel, out, 64));
+    batch[0] = 0x7F;
+    TEST_ASSERT_EQUAL_INT(-1, beamDecodeBatch(batch, n, &channel, out, 64));
+}
+
+void test_batch_ready_once_per_threshold() {
+    CountingAdc adc;
+    BeamSampler sampler;
+    TEST_ASSERT_TRUE(sampler.begin(adc, kPins, 1, 1000));
+    int calls = 0;
+    sampler.onBatchReady(8, [&calls] { calls++; });
+
+    for (uint32_t i = 0; i < 20; i++) sampler.tick(i * 1000);
+    TEST_ASSERT_EQUAL_INT(1, calls);
+
+    // Drained below the threshold: armed again
+    BeamSample out[32];
+    sampler.read(0, out, 32);
+    for (uint32_t i = 20; i < 27; i++) sampler.tick(i * 1000);
+    TEST_ASSERT_EQUAL_INT(1, calls);
+    sampler.tick(27000);
+    TEST_ASSERT_EQUAL_INT(2, calls);
+}
+
+// ============================================================================
+// Timer Tests
+// ============================================================================
+
+void test_timer_with_concurrent_consumer() {
+    BeamSimAdc adc;
+    BeamSampler sampler;
+    TEST_ASSERT_TRUE(sampler.begin(adc, kPins, 2, 1000));
+    TEST_ASSERT_TRUE(sampler.start());
+    TEST_ASSERT_TRUE(sampler.isRunning());
+    TEST_ASSERT_FALSE(sampler.start());
+
+    // Drain channel 0 while the timer fills it; timestamps must increase
+    uint32_t drained = 0, lastTime = 0, disorder = 0;
+    const unsigned long until = millis() + 200;
+    while (millis() < until) {
+        BeamSample out[32];
+        const size_t n = sampler.read(0, out, 32);
+        for (size_t i = 0; i < n; i++) {
+            if (drained && static_cast<int32_t>(out[i].timeUs - lastTime) <= 0) disorder++;
+            lastTime = out[i].timeUs;
+            drained++;
+        }
+        delay(1);
+    }
+    sampler.stop();
+    TEST_ASSERT_FALSE(sampler.isRunning());
+
+    const BeamSamplerStats s = sampler.stats();
+    drained += sampler.available(0);
+    TEST_ASSERT_EQUAL_UINT32(0, disorder);
+    TEST_ASSERT_EQUAL_UINT32(s.ticks, drained);
+    TEST_ASSERT_TRUE(s.ticks > 100); // ~200 expected; loose for loaded CI hosts
+    printf("{\"bench\":\"sampler_timer\",\"schema\":1,\"rate_hz\":1000,\"ms\":200,\"ticks\":%lu,\"late\":%lu,\"max_late_us\":%lu}\n",
+           static_cast<unsigned long>(s.ticks), static_cast<unsigned long>(s.lateTicks),
+           static_cast<unsigned long>(s.maxLatenessUs));
+}
+
+void test_tick_cost() {
+    BeamSimAdc adc;
+    BeamSampler sampler;
+    TEST_ASSERT_TRUE(sampler.begin(adc, kPins, 2, 1000));
+    uint8_t batch[244];
+
+    const uint32_t iterations = 20000;
+    const unsigned long start = micros();
+    for (uint32_t i = 0; i < iterations; i++) {
+        sampler.tick(i * 1000);
+        if ((i & 31) == 31) {
+            sampler.readBatch(0, batch, sizeof(batch));
+            sampler.readBatch(1, batch, sizeof(batch));
+        }
+    }
+    const unsigned long elapsed = micros() - start;
+    TEST_ASSERT_EQUAL_UINT32(0, sampler.stats().overruns);
+    printf("{\"bench\":\"sampler_tick\",\"schema\":1,\"channels\":2,\"iterations\":%lu,\"ns_per_tick\":%.1f}\n",
+           static_cast<unsigned long>(iterations), elapsed * 1000.0 / iterations);
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Ring Tests
+    RUN_TEST(test_ring_push_pop_full_and_wrap);
+
+    // Setup Tests
+    RUN_TEST(test_parse_pins);
+    RUN_TEST(test_begin_validation);
+
+    // Sampling Tests
+    RUN_TEST(test_tick_samples_every_channel);
+    RUN_TEST(test_sim_adc_sine_is_bounded);
+    RUN_TEST(test_overrun_keeps_oldest);
+    RUN_TEST(test_lateness_against_schedule);
+
+    // Batch Tests
+    RUN_TEST(test_batch_roundtrip_fits_capacity);
+    RUN_TEST(test_batch_ready_once_per_threshold);
+
+    // Timer Tests
+    RUN_TEST(test_timer_with_concurrent_consumer);
+    RUN_TEST(test_tick_cost);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
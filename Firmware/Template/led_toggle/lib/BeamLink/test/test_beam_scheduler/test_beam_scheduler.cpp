@@ -0,0 +1,301 @@
+/**
+ * @file test_beam_scheduler.cpp
+ * @brief Tests for the BeamScheduler timing wheel
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beam_scheduler`).
+ * Time is passed explicitly, so the tests do not depend on millis().
+ */
+
+#include <unity.h>
+#include "BeamScheduler.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static std::string trace;
+
+void setUp(void) {
+    trace.clear();
+}
+
+void tearDown(void) {}
+
+// ============================================================================
+// One-shot and Periodic Tests
+// ============================================================================
+
+void test_scheduler_one_shot_fires_once_on_time() {
+    BeamScheduler s(0);
+    BeamTimerId id = s.after(10, [] { trace += "a"; }, 0);
+    TEST_ASSERT_TRUE(id != 0);
+    TEST_ASSERT_TRUE(s.isScheduled(id));
+    TEST_ASSERT_EQUAL_UINT32(10, s.msUntilNext(0));
+    TEST_ASSERT_EQUAL_UINT32(3, s.msUntilNext(7));
+
+    TEST_ASSERT_EQUAL_size_t(0, s.run(9));
+    TEST_ASSERT_EQUAL_size_t(1, s.run(10));
+    TEST_ASSERT_EQUAL_STRING("a", trace.c_str());
+    TEST_ASSERT_FALSE(s.isScheduled(id));
+    TEST_ASSERT_EQUAL_size_t(0, s.run(100));
+    TEST_ASSERT_EQUAL_UINT32(BeamScheduler::kNever, s.msUntilNext(100));
+}
+
+void test_scheduler_periodic_keeps_phase_and_skips_missed() {
+    BeamScheduler s(0);
+    int count = 0;
+    s.every(100, [&] { count++; }, 0);
+
+    s.run(100);
+    TEST_ASSERT_EQUAL_INT(1, count);
+    s.run(250); // late: still due at 200, next at 300
+    TEST_ASSERT_EQUAL_INT(2, count);
+    TEST_ASSERT_EQUAL_UINT32(50, s.msUntilNext(250));
+
+    s.run(1000); // 300..1000 missed: one call, then back on the 100 ms grid
+    TEST_ASSERT_EQUAL_INT(3, count);
+    TEST_ASSERT_EQUAL_UINT32(100, s.msUntilNext(1000));
+}
+
+void test_scheduler_first_delay_and_order() {
+    BeamScheduler s(0);
+    s.every(50, [] { trace += "p"; }, 0, 0);
+    s.after(20, [] { trace += "a"; }, 0);
+    s.after(5000, [] { trace += "b"; }, 0);
+
+    s.run(30);
+    TEST_ASSERT_EQUAL_STRING("pa", trace.c_str());
+    s.run(60);
+    TEST_ASSERT_EQUAL_STRING("pap", trace.c_str());
+    TEST_ASSERT_EQUAL_UINT32(41, s.msUntilNext(60)); // first run was clamped to tick 1
+}
+
+// ============================================================================
+// Cancel Tests
+// ============================================================================
+
+void test_scheduler_cancel() {
+    BeamScheduler s(0);
+    BeamTimerId a = s.after(10, [] { trace += "a"; }, 0);
+    BeamTimerId b = s.after(10, [] { trace += "b"; }, 0);
+    BeamTimerId stale = a;
+
+    TEST_ASSERT_TRUE(s.cancel(a));
+    TEST_ASSERT_EQUAL_UINT32(0, a);
+    TEST_ASSERT_FALSE(s.cancel(stale));
+    s.run(10);
+    TEST_ASSERT_EQUAL_STRING("b", trace.c_str());
+    TEST_ASSERT_FALSE(s.cancel(b)); // already fired
+
+    // A reused slot does not answer to the old handle
+    BeamTimerId c = s.after(5, [] {}, 10);
+    TEST_ASSERT_FALSE(s.isScheduled(stale));
+    TEST_ASSERT_TRUE(s.isScheduled(c));
+}
+
+void test_scheduler_cancel_from_callback() {
+    BeamScheduler s(0);
+    static BeamScheduler* sched;
+    static BeamTimerId self;
+    sched = &s;
+    static int count;
+    count = 0;
+    self = s.every(10, [] {
+        if (++count == 3) sched->cancel(self);
+    }, 0);
+
+    for (uint32_t t = 10; t <= 100; t += 10) s.run(t);
+    TEST_ASSERT_EQUAL_INT(3, count);
+    TEST_ASSERT_EQUAL_size_t(0, s.size());
+
+    // A callback may also schedule new work; a zero delay runs next tick
+    s.after(1, [] { sched->after(0, [] { trace += "n"; }, 101); }, 100);
+    TEST_ASSERT_EQUAL_size_t(1, s.run(101));
+    TEST_ASSERT_EQUAL_STRING("", trace.c_str());
+    TEST_ASSERT_EQUAL_size_t(1, s.run(102));
+    TEST_ASSERT_EQUAL_STRING("n", trace.c_str());
+}
+
+void test_scheduler_pool_full() {
+    BeamScheduler s(0);
+    for (int i = 0; i < BEAM_SCHEDULER_MAX_TIMERS; i++) {
+        TEST_ASSERT_TRUE(s.after(100 + i, [] {}, 0) != 0);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, s.after(1, [] {}, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, s.every(0, [] {}, 0));
+    s.run(100);
+    TEST_ASSERT_TRUE(s.after(1, [] {}, 100) != 0);
+}
+
+// ============================================================================
+// Wheel Tests
+// ============================================================================
+
+void test_scheduler_long_delays_cascade_exactly() {
+    const uint32_t delays[] = {63, 64, 65, 4095, 4096, 4097, 70000, 262143, 262144, 600000};
+    for (uint32_t delay : delays) {
+        BeamScheduler s(17);
+        uint32_t firedAt = 0;
+        uint32_t now = 17;
+        s.after(delay, [&] { firedAt = now; }, 17);
+        TEST_ASSERT_EQUAL_UINT32(delay, s.msUntilNext(17));
+
+        // Sleep exactly as long as the scheduler says, as loop() does
+        int wakeups = 0;
+        while (firedAt == 0 && wakeups < 100) {
+            now += s.msUntilNext(now);
+            s.run(now);
+            wakeups++;
+        }
+        TEST_ASSERT_EQUAL_UINT32(17 + delay, firedAt);
+        TEST_ASSERT_EQUAL_INT(1, wakeups);
+    }
+}
+
+void test_scheduler_millis_wraparound() {
+    const uint32_t start = 0xFFFFFF00u;
+    BeamScheduler s(start);
+    int count = 0;
+    s.every(100, [&] { count++; }, start);
+    s.run(start + 150);
+    s.run(start + 250); // crosses 0
+    TEST_ASSERT_EQUAL_INT(2, count);
+    TEST_ASSERT_EQUAL_UINT32(50, s.msUntilNext(start + 250));
+}
+
+// Random schedule/cancel/run mix against a plain list of deadlines
+void test_scheduler_matches_reference_model() {
+    struct Ref {
+        BeamTimerId id;
+        uint32_t deadline;
+        uint32_t period;
+        int fired;
+    };
+    static std::vector<Ref> refs;
+    refs.clear();
+    static int fired[64];
+
+    BeamScheduler s(0);
+    uint32_t now = 0;
+    srand(1234);
+
+    for (int step = 0; step < 4000; step++) {
+        const int op = rand() % 10;
+        if (op < 3 && s.size() < BEAM_SCHEDULER_MAX_TIMERS && refs.size() < 64) {
+            const int slot = static_cast<int>(refs.size());
+            const uint32_t delay = (rand() % 4 == 0) ? rand() % 20000 : rand() % 300;
+            const uint32_t period = (rand() % 3 == 0) ? 1 + rand() % 500 : 0;
+            fired[slot] = 0;
+            BeamTimerId id = period ? s.every(period, [slot] { fired[slot]++; }, now, delay)
+                                    : s.after(delay, [slot] { fired[slot]++; }, now);
+            TEST_ASSERT_TRUE(id != 0);
+            refs.push_back(Ref{id, now + (delay ? delay : 1), period, 0});
+        } else if (op < 4 && !refs.empty()) {
+            Ref& r = refs[rand() % refs.size()];
+            BeamTimerId id = r.id;
+            TEST_ASSERT_EQUAL(r.id != 0, s.cancel(id));
+            r.id = 0;
+        } else {
+            now += (rand() % 8 == 0) ? rand() % 5000 : rand() % 40;
+            s.run(now);
+            for (size_t i = 0; i < refs.size(); i++) {
+                Ref& r = refs[i];
+                if (r.id == 0 || static_cast<int32_t>(r.deadline - now) > 0) continue;
+                r.fired++;
+                if (r.period == 0) {
+                    r.id = 0;
+                    continue;
+                }
+                r.deadline += r.period;
+                if (static_cast<int32_t>(r.deadline - now) <= 0) {
+                    r.deadline += ((now - r.deadline) / r.period + 1) * r.period;
+                }
+            }
+        }
+
+        uint32_t expectNext = BeamScheduler::kNever;
+        size_t armed = 0;
+        for (size_t i = 0; i < refs.size(); i++) {
+            TEST_ASSERT_EQUAL_INT(refs[i].fired, fired[i]);
+            if (refs[i].id == 0) continue;
+            armed++;
+            const uint32_t remaining = refs[i].deadline - now;
+            if (remaining < expectNext) expectNext = remaining;
+        }
+        TEST_ASSERT_EQUAL_size_t(armed, s.size());
+        TEST_ASSERT_EQUAL_UINT32(expectNext, s.msUntilNext(now));
+    }
+}
+
+// ============================================================================
+// Benchmark (host only)
+// ============================================================================
+
+#ifndef ARDUINO
+void test_scheduler_bench() {
+    const int iterations = 200000;
+    BeamScheduler s(0);
+    for (int i = 0; i < BEAM_SCHEDULER_MAX_TIMERS - 1; i++) {
+        s.every(10 + i * 97, [] {}, 0);
+    }
+
+    unsigned long start = micros();
+    uint32_t now = 0;
+    for (int i = 0; i < iterations; i++) {
+        BeamTimerId id = s.after(1 + (i % 5000), [] {}, now);
+        s.cancel(id);
+        now += s.msUntilNext(now) == 0 ? 0 : 1;
+        s.run(now);
+    }
+    unsigned long elapsed = micros() - start;
+
+    printf("{\"bench\":\"scheduler\",\"schema\":1,\"op\":\"schedule_cancel_run\",\"timers\":%d,\"ns_per_op\":%lu}\n",
+           BEAM_SCHEDULER_MAX_TIMERS, elapsed * 1000 / iterations);
+    TEST_ASSERT_EQUAL_size_t(BEAM_SCHEDULER_MAX_TIMERS - 1, s.size());
+}
+#endif
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // One-shot and Periodic Tests
+    RUN_TEST(test_scheduler_one_shot_fires_once_on_time);
+    RUN_TEST(test_scheduler_periodic_keeps_phase_and_skips_missed);
+    RUN_TEST(test_scheduler_first_delay_and_order);
+
+    // Cancel Tests
+    RUN_TEST(test_scheduler_cancel);
+    RUN_TEST(test_scheduler_cancel_from_callback);
+    RUN_TEST(test_scheduler_pool_full);
+
+    // Wheel Tests
+    RUN_TEST(test_scheduler_long_delays_cascade_exactly);
+    RUN_TEST(test_scheduler_millis_wraparound);
+    RUN_TEST(test_scheduler_matches_reference_model);
+
+#ifndef ARDUINO
+    // Benchmark
+    RUN_TEST(test_scheduler_bench);
+#endif
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
@@ -0,0 +1,311 @@
+/**
+ * @file test_beam_spectrum.cpp
+ * @brief Tests for the FFT and spectral features against a naive DFT
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beam_spectrum`).
+ * The FFT is checked against a direct O(N^2) DFT in double precision; the
+ * benchmark prints frames per second for both.
+ */
+
+#include <unity.h>
+#include "BeamSpectrum.h"
+#include "BeamPlatform.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static const double kPi = 3.14159265358979323846;
+
+static uint32_t rngState = 1;
+
+static float randomUnit() {
+    rngState = rngState * 1664525u + 1013904223u;
+    return static_cast<float>(rngState >> 8) / (1u << 24) * 2 - 1;
+}
+
+// Direct DFT of interleaved complex input (reference)
+static void naiveDft(const float* in, size_t points, std::vector<double>& out) {
+    out.assign(2 * points, 0.0);
+    for (size_t k = 0; k < points; k++) {
+        double re = 0, im = 0;
+        for (size_t t = 0; t < points; t++) {
+            const double angle = -2 * kPi * static_cast<double>(k * t % points) / points;
+            re += in[2 * t] * std::cos(angle) - in[2 * t + 1] * std::sin(angle);
+            im += in[2 * t] * std::sin(angle) + in[2 * t + 1] * std::cos(angle);
+        }
+        out[2 * k] = re;
+        out[2 * k + 1] = im;
+    }
+}
+
+// Amplitude spectrum of a real block the way BeamSpectrum scales it (reference)
+static void naiveMagnitudes(const float* x, size_t n, bool hann, std::vector<double>& mag) {
+    double mean = 0;
+    for (size_t i = 0; i < n; i++) mean += x[i];
+    mean /= n;
+    double windowSum = 0;
+    std::vector<double> w(n);
+    for (size_t i = 0; i < n; i++) {
+        w[i] = hann ? 0.5 - 0.5 * std::cos(2 * kPi * i / n) : 1.0;
+        windowSum += w[i];
+    }
+    mag.assign(n / 2 + 1, 0.0);
+    for (size_t k = 0; k <= n / 2; k++) {
+        double re = 0, im = 0;
+        for (size_t t = 0; t < n; t++) {
+            const double angle = -2 * kPi * static_cast<double>(k * t % n) / n;
+            re += (x[t] - mean) * w[t] * std::cos(angle);
+            im += (x[t] - mean) * w[t] * std::sin(angle);
+        }
+        mag[k] = std::sqrt(re * re + im * im) * (k == 0 || k == n / 2 ? 1 : 2) / windowSum;
+    }
+}
+
+static std::vector<float> tone(size_t n, float rateHz, float hz, float amplitude, float offset = 0) {
+    std::vector<float> x(n);
+    for (size_t i = 0; i < n; i++) x[i] = offset + amplitude * static_cast<float>(std::sin(2 * kPi * hz * i / rateHz));
+    return x;
+}
+
+static BeamSpectrum::Config makeConfig(size_t size, float rateHz, BeamFftWindow window, uint8_t bands = 4) {
+    BeamSpectrum::Config cfg;
+    cfg.size = size;
+    cfg.rateHz = rateHz;
+    cfg.window = window;
+    cfg.bands = bands;
+    return cfg;
+}
+
+void setUp(void) {
+    rngState = 1;
+}
+
+void tearDown(void) {}
+
+// ============================================================================
+// FFT Tests
+// ============================================================================
+
+void test_fft_matches_dft() {
+    std::vector<double> ref;
+    for (size_t points = 1; points <= BEAM_FFT_MAX_SIZE / 2; points *= 2) {
+        std::vector<float> data(2 * points);
+        for (float& v : data) v = randomUnit();
+        naiveDft(data.data(), points, ref);
+        TEST_ASSERT_TRUE(beamFftComplex(data.data(), points));
+        // Errors grow with log2(points); the values grow with sqrt(points)
+        for (size_t i = 0; i < 2 * points; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-4f * (1 + points / 16.0f), static_cast<float>(ref[i]), data[i]);
+        }
+    }
+    float data[8] = {};
+    TEST_ASSERT_FALSE(beamFftComplex(data, 0));
+    TEST_ASSERT_FALSE(beamFftComplex(data, 3));
+    TEST_ASSERT_FALSE(beamFftComplex(data, BEAM_FFT_MAX_SIZE));
+}
+
+void test_magnitudes_match_dft() {
+    std::vector<double> ref;
+    for (size_t n = BEAM_FFT_MIN_SIZE; n <= BEAM_FFT_MAX_SIZE; n *= 2) {
+        std::vector<float> x(n);
+        for (float& v : x) v = 2048 + 500 * randomUnit();
+        for (BeamFftWindow window : {kBeamWindowRectangular, kBeamWindowHann}) {
+            BeamSpectrum spectrum;
+            TEST_ASSERT_TRUE(spectrum.begin(makeConfig(n, 1000, window)));
+            TEST_ASSERT_TRUE(spectrum.analyze(x.data(), n));
+            naiveMagnitudes(x.data(), n, window == kBeamWindowHann, ref);
+            TEST_ASSERT_EQUAL_UINT32(n / 2 + 1, spectrum.bins());
+            for (size_t k = 0; k < spectrum.bins(); k++) {
+                TEST_ASSERT_FLOAT_WITHIN(0.05f, static_cast<float>(ref[k]), spectrum.magnitudes()[k]);
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Feature Tests
+// ============================================================================
+
+void test_bin_centred_tone() {
+    // 1 kHz sampling, 256 points: bins are 3.90625 Hz apart; 125 Hz is bin 32
+    BeamSpectrum spectrum;
+    TEST_ASSERT_TRUE(spectrum.begin(makeConfig(256, 1000, kBeamWindowRectangular)));
+    const std::vector<float> x = tone(256, 1000, 125, 300, 2048);
+    TEST_ASSERT_TRUE(spectrum.analyze(x.data(), x.size()));
+
+    const BeamSpectrumFeatures& f = spectrum.features();
+    TEST_ASSERT_EQUAL_UINT32(256, f.samples);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 2048, f.mean);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 300 / std::sqrt(2.0f), f.rms);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 125, f.peakHz);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 300, f.peakAmplitude);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 300, spectrum.magnitudes()[32]);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 0, spectrum.magnitudes()[0]);
+
+    // All energy in band 1 (125-250 Hz); the bands add up to rms^2
+    TEST_ASSERT_EQUAL_UINT8(4, f.bands);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, f.rms * f.rms, f.bandEnergy[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0, f.bandEnergy[0] + f.bandEnergy[2] + f.bandEnergy[3]);
+}
+
+void test_off_bin_tone_with_hann() {
+    BeamSpectrum spectrum;
+    TEST_ASSERT_TRUE(spectrum.begin(makeConfig(1024, 20000, kBeamWindowHann)));
+    const float hz[] = {50, 333.3f, 1234.5f, 7001};
+    for (float f0 : hz) {
+        const std::vector<float> x = tone(1024, 20000, f0, 1000, 1500);
+        TEST_ASSERT_TRUE(spectrum.analyze(x.data(), x.size()));
+        const BeamSpectrumFeatures& f = spectrum.features();
+        // Interpolation: a small fraction of a bin (19.5 Hz); the Hann
+        // scalloping loss (up to 15 %) corrected to a few %
+        TEST_ASSERT_FLOAT_WITHIN(0.05f * spectrum.binHz(), f0, f.peakHz);
+        TEST_ASSERT_FLOAT_WITHIN(40, 1000, f.peakAmplitude);
+        // 50 Hz covers only 2.56 periods, so its RMS is a little off too
+        TEST_ASSERT_FLOAT_WITHIN(f0 < 100 ? 30 : 5, 1000 / std::sqrt(2.0f), f.rms);
+    }
+}
+
+void test_band_energies() {
+    // Two tones and some noise, custom bands around them
+    const float edges[] = {0, 100, 400, 2000};
+    BeamSpectrum::Config cfg = makeConfig(512, 4000, kBeamWindowHann, 3);
+    cfg.bandEdgesHz = edges;
+    BeamSpectrum spectrum;
+    TEST_ASSERT_TRUE(spectrum.begin(cfg));
+
+    std::vector<float> x = tone(512, 4000, 60, 100);
+    const std::vector<float> high = tone(512, 4000, 1000, 400);
+    for (size_t i = 0; i < x.size(); i++) x[i] += high[i] + 2 * randomUnit();
+    TEST_ASSERT_TRUE(spectrum.analyze(x.data(), x.size()));
+
+    const BeamSpectrumFeatures& f = spectrum.features();
+    TEST_ASSERT_FLOAT_WITHIN(1000, 100 * 100 / 2, f.bandEnergy[0]);
+    TEST_ASSERT_TRUE(f.bandEnergy[1] < 50);
+    TEST_ASSERT_FLOAT_WITHIN(4000, 400 * 400 / 2, f.bandEnergy[2]);
+    TEST_ASSERT_FLOAT_WITHIN(1, 1000, f.peakHz);
+    const float total = f.bandEnergy[0] + f.bandEnergy[1] + f.bandEnergy[2];
+    TEST_ASSERT_FLOAT_WITHIN(0.02f * total, f.rms * f.rms, total);
+}
+
+void test_sample_types_and_limits() {
+    BeamSpectrum spectrum;
+    TEST_ASSERT_FALSE(spectrum.begin(makeConfig(8, 1000, kBeamWindowHann)));
+    TEST_ASSERT_FALSE(spectrum.begin(makeConfig(100, 1000, kBeamWindowHann)));
+    TEST_ASSERT_FALSE(spectrum.begin(makeConfig(BEAM_FFT_MAX_SIZE * 2, 1000, kBeamWindowHann)));
+    TEST_ASSERT_FALSE(spectrum.begin(makeConfig(256, 0, kBeamWindowHann)));
+    TEST_ASSERT_FALSE(spectrum.begin(makeConfig(256, 1000, kBeamWindowHann, 0)));
+    TEST_ASSERT_FALSE(spectrum.begin(makeConfig(256, 1000, kBeamWindowHann, BEAM_SPECTRUM_MAX_BANDS + 1)));
+    const float descending[] = {0, 200, 100};
+    BeamSpectrum::Config cfg = makeConfig(256, 1000, kBeamWindowHann, 2);
+    cfg.bandEdgesHz = descending;
+    TEST_ASSERT_FALSE(spectrum.begin(cfg));
+    uint16_t none[16] = {};
+    TEST_ASSERT_FALSE(spectrum.analyze(none, 16));  // not begun
+
+    // Raw counts, int16 and float give the same features
+    TEST_ASSERT_TRUE(spectrum.begin(makeConfig(64, 1000, kBeamWindowHann)));
+    const std::vector<float> x = tone(64, 1000, 187.5f, 1000, 2048);  // bin 12
+    uint16_t counts[64];
+    int16_t signedValues[64];
+    for (size_t i = 0; i < 64; i++) {
+        counts[i] = static_cast<uint16_t>(std::lround(x[i]));
+        signedValues[i] = static_cast<int16_t>(counts[i] - 2048);
+    }
+    TEST_ASSERT_FALSE(spectrum.analyze(counts, 63));
+    TEST_ASSERT_TRUE(spectrum.analyze(counts, 64));
+    const BeamSpectrumFeatures a = spectrum.features();
+    TEST_ASSERT_TRUE(spectrum.analyze(signedValues, 64));
+    const BeamSpectrumFeatures b = spectrum.features();
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, a.mean - 2048, b.mean);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, a.rms, b.rms);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, a.peakHz, b.peakHz);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 187.5f, a.peakHz);
+
+    // Longer blocks: only the first size() samples count
+    std::vector<float> longer(x);
+    longer.resize(200, 50000);
+    TEST_ASSERT_TRUE(spectrum.analyze(longer.data(), longer.size()));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 2048, spectrum.features().mean);
+}
+
+// ============================================================================
+// Throughput
+// ============================================================================
+
+void test_throughput_vs_dft() {
+#ifdef ARDUINO
+    const size_t sizes[] = {256, 1024};
+    const int rounds = 20;
+#else
+    const size_t sizes[] = {256, 1024};
+    const int rounds = 2000;
+#endif
+    for (size_t n : sizes) {
+        std::vector<float> x(n);
+        for (float& v : x) v = 2048 + 800 * randomUnit();
+        BeamSpectrum spectrum;
+        TEST_ASSERT_TRUE(spectrum.begin(makeConfig(n, 20000, kBeamWindowHann)));
+
+        unsigned long start = micros();
+        for (int r = 0; r < rounds; r++) spectrum.analyze(x.data(), n);
+        const unsigned long fftUs = micros() - start;
+
+        std::vector<double> ref;
+        const int dftRounds = rounds / 100 + 1;
+        start = micros();
+        for (int r = 0; r < dftRounds; r++) naiveMagnitudes(x.data(), n, true, ref);
+        const unsigned long dftUs = micros() - start;
+
+        float maxError = 0;
+        for (size_t k = 0; k < spectrum.bins(); k++) {
+            maxError = std::max(maxError, std::fabs(spectrum.magnitudes()[k] - static_cast<float>(ref[k])));
+        }
+        TEST_ASSERT_TRUE(maxError < 0.05f);
+
+        const float fftFrameUs = static_cast<float>(fftUs) / rounds;
+        const float dftFrameUs = static_cast<float>(dftUs) / dftRounds;
+        printf("{\"bench\":\"spectrum\",\"schema\":1,\"size\":%lu,\"fft_us_per_frame\":%.2f,"
+               "\"fft_frames_per_s\":%.0f,\"dft_us_per_frame\":%.1f,\"speedup\":%.0f,\"max_abs_error\":%.5f}\n",
+               static_cast<unsigned long>(n), fftFrameUs, fftFrameUs > 0 ? 1e6f / fftFrameUs : 0.0f, dftFrameUs,
+               fftFrameUs > 0 ? dftFrameUs / fftFrameUs : 0.0f, maxError);
+    }
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // FFT Tests
+    RUN_TEST(test_fft_matches_dft);
+    RUN_TEST(test_magnitudes_match_dft);
+
+    // Feature Tests
+    RUN_TEST(test_bin_centred_tone);
+    RUN_TEST(test_off_bin_tone_with_hann);
+    RUN_TEST(test_band_energies);
+    RUN_TEST(test_sample_types_and_limits);
+
+    // Throughput
+    RUN_TEST(test_throughput_vs_dft);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
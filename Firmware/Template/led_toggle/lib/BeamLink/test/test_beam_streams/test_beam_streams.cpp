@@ -0,0 +1,189 @@
+/**
+ * @file test_beam_streams.cpp
+ * @brief Tests for the BeamStreams registry behind BeamLink::addStream()
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beam_streams`).
+ * Subscriptions are set directly, as the NimBLE CCCD callback would.
+ */
+
+#include <unity.h>
+#include "BeamStreams.h"
+#include "Uuids.h"
+#include <cstdio>
+#include <string>
+
+static int writes = 0;
+static size_t lastWriteSize = 0;
+
+static void recordWrite(const uint8_t* data, size_t size) {
+    (void)data;
+    writes++;
+    lastWriteSize = size;
+}
+
+void setUp(void) {
+    writes = 0;
+    lastWriteSize = 0;
+}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Declaration Tests
+// ============================================================================
+
+void test_streams_add_in_order() {
+    BeamStreams streams;
+    TEST_ASSERT_EQUAL_INT(0, streams.add("state", BMLK_STATE_STREAM_UUID, BEAM_STREAM_NOTIFY));
+    TEST_ASSERT_EQUAL_INT(1, streams.add("telemetry", BMLK_TELEMETRY_STREAM_UUID, BEAM_STREAM_NOTIFY | BEAM_STREAM_READ));
+    TEST_ASSERT_EQUAL_INT(2, streams.add("log", BMLK_LOG_STREAM_UUID, BEAM_STREAM_NOTIFY | BEAM_STREAM_WRITE, recordWrite));
+    TEST_ASSERT_EQUAL_INT(3, streams.size());
+    TEST_ASSERT_EQUAL_STRING("telemetry", streams[1].name);
+    TEST_ASSERT_EQUAL_STRING(BMLK_TELEMETRY_STREAM_UUID, streams[1].uuid);
+    TEST_ASSERT_EQUAL_INT(BEAM_STREAM_NOTIFY | BEAM_STREAM_READ, streams[1].properties);
+}
+
+void test_streams_add_rejects_invalid() {
+    BeamStreams streams;
+    TEST_ASSERT_EQUAL_INT(0, streams.add("state", BMLK_STATE_STREAM_UUID, BEAM_STREAM_NOTIFY));
+    TEST_ASSERT_EQUAL_INT(kBeamNoStream, streams.add("state", BMLK_LOG_STREAM_UUID, BEAM_STREAM_NOTIFY));
+    // Same UUID, other case
+    TEST_ASSERT_EQUAL_INT(kBeamNoStream, streams.add("other", "12345678-1234-1234-1234-1234567890AD", BEAM_STREAM_NOTIFY));
+    TEST_ASSERT_EQUAL_INT(kBeamNoStream, streams.add("short", "1234", BEAM_STREAM_NOTIFY));
+    TEST_ASSERT_EQUAL_INT(kBeamNoStream, streams.add("", BMLK_LOG_STREAM_UUID, BEAM_STREAM_NOTIFY));
+    TEST_ASSERT_EQUAL_INT(kBeamNoStream, streams.add("none", BMLK_LOG_STREAM_UUID, 0));
+    TEST_ASSERT_EQUAL_INT(kBeamNoStream, streams.add("bits", BMLK_LOG_STREAM_UUID, 0x80));
+    // Writable without a handler
+    TEST_ASSERT_EQUAL_INT(kBeamNoStream, streams.add("cmd", BMLK_LOG_STREAM_UUID, BEAM_STREAM_WRITE));
+    TEST_ASSERT_EQUAL_INT(1, streams.size());
+}
+
+void test_streams_capacity() {
+    BeamStreams streams;
+    char uuid[] = "12345678-1234-1234-1234-1234567890b0";
+    static const char* names[] = {"s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7", "s8"};
+    for (int i = 0; i < BEAM_MAX_STREAMS; i++) {
+        uuid[35] = static_cast<char>('0' + i);
+        TEST_ASSERT_EQUAL_INT(i, streams.add(names[i], uuid, BEAM_STREAM_NOTIFY));
+    }
+    uuid[35] = '9';
+    TEST_ASSERT_EQUAL_INT(kBeamNoStream, streams.add(names[BEAM_MAX_STREAMS], uuid, BEAM_STREAM_NOTIFY));
+}
+
+void test_streams_find() {
+    BeamStreams streams;
+    streams.add("state", BMLK_STATE_STREAM_UUID, BEAM_STREAM_NOTIFY);
+    streams.add("log", BMLK_LOG_STREAM_UUID, BEAM_STREAM_NOTIFY);
+    TEST_ASSERT_EQUAL_INT(1, streams.find("log"));
+    TEST_ASSERT_EQUAL_INT(0, streams.find("12345678-1234-1234-1234-1234567890AD"));
+    TEST_ASSERT_EQUAL_INT(kBeamNoStream, streams.find("telemetry"));
+    TEST_ASSERT_EQUAL_INT(kBeamNoStream, streams.find(nullptr));
+}
+
+// ============================================================================
+// Subscription Tests
+// ============================================================================
+
+void test_streams_subscriptions_are_per_stream() {
+    BeamStreams streams;
+    streams.add("state", BMLK_STATE_STREAM_UUID, BEAM_STREAM_NOTIFY);
+    streams.add("telemetry", BMLK_TELEMETRY_STREAM_UUID, BEAM_STREAM_NOTIFY);
+    TEST_ASSERT_FALSE(streams.isSubscribed(0));
+
+    streams.setSubscribed(1, true);
+    TEST_ASSERT_FALSE(streams.isSubscribed(0));
+    TEST_ASSERT_TRUE(streams.isSubscribed(1));
+    TEST_ASSERT_EQUAL_UINT32(0x2, streams.subscribedMask());
+
+    streams.setSubscribed(0, true);
+    streams.setSubscribed(1, false);
+    TEST_ASSERT_EQUAL_UINT32(0x1, streams.subscribedMask());
+
+    // Undeclared ids never read as subscribed
+    streams.setSubscribed(3, true);
+    TEST_ASSERT_FALSE(streams.isSubscribed(3));
+    TEST_ASSERT_FALSE(streams.isSubscribed(kBeamNoStream));
+
+    streams.clearSubscriptions();
+    TEST_ASSERT_EQUAL_UINT32(0, streams.subscribedMask());
+}
+
+void test_streams_handler_and_counters() {
+    BeamStreams streams;
+    const BeamStreamId log = streams.add("log", BMLK_LOG_STREAM_UUID, BEAM_STREAM_NOTIFY | BEAM_STREAM_WRITE, recordWrite);
+    const uint8_t level[] = {'d', 'e', 'b', 'u', 'g'};
+    streams[log].handler(level, sizeof(level));
+    streams.countReceived(log);
+    TEST_ASSERT_EQUAL_INT(1, writes);
+    TEST_ASSERT_EQUAL_INT(5, lastWriteSize);
+
+    streams.countSent(log, false);
+    streams.countSent(log, true);
+    streams.countSkipped(log);
+    const BeamStreamStats s = streams.stats(log);
+    TEST_ASSERT_EQUAL_UINT32(2, s.sent);
+    TEST_ASSERT_EQUAL_UINT32(1, s.truncated);
+    TEST_ASSERT_EQUAL_UINT32(1, s.skipped);
+    TEST_ASSERT_EQUAL_UINT32(1, s.received);
+
+    streams.resetStats();
+    TEST_ASSERT_EQUAL_UINT32(0, streams.stats(log).sent);
+    TEST_ASSERT_EQUAL_UINT32(0, streams.stats(7).sent);
+}
+
+// A central that only shows the LED state: telemetry samples are never
+// encoded, while the multiplexed characteristic had to format every one
+void test_streams_gate_skips_encoding() {
+    BeamStreams streams;
+    const BeamStreamId state = streams.add("state", BMLK_STATE_STREAM_UUID, BEAM_STREAM_NOTIFY);
+    const BeamStreamId telemetry = streams.add("telemetry", BMLK_TELEMETRY_STREAM_UUID, BEAM_STREAM_NOTIFY);
+    streams.setSubscribed(state, true);
+
+    int encoded = 0;
+    size_t bytes = 0;
+    for (int i = 0; i < 1000; i++) {
+        if (!streams.isSubscribed(telemetry)) continue;
+        char line[48];
+        bytes += snprintf(line, sizeof(line), "{\"t\":%d,\"light\":%d}", i, i * 3);
+        encoded++;
+    }
+    printf("{\"bench\":\"stream_gate\",\"schema\":1,\"samples\":1000,\"encoded\":%d,\"bytes\":%lu}\n",
+           encoded, static_cast<unsigned long>(bytes));
+    TEST_ASSERT_EQUAL_INT(0, encoded);
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Declaration Tests
+    RUN_TEST(test_streams_add_in_order);
+    RUN_TEST(test_streams_add_rejects_invalid);
+    RUN_TEST(test_streams_capacity);
+    RUN_TEST(test_streams_find);
+
+    // Subscription Tests
+    RUN_TEST(test_streams_subscriptions_are_per_stream);
+    RUN_TEST(test_streams_handler_and_counters);
+    RUN_TEST(test_streams_gate_skips_encoding);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
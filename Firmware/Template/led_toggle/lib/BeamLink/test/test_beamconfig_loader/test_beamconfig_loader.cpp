@@ -0,0 +1,194 @@
+/**
+ * @file test_beamconfig_loader.cpp
+ * @brief Tests for the configuration parser and file loader
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_beamconfig_loader`).
+ * On the host the file-backed tests use stdio and print parse and load
+ * timings; on the board they are skipped (SPIFFS content is not controlled).
+ */
+
+#include <unity.h>
+#include "BeamConfig.h"
+#include <cstdio>
+#include <cstring>
+
+static const char* kSampleConfig =
+    "# BeamLink configuration\r\n"
+    "DEVICE_NAME = \"Porch Light\"\r\n"
+    "BLE_POWER_DBM=3\n"
+    "BLE_ADV_INTERVAL_MS = 250\n"
+    "\n"
+    "LED_PIN=5\n"
+    "LED_ACTIVE_HIGH=false\n"
+    "ACTUATOR_PINS=12,13\n"
+    "SERIAL_BAUD=921600\n"
+    "ZERO_OFFSET=-0.5\n"
+    "DEBUG_MODE=off\n";
+
+// Every key, as in the template's data/beam.config
+static const char* kFullConfig =
+    "DEVICE_ID=BLX-LED-001\nDEVICE_NAME=BeamLink-LED\nDEVICE_TYPE=BLE-Controller\nFIRMWARE_VERSION=1.0.0\n"
+    "BLE_ENABLED=true\nBLE_NAME=BeamLink-LED\nBLE_POWER_DBM=9\nBLE_ADV_INTERVAL_MS=100\n"
+    "BLE_SERVICE_UUID=12345678-1234-1234-1234-1234567890ab\n"
+    "BLE_CHARACTERISTIC_UUID=12345678-1234-1234-1234-1234567890ac\n"
+    "WIFI_ENABLED=false\nWIFI_SSID=\nWIFI_PASSWORD=\nWIFI_MODE=STA\n"
+    "CLOUD_ENABLED=false\nCLOUD_ENDPOINT=https://api.beamlink.io\n"
+    "OTA_ENABLED=true\nOTA_URL=https://firmware.beamlink.io/esp32/latest.bin\n"
+    "LED_PIN=2\nLED_ACTIVE_HIGH=true\nSENSOR_PINS=34,35\nACTUATOR_PINS=12,13,14\n"
+    "REPORT_INTERVAL_MS=5000\nHEARTBEAT_MS=60000\nAUTO_RECONNECT=true\nLOG_LEVEL=INFO\nSERIAL_BAUD=115200\nDEBUG_MODE=true\n"
+    "AUTH_TOKEN=\nENCRYPTION_ENABLED=false\nSENSOR_GAIN=1.0\nZERO_OFFSET=0.02\n";
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Parser Tests
+// ============================================================================
+
+void test_parse_applies_keys() {
+    BeamConfig cfg;
+    BeamConfigLoadInfo info;
+    TEST_ASSERT_TRUE(parseBeamConfig(kSampleConfig, cfg, &info));
+    TEST_ASSERT_EQUAL_UINT16(9, info.keysApplied);
+    TEST_ASSERT_EQUAL_UINT16(0, info.keysRejected);
+
+    TEST_ASSERT_EQUAL_STRING("Porch Light", cfg.deviceName.c_str());
+    TEST_ASSERT_EQUAL_INT(3, cfg.blePowerDbm);
+    TEST_ASSERT_EQUAL_INT(250, cfg.bleAdvIntervalMs);
+    TEST_ASSERT_EQUAL_INT(5, cfg.ledPin);
+    TEST_ASSERT_FALSE(cfg.ledActiveHigh);
+    TEST_ASSERT_EQUAL_STRING("12,13", cfg.actuatorPins.c_str());
+    TEST_ASSERT_EQUAL_INT(921600, cfg.serialBaud);
+    TEST_ASSERT_EQUAL_FLOAT(-0.5f, cfg.zeroOffset);
+    TEST_ASSERT_FALSE(cfg.debugMode);
+
+    // Untouched keys keep their defaults
+    TEST_ASSERT_EQUAL_STRING("BLX-01A2B3", cfg.deviceId.c_str());
+}
+
+void test_parse_rejects_invalid_lines() {
+    BeamConfig cfg;
+    BeamConfigLoadInfo info;
+    TEST_ASSERT_FALSE(parseBeamConfig("BLE_POWER_DBM=20\nLED_PIN=abc\nNO_SUCH_KEY=1\nmissing separator\nBLE_NAME=Ok\n",
+                                      cfg, &info));
+    TEST_ASSERT_EQUAL_UINT16(1, info.keysApplied);
+    TEST_ASSERT_EQUAL_UINT16(4, info.keysRejected);
+    TEST_ASSERT_EQUAL_INT(9, cfg.blePowerDbm);
+    TEST_ASSERT_EQUAL_INT(2, cfg.ledPin);
+    TEST_ASSERT_EQUAL_STRING("Ok", cfg.bleName.c_str());
+
+    // The radio has 3 dB levels only; 4 dBm would silently radiate 3
+    TEST_ASSERT_FALSE(parseBeamConfig("BLE_POWER_DBM=4\n", cfg));
+    TEST_ASSERT_EQUAL_INT(9, cfg.blePowerDbm);
+    TEST_ASSERT_TRUE(parseBeamConfig("BLE_POWER_DBM=-3\n", cfg));
+    TEST_ASSERT_EQUAL_INT(-3, cfg.blePowerDbm);
+}
+
+// ============================================================================
+// File Tests (host only)
+// ============================================================================
+
+#ifndef ARDUINO
+static const char* kConfigPath = "test_beam.config";
+
+static void writeFile(const char* path, const char* text) {
+    FILE* f = fopen(path, "wb");
+    fputs(text, f);
+    fclose(f);
+}
+
+void test_load_parses_file() {
+    writeFile(kConfigPath, kSampleConfig);
+
+    BeamConfig cfg;
+    BeamConfigLoadInfo info;
+    TEST_ASSERT_TRUE(loadBeamConfig(cfg, kConfigPath, &info));
+    TEST_ASSERT_TRUE(info.source == BeamConfigLoadInfo::Source::Text);
+    TEST_ASSERT_EQUAL_UINT16(9, info.keysApplied);
+    TEST_ASSERT_EQUAL_STRING("Porch Light", cfg.deviceName.c_str());
+
+    // Edits are picked up on the next load, whatever their size
+    writeFile(kConfigPath, "LED_PIN=7\n");
+    BeamConfig edited;
+    TEST_ASSERT_TRUE(loadBeamConfig(edited, kConfigPath, &info));
+    TEST_ASSERT_EQUAL_INT(7, edited.ledPin);
+
+    // Keys left out keep the values passed in (the compiled-in defaults)
+    BeamConfig reflashed;
+    reflashed.deviceType = "porch-light";
+    TEST_ASSERT_TRUE(loadBeamConfig(reflashed, kConfigPath, &info));
+    TEST_ASSERT_EQUAL_STRING("porch-light", reflashed.deviceType.c_str());
+    TEST_ASSERT_EQUAL_INT(7, reflashed.ledPin);
+
+    BeamConfig missing;
+    TEST_ASSERT_FALSE(loadBeamConfig(missing, "no_such_beam.config", &info));
+    TEST_ASSERT_TRUE(info.source == BeamConfigLoadInfo::Source::Defaults);
+
+    remove(kConfigPath);
+}
+
+void test_parse_and_load_timing() {
+    const int iterations = 2000;
+    BeamConfig cfg;
+    BeamConfigLoadInfo info;
+    TEST_ASSERT_TRUE(parseBeamConfig(kFullConfig, cfg, &info));
+    TEST_ASSERT_EQUAL_UINT16(32, info.keysApplied);
+
+    unsigned long start = micros();
+    for (int i = 0; i < iterations; i++) {
+        BeamConfig parsed;
+        parseBeamConfig(kFullConfig, parsed);
+    }
+    unsigned long parseMicros = micros() - start;
+
+    // Whole load, file access included (stdio here, SPIFFS on the board)
+    writeFile(kConfigPath, kFullConfig);
+    const int loads = 200;
+    start = micros();
+    for (int i = 0; i < loads; i++) {
+        BeamConfig loaded;
+        loadBeamConfig(loaded, kConfigPath);
+    }
+    unsigned long loadMicros = micros() - start;
+    remove(kConfigPath);
+
+    printf("{\"bench\":\"beamconfig\",\"schema\":2,\"op\":\"load\",\"parse_ns\":%lu,\"load_ns\":%lu,\"text_bytes\":%u}\n",
+           parseMicros * 1000 / iterations, loadMicros * 1000 / loads, static_cast<unsigned>(strlen(kFullConfig)));
+}
+#endif
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Parser Tests
+    RUN_TEST(test_parse_applies_keys);
+    RUN_TEST(test_parse_rejects_invalid_lines);
+
+#ifndef ARDUINO
+    // File Tests
+    RUN_TEST(test_load_parses_file);
+    RUN_TEST(test_parse_and_load_timing);
+#endif
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
@@ -69,6 +69,34 @@ void test_beamlink_begin_with_custom_power() {
     TEST_ASSERT_EQUAL_STRING("TestDevice", beam->getDeviceName().c_str());
 }
 
+void test_beamlink_live_reconfigure() {
+    beam = new BeamLink();
+    TEST_ASSERT_FALSE(beam->setAdvPower(3)); // before begin()
+    TEST_ASSERT_TRUE(beam->begin("TestDevice", 9, 100));
+
+    BeamChangeReport report;
+    TEST_ASSERT_TRUE(beam->setAdvPower(3, &report));
+    TEST_ASSERT_TRUE(report.ok);
+    TEST_ASSERT_FALSE(report.restarted);
+    TEST_ASSERT_EQUAL_INT8(3, beam->getAdvPower());
+    TEST_ASSERT_FALSE(beam->setAdvPower(4, &report)); // between levels
+    TEST_ASSERT_EQUAL_INT8(3, beam->getAdvPower());
+
+    TEST_ASSERT_FALSE(beam->setAdvInterval(5, &report));
+    TEST_ASSERT_EQUAL_UINT16(100, beam->getAdvInterval());
+    TEST_ASSERT_TRUE(beam->setAdvInterval(500, &report));
+    TEST_ASSERT_FALSE(report.restarted);
+
+    BeamConfig cfg;
+    cfg.bleName = "Renamed";
+    cfg.blePowerDbm = 3;
+    cfg.bleAdvIntervalMs = 500;
+    BeamChangeReport reports[4];
+    TEST_ASSERT_EQUAL_size_t(1, beam->reconfigure(cfg, reports, 4));
+    TEST_ASSERT_TRUE(reports[0].ok);
+    TEST_ASSERT_EQUAL_STRING("Renamed", beam->getDeviceName().c_str());
+}
+
 void test_beamlink_begin_twice_fails() {
     beam = new BeamLink();
     bool first = beam->begin("TestDevice");
@@ -139,10 +167,11 @@ void test_beamlink_mtu_default() {
 void test_beamlink_mtu_after_init() {
     beam = new BeamLink();
     beam->begin("TestDevice");
-    // After init, MTU should be set (NimBLE sets to 512 or negotiated value)
-    uint16_t mtu = beam->getMTU();
+    // We ask for up to 512; what a client takes is only known after it connects
+    uint16_t mtu = beam->getPreferredMTU();
     TEST_ASSERT_GREATER_THAN_UINT16(23, mtu);
     TEST_ASSERT_LESS_OR_EQUAL_UINT16(512, mtu);
+    TEST_ASSERT_EQUAL_UINT16(23, beam->getMTU());
 }
 
 // ============================================================================
@@ -242,6 +271,29 @@ void test_beamlink_can_reinitialize_after_end() {
     TEST_ASSERT_EQUAL_STRING("TestDevice2", beam->getDeviceName().c_str());
 }
 
+void test_beamlink_restart_keeps_server_callbacks() {
+    beam = new BeamLink();
+    bool connected = false;
+    beam->onConnectionChange([&connected](bool on) { connected = on; });
+
+    // What setUuids() does on config:set:BLE_SERVICE_UUID=..., twice
+    TEST_ASSERT_TRUE(beam->begin("TestDevice"));
+    for (int i = 0; i < 2; i++) {
+        beam->end();
+        TEST_ASSERT_TRUE(beam->begin("TestDevice"));
+    }
+
+    // The callbacks NimBLE holds must still be alive (deinit() must not have freed them)
+    NimBLEServerCallbacks* callbacks = beam->getServerCallbacks();
+    TEST_ASSERT_NOT_NULL(callbacks);
+    callbacks->onConnect(NimBLEDevice::getServer());
+    TEST_ASSERT_TRUE(beam->isConnected());
+    TEST_ASSERT_TRUE(connected);
+    callbacks->onDisconnect(NimBLEDevice::getServer());
+    TEST_ASSERT_FALSE(beam->isConnected());
+    // tearDown() deletes beam: a double free would abort there
+}
+
 // ============================================================================
 // BeamConfig Tests
 // ============================================================================
@@ -347,6 +399,33 @@ void test_beamutils_parse_command_invalid() {
     TEST_ASSERT_FALSE(result);
 }
 
+void test_beamutils_views() {
+    std::string_view text = "  A = 1 \r\nB=\n", line, key, value;
+    TEST_ASSERT_TRUE(BeamUtils::nextLine(text, line));
+    TEST_ASSERT_TRUE(BeamUtils::splitPair(line, '=', key, value));
+    TEST_ASSERT_TRUE(key == "A");
+    TEST_ASSERT_TRUE(value == "1");
+    TEST_ASSERT_TRUE(BeamUtils::nextLine(text, line));
+    TEST_ASSERT_TRUE(BeamUtils::splitPair(line, '=', key, value));
+    TEST_ASSERT_TRUE(value.empty());
+    TEST_ASSERT_FALSE(BeamUtils::nextLine(text, line));
+}
+
+void test_beamutils_parse_numbers() {
+    int32_t i = 0;
+    float f = 0;
+    bool b = false;
+    TEST_ASSERT_TRUE(BeamUtils::parseInt(" -12 ", i));
+    TEST_ASSERT_EQUAL_INT32(-12, i);
+    TEST_ASSERT_FALSE(BeamUtils::parseInt("12a", i));
+    TEST_ASSERT_FALSE(BeamUtils::parseInt("99999999999", i));
+    TEST_ASSERT_TRUE(BeamUtils::parseFloat("0.02", f));
+    TEST_ASSERT_EQUAL_FLOAT(0.02f, f);
+    TEST_ASSERT_TRUE(BeamUtils::parseBool("ON", b));
+    TEST_ASSERT_TRUE(b);
+    TEST_ASSERT_FALSE(BeamUtils::parseBool("maybe", b));
+}
+
 void test_beamutils_format_uptime() {
     unsigned long oneHour = 3600000;
     std::string result = BeamUtils::formatUptime(oneHour);
@@ -391,6 +470,7 @@ void setup() {
     RUN_TEST(test_beamlink_begin_with_defaults);
     RUN_TEST(test_beamlink_begin_with_custom_power);
     RUN_TEST(test_beamlink_begin_twice_fails);
+    RUN_TEST(test_beamlink_live_reconfigure);
     
     // Message Handler Tests
     RUN_TEST(test_beamlink_set_message_handler);
@@ -418,6 +498,7 @@ void setup() {
     // End/Cleanup Tests
     RUN_TEST(test_beamlink_end_cleans_up);
     RUN_TEST(test_beamlink_can_reinitialize_after_end);
+    RUN_TEST(test_beamlink_restart_keeps_server_callbacks);
     
     // BeamConfig Tests
     RUN_TEST(test_beamconfig_defaults);
@@ -435,6 +516,8 @@ void setup() {
     RUN_TEST(test_beamutils_parse_command);
     RUN_TEST(test_beamutils_parse_command_value);
     RUN_TEST(test_beamutils_parse_command_invalid);
+    RUN_TEST(test_beamutils_views);
+    RUN_TEST(test_beamutils_parse_numbers);
     RUN_TEST(test_beamutils_format_uptime);
     
     // BeamErrors Tests
@@ -0,0 +1,138 @@
+/**
+ * @file test_boot_sequence.cpp
+ * @brief Tests for boot phase markers, the step sequencer and BootTask
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_boot_sequence`).
+ */
+
+#include <unity.h>
+#include "BootSequence.h"
+#include <string>
+
+static std::string trace;
+
+void setUp(void) {
+    trace.clear();
+}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Timeline Tests
+// ============================================================================
+
+void test_boot_timeline_marks() {
+    BootTimeline timeline;
+    TEST_ASSERT_TRUE(timeline.mark("setup"));
+    delay(2);
+    TEST_ASSERT_TRUE(timeline.mark("advertising"));
+
+    TEST_ASSERT_EQUAL_size_t(2, timeline.size());
+    TEST_ASSERT_EQUAL_STRING("advertising", timeline.name(1));
+    TEST_ASSERT_TRUE(timeline.at("advertising") >= timeline.at("setup") + 1000);
+    TEST_ASSERT_EQUAL_UINT32(0, timeline.at("missing"));
+    TEST_ASSERT_NULL(timeline.name(5));
+
+    TEST_ASSERT_TRUE(timeline.report());
+    TEST_ASSERT_FALSE(timeline.report()); // reported once
+}
+
+void test_boot_timeline_capacity() {
+    BootTimeline timeline;
+    for (int i = 0; i < BOOT_MAX_MARKERS; i++) {
+        TEST_ASSERT_TRUE(timeline.mark("phase"));
+    }
+    TEST_ASSERT_FALSE(timeline.mark("overflow"));
+    TEST_ASSERT_EQUAL_size_t(BOOT_MAX_MARKERS, timeline.size());
+}
+
+// ============================================================================
+// Sequencer Tests
+// ============================================================================
+
+void test_boot_sequencer_runs_steps_on_time() {
+    BootSequencer seq;
+    seq.then(0, [] { trace += "a"; });
+    seq.then(150, [] { trace += "b"; });
+    seq.then(150, [] { trace += "c"; });
+
+    TEST_ASSERT_TRUE(seq.update(0)); // not started: nothing runs
+    TEST_ASSERT_EQUAL_STRING("", trace.c_str());
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, seq.msUntilNext(0));
+
+    seq.start(1000);
+    TEST_ASSERT_TRUE(seq.isRunning());
+    TEST_ASSERT_TRUE(seq.update(1000));
+    TEST_ASSERT_EQUAL_STRING("a", trace.c_str());
+    TEST_ASSERT_TRUE(seq.update(1149));
+    TEST_ASSERT_EQUAL_STRING("a", trace.c_str());
+    TEST_ASSERT_EQUAL_UINT32(1, seq.msUntilNext(1149));
+
+    // A late loop() catches up on every step that is due
+    TEST_ASSERT_FALSE(seq.update(1400));
+    TEST_ASSERT_EQUAL_STRING("abc", trace.c_str());
+    TEST_ASSERT_TRUE(seq.isFinished());
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, seq.msUntilNext(1400));
+    TEST_ASSERT_FALSE(seq.then(10, [] {}));
+}
+
+// ============================================================================
+// BootTask Tests
+// ============================================================================
+
+void test_boot_task_runs_in_parallel() {
+    BootTask task;
+    std::atomic<bool> release{false};
+    std::atomic<int> value{0};
+
+    TEST_ASSERT_TRUE(task.start("init", [&] {
+        while (!release.load()) delay(1);
+        value.store(42);
+    }));
+    TEST_ASSERT_FALSE(task.isDone());
+    TEST_ASSERT_FALSE(task.wait(5));
+
+    release.store(true);
+    TEST_ASSERT_TRUE(task.wait());
+    TEST_ASSERT_EQUAL_INT(42, value.load());
+
+    // Can be reused once finished
+    TEST_ASSERT_TRUE(task.start("again", [&] { value.store(7); }));
+    TEST_ASSERT_TRUE(task.wait(1000));
+    TEST_ASSERT_EQUAL_INT(7, value.load());
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Timeline Tests
+    RUN_TEST(test_boot_timeline_marks);
+    RUN_TEST(test_boot_timeline_capacity);
+
+    // Sequencer Tests
+    RUN_TEST(test_boot_sequencer_runs_steps_on_time);
+
+    // BootTask Tests
+    RUN_TEST(test_boot_task_runs_in_parallel);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
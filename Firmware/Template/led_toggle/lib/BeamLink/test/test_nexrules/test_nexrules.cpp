@@ -0,0 +1,184 @@
+/**
+ * @file test_nexrules.cpp
+ * @brief Tests for the NexState rule engine (compile, index, edge triggering)
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_nexrules`).
+ */
+
+#include <unity.h>
+#include "NexRules.h"
+#include "../nexstate_test_helpers.h"
+#include <vector>
+
+using namespace nexstate;
+
+static std::vector<std::string> notifications;
+
+static void recordNotify(std::string_view message) {
+    notifications.emplace_back(message);
+}
+
+void setUp(void) {
+    notifications.clear();
+}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Compiler Tests
+// ============================================================================
+
+void test_rules_compile_forms() {
+    Rule rule;
+    TEST_ASSERT_TRUE(RuleEngine::compile("light < 200 => ledOn = true", rule));
+    TEST_ASSERT_EQUAL_UINT8(1, rule.conditionCount);
+    TEST_ASSERT_TRUE(rule.conditions[0].op == RuleOp::Less);
+    TEST_ASSERT_EQUAL_STRING("ledOn", rule.target.c_str());
+    TEST_ASSERT_TRUE(rule.valueType == RecordType::Bool);
+
+    TEST_ASSERT_TRUE(RuleEngine::compile("temp>=30&&fan==false=>notify:Overheating", rule));
+    TEST_ASSERT_EQUAL_UINT8(2, rule.conditionCount);
+    TEST_ASSERT_TRUE(rule.conditions[0].op == RuleOp::GreaterEqual);
+    TEST_ASSERT_TRUE(rule.conditions[1].op == RuleOp::Equal);
+    TEST_ASSERT_TRUE(rule.action == Rule::Action::Notify);
+    TEST_ASSERT_EQUAL_STRING("Overheating", rule.target.c_str());
+
+    TEST_ASSERT_TRUE(RuleEngine::compile("x != 1.5 => level = 3", rule));
+    TEST_ASSERT_TRUE(rule.valueType == RecordType::Int);
+}
+
+void test_rules_compile_errors() {
+    Rule rule;
+    std::string error;
+    TEST_ASSERT_FALSE(RuleEngine::compile("light < 200", rule, &error));
+    TEST_ASSERT_EQUAL_STRING("missing =>", error.c_str());
+    TEST_ASSERT_FALSE(RuleEngine::compile("light = 200 => a = 1", rule, &error));
+    TEST_ASSERT_FALSE(RuleEngine::compile("light < abc => a = 1", rule, &error));
+    TEST_ASSERT_FALSE(RuleEngine::compile("a < 1 && b < 2 && c < 3 => a = 1", rule, &error));
+    TEST_ASSERT_EQUAL_STRING("too many conditions", error.c_str());
+    TEST_ASSERT_FALSE(RuleEngine::compile("a < 1 => notify:", rule, &error));
+}
+
+// ============================================================================
+// Engine Tests
+// ============================================================================
+
+void test_rules_edge_triggered_set() {
+    NexState store(quietConfig());
+    RuleEngine engine;
+    engine.begin(store);
+    store.set("ledOn", false);
+    store.set("light", 500);
+
+    TEST_ASSERT_EQUAL_INT(0, engine.addRule("light < 200 => ledOn = true"));
+    TEST_ASSERT_FALSE(store.get<bool>("ledOn"));
+
+    store.set("light", 150);
+    TEST_ASSERT_TRUE(store.get<bool>("ledOn"));
+
+    // Still dark: the action does not repeat after the user turns the LED off
+    store.set("ledOn", false);
+    store.set("light", 120);
+    TEST_ASSERT_FALSE(store.get<bool>("ledOn"));
+
+    // Bright again, then dark again: fires once more
+    store.set("light", 800);
+    store.set("light", 100);
+    TEST_ASSERT_TRUE(store.get<bool>("ledOn"));
+}
+
+void test_rules_only_affected_rules_evaluated() {
+    NexState store(quietConfig());
+    RuleEngine engine;
+    engine.begin(store);
+    engine.onNotify(recordNotify);
+    engine.addRule("temp > 30 => notify:hot");
+    engine.addRule("humidity > 80 => notify:humid");
+    uint32_t before = engine.getEvaluations();
+
+    store.set("temp", 35.0f);
+    store.set("other", 1);
+    TEST_ASSERT_EQUAL_UINT32(before + 1, engine.getEvaluations());
+    TEST_ASSERT_EQUAL_size_t(1, notifications.size());
+    TEST_ASSERT_EQUAL_STRING("hot", notifications[0].c_str());
+}
+
+void test_rules_action_keeps_key_type() {
+    NexState store(quietConfig());
+    RuleEngine engine;
+    engine.begin(store);
+    store.set("fanSpeed", 0.0f);
+    engine.addRule("temp > 30 => fanSpeed = 1");
+    store.set("temp", 31);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, store.get<float>("fanSpeed"));
+}
+
+void test_rules_commands_and_cascade_limit() {
+    NexState store(quietConfig());
+    RuleEngine engine;
+    engine.begin(store);
+    engine.onNotify(recordNotify);
+
+    TEST_ASSERT_TRUE(engine.post("rule:add:a == 1 => b = 1"));
+    TEST_ASSERT_TRUE(engine.post("rule:add:b == 1 => a = 0"));
+    TEST_ASSERT_TRUE(engine.post("rule:add:broken"));
+    engine.update();
+    TEST_ASSERT_EQUAL_size_t(2, engine.size());
+    TEST_ASSERT_EQUAL_STRING("RULE 0 OK", notifications[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("RULE ERR missing =>", notifications[2].c_str());
+
+    // a=1 -> b=1 -> a=0 terminates through edge triggering
+    store.set("a", 1);
+    TEST_ASSERT_EQUAL_INT(0, store.get<int>("a"));
+    TEST_ASSERT_EQUAL_INT(1, store.get<int>("b"));
+
+    notifications.clear();
+    TEST_ASSERT_TRUE(engine.handleCommand("rule:list"));
+    TEST_ASSERT_EQUAL_STRING("0: a == 1 => b = 1", notifications[0].c_str());
+    // Not a number: nothing is deleted (atoi would have read rule 0)
+    notifications.clear();
+    TEST_ASSERT_TRUE(engine.handleCommand("rule:del:xyz"));
+    TEST_ASSERT_TRUE(engine.handleCommand("rule:del:"));
+    TEST_ASSERT_EQUAL_size_t(2, engine.size());
+    TEST_ASSERT_EQUAL_STRING("RULE ERR invalid id", notifications[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("RULE ERR invalid id", notifications[1].c_str());
+
+    TEST_ASSERT_TRUE(engine.handleCommand("rule:del:0"));
+    TEST_ASSERT_EQUAL_size_t(1, engine.size());
+    TEST_ASSERT_FALSE(engine.handleCommand("led:on"));
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Compiler Tests
+    RUN_TEST(test_rules_compile_forms);
+    RUN_TEST(test_rules_compile_errors);
+
+    // Engine Tests
+    RUN_TEST(test_rules_edge_triggered_set);
+    RUN_TEST(test_rules_only_affected_rules_evaluated);
+    RUN_TEST(test_rules_action_keeps_key_type);
+    RUN_TEST(test_rules_commands_and_cascade_limit);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
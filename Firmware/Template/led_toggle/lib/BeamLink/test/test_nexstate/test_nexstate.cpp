@@ -0,0 +1,334 @@
+/**
+ * @file test_nexstate.cpp
+ * @brief Unit tests for the NexState store (storage, types, output)
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_nexstate`).
+ */
+
+#include <unity.h>
+#include "NexState.h"
+#include "BeamScheduler.h"
+#include "../nexstate_test_helpers.h"
+
+using namespace nexstate;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================================================
+// SmallString Tests
+// ============================================================================
+
+void test_smallstring_short_is_inline() {
+    SmallString s("ledOn");
+    TEST_ASSERT_TRUE(s.isInline());
+    TEST_ASSERT_EQUAL_size_t(5, s.size());
+    TEST_ASSERT_EQUAL_STRING("ledOn", s.c_str());
+    TEST_ASSERT_EQUAL_size_t(0, s.heapBytes());
+}
+
+void test_smallstring_long_spills_to_heap() {
+    std::string longValue(SmallString::kInlineCapacity + 10, 'x');
+    SmallString s(longValue);
+    TEST_ASSERT_FALSE(s.isInline());
+    TEST_ASSERT_EQUAL_STRING(longValue.c_str(), s.c_str());
+    TEST_ASSERT_EQUAL_size_t(longValue.size() + 1, s.heapBytes());
+
+    SmallString copy(s);
+    SmallString moved(std::move(s));
+    TEST_ASSERT_TRUE(copy == moved);
+    TEST_ASSERT_TRUE(s.empty());
+
+    copy = SmallString("short");
+    TEST_ASSERT_TRUE(copy.isInline());
+    TEST_ASSERT_EQUAL_STRING("short", copy.c_str());
+}
+
+// ============================================================================
+// Storage Tests
+// ============================================================================
+
+void test_nexstate_set_get_basic_types() {
+    NexState store(quietConfig());
+    store.set("ledOn", true);
+    store.set("count", 7);
+    store.set("temp", 21.5f);
+    store.set("name", "BeamLink");
+
+    TEST_ASSERT_TRUE(store.get<bool>("ledOn"));
+    TEST_ASSERT_EQUAL_INT(7, store.get<int>("count"));
+    TEST_ASSERT_EQUAL_FLOAT(21.5f, store.get<float>("temp"));
+    TEST_ASSERT_EQUAL_STRING("BeamLink", store.get<std::string>("name").c_str());
+    TEST_ASSERT_EQUAL_size_t(4, store.size());
+}
+
+void test_nexstate_wide_numeric_types() {
+    NexState store(quietConfig());
+    store.set("uptime", static_cast<uint32_t>(4000000000u));
+    store.set("energy", static_cast<int64_t>(-9000000000LL));
+    store.set("ratio", 0.125);
+
+    TEST_ASSERT_EQUAL_UINT32(4000000000u, store.get<uint32_t>("uptime"));
+    TEST_ASSERT_TRUE(store.get<int64_t>("energy") == -9000000000LL);
+    TEST_ASSERT_EQUAL_DOUBLE(0.125, store.get<double>("ratio"));
+
+    // Types are strict: reading with another storage type yields the default
+    TEST_ASSERT_EQUAL_INT(-1, store.get<int>("uptime", -1));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, store.get<float>("ratio"));
+}
+
+void test_nexstate_keys_sorted_and_unique() {
+    NexState store(quietConfig());
+    store.set("zeta", 1);
+    store.set("alpha", 2);
+    store.set("mid", 3);
+    store.set("alpha", 4);
+
+    TEST_ASSERT_EQUAL_size_t(3, store.size());
+    std::string json = store.getStateAsJson();
+    size_t a = json.find("\"alpha\":4");
+    size_t m = json.find("\"mid\":3");
+    size_t z = json.find("\"zeta\":1");
+    TEST_ASSERT_TRUE(a != std::string::npos && m != std::string::npos && z != std::string::npos);
+    TEST_ASSERT_TRUE(a < m && m < z);
+}
+
+void test_nexstate_type_change_replaces_value() {
+    NexState store(quietConfig());
+    store.set("mode", 1);
+    store.set("mode", "blink");
+    TEST_ASSERT_EQUAL_STRING("blink", store.get<std::string>("mode").c_str());
+    TEST_ASSERT_EQUAL_INT(0, store.get<int>("mode"));
+    TEST_ASSERT_EQUAL_size_t(1, store.size());
+}
+
+// ============================================================================
+// Change Detection Tests
+// ============================================================================
+
+void test_nexstate_change_detection() {
+    NexState store(quietConfig());
+    store.set("ledOn", false);
+    TEST_ASSERT_FALSE(store.hasChanged<bool>("ledOn"));
+
+    store.set("ledOn", true);
+    TEST_ASSERT_TRUE(store.hasChanged<bool>("ledOn"));
+    TEST_ASSERT_TRUE(store.hasAnyChanged());
+    TEST_ASSERT_EQUAL_size_t(1, store.getChangedKeys().size());
+
+    store.markAsRead<bool>("ledOn");
+    TEST_ASSERT_FALSE(store.hasAnyChanged());
+
+    store.set("label", std::string(40, 'a'));
+    store.set("label", std::string(40, 'b'));
+    TEST_ASSERT_TRUE(store.hasChanged<std::string>("label"));
+    store.markAllAsRead();
+    TEST_ASSERT_FALSE(store.hasChanged<std::string>("label"));
+}
+
+void test_nexstate_json_output() {
+    NexStateConfig config = quietConfig();
+    config.deviceInfo.deviceName = "Dev";
+    config.deviceInfo.deviceId = "ID1";
+    config.deviceInfo.deviceType = "T";
+    config.deviceInfo.firmwareVersion = "1.0";
+    NexState store(config);
+    store.set("ledOn", true);
+    store.set("name", "x");
+
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"device\":\"Dev\",\"id\":\"ID1\",\"type\":\"T\",\"fw\":\"1.0\",\"state\":{\"ledOn\":true,\"name\":\"x\"}}",
+        store.getStateAsJson().c_str());
+}
+
+void test_nexstate_interval_output_from_scheduler() {
+    NexStateConfig config = quietConfig();
+    config.enableSerialOutput = true;
+    config.outputOnInterval = true;
+    config.outputIntervalMs = 100;
+    NexState store(config);
+    BeamScheduler scheduler;
+    store.attachScheduler(scheduler);
+    TEST_ASSERT_EQUAL_size_t(1, scheduler.size());
+    store.attachScheduler(scheduler); // only once
+    TEST_ASSERT_EQUAL_size_t(1, scheduler.size());
+
+    store.set("ledOn", false);
+    store.set("ledOn", true);
+    store.update(); // interval output no longer polled here
+    TEST_ASSERT_TRUE(store.hasAnyChanged());
+
+    TEST_ASSERT_EQUAL_size_t(1, scheduler.run(millis() + 100));
+    TEST_ASSERT_FALSE(store.hasAnyChanged()); // output marks values as read
+}
+
+void test_nexstate_change_listeners() {
+    NexState store(quietConfig());
+    int calls = 0;
+    bool last = false;
+    store.onChange<bool>("ledOn", [&](const bool& on) { calls++; last = on; });
+
+    std::string changedKey;
+    std::string changedValue;
+    store.subscribe([&](const std::string& key, const std::string& value) {
+        changedKey = key;
+        changedValue = value;
+    });
+
+    store.set("ledOn", true);  // first set counts as a change
+    store.set("ledOn", true);  // unchanged: no callback
+    store.set("other", true);  // different key
+    TEST_ASSERT_EQUAL_INT(1, calls);
+    TEST_ASSERT_TRUE(last);
+    TEST_ASSERT_EQUAL_STRING("other", changedKey.c_str());
+
+    store.set("ledOn", false);
+    TEST_ASSERT_EQUAL_INT(2, calls);
+    TEST_ASSERT_FALSE(last);
+    TEST_ASSERT_EQUAL_STRING("false", changedValue.c_str());
+
+    // A listener may write other keys without invalidating the dispatch
+    store.onChange<int>("count", [&](const int& v) { store.set("count" + std::to_string(v), v); });
+    store.set("count", 1);
+    TEST_ASSERT_EQUAL_INT(1, store.get<int>("count1"));
+}
+
+// ============================================================================
+// Computed Key Tests
+// ============================================================================
+
+void test_nexstate_computed_lazy_and_cached() {
+    NexState store(quietConfig());
+    int evaluations = 0;
+    store.set("temp", 20.0f);
+    store.set("threshold", 25.0f);
+    store.compute<bool>("alarm", {"temp", "threshold"}, [&](const NexState& s) {
+        evaluations++;
+        return s.get<float>("temp") > s.get<float>("threshold");
+    });
+    TEST_ASSERT_EQUAL_INT(0, evaluations); // nothing read yet
+
+    TEST_ASSERT_FALSE(store.get<bool>("alarm"));
+    TEST_ASSERT_FALSE(store.get<bool>("alarm"));
+    TEST_ASSERT_EQUAL_INT(1, evaluations);
+
+    // Unrelated and unchanged writes do not invalidate the cache
+    store.set("humidity", 40);
+    store.set("temp", 20.0f);
+    store.get<bool>("alarm");
+    TEST_ASSERT_EQUAL_INT(1, evaluations);
+
+    // Several input changes between reads cost one evaluation
+    store.set("temp", 26.0f);
+    store.set("temp", 27.0f);
+    store.set("threshold", 26.5f);
+    TEST_ASSERT_TRUE(store.get<bool>("alarm"));
+    TEST_ASSERT_EQUAL_INT(2, evaluations);
+}
+
+void test_nexstate_computed_notifies_and_chains() {
+    NexState store(quietConfig());
+    store.set("a0", false);
+    store.set("a1", false);
+    store.compute<bool>("anyOn", {"a0", "a1"}, [](const NexState& s) {
+        return s.get<bool>("a0") || s.get<bool>("a1");
+    });
+    store.compute<std::string>("status", {"anyOn"}, [](const NexState& s) {
+        return std::string(s.get<bool>("anyOn") ? "ACTIVE" : "IDLE");
+    });
+
+    int notifications = 0;
+    store.onChange<bool>("anyOn", [&](const bool&) { notifications++; });
+
+    store.update(); // first publish evaluates both
+    TEST_ASSERT_EQUAL_INT(1, notifications);
+    TEST_ASSERT_TRUE(store.getStateAsJson().find("\"status\":\"IDLE\"") != std::string::npos);
+
+    store.set("a1", true);
+    TEST_ASSERT_EQUAL_STRING("ACTIVE", store.get<std::string>("status").c_str());
+    TEST_ASSERT_EQUAL_INT(2, notifications);
+
+    // Result unchanged: no notification
+    store.set("a0", true);
+    store.update();
+    TEST_ASSERT_EQUAL_INT(2, notifications);
+
+    StateSnapshot snap;
+    store.readSnapshot(snap);
+    TEST_ASSERT_TRUE(snap.get<bool>("anyOn", false));
+}
+
+// ============================================================================
+// Memory Accounting Tests
+// ============================================================================
+
+void test_nexstate_memory_stats() {
+    NexState store(quietConfig());
+    MemoryStats empty = store.getMemoryStats();
+    TEST_ASSERT_EQUAL_size_t(0, empty.keyCount);
+    TEST_ASSERT_EQUAL_size_t(0, empty.bytesPerKey());
+    TEST_ASSERT_TRUE(empty.syncBytes > 0);
+
+    store.set("ledOn", true);
+    MemoryStats inlineOnly = store.getMemoryStats();
+    TEST_ASSERT_EQUAL_size_t(1, inlineOnly.keyCount);
+    TEST_ASSERT_EQUAL_size_t(sizeof(SmallString), inlineOnly.keyBytes);
+
+    // Long keys and string values add their heap bytes
+    std::string longKey(SmallString::kInlineCapacity + 8, 'k');
+    std::string longValue(SmallString::kInlineCapacity + 18, 'v');
+    store.set(longKey, longValue);
+    MemoryStats withHeap = store.getMemoryStats();
+    TEST_ASSERT_EQUAL_size_t(2 * sizeof(SmallString) + longKey.size() + 1, withHeap.keyBytes);
+    TEST_ASSERT_EQUAL_size_t(inlineOnly.valueBytes * 2 + 2 * (longValue.size() + 1), withHeap.valueBytes);
+    TEST_ASSERT_EQUAL_size_t(withHeap.keyBytes + withHeap.valueBytes + withHeap.containerBytes +
+                             withHeap.callbackBytes + withHeap.syncBytes, withHeap.total());
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // SmallString Tests
+    RUN_TEST(test_smallstring_short_is_inline);
+    RUN_TEST(test_smallstring_long_spills_to_heap);
+
+    // Storage Tests
+    RUN_TEST(test_nexstate_set_get_basic_types);
+    RUN_TEST(test_nexstate_wide_numeric_types);
+    RUN_TEST(test_nexstate_keys_sorted_and_unique);
+    RUN_TEST(test_nexstate_type_change_replaces_value);
+
+    // Change Detection Tests
+    RUN_TEST(test_nexstate_change_detection);
+    RUN_TEST(test_nexstate_json_output);
+    RUN_TEST(test_nexstate_interval_output_from_scheduler);
+    RUN_TEST(test_nexstate_change_listeners);
+
+    // Computed Key Tests
+    RUN_TEST(test_nexstate_computed_lazy_and_cached);
+    RUN_TEST(test_nexstate_computed_notifies_and_chains);
+
+    // Memory Accounting Tests
+    RUN_TEST(test_nexstate_memory_stats);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
@@ -0,0 +1,240 @@
+/**
+ * @file test_nexstate_bench.cpp
+ * @brief NexState cost benchmarks against a plain-struct baseline
+ *
+ * Runs on the host (`pio test -e native -f test_nexstate_bench -v`) or on the
+ * board. Every measurement is printed as one JSON line so results can be
+ * collected with `grep '^{"bench"'` and compared across releases:
+ *
+ *   {"bench":"nexstate","schema":1,"impl":"nexstate","op":"get","keys":32,"iterations":200000,"ns_per_op":14.2}
+ *
+ * impl is "nexstate" or "struct"; op is set, get, has_changed, json or memory.
+ */
+
+#include <unity.h>
+#include "NexState.h"
+#include "../nexstate_test_helpers.h"
+#include <string>
+#include <vector>
+
+using namespace nexstate;
+
+#ifdef ARDUINO
+static const uint32_t kIterations = 20000;
+static const uint32_t kJsonIterations = 200;
+#else
+static const uint32_t kIterations = 200000;
+static const uint32_t kJsonIterations = 2000;
+#endif
+
+static const size_t kSizes[] = {8, 32, 128};
+static const size_t kMaxKeys = 128;
+
+static volatile uint32_t sink = 0;
+
+/**
+ * @brief Hand-written equivalent of a store of bool flags
+ */
+struct PlainState {
+    bool flags[kMaxKeys];
+    bool changed[kMaxKeys];
+};
+
+static PlainState plain;
+
+static std::vector<std::string> makeKeys(size_t count) {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < count; i++) {
+        keys.push_back("flag" + std::to_string(i));
+    }
+    return keys;
+}
+
+static void fillStore(NexState& store, const std::vector<std::string>& keys) {
+    store.reserve(keys.size());
+    for (const auto& key : keys) {
+        store.set(key, false);
+    }
+    store.markAllAsRead();
+}
+
+template<typename Fn>
+static double nsPerOp(uint32_t iterations, Fn fn) {
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < iterations; i++) {
+        fn(i);
+    }
+    unsigned long elapsed = micros() - start;
+    return elapsed * 1000.0 / iterations;
+}
+
+static void emit(const char* impl, const char* op, size_t keys, uint32_t iterations, double ns) {
+    Serial.printf("{\"bench\":\"nexstate\",\"schema\":1,\"impl\":\"%s\",\"op\":\"%s\","
+                  "\"keys\":%u,\"iterations\":%u,\"ns_per_op\":%.1f}\n",
+                  impl, op, static_cast<unsigned>(keys), static_cast<unsigned>(iterations), ns);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================================================
+// Memory
+// ============================================================================
+
+void test_bench_memory() {
+    for (size_t n : kSizes) {
+        NexState store(quietConfig());
+        fillStore(store, makeKeys(n));
+        MemoryStats stats = store.getMemoryStats();
+
+        TEST_ASSERT_EQUAL_size_t(n, stats.keyCount);
+        TEST_ASSERT_TRUE(stats.bytesPerKey() > 0);
+
+        Serial.printf("{\"bench\":\"nexstate\",\"schema\":1,\"impl\":\"nexstate\",\"op\":\"memory\","
+                      "\"keys\":%u,\"bytes_per_key\":%u,\"key_bytes\":%u,\"value_bytes\":%u,"
+                      "\"container_bytes\":%u,\"callback_bytes\":%u,\"sync_bytes\":%u,\"total_bytes\":%u}\n",
+                      static_cast<unsigned>(n), static_cast<unsigned>(stats.bytesPerKey()),
+                      static_cast<unsigned>(stats.keyBytes), static_cast<unsigned>(stats.valueBytes),
+                      static_cast<unsigned>(stats.containerBytes), static_cast<unsigned>(stats.callbackBytes),
+                      static_cast<unsigned>(stats.syncBytes), static_cast<unsigned>(stats.total()));
+        Serial.printf("{\"bench\":\"nexstate\",\"schema\":1,\"impl\":\"struct\",\"op\":\"memory\","
+                      "\"keys\":%u,\"bytes_per_key\":%u,\"total_bytes\":%u}\n",
+                      static_cast<unsigned>(n), static_cast<unsigned>(sizeof(plain) / kMaxKeys),
+                      static_cast<unsigned>(n * sizeof(plain) / kMaxKeys));
+    }
+}
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+void test_bench_set() {
+    for (size_t n : kSizes) {
+        auto keys = makeKeys(n);
+        NexState store(quietConfig());
+        fillStore(store, keys);
+
+        double ns = nsPerOp(kIterations, [&](uint32_t i) {
+            store.set(keys[i % n], ((i / n) & 1) != 0);
+        });
+        emit("nexstate", "set", n, kIterations, ns);
+
+        ns = nsPerOp(kIterations, [&](uint32_t i) {
+            size_t k = i % n;
+            bool v = ((i / n) & 1) != 0;
+            if (plain.flags[k] != v) {
+                plain.flags[k] = v;
+                plain.changed[k] = true;
+            }
+        });
+        emit("struct", "set", n, kIterations, ns);
+        TEST_ASSERT_TRUE(store.hasAnyChanged());
+    }
+}
+
+void test_bench_get() {
+    for (size_t n : kSizes) {
+        auto keys = makeKeys(n);
+        NexState store(quietConfig());
+        fillStore(store, keys);
+        store.set(keys[0], true);
+
+        uint32_t hits = 0;
+        double ns = nsPerOp(kIterations, [&](uint32_t i) {
+            hits += store.get<bool>(keys[i % n]);
+        });
+        emit("nexstate", "get", n, kIterations, ns);
+        TEST_ASSERT_EQUAL_UINT32((kIterations + n - 1) / n, hits);
+
+        ns = nsPerOp(kIterations, [&](uint32_t i) {
+            hits += plain.flags[i % n];
+        });
+        emit("struct", "get", n, kIterations, ns);
+        sink = hits;
+    }
+}
+
+void test_bench_has_changed() {
+    for (size_t n : kSizes) {
+        auto keys = makeKeys(n);
+        NexState store(quietConfig());
+        fillStore(store, keys);
+
+        uint32_t hits = 0;
+        double ns = nsPerOp(kIterations, [&](uint32_t i) {
+            hits += store.hasChanged<bool>(keys[i % n]);
+        });
+        emit("nexstate", "has_changed", n, kIterations, ns);
+        TEST_ASSERT_EQUAL_UINT32(0, hits);
+
+        ns = nsPerOp(kIterations, [&](uint32_t i) {
+            hits += plain.changed[i % n];
+        });
+        emit("struct", "has_changed", n, kIterations, ns);
+        sink = hits;
+    }
+}
+
+void test_bench_json() {
+    for (size_t n : kSizes) {
+        auto keys = makeKeys(n);
+        NexState store(quietConfig());
+        fillStore(store, keys);
+
+        size_t bytes = 0;
+        double ns = nsPerOp(kJsonIterations, [&](uint32_t) {
+            bytes += store.getStateAsJson().size();
+        });
+        emit("nexstate", "json", n, kJsonIterations, ns);
+        TEST_ASSERT_TRUE(bytes > 0);
+
+        // Baseline: the same document written field by field
+        ns = nsPerOp(kJsonIterations, [&](uint32_t) {
+            std::string out;
+            out.reserve(n * 16 + 16);
+            out += "{\"state\":{";
+            for (size_t k = 0; k < n; k++) {
+                if (k) out += ',';
+                out += '"';
+                out += keys[k];
+                out += "\":";
+                out += plain.flags[k] ? "true" : "false";
+            }
+            out += "}}";
+            bytes += out.size();
+        });
+        emit("struct", "json", n, kJsonIterations, ns);
+        sink = static_cast<uint32_t>(bytes);
+    }
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_bench_memory);
+    RUN_TEST(test_bench_set);
+    RUN_TEST(test_bench_get);
+    RUN_TEST(test_bench_has_changed);
+    RUN_TEST(test_bench_json);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
@@ -0,0 +1,220 @@
+/**
+ * @file test_nexstate_sync.cpp
+ * @brief Cross-task access tests for NexState (post queue + snapshot reads)
+ *
+ * Runs on the host (`pio test -e native -f test_nexstate_sync`), where the
+ * stress tests use several std::threads to play the roles of loop(), the
+ * NimBLE host task and a telemetry reader.
+ */
+
+#include <unity.h>
+#include "NexState.h"
+#include "../nexstate_test_helpers.h"
+
+#ifndef ARDUINO
+#include <thread>
+#include <vector>
+#endif
+
+using namespace nexstate;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================================================
+// Single-task behaviour
+// ============================================================================
+
+void test_nexstate_post_applied_on_update() {
+    NexState store(quietConfig());
+    TEST_ASSERT_TRUE(store.post("ledOn", true));
+    TEST_ASSERT_TRUE(store.post("count", 42));
+    TEST_ASSERT_TRUE(store.post("temp", 21.5f));
+    TEST_ASSERT_TRUE(store.post("mode", "blink"));
+
+    // Nothing is applied until the owner drains the queue
+    TEST_ASSERT_EQUAL_size_t(0, store.size());
+
+    store.update();
+    TEST_ASSERT_TRUE(store.get<bool>("ledOn"));
+    TEST_ASSERT_EQUAL_INT(42, store.get<int>("count"));
+    TEST_ASSERT_EQUAL_FLOAT(21.5f, store.get<float>("temp"));
+    TEST_ASSERT_EQUAL_STRING("blink", store.get<std::string>("mode").c_str());
+}
+
+void test_nexstate_post_reports_full_queue() {
+    NexState store(quietConfig());
+    for (int i = 0; i < NEXSTATE_COMMAND_QUEUE_CAPACITY; i++) {
+        TEST_ASSERT_TRUE(store.post("k", i));
+    }
+    TEST_ASSERT_FALSE(store.post("k", -1));
+    TEST_ASSERT_EQUAL_UINT32(1, store.getDroppedPosts());
+
+    store.update();
+    TEST_ASSERT_EQUAL_INT(NEXSTATE_COMMAND_QUEUE_CAPACITY - 1, store.get<int>("k"));
+    TEST_ASSERT_TRUE(store.post("k", 7));
+}
+
+void test_nexstate_snapshot_reflects_last_update() {
+    NexState store(quietConfig());
+    store.set("ledOn", true);
+    store.set("name", std::string("BeamLink"));
+
+    StateSnapshot snap;
+    TEST_ASSERT_TRUE(store.readSnapshot(snap));
+    TEST_ASSERT_EQUAL_UINT16(0, snap.count); // not published yet
+
+    store.update();
+    TEST_ASSERT_TRUE(store.readSnapshot(snap));
+    TEST_ASSERT_EQUAL_UINT16(2, snap.count);
+    TEST_ASSERT_TRUE(snap.get<bool>("ledOn", false));
+    TEST_ASSERT_EQUAL_STRING("BeamLink", snap.get<std::string>("name").c_str());
+    TEST_ASSERT_EQUAL_INT(-1, snap.get<int>("missing", -1));
+
+    // Unchanged store does not republish
+    uint32_t version = snap.version;
+    store.set("ledOn", true);
+    store.update();
+    TEST_ASSERT_TRUE(store.readSnapshot(snap));
+    TEST_ASSERT_EQUAL_UINT32(version, snap.version);
+}
+
+void test_nexstate_snapshot_counts_overflow() {
+    NexState store(quietConfig());
+    for (int i = 0; i < NEXSTATE_SNAPSHOT_CAPACITY + 3; i++) {
+        store.set("key" + std::to_string(i), i);
+    }
+    store.update();
+
+    StateSnapshot snap;
+    TEST_ASSERT_TRUE(store.readSnapshot(snap));
+    TEST_ASSERT_EQUAL_UINT16(NEXSTATE_SNAPSHOT_CAPACITY, snap.count);
+    TEST_ASSERT_EQUAL_UINT16(3, snap.dropped);
+}
+
+#ifndef ARDUINO
+// ============================================================================
+// Multi-threaded stress tests (host only)
+// ============================================================================
+
+void test_nexstate_snapshot_never_torn() {
+    NexState store(quietConfig());
+    std::atomic<bool> done{false};
+    std::atomic<uint32_t> reads{0};
+    std::atomic<uint32_t> torn{0};
+
+    auto reader = [&]() {
+        StateSnapshot snap;
+        uint32_t lastVersion = 0;
+        while (!done.load()) {
+            if (!store.readSnapshot(snap)) continue;
+            // The owner always writes a and b together before publishing
+            int a = snap.get<int>("a", 0);
+            int b = snap.get<int>("b", 0);
+            std::string s = snap.get<std::string>("s", "0");
+            if (a != b || std::to_string(a) != s || snap.version < lastVersion) {
+                torn.fetch_add(1);
+            }
+            lastVersion = snap.version;
+            reads.fetch_add(1);
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; i++) readers.emplace_back(reader);
+
+    for (int i = 1; i <= 20000; i++) {
+        store.set("a", i);
+        store.set("b", i);
+        store.set("s", std::to_string(i));
+        store.update();
+    }
+    done.store(true);
+    for (auto& t : readers) t.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn.load());
+    TEST_ASSERT_GREATER_THAN_UINT32(0, reads.load());
+}
+
+void test_nexstate_post_from_many_producers() {
+    NexState store(quietConfig());
+    const int producers = 4;
+    const int writesPerProducer = 5000;
+    std::atomic<int> finished{0};
+    std::atomic<uint32_t> regressions{0};
+
+    auto producer = [&](int id) {
+        std::string key = "p" + std::to_string(id);
+        for (int v = 1; v <= writesPerProducer; v++) {
+            while (!store.post(key.c_str(), v)) {
+                std::this_thread::yield();
+            }
+        }
+        finished.fetch_add(1);
+    };
+
+    auto watcher = [&]() {
+        StateSnapshot snap;
+        int last[producers] = {};
+        while (finished.load() < producers) {
+            if (!store.readSnapshot(snap)) continue;
+            for (int id = 0; id < producers; id++) {
+                int v = snap.get<int>(("p" + std::to_string(id)).c_str(), 0);
+                if (v < last[id]) regressions.fetch_add(1);
+                last[id] = v;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int id = 0; id < producers; id++) threads.emplace_back(producer, id);
+    threads.emplace_back(watcher);
+
+    // This thread is the owner: drain and publish like loop() would
+    while (finished.load() < producers) {
+        store.update();
+    }
+    for (auto& t : threads) t.join();
+    store.update();
+
+    TEST_ASSERT_EQUAL_UINT32(0, regressions.load());
+    for (int id = 0; id < producers; id++) {
+        TEST_ASSERT_EQUAL_INT(writesPerProducer, store.get<int>("p" + std::to_string(id)));
+    }
+}
+#endif
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_nexstate_post_applied_on_update);
+    RUN_TEST(test_nexstate_post_reports_full_queue);
+    RUN_TEST(test_nexstate_snapshot_reflects_last_update);
+    RUN_TEST(test_nexstate_snapshot_counts_overflow);
+
+#ifndef ARDUINO
+    RUN_TEST(test_nexstate_snapshot_never_torn);
+    RUN_TEST(test_nexstate_post_from_many_producers);
+#endif
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
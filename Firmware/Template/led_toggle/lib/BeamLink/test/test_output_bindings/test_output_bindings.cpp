@@ -0,0 +1,158 @@
+/**
+ * @file test_output_bindings.cpp
+ * @brief Tests for NexState-driven GPIO output bindings
+ *
+ * Uses a recording mask writer, so it runs on the host
+ * (`pio test -e native -f test_output_bindings`) without touching real pins.
+ */
+
+#include <unity.h>
+#include "OutputBindings.h"
+#include "../nexstate_test_helpers.h"
+
+using namespace nexstate;
+
+static uint64_t lastSet = 0;
+static uint64_t lastClear = 0;
+static int writes = 0;
+
+static void recordMasks(uint64_t setMask, uint64_t clearMask) {
+    lastSet = setMask;
+    lastClear = clearMask;
+    writes++;
+}
+
+static void noSetup(uint8_t) {}
+
+void setUp(void) {
+    lastSet = 0;
+    lastClear = 0;
+    writes = 0;
+}
+
+void tearDown(void) {}
+
+void test_outputs_written_only_on_change() {
+    NexState store(quietConfig());
+    OutputBindings outputs(recordMasks, noSetup);
+    TEST_ASSERT_FALSE(outputs.bindOutput("ledOn", 2)); // no store yet
+    outputs.begin(store);
+    TEST_ASSERT_TRUE(outputs.bindOutput("ledOn", 2));
+
+    // Nothing set yet, nothing to write
+    TEST_ASSERT_FALSE(outputs.flush());
+
+    store.set("ledOn", true);
+    TEST_ASSERT_TRUE(outputs.flush());
+    TEST_ASSERT_TRUE(lastSet == (1ULL << 2));
+    TEST_ASSERT_TRUE(lastClear == 0);
+
+    // Same value again: no callback, no register write
+    store.set("ledOn", true);
+    TEST_ASSERT_FALSE(outputs.flush());
+    TEST_ASSERT_EQUAL_INT(1, writes);
+
+    store.set("ledOn", false);
+    TEST_ASSERT_TRUE(outputs.flush());
+    TEST_ASSERT_TRUE(lastClear == (1ULL << 2));
+}
+
+void test_outputs_batched_into_one_write() {
+    NexState store(quietConfig());
+    OutputBindings outputs(recordMasks, noSetup);
+    outputs.begin(store);
+    outputs.bindOutput("a", 4);
+    outputs.bindOutput("b", 5);
+    outputs.bindOutput("c", 33, false); // active low
+
+    store.set("a", true);
+    store.set("b", false);
+    store.set("c", true);
+    TEST_ASSERT_TRUE(outputs.flush());
+    TEST_ASSERT_EQUAL_INT(1, writes);
+    TEST_ASSERT_TRUE(lastSet == (1ULL << 4));
+    TEST_ASSERT_TRUE(lastClear == ((1ULL << 5) | (1ULL << 33)));
+    TEST_ASSERT_EQUAL_UINT32(1, outputs.getRegisterWrites());
+}
+
+void test_outputs_toggle_back_is_not_written() {
+    NexState store(quietConfig());
+    OutputBindings outputs(recordMasks, noSetup);
+    outputs.begin(store);
+    store.set("ledOn", true);
+    outputs.bindOutput("ledOn", 2); // existing key is applied immediately
+    TEST_ASSERT_TRUE(outputs.flush());
+
+    store.set("ledOn", false);
+    store.set("ledOn", true);
+    TEST_ASSERT_FALSE(outputs.flush());
+    TEST_ASSERT_EQUAL_INT(1, writes);
+}
+
+void test_outputs_posted_writes_drive_pins() {
+    NexState store(quietConfig());
+    OutputBindings outputs(recordMasks, noSetup);
+    outputs.begin(store);
+    outputs.bindOutput("ledOn", 2);
+
+    store.post("ledOn", true);
+    TEST_ASSERT_FALSE(outputs.flush()); // not applied before update()
+    store.update();
+    TEST_ASSERT_TRUE(outputs.flush());
+    TEST_ASSERT_TRUE(lastSet == (1ULL << 2));
+}
+
+void test_outputs_bind_pin_list() {
+    NexState store(quietConfig());
+    OutputBindings outputs(recordMasks, noSetup);
+    outputs.begin(store);
+    TEST_ASSERT_EQUAL_size_t(3, outputs.bindOutputs("12, 13,14", "actuator"));
+    TEST_ASSERT_TRUE(outputs.getBoundMask() == ((1ULL << 12) | (1ULL << 13) | (1ULL << 14)));
+
+    store.set("actuator1", true);
+    outputs.flush();
+    TEST_ASSERT_TRUE(lastSet == (1ULL << 13));
+
+    // Duplicates, bad entries and out-of-range pins are rejected
+    TEST_ASSERT_EQUAL_size_t(0, outputs.bindOutputs("12,x,99", "other"));
+    TEST_ASSERT_FALSE(outputs.bindOutput("ledOn", 64));
+
+    // "1 2" is not pin 12, and a rejected entry keeps the later keys in place
+    TEST_ASSERT_EQUAL_size_t(1, outputs.bindOutputs("1 2, x ,25", "relay"));
+    TEST_ASSERT_TRUE(outputs.getBoundMask() & (1ULL << 25));
+    TEST_ASSERT_FALSE(outputs.getBoundMask() & (1ULL << 2));
+    store.set("relay2", true);
+    outputs.flush();
+    TEST_ASSERT_TRUE(lastSet == (1ULL << 25));
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_outputs_written_only_on_change);
+    RUN_TEST(test_outputs_batched_into_one_write);
+    RUN_TEST(test_outputs_toggle_back_is_not_written);
+    RUN_TEST(test_outputs_posted_writes_drive_pins);
+    RUN_TEST(test_outputs_bind_pin_list);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
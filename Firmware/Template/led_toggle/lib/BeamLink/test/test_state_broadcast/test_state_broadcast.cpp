@@ -0,0 +1,308 @@
+/**
+ * @file test_state_broadcast.cpp
+ * @brief Tests for the StateBroadcast advertising payload
+ *
+ * Portable: runs on the board or on the host (`pio test -e native -f test_state_broadcast`).
+ * The payload goes to a recording sink and time is passed explicitly.
+ */
+
+#include <unity.h>
+#include "StateBroadcast.h"
+#include "../nexstate_test_helpers.h"
+#include <cstring>
+
+using namespace nexstate;
+
+static uint8_t lastPayload[kLegacyAdvBytes];
+static size_t lastSize = 0;
+static int payloads = 0;
+
+static void recordPayload(const uint8_t* data, size_t size) {
+    memcpy(lastPayload, data, size);
+    lastSize = size;
+    payloads++;
+}
+
+void setUp(void) {
+    memset(lastPayload, 0, sizeof(lastPayload));
+    lastSize = 0;
+    payloads = 0;
+}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Encoding Tests
+// ============================================================================
+
+void test_broadcast_roundtrip_types() {
+    NexState store(quietConfig());
+    store.set("ledOn", true);
+    store.set("count", 300);
+    store.set("temperature", 21.54f);
+    store.set("ratio", 0.25);
+    store.set("status", std::string("ok"));
+
+    StateBroadcast broadcast(0x1234);
+    TEST_ASSERT_TRUE(broadcast.add(0, "ledOn"));
+    TEST_ASSERT_TRUE(broadcast.add(1, "count"));
+    TEST_ASSERT_TRUE(broadcast.add(2, "temperature", 1));
+    TEST_ASSERT_TRUE(broadcast.add(3, "ratio"));
+    TEST_ASSERT_TRUE(broadcast.add(4, "status"));
+
+    uint8_t out[kLegacyAdvBytes];
+    const BroadcastResult r = broadcast.build(store, 7, out, sizeof(out));
+    TEST_ASSERT_EQUAL_INT(5, r.included);
+    TEST_ASSERT_EQUAL_INT(0, r.dropped);
+    // header 4 + bool 1 + int16 3 + int16 3 + float 5 + text 4
+    TEST_ASSERT_EQUAL_INT(20, r.size);
+
+    BroadcastField fields[8];
+    uint8_t seq = 0;
+    uint16_t company = 0;
+    TEST_ASSERT_EQUAL_INT(5, decodeBroadcast(out, r.size, fields, 8, &seq, &company));
+    TEST_ASSERT_EQUAL_INT(7, seq);
+    TEST_ASSERT_EQUAL_INT(0x1234, company);
+    TEST_ASSERT_EQUAL_INT(0x34, out[0]); // little-endian company id
+
+    TEST_ASSERT_TRUE(fields[0].type == BroadcastType::True);
+    TEST_ASSERT_TRUE(fields[1].type == BroadcastType::Int16);
+    TEST_ASSERT_EQUAL_INT(300, static_cast<int>(fields[1].number));
+    TEST_ASSERT_TRUE(fields[2].type == BroadcastType::Int16);
+    TEST_ASSERT_EQUAL_INT(215, static_cast<int>(fields[2].number));
+    TEST_ASSERT_TRUE(fields[3].type == BroadcastType::Float);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, 0.25, fields[3].number);
+    TEST_ASSERT_TRUE(fields[4].type == BroadcastType::Text);
+    TEST_ASSERT_TRUE(fields[4].text == "ok");
+    TEST_ASSERT_EQUAL_INT(4, fields[4].id);
+}
+
+void test_broadcast_int_widths() {
+    NexState store(quietConfig());
+    store.set("a", -5);
+    store.set("b", -40000);
+    StateBroadcast broadcast;
+    broadcast.add(0, "a");
+    broadcast.add(1, "b");
+
+    uint8_t out[kLegacyAdvBytes];
+    const BroadcastResult r = broadcast.build(store, 0, out, sizeof(out));
+    BroadcastField fields[2];
+    TEST_ASSERT_EQUAL_INT(2, decodeBroadcast(out, r.size, fields, 2));
+    TEST_ASSERT_TRUE(fields[0].type == BroadcastType::Int8);
+    TEST_ASSERT_EQUAL_INT(-5, static_cast<int>(fields[0].number));
+    TEST_ASSERT_TRUE(fields[1].type == BroadcastType::Int32);
+    TEST_ASSERT_EQUAL_INT(-40000, static_cast<int>(fields[1].number));
+}
+
+void test_broadcast_add_rejects_bad_ids() {
+    StateBroadcast broadcast;
+    TEST_ASSERT_FALSE(broadcast.add(32, "x"));
+    TEST_ASSERT_TRUE(broadcast.add(31, "x"));
+    TEST_ASSERT_FALSE(broadcast.add(31, "y"));
+    TEST_ASSERT_FALSE(broadcast.add(1, ""));
+    for (uint8_t id = 0; id < STATE_BROADCAST_MAX_KEYS - 1; id++) {
+        TEST_ASSERT_TRUE(broadcast.add(id, "k"));
+    }
+    TEST_ASSERT_FALSE(broadcast.add(30, "z"));
+}
+
+void test_broadcast_decode_rejects_malformed() {
+    BroadcastField fields[4];
+    const uint8_t wrongVersion[] = {0xFF, 0xFF, 2, 0};
+    TEST_ASSERT_EQUAL_INT(-1, decodeBroadcast(wrongVersion, sizeof(wrongVersion), fields, 4));
+    const uint8_t cutInt16[] = {0xFF, 0xFF, kBroadcastVersion, 0, (1 << 3) | 3, 0x01};
+    TEST_ASSERT_EQUAL_INT(-1, decodeBroadcast(cutInt16, sizeof(cutInt16), fields, 4));
+    const uint8_t cutText[] = {0xFF, 0xFF, kBroadcastVersion, 0, 6, 5, 'a'};
+    TEST_ASSERT_EQUAL_INT(-1, decodeBroadcast(cutText, sizeof(cutText), fields, 4));
+    const uint8_t headerOnly[] = {0xFF, 0xFF, kBroadcastVersion, 9};
+    TEST_ASSERT_EQUAL_INT(0, decodeBroadcast(headerOnly, sizeof(headerOnly), fields, 4));
+}
+
+// ============================================================================
+// Capacity Tests
+// ============================================================================
+
+void test_broadcast_drops_fields_that_do_not_fit() {
+    NexState store(quietConfig());
+    store.set("ledOn", false);
+    store.set("status", std::string("a long status text"));
+    store.set("count", 1);
+
+    StateBroadcast broadcast;
+    broadcast.add(0, "ledOn");
+    broadcast.add(1, "status");
+    broadcast.add(2, "count");
+    broadcast.add(3, "missing");
+
+    // 4 header + 1 bool + 2 int8 = 7; the 20-byte text does not fit in 12
+    uint8_t out[kLegacyAdvBytes];
+    const BroadcastResult r = broadcast.build(store, 0, out, 12);
+    TEST_ASSERT_EQUAL_INT(7, r.size);
+    TEST_ASSERT_EQUAL_INT(2, r.included);
+    TEST_ASSERT_EQUAL_INT(2, r.dropped);
+    TEST_ASSERT_EQUAL_STRING("status", r.firstDropped);
+
+    // What was written still decodes: nothing was cut
+    BroadcastField fields[4];
+    TEST_ASSERT_EQUAL_INT(2, decodeBroadcast(out, r.size, fields, 4));
+    TEST_ASSERT_EQUAL_INT(2, fields[1].id);
+}
+
+void test_broadcast_fits_legacy_scan_response() {
+    // Scan response with the 9-character default name: 31 - (2 + 9) - 2 = 18
+    NexState store(quietConfig());
+    store.set("ledOn", true);
+    store.set("ledBlinking", false);
+    store.set("ledStatus", std::string("LED is ON"));
+    StateBroadcast broadcast;
+    broadcast.add(0, "ledOn");
+    broadcast.add(1, "ledBlinking");
+    broadcast.add(2, "ledStatus");
+    broadcast.setCapacity(kLegacyAdvBytes - (2 + 9) - 2);
+
+    broadcast.begin(store);
+    broadcast.onPayload(recordPayload);
+    broadcast.update(0);
+    TEST_ASSERT_EQUAL_INT(1, payloads);
+    // 4 + 1 + 1 + 11 = 17 bytes
+    TEST_ASSERT_EQUAL_INT(17, lastSize);
+    TEST_ASSERT_EQUAL_INT(0, broadcast.lastResult().dropped);
+
+    // Capacity never exceeds the legacy PDU
+    broadcast.setCapacity(100);
+    store.set("ledStatus", std::string("this status text is far too long to fit"));
+    broadcast.update(5000);
+    TEST_ASSERT_TRUE(lastSize <= kLegacyAdvBytes);
+    TEST_ASSERT_EQUAL_STRING("ledStatus", broadcast.lastResult().firstDropped);
+}
+
+// ============================================================================
+// Update Tests
+// ============================================================================
+
+void test_broadcast_rate_limit_coalesces() {
+    NexState store(quietConfig());
+    store.set("count", 0);
+    StateBroadcast broadcast;
+    broadcast.add(0, "count");
+    broadcast.onPayload(recordPayload);
+    TEST_ASSERT_EQUAL_UINT32(StateBroadcast::kNever, broadcast.update(0)); // not begun
+    broadcast.begin(store, 1000);
+
+    TEST_ASSERT_EQUAL_UINT32(StateBroadcast::kNever, broadcast.update(0));
+    TEST_ASSERT_EQUAL_INT(1, payloads);
+
+    // Three changes inside the window: one payload, with the last value
+    store.set("count", 1);
+    store.set("count", 2);
+    store.set("count", 3);
+    TEST_ASSERT_EQUAL_UINT32(600, broadcast.update(400));
+    TEST_ASSERT_EQUAL_INT(1, payloads);
+    TEST_ASSERT_EQUAL_UINT32(StateBroadcast::kNever, broadcast.update(1000));
+    TEST_ASSERT_EQUAL_INT(2, payloads);
+    TEST_ASSERT_EQUAL_UINT32(2, broadcast.getChangesCoalesced());
+
+    BroadcastField fields[1];
+    TEST_ASSERT_EQUAL_INT(1, decodeBroadcast(lastPayload, lastSize, fields, 1));
+    TEST_ASSERT_EQUAL_INT(3, static_cast<int>(fields[0].number));
+}
+
+void test_broadcast_ignores_other_keys() {
+    NexState store(quietConfig());
+    store.set("ledOn", true);
+    StateBroadcast broadcast;
+    broadcast.add(0, "ledOn");
+    broadcast.onPayload(recordPayload);
+    broadcast.begin(store);
+    broadcast.update(0);
+
+    store.set("unrelated", 5);
+    TEST_ASSERT_EQUAL_UINT32(StateBroadcast::kNever, broadcast.update(5000));
+    TEST_ASSERT_EQUAL_INT(1, payloads);
+}
+
+void test_broadcast_capacity_change_rebuilds() {
+    NexState store(quietConfig());
+    store.set("ledOn", true);
+    store.set("ledStatus", std::string("LED is ON"));
+    StateBroadcast broadcast;
+    broadcast.add(0, "ledOn");
+    broadcast.add(1, "ledStatus");
+    broadcast.setCapacity(18);
+    broadcast.onPayload(recordPayload);
+    broadcast.begin(store);
+    broadcast.update(0);
+    TEST_ASSERT_EQUAL_INT(16, lastSize);
+
+    // A longer name, no state change: rebuilt for the smaller room on the next update
+    broadcast.setCapacity(10);
+    TEST_ASSERT_EQUAL_UINT32(StateBroadcast::kNever, broadcast.update(2000));
+    TEST_ASSERT_EQUAL_INT(2, payloads);
+    TEST_ASSERT_TRUE(lastSize <= 10);
+    TEST_ASSERT_EQUAL_STRING("ledStatus", broadcast.lastResult().firstDropped);
+}
+
+void test_broadcast_unchanged_content_not_resent() {
+    NexState store(quietConfig());
+    store.set("ledOn", false);
+    StateBroadcast broadcast;
+    broadcast.add(0, "ledOn");
+    broadcast.onPayload(recordPayload);
+    broadcast.begin(store);
+    broadcast.update(0);
+    uint8_t firstSeq = lastPayload[3];
+
+    // Toggled on and back off before the window ended
+    store.set("ledOn", true);
+    store.set("ledOn", false);
+    broadcast.update(2000);
+    TEST_ASSERT_EQUAL_INT(1, payloads);
+
+    store.set("ledOn", true);
+    broadcast.update(4000);
+    TEST_ASSERT_EQUAL_INT(2, payloads);
+    TEST_ASSERT_EQUAL_INT(static_cast<uint8_t>(firstSeq + 1), lastPayload[3]);
+    TEST_ASSERT_EQUAL_UINT32(2, broadcast.getPayloadsSent());
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Encoding Tests
+    RUN_TEST(test_broadcast_roundtrip_types);
+    RUN_TEST(test_broadcast_int_widths);
+    RUN_TEST(test_broadcast_add_rejects_bad_ids);
+    RUN_TEST(test_broadcast_decode_rejects_malformed);
+
+    // Capacity Tests
+    RUN_TEST(test_broadcast_drops_fields_that_do_not_fit);
+    RUN_TEST(test_broadcast_fits_legacy_scan_response);
+
+    // Update Tests
+    RUN_TEST(test_broadcast_rate_limit_coalesces);
+    RUN_TEST(test_broadcast_ignores_other_keys);
+    RUN_TEST(test_broadcast_capacity_change_rebuilds);
+    RUN_TEST(test_broadcast_unchanged_content_not_resent);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
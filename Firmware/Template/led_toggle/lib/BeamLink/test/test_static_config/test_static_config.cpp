@@ -0,0 +1,98 @@
+/**
+ * @file test_static_config.cpp
+ * @brief Tests for the compile-time configuration and UUID parsing
+ *
+ * Most checks are static_asserts: if this file compiles, they passed.
+ * Portable: runs on the board or on the host (`pio test -e native -f test_static_config`).
+ */
+
+#include <unity.h>
+#include "BeamPlatform.h"
+#include "BeamStaticConfig.h"
+
+static constexpr BeamStaticConfig kValid("BLX-01", "Beam", "BLE-Controller", "1.0.0",
+                                         "BeamLink-LED", 9, 100,
+                                         "12345678-1234-1234-1234-1234567890ab",
+                                         "12345678-1234-1234-1234-1234567890AC",
+                                         2, true);
+BEAM_STATIC_ASSERT_CONFIG(kValid);
+
+// Invalid values are detected by the same checks the macro uses
+static constexpr BeamStaticConfig kLoudAndSlow("id", "n", "t", "v", "BeamLink-LED", 12, 20000,
+                                               "12345678-1234-1234-1234-1234567890ab",
+                                               "not-a-uuid", 40, true);
+static_assert(!kLoudAndSlow.powerValid(), "power above +9 dBm");
+static_assert(!beamcfg::powerValid(4) && beamcfg::powerValid(-3), "power between levels");
+static_assert(!kLoudAndSlow.intervalValid(), "interval above 10240 ms");
+static_assert(!kLoudAndSlow.pinValid(), "pin above 39");
+static_assert(!kLoudAndSlow.uuidsValid(), "malformed UUID");
+static_assert(kLoudAndSlow.nameValid(), "name within limit");
+static_assert(!BeamStaticConfig("id", "n", "t", "v", "ThisAdvertisingNameIsMuchTooLong", 0, 100,
+                                "12345678-1234-1234-1234-1234567890ab",
+                                "12345678-1234-1234-1234-1234567890ac", 2, true).nameValid(),
+              "name longer than one AD payload");
+
+// UUIDs are parsed by the compiler, least significant byte first
+static_assert(kValid.serviceUuid.bytes[0] == 0xab, "last byte of the text comes first");
+static_assert(kValid.serviceUuid.bytes[15] == 0x12, "first byte of the text comes last");
+static_assert(kValid.characteristicUuid.bytes[0] == 0xac, "upper-case hex accepted");
+static_assert(!beamcfg::isUuid128("12345678-1234-1234-1234-1234567890a"), "too short");
+static_assert(!beamcfg::isUuid128("12345678_1234-1234-1234-1234567890ab"), "separator");
+static_assert(!beamcfg::isUuid128("1234567g-1234-1234-1234-1234567890ab"), "hex digit");
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Runtime Tests
+// ============================================================================
+
+void test_static_config_uuid_bytes() {
+    const uint8_t expected[16] = {0xab, 0x90, 0x78, 0x56, 0x34, 0x12, 0x34, 0x12,
+                                  0x34, 0x12, 0x34, 0x12, 0x78, 0x56, 0x34, 0x12};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, kValid.serviceUuid.bytes, 16);
+}
+
+void test_static_config_malformed_uuid_is_zero() {
+    beamcfg::Uuid128 uuid = beamcfg::parseUuid128("not-a-uuid");
+    for (uint8_t byte : uuid.bytes) {
+        TEST_ASSERT_EQUAL_UINT8(0, byte);
+    }
+}
+
+void test_static_config_valid() {
+    TEST_ASSERT_TRUE(kValid.valid());
+    TEST_ASSERT_FALSE(kLoudAndSlow.valid());
+    TEST_ASSERT_EQUAL_STRING("BeamLink-LED", kValid.bleName);
+}
+
+// ============================================================================
+// Main Test Setup
+// ============================================================================
+
+int runAllTests() {
+    UNITY_BEGIN();
+
+    // Runtime Tests
+    RUN_TEST(test_static_config_uuid_bytes);
+    RUN_TEST(test_static_config_malformed_uuid_is_zero);
+    RUN_TEST(test_static_config_valid);
+
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial to initialize
+    runAllTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main() {
+    return runAllTests();
+}
+#endif
@@ -7,25 +7,33 @@ namespace LEDMessageHandler {
 LEDCommandHandler::LEDCommandHandler(int pin, bool activeHigh, const char* name, const char* id, 
                                    const char* type, const char* fw)
   : ledPin(pin), ledActiveHigh(activeHigh), deviceName(name), deviceId(id), 
-    deviceType(type), firmwareVersion(fw), ledState(false), blinkingMode(false), lastBlinkTime(0) {
+    deviceType(type), firmwareVersion(fw), ledState(false), blinkingMode(false) {
   
   LOG_INFO("LEDCommandHandler initialized");
 }
 
+bool LEDCommandHandler::begin() {
+  if (!led.begin(ledDriver, ledPin, ledActiveHigh)) {
+    LOG_ERR("LED PWM setup failed on pin %d", ledPin);
+    return false;
+  }
+  return true;
+}
+
 void LEDCommandHandler::handleMessage(const std::string& message, std::function<void(const std::string&)> reply) {
   LOG_BLE("RX: %s", message.c_str());
 
   if (message == "led:on") {
     ledState = true;
     blinkingMode = false;
-    LEDUtils::turnOn(ledPin, ledActiveHigh);
+    led.set(true);
     reply("LED ON");
     LOG_OK("LED turned ON via BLE");
   }
   else if (message == "led:off") {
     ledState = false;
     blinkingMode = false;
-    LEDUtils::turnOff(ledPin, ledActiveHigh);
+    led.set(false);
     reply("LED OFF");
     LOG_OK("LED turned OFF via BLE");
   }
@@ -37,11 +45,7 @@ void LEDCommandHandler::handleMessage(const std::string& message, std::function<
   else if (message == "led:toggle") {
     ledState = !ledState;
     blinkingMode = false;
-    if (ledState) {
-      LEDUtils::turnOn(ledPin, ledActiveHigh);
-    } else {
-      LEDUtils::turnOff(ledPin, ledActiveHigh);
-    }
+    led.set(ledState);
     const char* stateStr = ledState ? "ON" : "OFF";
     reply(std::string("LED ") + stateStr);
     LOG_OK("LED toggled to: %s via BLE", stateStr);
@@ -49,9 +53,30 @@ void LEDCommandHandler::handleMessage(const std::string& message, std::function<
   else if (message == "led:blink") {
     blinkingMode = true;
     ledState = true; // Start blinking from ON state
+    led.blink(1000);
     reply("LED BLINKING");
     LOG_OK("LED set to BLINKING mode via BLE");
   }
+  else if (message.rfind("led:brightness:", 0) == 0) {
+    int32_t percent;
+    if (!BeamUtils::parseInt(std::string_view(message).substr(15), percent) || percent < 0 || percent > 100) {
+      reply("LED ERR brightness 0-100");
+    } else {
+      led.setBrightness(static_cast<uint8_t>(percent));
+      reply("LED BRIGHTNESS " + std::to_string(percent));
+      LOG_OK("LED brightness %ld%% via BLE", (long)percent);
+    }
+  }
+  else if (message.rfind("led:fade:", 0) == 0) {
+    int32_t ms;
+    if (!BeamUtils::parseInt(std::string_view(message).substr(9), ms) || ms < 0 || ms > 60000) {
+      reply("LED ERR fade 0-60000 ms");
+    } else {
+      led.setFade(static_cast<uint32_t>(ms));
+      reply("LED FADE " + std::to_string(ms) + "ms");
+      LOG_OK("LED fade %ld ms via BLE", (long)ms);
+    }
+  }
   else if (message == "state:info") {
     std::string stateInfo = std::string("State: ") + (ledState ? "ON" : "OFF") +
                            ", Blinking: " + (blinkingMode ? "YES" : "NO");
@@ -73,39 +98,25 @@ void LEDCommandHandler::handleMessage(const std::string& message, std::function<
   }
 }
 
-void LEDCommandHandler::update() {
-  // Handle blinking mode
-  if (blinkingMode) {
-    if (millis() - lastBlinkTime >= 500) { // 500ms blink interval
-      ledState = !ledState;
-      if (ledState) {
-        LEDUtils::turnOn(ledPin, ledActiveHigh);
-      } else {
-        LEDUtils::turnOff(ledPin, ledActiveHigh);
-      }
-      lastBlinkTime = millis();
-    }
-  }
-}
-
 bool LEDCommandHandler::refreshFromSerial(const std::string& serialInput) {
   if (serialInput == "on" || serialInput == "1") {
     ledState = true;
     blinkingMode = false;
-    LEDUtils::turnOn(ledPin, ledActiveHigh);
+    led.set(true);
     LOG_INFO("LED turned ON via serial");
     return true;
   }
   else if (serialInput == "off" || serialInput == "0") {
     ledState = false;
     blinkingMode = false;
-    LEDUtils::turnOff(ledPin, ledActiveHigh);
+    led.set(false);
     LOG_INFO("LED turned OFF via serial");
     return true;
   }
   else if (serialInput == "blink" || serialInput == "toggle") {
     blinkingMode = true;
     ledState = true;
+    led.blink(1000);
     LOG_INFO("LED set to BLINKING mode via serial");
     return true;
   }
@@ -1,28 +1,195 @@
 #include <Arduino.h>
+#include <SPIFFS.h>
+#include <algorithm>
+#include <atomic>
 #include "BeamLink.h"
+#include "BeamConfig.h"
+#include "BeamStaticConfig.h"
+#include "BeamUtils.h"
 #include "BeamLog.hpp"
 #include "beam.config.h"
 #include "NexState.h"
+#include "BeamLed.h"
+#include "NexRules.h"
+#include "OutputBindings.h"
+#include "BootSequence.h"
+#include "BeamScheduler.h"
+#include "BeamPower.h"
+#include "StateBroadcast.h"
+#include "BeamReport.h"
 
 using namespace nexstate;
 
 BeamLink beam;
 
-// Button handling
-static unsigned long lastButtonPress = 0;
-static const unsigned long BUTTON_DEBOUNCE_MS = 200;
+// beam.config.h values, checked by the compiler and kept in flash
+constexpr BeamStaticConfig kBeamConfig(DEVICE_ID, DEVICE_NAME, DEVICE_TYPE, FIRMWARE_VERSION,
+                                       BLE_NAME, BLE_POWER_DBM, BLE_ADV_INTERVAL_MS,
+                                       BLE_SERVICE_UUID, BLE_CHARACTERISTIC_UUID,
+                                       LED_PIN, LED_ACTIVE_HIGH);
+BEAM_STATIC_ASSERT_CONFIG(kBeamConfig);
+
+// Runtime copy, overridden by /beam.config on SPIFFS when present
+static BeamConfig beamConfig;
+
+// config:set commands, handed from the BLE task to loop()
+struct ConfigCommand {
+    char text[96];
+};
+static CommandQueue<ConfigCommand, 2> configCommands;
+
+// The LED: LEDC PWM with hardware fades; blinking is stepped by a hardware
+// timer, so loop() is not involved once a pattern is set
+static BeamLedcDriver ledDriver;
+static BeamLed led;
+
+// Automations uploaded over BLE ("rule:add:light < 200 => ledOn = true")
+RuleEngine rules;
+
+// ACTUATOR_PINS follow the actuator0, actuator1, ... keys; written by flush() in loop()
+static OutputBindings outputs;
+
+// Boot phase timestamps, printed once at the end of setup()
+static BootTimeline bootTimeline;
+
+// NexState/LED/rules init, run on the other core while BLE starts
+static BootTask stateInit;
+static bool stateReady = false;
+
+// Boot blink, played from loop() once advertising is up
+static BootSequencer bootBlink;
+
+// Timers run from loop(); loop() sleeps until the next one is due
+static BeamScheduler scheduler;
+
+// Full CPU speed only while BLE or loop() work is pending
+static BeamPower power;
+
+// "key=value" on its own characteristic, so state changes don't mix with replies
+static BeamStreamId stateStream = kBeamNoStream;
+
+// ledOn/ledBlinking in the scan response, so scanners need not connect
+static StateBroadcast broadcast;
+
+// State changes reach stateStream only when they differ from what was sent,
+// at most one per key every REPORT_INTERVAL_MS, plus a HEARTBEAT_MS resend
+static BeamReporter reporter;
+
+// "loop:stats", "power:stats" and "report:stats" are answered from loop(), which owns the counters
+static std::atomic<bool> loopStatsRequested{false};
+static std::atomic<bool> powerStatsRequested{false};
+static std::atomic<bool> reportStatsRequested{false};
+
+// Loop-side copies of state, kept current by change callbacks
+static bool ledOn = true;
+static bool ledBlinking = false;
 
 // BLE notification function
 bool notifyBleClient(const std::string& message) {
     return beam.notify(message);
 }
 
-void setup() {
-    Serial.begin(SERIAL_BAUD);
-    delay(300); // Give USB CDC time to initialize
+// Show ledOn/ledBlinking; a blink keeps running in hardware until the next change
+static void applyLed() {
+    if (ledBlinking) {
+        led.blink(LED_BLINK_MS);
+    } else {
+        led.set(ledOn);
+    }
+}
 
-    LOG_INFO("BeamLink LED Toggle Example with NexState booting...");
+// Compile-time defaults from beam.config.h
+static void applyHeaderDefaults(BeamConfig& cfg) {
+    cfg.deviceId = kBeamConfig.deviceId;
+    cfg.deviceName = kBeamConfig.deviceName;
+    cfg.deviceType = kBeamConfig.deviceType;
+    cfg.fwVersion = kBeamConfig.fwVersion;
+    cfg.bleEnabled = BLE_ENABLED;
+    cfg.bleName = kBeamConfig.bleName;
+    cfg.blePowerDbm = kBeamConfig.blePowerDbm;
+    cfg.bleAdvIntervalMs = kBeamConfig.bleAdvIntervalMs;
+    cfg.bleAdvFastIntervalMs = BLE_ADV_FAST_INTERVAL_MS;
+    cfg.bleAdvFastMs = BLE_ADV_FAST_MS;
+    cfg.bleAdvNormalMs = BLE_ADV_NORMAL_MS;
+    cfg.bleAdvSlowIntervalMs = BLE_ADV_SLOW_INTERVAL_MS;
+    cfg.bleServiceUuid = kBeamConfig.bleServiceUuid;
+    cfg.bleCharacteristicUuid = kBeamConfig.bleCharacteristicUuid;
+    cfg.ledPin = kBeamConfig.ledPin;
+    cfg.ledActiveHigh = kBeamConfig.ledActiveHigh;
+    cfg.sensorPins = SENSOR_PINS;
+    cfg.actuatorPins = ACTUATOR_PINS;
+    cfg.reportIntervalMs = REPORT_INTERVAL_MS;
+    cfg.heartbeatMs = HEARTBEAT_MS;
+    cfg.serialBaud = SERIAL_BAUD;
+}
+
+// True when /beam.config left every BLE setting at its beam.config.h value
+static bool bleMatchesHeader(const BeamConfig& cfg) {
+    return cfg.bleName == kBeamConfig.bleName &&
+           cfg.blePowerDbm == kBeamConfig.blePowerDbm &&
+           cfg.bleAdvIntervalMs == kBeamConfig.bleAdvIntervalMs &&
+           cfg.bleServiceUuid == kBeamConfig.bleServiceUuid &&
+           cfg.bleCharacteristicUuid == kBeamConfig.bleCharacteristicUuid;
+}
+
+static void applyReportPolicy() {
+    BeamReportPolicy policy;
+    policy.minIntervalMs = beamConfig.reportIntervalMs;
+    policy.heartbeatMs = beamConfig.heartbeatMs;
+    reporter.setDefaultPolicy(policy);
+}
+
+// Apply one KEY=VALUE without a reboot; only UUID changes restart the BLE stack
+static std::string applyConfigSet(std::string_view assignment) {
+    std::string_view key, value;
+    if (!BeamUtils::splitPair(assignment, '=', key, value)) {
+        return "CONFIG ERR expected KEY=VALUE";
+    }
+    const std::string name(key);
 
+    BeamConfig candidate = beamConfig;
+    if (!parseBeamConfig(assignment, candidate)) {
+        return "CONFIG ERR invalid " + name;
+    }
+
+    if (key == "LOG_LEVEL") {
+        BeamLogLevel level;
+        if (!bl_parse_level(candidate.logLevel.c_str(), level)) {
+            return "CONFIG ERR invalid LOG_LEVEL";
+        }
+        bl_set_level(level);
+        beamConfig.logLevel = candidate.logLevel;
+        return "CONFIG LOG_LEVEL OK live 0us";
+    }
+    if (key == "REPORT_INTERVAL_MS" || key == "HEARTBEAT_MS") {
+        beamConfig.reportIntervalMs = candidate.reportIntervalMs;
+        beamConfig.heartbeatMs = candidate.heartbeatMs;
+        applyReportPolicy();
+        return "CONFIG " + name + " OK live 0us";
+    }
+    if (key.substr(0, 4) != "BLE_" || key == "BLE_ENABLED") {
+        return "CONFIG ERR " + name + " needs a reboot";
+    }
+
+    BeamChangeReport report;
+    if (beam.reconfigure(candidate, &report, 1) == 0) {
+        return "CONFIG " + name + " unchanged";
+    }
+    if (report.ok) {
+        beamConfig = candidate;
+        // A new name changes the room left in the scan response; rebuild for it
+        broadcast.setCapacity(beam.getBroadcastCapacity());
+    }
+
+    char reply[96];
+    snprintf(reply, sizeof(reply), "CONFIG %s %s %s %luus", name.c_str(), report.ok ? "OK" : "FAILED",
+             report.restarted ? "restart" : "live", (unsigned long)report.downtimeUs);
+    LOG_CFG("%s", reply);
+    return reply;
+}
+
+// State, pins and rules; independent of the BLE stack so it runs alongside beam.begin()
+static bool initStateAndOutputs() {
     // Initialize NexState system
     NexStateConfig config;
     config.enableSerialOutput = true;
@@ -33,16 +200,16 @@ void setup() {
     config.outputIntervalMs = 1000;
     
     // Set device information (not state, but output context)
-    config.deviceInfo.deviceName = DEVICE_NAME;
-    config.deviceInfo.deviceId = DEVICE_ID;
-    config.deviceInfo.deviceType = DEVICE_TYPE;
-    config.deviceInfo.firmwareVersion = FIRMWARE_VERSION;
-    config.deviceInfo.ledPin = LED_PIN;
-    config.deviceInfo.ledActiveHigh = LED_ACTIVE_HIGH;
+    config.deviceInfo.deviceName = beamConfig.deviceName;
+    config.deviceInfo.deviceId = beamConfig.deviceId;
+    config.deviceInfo.deviceType = beamConfig.deviceType;
+    config.deviceInfo.firmwareVersion = beamConfig.fwVersion;
+    config.deviceInfo.ledPin = beamConfig.ledPin;
+    config.deviceInfo.ledActiveHigh = beamConfig.ledActiveHigh;
 
     if (!initialize(config)) {
         LOG_ERR("NexState initialization failed");
-        return;
+        return false;
     }
 
     LOG_OK("NexState system initialized");
@@ -50,26 +217,145 @@ void setup() {
     // Set initial state (only dynamic values, not device info)
     State().set("ledOn", true); // Start with LED ON
     State().set("ledBlinking", false);
+    State().set("ledBrightness", LED_BRIGHTNESS);
+    State().set("ledFadeMs", LED_FADE_MS);
     State().set("bleConnected", false);
 
-    // Subscribe to state changes
+    // Subscribe to state changes; the reporter decides what goes on air
+    applyReportPolicy();
+    reporter.setActive(false);  // until the state stream is subscribed (see loop())
+    reporter.onReport([](const std::string& key, const std::string& value) {
+        beam.notify(stateStream, key + "=" + value);
+    });
     State().subscribe([](const std::string& key, const std::string& value) {
         LOG_INFO("State changed: %s = %s", key.c_str(), value.c_str());
+        reporter.offer(key, value);
     });
+    // Run on the loop task (inside set()/update()), which owns the LED
+    State().onChange<bool>("ledOn", [](bool on) {
+        ledOn = on;
+        // A visible change is worth advertising fast again; a blink ignores it
+        if (!ledBlinking) {
+            led.set(on);
+            beam.restartAdvertising();
+        }
+    });
+    State().onChange<bool>("ledBlinking", [](bool blinking) {
+        ledBlinking = blinking;
+        applyLed();
+    });
+    State().onChange<int>("ledBrightness", [](int percent) {
+        led.setBrightness(static_cast<uint8_t>(std::clamp(percent, 0, 100)));
+    });
+    State().onChange<int>("ledFadeMs", [](int ms) {
+        led.setFade(static_cast<uint32_t>(std::max(ms, 0)));
+    });
+
+    // Derived status, recomputed only when ledOn/ledBlinking change
+    State().compute<std::string>("ledStatus", {"ledOn", "ledBlinking"}, [](const NexState& s) {
+        if (s.get<bool>("ledBlinking")) return std::string("BLINKING");
+        return std::string(s.get<bool>("ledOn") ? "ON" : "OFF");
+    });
+
+    // The LED follows the "ledOn" key (initially ON); the boot blink plays over it
+    if (!led.begin(ledDriver, beamConfig.ledPin, beamConfig.ledActiveHigh)) {
+        LOG_ERR("LED PWM setup failed");
+    }
+    led.setBrightness(LED_BRIGHTNESS);
+    led.setFade(LED_FADE_MS);
+    applyLed();
+
+    // Actuator pins stay low until a rule sets their key ("... => actuator0 = true")
+    outputs.begin(State());
+    const size_t actuators = outputs.bindOutputs(beamConfig.actuatorPins, "actuator");
+    LOG_CFG("Actuators: %u bound (%s)", (unsigned)actuators, beamConfig.actuatorPins.c_str());
+
+    rules.begin(State());
+    rules.onNotify([](std::string_view msg) {
+        beam.notify(std::string(msg));
+    });
+
+    bootTimeline.mark("state");
+    return true;
+}
+
+// Two short blinks, then back to whatever "ledOn"/"ledBlinking" say
+static void queueBootBlink() {
+    for (int i = 0; i < 2; i++) {
+        bootBlink.then(i == 0 ? 0 : 150, [] { led.set(true); });
+        bootBlink.then(150, [] { led.set(false); });
+    }
+    bootBlink.then(150, [] {
+        applyLed();
+        LOG_OK("Boot blink sequence completed (LED %s)", ledBlinking ? "BLINKING" : ledOn ? "ON" : "OFF");
+    });
+    bootBlink.start();
+}
+
+void setup() {
+    bootTimeline.mark("setup");
+    Serial.begin(SERIAL_BAUD);
+#if ARDUINO_USB_CDC_ON_BOOT
+    // Native USB only: wait for the host to open the port, but not for long
+    while (!Serial && millis() < 300) {
+        delay(1);
+    }
+#endif
+    bootTimeline.mark("serial");
+
+    LOG_INFO("BeamLink LED Toggle Example with NexState booting...");
+
+    // Runtime configuration: /beam.config over the beam.config.h defaults
+    applyHeaderDefaults(beamConfig);
+    BeamConfigLoadInfo loadInfo;
+    if (SPIFFS.begin(false)) {
+        loadBeamConfig(beamConfig, "/beam.config", &loadInfo);
+        LOG_CFG("Config source: %s (%lu us)",
+                loadInfo.source == BeamConfigLoadInfo::Source::Text ? "text" : "defaults",
+                (unsigned long)loadInfo.totalMicros);
+    } else {
+        LOG_WARN("SPIFFS not mounted, using beam.config.h defaults");
+    }
+
+    BeamLogLevel logLevel;
+    if (bl_parse_level(beamConfig.logLevel.c_str(), logLevel)) {
+        bl_set_level(logLevel);
+    }
+    bootTimeline.mark("config");
+
+    // NexState, output pins and rules do not need BLE: build them on the other core
+    stateInit.start("stateInit", [] { stateReady = initStateAndOutputs(); });
 
     // Print initial configuration
-    LOG_CFG("Config: name=%s id=%s type=%s fw=%s", DEVICE_NAME, DEVICE_ID, DEVICE_TYPE, FIRMWARE_VERSION);
-    LOG_BLE("Service UUID: %s", BLE_SERVICE_UUID);
-    LOG_BLE("Char UUID: %s", BLE_CHARACTERISTIC_UUID);
-
-    // Initialize BLE
-    const bool bleOk = beam.begin(
-        BLE_NAME,
-        BLE_POWER_DBM,
-        BLE_ADV_INTERVAL_MS,
-        BLE_SERVICE_UUID,
-        BLE_CHARACTERISTIC_UUID
-    );
+    LOG_CFG("Config: name=%s id=%s type=%s fw=%s", beamConfig.deviceName.c_str(), beamConfig.deviceId.c_str(),
+            beamConfig.deviceType.c_str(), beamConfig.fwVersion.c_str());
+    LOG_BLE("Service UUID: %s", beamConfig.bleServiceUuid.c_str());
+    LOG_BLE("Char UUID: %s", beamConfig.bleCharacteristicUuid.c_str());
+
+    // Extra characteristics are part of the GATT table, so declare them first
+    stateStream = beam.addStream("state", BLE_STATE_STREAM_UUID);
+
+    // Initialize BLE: straight from flash unless /beam.config changed a BLE key.
+    // The shipped file repeats the header values, so compare the values rather
+    // than checking whether a file was loaded.
+    const bool bleOk = bleMatchesHeader(beamConfig)
+        ? beam.begin(kBeamConfig)
+        : beam.begin(
+              beamConfig.bleName.c_str(),
+              beamConfig.blePowerDbm,
+              beamConfig.bleAdvIntervalMs,
+              beamConfig.bleServiceUuid.c_str(),
+              beamConfig.bleCharacteristicUuid.c_str()
+          );
+
+    bootTimeline.mark("ble");
+
+    // Handlers below use State(); it must be complete first
+    stateInit.wait();
+    if (!stateReady) {
+        return;
+    }
+    State().attachScheduler(scheduler);
 
     if (!bleOk) {
         LOG_ERR("BeamLink begin() failed — BLE not started");
@@ -80,62 +366,143 @@ void setup() {
 
     // Ensure service UUID is in advertising
     auto* adv = NimBLEDevice::getAdvertising();
-    adv->addServiceUUID(BLE_SERVICE_UUID);
+    adv->addServiceUUID(beamConfig.bleServiceUuid.c_str());
     adv->setScanResponse(true);
     adv->start();
 
-    LOG_BLE("Advertising as %s", BLE_NAME);
+    // Fast discovery burst, then back off (BLE_ADV_* in beam.config)
+    beam.setAdvSchedule(beamAdvSteps(beamConfig));
+
+    LOG_BLE("Advertising as %s", beamConfig.bleName.c_str());
+    bootTimeline.mark("advertising");
+
+    // Connection changes arrive on the NimBLE host task
+    beam.onConnectionChange([](bool connected) {
+        State().post("bleConnected", connected);
+    });
 
-    // Set up message handler
+    // Set up message handler (runs on the NimBLE host task: writes go through
+    // post() and reads through a snapshot, never directly into the store)
     beam.onMessage([](const std::string& message, ReplyFn reply) {
         LOG_BLE("RX: %s", message.c_str());
 
-        if (message == "led:on") {
-            State().set("ledOn", true);
-            State().set("ledBlinking", false);
+        static StateSnapshot snap;
+        State().readSnapshot(snap);
+
+        if (message.rfind("config:set:", 0) == 0) {
+            // Applied on the loop task, which owns the BLE stack
+            ConfigCommand cmd;
+            const std::string assignment = message.substr(11);
+            if (assignment.size() >= sizeof(cmd.text)) {
+                reply("CONFIG ERR too long");
+            } else {
+                memcpy(cmd.text, assignment.c_str(), assignment.size() + 1);
+                if (!configCommands.push(cmd)) {
+                    reply("CONFIG ERR busy");
+                }
+            }
+        }
+        else if (message == "loop:stats") {
+            loopStatsRequested = true;
+        }
+        else if (message == "power:stats") {
+            powerStatsRequested = true;
+        }
+        else if (message == "report:stats") {
+            reportStatsRequested = true;
+        }
+        else if (message == "adv:stats") {
+            const BeamAdvStats s = beam.getAdvStats();
+            char stats[96];
+            snprintf(stats, sizeof(stats), "ADV %s, fast %lus normal %lus slow %lus off %lus, %lu restarts",
+                     beamAdvPhaseName(beam.getAdvPhase()),
+                     (unsigned long)(s.timeMs[0] / 1000), (unsigned long)(s.timeMs[1] / 1000),
+                     (unsigned long)(s.timeMs[2] / 1000), (unsigned long)(s.timeMs[3] / 1000),
+                     (unsigned long)s.restarts);
+            reply(stats);
+        }
+        else if (message == "conn:stats" || message == "conn:reset") {
+            // Both on the NimBLE host task, like the connect timer itself
+            if (message == "conn:reset") beam.resetConnectStats();
+            const BeamConnectStats& s = beam.getConnectStats();
+            char stats[112];
+            snprintf(stats, sizeof(stats), "CONN layout %08lx, first command %lums last %lums mean %lums max, %lu/%lu",
+                     (unsigned long)beam.getLayoutHash(), (unsigned long)(s.lastUs / 1000),
+                     (unsigned long)(s.meanUs() / 1000), (unsigned long)(s.maxUs / 1000),
+                     (unsigned long)s.measured, (unsigned long)s.connections);
+            reply(stats);
+        }
+        else if (message.rfind("rule:", 0) == 0) {
+            // Compiled on the loop task; the result arrives as a notification
+            if (!rules.post(message)) {
+                reply("RULE ERR busy or too long");
+            }
+        }
+        else if (message == "led:on") {
+            State().post("ledOn", true);
+            State().post("ledBlinking", false);
             reply("LED ON");
             LOG_OK("LED turned ON via BLE");
         }
         else if (message == "led:off") {
-            State().set("ledOn", false);
-            State().set("ledBlinking", false);
+            State().post("ledOn", false);
+            State().post("ledBlinking", false);
             reply("LED OFF");
             LOG_OK("LED turned OFF via BLE");
         }
         else if (message == "led:status") {
-            bool ledOn = State().get<bool>("ledOn", false);
-            const char* stateStr = ledOn ? "ON" : "OFF";
-            reply(std::string("LED ") + stateStr);
-            LOG_INFO("LED status requested: %s", stateStr);
+            std::string status = snap.get<std::string>("ledStatus", "OFF");
+            reply("LED " + status);
+            LOG_INFO("LED status requested: %s", status.c_str());
         }
         else if (message == "led:toggle") {
-            bool currentLedOn = State().get<bool>("ledOn", false);
-            State().set("ledOn", !currentLedOn);
-            State().set("ledBlinking", false);
+            bool currentLedOn = snap.get<bool>("ledOn", false);
+            State().post("ledOn", !currentLedOn);
+            State().post("ledBlinking", false);
             const char* stateStr = !currentLedOn ? "ON" : "OFF";
             reply(std::string("LED ") + stateStr);
             LOG_OK("LED toggled to: %s via BLE", stateStr);
         }
         else if (message == "led:blink") {
-            State().set("ledBlinking", true);
-            State().set("ledOn", true);
+            State().post("ledBlinking", true);
+            State().post("ledOn", true);
             reply("LED BLINKING");
             LOG_OK("LED set to BLINKING mode via BLE");
         }
+        else if (message.rfind("led:brightness:", 0) == 0) {
+            int32_t percent;
+            if (!BeamUtils::parseInt(std::string_view(message).substr(15), percent) || percent < 0 || percent > 100) {
+                reply("LED ERR brightness 0-100");
+            } else {
+                State().post("ledBrightness", static_cast<int>(percent));
+                reply("LED BRIGHTNESS " + std::to_string(percent));
+                LOG_OK("LED brightness %ld%% via BLE", (long)percent);
+            }
+        }
+        else if (message.rfind("led:fade:", 0) == 0) {
+            int32_t ms;
+            if (!BeamUtils::parseInt(std::string_view(message).substr(9), ms) || ms < 0 || ms > 60000) {
+                reply("LED ERR fade 0-60000 ms");
+            } else {
+                State().post("ledFadeMs", static_cast<int>(ms));
+                reply("LED FADE " + std::to_string(ms) + "ms");
+                LOG_OK("LED fade %ld ms via BLE", (long)ms);
+            }
+        }
         else if (message == "state:info") {
-            bool ledOn = State().get<bool>("ledOn", false);
-            bool ledBlinking = State().get<bool>("ledBlinking", false);
+            bool ledOn = snap.get<bool>("ledOn", false);
+            bool ledBlinking = snap.get<bool>("ledBlinking", false);
             std::string stateInfo = std::string("State: ") + (ledOn ? "ON" : "OFF") +
                                    ", Blinking: " + (ledBlinking ? "YES" : "NO");
             reply(stateInfo);
             LOG_INFO("State info requested");
         }
         else if (message == "info") {
-            bool ledOn = State().get<bool>("ledOn", false);
-            std::string info = std::string("Device: ") + DEVICE_NAME +
-                               ", ID: " + DEVICE_ID +
-                               ", Type: " + DEVICE_TYPE +
-                               ", FW: " + FIRMWARE_VERSION +
+            bool ledOn = snap.get<bool>("ledOn", false);
+            std::string info = "Device: " + beamConfig.deviceName +
+                               ", ID: " + beamConfig.deviceId +
+                               ", Type: " + beamConfig.deviceType +
+                               ", FW: " + beamConfig.fwVersion +
                                ", State: " + (ledOn ? "ON" : "OFF");
             reply(info);
             LOG_INFO("Info sent with state");
@@ -146,55 +513,108 @@ void setup() {
         }
     });
 
-    // Perform boot blink sequence
-    LOG_INFO("Starting boot blink sequence...");
-    // Simple boot blink sequence
-    pinMode(LED_PIN, OUTPUT);
-    for (int i = 0; i < 2; i++) {
-        digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? HIGH : LOW);
-        delay(150);
-        digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? LOW : HIGH);
-        delay(150);
+    // Replies need no loop() work, so TX completions don't wake it
+    beam.setWakeEvents(BEAM_EVENT_ALL & ~BEAM_EVENT_TX_DONE);
+    beam.resetEventStats();
+
+#if POWER_MANAGEMENT_ENABLED
+    BeamPowerConfig powerConfig;
+    powerConfig.maxFreqMhz = POWER_MAX_FREQ_MHZ;
+    powerConfig.minFreqMhz = POWER_MIN_FREQ_MHZ;
+    powerConfig.lightSleep = POWER_LIGHT_SLEEP;
+    powerConfig.lingerMs = POWER_LINGER_MS;
+    if (power.begin(powerConfig)) {
+        LOG_OK("Power management: %u-%u MHz, light sleep %s", POWER_MIN_FREQ_MHZ, POWER_MAX_FREQ_MHZ,
+               POWER_LIGHT_SLEEP ? "on" : "off");
+    } else {
+        LOG_WARN("Power management unavailable in this SDK build, accounting only");
     }
-    digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? HIGH : LOW); // Final state ON
-    LOG_OK("Boot blink sequence completed (LED ON)");
+    beam.setPowerManager(&power);
+#endif
+
+#if STATE_BROADCAST_ENABLED
+    // Two bools: 6 bytes, well inside the room left by the name
+    broadcast.add(0, "ledOn");
+    broadcast.add(1, "ledBlinking");
+    broadcast.setCapacity(beam.getBroadcastCapacity());
+    broadcast.onPayload([](const uint8_t* data, size_t size) {
+        if (!beam.setBroadcastData(data, size)) {
+            LOG_WARN("Broadcast payload rejected: %u bytes, room for %u", (unsigned)size,
+                     (unsigned)beam.getBroadcastCapacity());
+        }
+    });
+    broadcast.begin(State(), STATE_BROADCAST_INTERVAL_MS);
+#endif
+
+    // Cosmetic only: plays from loop() while the device is already discoverable
+    queueBootBlink();
 
-    LOG_OK("Ready. Commands: led:on, led:off, led:status, led:toggle, led:blink, info");
+    bootTimeline.mark("ready");
+    bootTimeline.report();
+    LOG_OK("Ready. Commands: led:on, led:off, led:status, led:toggle, led:blink, led:brightness:<0-100>, led:fade:<ms>, info, rule:add|del|list|clear, config:set:KEY=VALUE, loop:stats, power:stats, report:stats, adv:stats, conn:stats, conn:reset");
 }
 
 void loop() {
-    beam.loop();
-    
-    // Update NexState system (handles change detection and output)
-    update();
+    // Each runs once, inside the hold; what they return is how long they can wait
+    uint32_t broadcastWait, reportWait;
+    {
+        // Released before the wait below, so idle time can drop the clock
+        BeamPower::Hold hold(&power, BeamPowerReason::App);
 
-    // Handle BOOT button for LED toggle (simplified - no g_pins)
-    // Note: This is a placeholder - implement actual button handling as needed
-    static unsigned long lastButtonCheck = 0;
-    if (millis() - lastButtonCheck >= 100) { // Check every 100ms
-        // Add actual button handling here if needed
-        lastButtonCheck = millis();
-    }
+        beam.loop();
 
-    // Update BLE connection state
-    bool bleConnected = beam.isConnected();
-    State().set("bleConnected", bleConnected);
+        // Reports only count while the state stream is subscribed; a new
+        // subscriber gets every key's current value
+        reporter.setActive(beam.isSubscribed(stateStream));
 
-    // Handle LED blinking mode
-    bool ledBlinking = State().get<bool>("ledBlinking", false);
-    if (ledBlinking) {
-        static unsigned long lastBlinkTime = 0;
-        unsigned long now = millis();
-        if (now - lastBlinkTime >= 500) { // 500ms blink interval
-            bool currentLedOn = State().get<bool>("ledOn", false);
-            State().set("ledOn", !currentLedOn);
-            lastBlinkTime = now;
+        // Due timers first, so their state changes are published below
+        scheduler.run();
+
+        // Update NexState system (handles change detection and output)
+        update();
+        rules.update();
+        outputs.flush();
+        bootBlink.update();
+        broadcastWait = broadcast.update();
+        reportWait = reporter.update();
+
+        // Replies are lost if a UUID change restarted the stack (client disconnected)
+        ConfigCommand configCmd;
+        while (configCommands.pop(configCmd)) {
+            beam.notify(applyConfigSet(configCmd.text));
         }
-    }
 
-    // Update hardware LED based on state
-    bool ledOn = State().get<bool>("ledOn", false);
-    digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? (ledOn ? HIGH : LOW) : (ledOn ? LOW : HIGH));
+        // LED blinks and fades run in hardware (BeamLed), so nothing to do here.
+
+        if (loopStatsRequested.exchange(false)) {
+            const BeamEventStats s = beam.getEventStats();
+            char reply[96];
+            snprintf(reply, sizeof(reply), "LOOP %.1f wakeups/s, RX->loop %luus mean %luus max",
+                     s.wakeupsPerSecond(), (unsigned long)s.meanLatencyUs(), (unsigned long)s.maxLatencyUs);
+            beam.notify(reply);
+        }
+
+        if (powerStatsRequested.exchange(false)) {
+            const BeamPowerStats s = power.stats();
+            char reply[96];
+            snprintf(reply, sizeof(reply), "POWER busy %.2f%% linger %.2f%% idle %.2f%% (%s)",
+                     s.percent(BeamPowerState::Busy), s.percent(BeamPowerState::Linger),
+                     s.percent(BeamPowerState::Idle), power.isManaged() ? "esp_pm" : "no esp_pm");
+            beam.notify(reply);
+        }
+
+        if (reportStatsRequested.exchange(false)) {
+            const BeamReportStats s = reporter.stats();
+            char reply[96];
+            snprintf(reply, sizeof(reply), "REPORT %lu sent of %lu (%.1fx less), %lu suppressed, %lu heartbeats",
+                     (unsigned long)s.sent, (unsigned long)s.offered, s.reduction(),
+                     (unsigned long)s.suppressed, (unsigned long)s.heartbeats);
+            beam.notify(reply);
+        }
+    }
 
-    delay(10);
+    // Sleep until the next timer or boot step, the end of the linger period,
+    // a held-back broadcast or state report, or BLE activity
+    beam.waitForEvent(std::min({scheduler.msUntilNext(), bootBlink.msUntilNext(), power.update(),
+                                broadcastWait, reportWait}));
 }
\ No newline at end of file